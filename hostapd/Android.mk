@@ -242,6 +242,11 @@ NEED_AES_OMAC1=y
 NEED_AES_UNWRAP=y
 endif
 
+ifdef CONFIG_PMKSA_CACHE_FILE
+L_CFLAGS += -DCONFIG_PMKSA_CACHE_FILE
+NEED_AES_UNWRAP=y
+endif
+
 ifdef CONFIG_SAE
 L_CFLAGS += -DCONFIG_SAE
 OBJS += src/common/sae.c
@@ -690,6 +695,10 @@ CONFIG_INTERNAL_RC4=y
 endif
 endif
 
+ifdef CONFIG_INTERNAL_CRYPTO_ACCEL
+L_CFLAGS += -DCONFIG_INTERNAL_CRYPTO_ACCEL
+endif
+
 AESOBJS = # none so far
 ifdef CONFIG_INTERNAL_AES
 AESOBJS += src/crypto/aes-internal.c src/crypto/aes-internal-enc.c
@@ -923,6 +932,11 @@ OBJS += src/ap/acs.c
 LIBS += -lm
 endif
 
+ifdef CONFIG_PMKSA_CACHE_SHARED
+L_CFLAGS += -DCONFIG_PMKSA_CACHE_SHARED
+OBJS += src/ap/pmksa_cache_shared.c
+endif
+
 ifdef CONFIG_NO_STDOUT_DEBUG
 L_CFLAGS += -DCONFIG_NO_STDOUT_DEBUG
 endif
@@ -935,6 +949,24 @@ ifdef CONFIG_DEBUG_FILE
 L_CFLAGS += -DCONFIG_DEBUG_FILE
 endif
 
+ifdef CONFIG_TRACE_RING
+L_CFLAGS += -DCONFIG_TRACE_RING
+OBJS += src/utils/trace_ring.c
+endif
+
+ifdef CONFIG_STATUS_PAGE
+L_CFLAGS += -DCONFIG_STATUS_PAGE
+OBJS += src/utils/status_page.c
+endif
+
+ifdef CONFIG_DEBUG_ASYNC
+L_CFLAGS += -DCONFIG_DEBUG_ASYNC
+endif
+
+ifdef CONFIG_DEBUG_MIN_LEVEL
+L_CFLAGS += -DWPA_DEBUG_MIN_LEVEL=$(CONFIG_DEBUG_MIN_LEVEL)
+endif
+
 ifdef CONFIG_ANDROID_LOG
 L_CFLAGS += -DCONFIG_ANDROID_LOG
 endif
@@ -14,6 +14,7 @@
 #include "utils/common.h"
 #include "utils/uuid.h"
 #include "common/ieee802_11_defs.h"
+#include "common/sae.h"
 #include "drivers/driver.h"
 #include "eap_server/eap.h"
 #include "radius/radius_client.h"
@@ -2025,6 +2026,9 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->logger_syslog = atoi(pos);
 	} else if (os_strcmp(buf, "logger_stdout") == 0) {
 		bss->logger_stdout = atoi(pos);
+	} else if (os_strcmp(buf, "status_page") == 0) {
+		os_free(bss->status_page);
+		bss->status_page = os_strdup(pos);
 	} else if (os_strcmp(buf, "dump_file") == 0) {
 		wpa_printf(MSG_INFO, "Line %d: DEPRECATED: 'dump_file' configuration variable is not used anymore",
 			   line);
@@ -2891,6 +2895,47 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 		bss->disable_pmksa_caching = atoi(pos);
 	} else if (os_strcmp(buf, "okc") == 0) {
 		bss->okc = atoi(pos);
+	} else if (os_strcmp(buf, "pmksa_cache_max_entries") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid pmksa_cache_max_entries %d",
+				   line, val);
+			return 1;
+		}
+		bss->pmksa_cache_max_entries = val;
+	} else if (os_strcmp(buf, "pmksa_cache_shared") == 0) {
+		os_free(bss->pmksa_cache_shared);
+		bss->pmksa_cache_shared = os_strdup(pos);
+	} else if (os_strcmp(buf, "pmksa_cache_file") == 0) {
+		os_free(bss->pmksa_cache_file);
+		bss->pmksa_cache_file = os_strdup(pos);
+	} else if (os_strcmp(buf, "pmksa_cache_file_key") == 0) {
+		size_t len = os_strlen(pos);
+
+		if ((len != 32 && len != 64) ||
+		    hexstr2bin(pos, bss->pmksa_cache_file_key, len / 2)) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid pmksa_cache_file_key",
+				   line);
+			/* hexstr2bin() may have written a part of the key */
+			os_memset(bss->pmksa_cache_file_key, 0,
+				  sizeof(bss->pmksa_cache_file_key));
+			bss->pmksa_cache_file_key_len = 0;
+			return 1;
+		}
+		bss->pmksa_cache_file_key_len = len / 2;
+	} else if (os_strcmp(buf, "pmksa_cache_file_interval") == 0) {
+		int val = atoi(pos);
+
+		if (val < 0) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid pmksa_cache_file_interval %d",
+				   line, val);
+			return 1;
+		}
+		bss->pmksa_cache_file_interval = val;
 #ifdef CONFIG_WPS
 	} else if (os_strcmp(buf, "wps_state") == 0) {
 		bss->wps_state = atoi(pos);
@@ -3392,6 +3437,15 @@ static int hostapd_config_fill(struct hostapd_config *conf,
 				   line, pos);
 			return 1;
 		}
+	} else if (os_strcmp(buf, "sae_pwe_cache_size") == 0) {
+		int val = atoi(pos);
+		if (val < 0 || val > SAE_PWE_CACHE_MAX_SIZE) {
+			wpa_printf(MSG_ERROR,
+				   "Line %d: Invalid sae_pwe_cache_size %d (expected 0..%d)",
+				   line, val, SAE_PWE_CACHE_MAX_SIZE);
+			return 1;
+		}
+		bss->sae_pwe_cache_size = val;
 	} else if (os_strcmp(buf, "local_pwr_constraint") == 0) {
 		int val = atoi(pos);
 		if (val < 0 || val > 255) {
@@ -21,6 +21,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/trace_ring.h"
 #include "common/version.h"
 #include "common/ieee802_11_defs.h"
 #include "crypto/tls.h"
@@ -1965,9 +1966,13 @@ static int hostapd_ctrl_iface_log_level(struct hostapd_data *hapd, char *cmd,
 					char *buf, size_t buflen)
 {
 	char *pos, *end, *stamp;
+	char modules[600];
 	int ret;
 
-	/* cmd: "LOG_LEVEL [<level>]" */
+	/*
+	 * cmd: "LOG_LEVEL [<level>]" or
+	 * "LOG_LEVEL <module>=<level|default> [<module>=<level|default>...]"
+	 */
 	if (*cmd == '\0') {
 		pos = buf;
 		end = buf + buflen;
@@ -1976,14 +1981,29 @@ static int hostapd_ctrl_iface_log_level(struct hostapd_data *hapd, char *cmd,
 				  debug_level_str(wpa_debug_level),
 				  wpa_debug_timestamp);
 		if (os_snprintf_error(end - pos, ret))
-			ret = 0;
+			return 0;
+		pos += ret;
 
-		return ret;
+		if (wpa_debug_module_levels(modules, sizeof(modules)) > 0) {
+			ret = os_snprintf(pos, end - pos,
+					  "Module levels: %s\n", modules);
+			if (!os_snprintf_error(end - pos, ret))
+				pos += ret;
+		}
+
+		return pos - buf;
 	}
 
 	while (*cmd == ' ')
 		cmd++;
 
+	if (os_strchr(cmd, '=')) {
+		if (wpa_debug_set_module_levels(cmd) < 0)
+			return -1;
+		os_memcpy(buf, "OK\n", 3);
+		return 3;
+	}
+
 	stamp = os_strchr(cmd, ' ');
 	if (stamp) {
 		*stamp++ = '\0';
@@ -2103,6 +2123,10 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
 		reply_len = hostapd_ctrl_iface_sta_next(hapd, buf + 9, reply,
 							reply_size);
+	} else if (os_strcmp(buf, "ALL_STA_DUMP") == 0 ||
+		   os_strncmp(buf, "ALL_STA_DUMP ", 13) == 0) {
+		reply_len = hostapd_ctrl_iface_all_sta_dump(hapd, buf + 12,
+							    reply, reply_size);
 	} else if (os_strcmp(buf, "ATTACH") == 0) {
 		if (hostapd_ctrl_iface_attach(hapd, from, fromlen))
 			reply_len = -1;
@@ -2271,6 +2295,9 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "LOG_LEVEL", 9) == 0) {
 		reply_len = hostapd_ctrl_iface_log_level(
 			hapd, buf + 9, reply, reply_size);
+	} else if (os_strcmp(buf, "TRACE_DUMP") == 0 ||
+		   os_strncmp(buf, "TRACE_DUMP ", 11) == 0) {
+		reply_len = trace_ring_dump(buf + 10, reply, reply_size);
 #ifdef NEED_AP_MLME
 	} else if (os_strcmp(buf, "TRACK_STA_LIST") == 0) {
 		reply_len = hostapd_ctrl_iface_track_sta_list(
@@ -2290,6 +2317,28 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 }
 
 
+/* Maximum reply length that can be requested with ALL_STA_DUMP size=<len> */
+#define ALL_STA_DUMP_MAX_REPLY_SIZE 65536
+
+static int hostapd_ctrl_iface_reply_size(const char *cmd, int reply_size)
+{
+	const char *pos;
+	int size;
+
+	if (os_strncmp(cmd, "ALL_STA_DUMP ", 13) != 0)
+		return reply_size;
+	pos = os_strstr(cmd, " size=");
+	if (pos == NULL)
+		return reply_size;
+	size = atoi(pos + 6);
+	if (size < reply_size)
+		return reply_size;
+	if (size > ALL_STA_DUMP_MAX_REPLY_SIZE)
+		return ALL_STA_DUMP_MAX_REPLY_SIZE;
+	return size;
+}
+
+
 static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 				       void *sock_ctx)
 {
@@ -2299,7 +2348,7 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 	struct sockaddr_un from;
 	socklen_t fromlen = sizeof(from);
 	char *reply;
-	const int reply_size = 4096;
+	int reply_size = 4096;
 	int reply_len;
 	int level = MSG_DEBUG;
 
@@ -2315,6 +2364,7 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 		level = MSG_EXCESSIVE;
 	wpa_hexdump_ascii(level, "RX ctrl_iface", (u8 *) buf, res);
 
+	reply_size = hostapd_ctrl_iface_reply_size(buf, reply_size);
 	reply = os_malloc(reply_size);
 	if (reply == NULL) {
 		if (sendto(sock, "FAIL\n", 5, 0, (struct sockaddr *) &from,
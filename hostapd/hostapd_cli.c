@@ -61,7 +61,8 @@ static const char *const commands_help =
 "Commands:\n"
 "   mib                  get MIB variables (dot1x, dot11, radius)\n"
 "   sta <addr>           get MIB variables for one station\n"
-"   all_sta              get MIB variables for all stations\n"
+"   all_sta [fields]     get MIB variables for all stations (optionally only\n"
+"                        the comma separated list of fields)\n"
 "   new_sta <addr>       add a new station\n"
 "   deauthenticate <addr>  deauthenticate a station\n"
 "   disassociate <addr>  disassociate a station\n"
@@ -83,6 +84,7 @@ static const char *const commands_help =
 "   wps_get_status       show current WPS status\n"
 #endif /* CONFIG_WPS */
 "   get_config           show current configuration\n"
+"   trace_dump [seq]     dump binary trace ring entries of all interfaces\n"
 "   help                 show this usage help\n"
 "   interface [ifname]   show interfaces/select interface\n"
 "   level <debug level>  change debug level\n"
@@ -703,11 +705,84 @@ static int wpa_ctrl_command_sta(struct wpa_ctrl *ctrl, char *cmd,
 }
 
 
+#define ALL_STA_DUMP_SIZE 65536
+
+/* Returns 1 if ALL_STA_DUMP is not supported by hostapd */
+static int hostapd_cli_all_sta_dump(struct wpa_ctrl *ctrl, const char *fields)
+{
+	char *buf, *pos, cursor[32], cmd[256];
+	size_t len;
+	int ret;
+
+	buf = os_malloc(ALL_STA_DUMP_SIZE);
+	if (buf == NULL)
+		return -1;
+
+	cursor[0] = '\0';
+	for (;;) {
+		ret = os_snprintf(cmd, sizeof(cmd), "ALL_STA_DUMP size=%d%s%s%s%s",
+				  ALL_STA_DUMP_SIZE,
+				  cursor[0] ? " cursor=" : "", cursor,
+				  fields ? " fields=" : "", fields ? fields : "");
+		if (os_snprintf_error(sizeof(cmd), ret)) {
+			printf("Too long ALL_STA_DUMP command.\n");
+			ret = -1;
+			break;
+		}
+
+		len = ALL_STA_DUMP_SIZE - 1;
+		ret = wpa_ctrl_request(ctrl, cmd, os_strlen(cmd), buf, &len,
+				       hostapd_cli_msg_cb);
+		if (ret == -2) {
+			printf("'%s' command timed out.\n", cmd);
+			break;
+		} else if (ret < 0) {
+			printf("'%s' command failed.\n", cmd);
+			break;
+		}
+		buf[len] = '\0';
+		if (os_strncmp(buf, "UNKNOWN COMMAND", 15) == 0) {
+			ret = 1;
+			break;
+		}
+		if (os_strncmp(buf, "FAIL", 4) == 0) {
+			ret = -1;
+			break;
+		}
+
+		/* Print the station entries without the END/MORE line */
+		if (len > 0 && buf[len - 1] == '\n')
+			buf[--len] = '\0';
+		pos = os_strrchr(buf, '\n');
+		pos = pos ? pos + 1 : buf;
+		printf("%.*s", (int) (pos - buf), buf);
+
+		if (os_strncmp(pos, "MORE ", 5) != 0)
+			break;
+		os_strlcpy(cursor, pos + 5, sizeof(cursor));
+	}
+
+	os_free(buf);
+	return ret;
+}
+
+
 static int hostapd_cli_cmd_all_sta(struct wpa_ctrl *ctrl, int argc,
 				   char *argv[])
 {
 	char addr[32], cmd[64];
+	int ret;
 
+	if (ctrl_conn == NULL) {
+		printf("Not connected to hostapd - command dropped.\n");
+		return -1;
+	}
+
+	ret = hostapd_cli_all_sta_dump(ctrl, argc > 0 ? argv[0] : NULL);
+	if (ret != 1)
+		return ret;
+
+	/* Older hostapd without ALL_STA_DUMP */
 	if (wpa_ctrl_command_sta(ctrl, "STA-FIRST", addr, sizeof(addr)))
 		return 0;
 	do {
@@ -1068,6 +1143,23 @@ static int hostapd_cli_cmd_log_level(struct wpa_ctrl *ctrl, int argc,
 }
 
 
+static int hostapd_cli_cmd_trace_dump(struct wpa_ctrl *ctrl, int argc,
+				      char *argv[])
+{
+	char cmd[64];
+	int res;
+
+	res = os_snprintf(cmd, sizeof(cmd), "TRACE_DUMP%s%s",
+			  argc >= 1 ? " " : "",
+			  argc >= 1 ? argv[0] : "");
+	if (os_snprintf_error(sizeof(cmd), res)) {
+		printf("Too long option\n");
+		return -1;
+	}
+	return wpa_ctrl_command(ctrl, cmd);
+}
+
+
 struct hostapd_cli_cmd {
 	const char *cmd;
 	int (*handler)(struct wpa_ctrl *ctrl, int argc, char *argv[]);
@@ -1126,6 +1218,7 @@ static const struct hostapd_cli_cmd hostapd_cli_commands[] = {
 	{ "disable", hostapd_cli_cmd_disable },
 	{ "erp_flush", hostapd_cli_cmd_erp_flush },
 	{ "log_level", hostapd_cli_cmd_log_level },
+	{ "trace_dump", hostapd_cli_cmd_trace_dump },
 	{ NULL, NULL }
 };
 
@@ -18,6 +18,7 @@
 #include "crypto/random.h"
 #include "crypto/tls.h"
 #include "common/version.h"
+#include "common/sae.h"
 #include "drivers/driver.h"
 #include "eap_server/eap.h"
 #include "eap_server/tncs.h"
@@ -372,6 +373,10 @@ static void hostapd_global_deinit(const char *pid_file)
 	tncs_global_deinit();
 #endif /* EAP_SERVER_TNC */
 
+#ifdef CONFIG_SAE
+	sae_pwe_cache_set_size(0);
+#endif /* CONFIG_SAE */
+
 	random_deinit();
 
 	eloop_destroy();
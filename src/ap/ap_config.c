@@ -70,6 +70,7 @@ void hostapd_config_defaults_bss(struct hostapd_bss_config *bss)
 	bss->eapol_version = EAPOL_VERSION;
 
 	bss->max_listen_interval = 65535;
+	bss->pmksa_cache_file_interval = 60;
 
 	bss->pwd_group = 19; /* ECC: GF(p=256) */
 
@@ -209,6 +210,113 @@ int hostapd_mac_comp_empty(const void *a)
 }
 
 
+struct hostapd_wpa_psk_pending {
+	const char **passphrase;
+	struct hostapd_wpa_psk **psk;
+	size_t num;
+};
+
+
+static int hostapd_wpa_psk_pending_add(struct hostapd_wpa_psk_pending *pending,
+				       const char *passphrase,
+				       struct hostapd_wpa_psk *psk)
+{
+	const char **n_passphrase;
+	struct hostapd_wpa_psk **n_psk;
+	char *pw;
+
+	n_passphrase = os_realloc_array(pending->passphrase, pending->num + 1,
+					sizeof(*n_passphrase));
+	if (n_passphrase == NULL)
+		return -1;
+	pending->passphrase = n_passphrase;
+	n_psk = os_realloc_array(pending->psk, pending->num + 1,
+				 sizeof(*n_psk));
+	if (n_psk == NULL)
+		return -1;
+	pending->psk = n_psk;
+	pw = os_strdup(passphrase);
+	if (pw == NULL)
+		return -1;
+
+	pending->passphrase[pending->num] = pw;
+	pending->psk[pending->num] = psk;
+	pending->num++;
+	return 0;
+}
+
+
+/*
+ * Derive the PSKs for all passphrases from a wpa_psk_file with a single
+ * pbkdf2_sha1_multi() call, which is considerably faster than deriving them
+ * one at a time.
+ */
+static int hostapd_wpa_psk_pending_derive(
+	struct hostapd_wpa_psk_pending *pending, struct hostapd_ssid *ssid)
+{
+	const u8 **ssids;
+	size_t *ssid_lens, i;
+	u8 **bufs;
+	int ret = -1;
+
+	ssids = os_calloc(pending->num, sizeof(*ssids));
+	ssid_lens = os_calloc(pending->num, sizeof(*ssid_lens));
+	bufs = os_calloc(pending->num, sizeof(*bufs));
+	if (ssids == NULL || ssid_lens == NULL || bufs == NULL)
+		goto out;
+
+	for (i = 0; i < pending->num; i++) {
+		ssids[i] = ssid->ssid;
+		ssid_lens[i] = ssid->ssid_len;
+		bufs[i] = pending->psk[i]->psk;
+	}
+	wpa_printf(MSG_DEBUG, "Deriving %u PSKs from passphrases",
+		   (unsigned int) pending->num);
+	ret = pbkdf2_sha1_multi(pending->num, pending->passphrase, ssids,
+				ssid_lens, 4096, bufs, PMK_LEN);
+out:
+	os_free(ssids);
+	os_free(ssid_lens);
+	os_free(bufs);
+	return ret;
+}
+
+
+/*
+ * Remove the PSK entries whose keys could not be derived so that no entry with
+ * an all-zero PSK is left on the list.
+ */
+static void hostapd_wpa_psk_pending_drop(
+	struct hostapd_wpa_psk_pending *pending, struct hostapd_ssid *ssid)
+{
+	struct hostapd_wpa_psk **pos, *psk;
+	size_t i;
+
+	for (i = 0; i < pending->num; i++) {
+		for (pos = &ssid->wpa_psk; *pos; pos = &(*pos)->next) {
+			if (*pos != pending->psk[i])
+				continue;
+			psk = *pos;
+			*pos = psk->next;
+			bin_clear_free(psk, sizeof(*psk));
+			break;
+		}
+	}
+}
+
+
+static void hostapd_wpa_psk_pending_free(
+	struct hostapd_wpa_psk_pending *pending)
+{
+	size_t i;
+
+	for (i = 0; i < pending->num; i++)
+		str_clear_free((char *) pending->passphrase[i]);
+	os_free(pending->passphrase);
+	os_free(pending->psk);
+}
+
+
 static int hostapd_config_read_wpa_psk(const char *fname,
 				       struct hostapd_ssid *ssid)
 {
@@ -217,6 +325,7 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 	int line = 0, ret = 0, len, ok;
 	u8 addr[ETH_ALEN];
 	struct hostapd_wpa_psk *psk;
+	struct hostapd_wpa_psk_pending pending;
 
 	if (!fname)
 		return 0;
@@ -227,6 +336,8 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 		return -1;
 	}
 
+	os_memset(&pending, 0, sizeof(pending));
+
 	while (fgets(buf, sizeof(buf), f)) {
 		line++;
 
@@ -276,8 +387,14 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 		if (len == 64 && hexstr2bin(pos, psk->psk, PMK_LEN) == 0)
 			ok = 1;
 		else if (len >= 8 && len < 64) {
-			pbkdf2_sha1(pos, ssid->ssid, ssid->ssid_len,
-				    4096, psk->psk, PMK_LEN);
+			if (hostapd_wpa_psk_pending_add(&pending, pos,
+							psk) < 0) {
+				wpa_printf(MSG_ERROR,
+					   "WPA PSK allocation failed");
+				os_free(psk);
+				ret = -1;
+				break;
+			}
 			ok = 1;
 		}
 		if (!ok) {
@@ -294,6 +411,18 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 
 	fclose(f);
 
+	/*
+	 * The entries from the earlier lines are already on the list, so
+	 * derive their keys even if a later line was invalid.
+	 */
+	if (pending.num &&
+	    hostapd_wpa_psk_pending_derive(&pending, ssid) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to derive PSKs for '%s'", fname);
+		hostapd_wpa_psk_pending_drop(&pending, ssid);
+		ret = -1;
+	}
+	hostapd_wpa_psk_pending_free(&pending);
+
 	return ret;
 }
 
@@ -465,7 +594,10 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	hostapd_config_free_radius_attr(conf->radius_auth_req_attr);
 	hostapd_config_free_radius_attr(conf->radius_acct_req_attr);
 	os_free(conf->rsn_preauth_interfaces);
+	os_free(conf->pmksa_cache_shared);
+	os_free(conf->pmksa_cache_file);
 	os_free(conf->ctrl_interface);
+	os_free(conf->status_page);
 	os_free(conf->ca_cert);
 	os_free(conf->server_cert);
 	os_free(conf->private_key);
@@ -588,6 +720,8 @@ void hostapd_config_free_bss(struct hostapd_bss_config *conf)
 	os_free(conf->no_probe_resp_if_seen_on);
 	os_free(conf->no_auth_if_seen_on);
 
+	os_memset(conf->pmksa_cache_file_key, 0,
+		  sizeof(conf->pmksa_cache_file_key));
 	os_free(conf);
 }
 
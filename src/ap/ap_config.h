@@ -334,6 +334,8 @@ struct hostapd_bss_config {
 #endif /* CONFIG_NATIVE_WINDOWS */
 	int ctrl_interface_gid_set;//setting group id of control interface ==>Yajun
 
+	char *status_page; /* path of the memory-mapped status page file */
+
 	char *ca_cert;
 	char *server_cert;
 	char *private_key;
@@ -386,6 +388,12 @@ struct hostapd_bss_config {
 
 	int disable_pmksa_caching;
 	int okc; /* Opportunistic Key Caching */
+	unsigned int pmksa_cache_max_entries;
+	char *pmksa_cache_shared;
+	char *pmksa_cache_file;
+	u8 pmksa_cache_file_key[32];
+	size_t pmksa_cache_file_key_len;
+	unsigned int pmksa_cache_file_interval;
 
 	int wps_state;
 #ifdef CONFIG_WPS
@@ -552,6 +560,7 @@ struct hostapd_bss_config {
 
 	unsigned int sae_anti_clogging_threshold;
 	int *sae_groups;
+	unsigned int sae_pwe_cache_size;
 
 	char *wowlan_triggers; /* Wake-on-WLAN triggers */
 
@@ -236,6 +236,160 @@ int hostapd_ctrl_iface_sta_next(struct hostapd_data *hapd, const char *txtaddr,
 }
 
 
+/* Room left at the end of an ALL_STA_DUMP reply for the END/MORE line */
+#define ALL_STA_DUMP_TRAILER_LEN 32
+
+
+static int all_sta_dump_field_match(const char *fields, const char *line,
+				    size_t len)
+{
+	const char *pos, *end;
+
+	pos = os_strchr(line, '=');
+	if (pos == NULL || (size_t) (pos - line) >= len)
+		return 0;
+	len = pos - line;
+
+	pos = fields;
+	while (*pos) {
+		end = os_strchr(pos, ',');
+		if (end == NULL)
+			end = pos + os_strlen(pos);
+		if ((size_t) (end - pos) == len && os_strncmp(pos, line, len) == 0)
+			return 1;
+		if (*end == '\0')
+			break;
+		pos = end + 1;
+	}
+
+	return 0;
+}
+
+
+static int all_sta_dump_filter(const char *fields, char *rec, int len)
+{
+	char *pos, *end, *out;
+
+	/* Always keep the first line, i.e., the station address */
+	pos = os_strchr(rec, '\n');
+	if (pos == NULL)
+		return len;
+	pos++;
+	out = pos;
+
+	while (pos < rec + len) {
+		end = os_strchr(pos, '\n');
+		if (end == NULL)
+			end = rec + len;
+		else
+			end++;
+		if (all_sta_dump_field_match(fields, pos, end - pos)) {
+			os_memmove(out, pos, end - pos);
+			out += end - pos;
+		}
+		pos = end;
+	}
+
+	return out - rec;
+}
+
+
+/**
+ * hostapd_ctrl_iface_all_sta_dump - Dump information of all stations
+ * @hapd: Pointer to BSS data
+ * @cmd: Command parameters: [cursor=<addr>] [fields=<name>[,<name>...]]
+ *	[size=<max reply length>]
+ * @buf: Buffer for the reply
+ * @buflen: Length of the buffer, i.e., the maximum reply length
+ * Returns: Length of the reply or -1 on failure
+ *
+ * The reply contains the same per-station information as the STA command for
+ * as many stations as fit into the buffer starting from the station indicated
+ * by cursor (or the first station). If fields is specified, only the listed
+ * fields are included for each station. The last line of the reply is either
+ * "END" if all stations were included or "MORE <addr>" where addr is the
+ * cursor to use in the next ALL_STA_DUMP command to fetch the remaining
+ * stations.
+ */
+int hostapd_ctrl_iface_all_sta_dump(struct hostapd_data *hapd,
+				    const char *cmd, char *buf, size_t buflen)
+{
+	struct sta_info *sta;
+	const char *fields = NULL;
+	char *fields_buf = NULL, *pos, *end, *rec;
+	size_t rec_len;
+	int len, ret;
+
+	if (buflen < 2 * ALL_STA_DUMP_TRAILER_LEN)
+		return -1;
+
+	sta = hapd->sta_list;
+	pos = os_strstr(cmd, "cursor=");
+	if (pos) {
+		u8 addr[ETH_ALEN];
+
+		if (hwaddr_aton(pos + 7, addr))
+			return -1;
+		sta = ap_get_sta(hapd, addr);
+		if (sta == NULL)
+			return -1;
+	}
+
+	pos = os_strstr(cmd, "fields=");
+	if (pos) {
+		pos += 7;
+		end = os_strchr(pos, ' ');
+		if (end == NULL)
+			end = pos + os_strlen(pos);
+		fields_buf = dup_binstr(pos, end - pos);
+		if (fields_buf == NULL)
+			return -1;
+		fields = fields_buf;
+	}
+
+	rec_len = buflen - ALL_STA_DUMP_TRAILER_LEN;
+	if (rec_len > 4096)
+		rec_len = 4096;
+	rec = os_malloc(rec_len + 1);
+	if (rec == NULL) {
+		os_free(fields_buf);
+		return -1;
+	}
+
+	pos = buf;
+	end = buf + buflen - ALL_STA_DUMP_TRAILER_LEN;
+	for (; sta; sta = sta->next) {
+		len = hostapd_ctrl_iface_sta_mib(hapd, sta, rec, rec_len);
+		if (len <= 0)
+			continue;
+		rec[len] = '\0';
+		if (fields)
+			len = all_sta_dump_filter(fields, rec, len);
+		if (len > end - pos && pos > buf)
+			break;
+		if (len > end - pos)
+			len = end - pos;
+		os_memcpy(pos, rec, len);
+		pos += len;
+	}
+
+	os_free(rec);
+	os_free(fields_buf);
+
+	end = buf + buflen;
+	if (sta)
+		ret = os_snprintf(pos, end - pos, "MORE " MACSTR "\n",
+				  MAC2STR(sta->addr));
+	else
+		ret = os_snprintf(pos, end - pos, "END\n");
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	return pos - buf;
+}
+
+
 #ifdef CONFIG_P2P_MANAGER
 static int p2p_manager_disconnect(struct hostapd_data *hapd, u16 stype,
 				  u8 minor_reason_code, const u8 *addr)
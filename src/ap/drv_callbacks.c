@@ -458,6 +458,7 @@ void hostapd_event_ch_switch(struct hostapd_data *hapd, int freq, int ht,
 #ifdef NEED_AP_MLME
 	int channel, chwidth, is_dfs;
 	u8 seg0_idx = 0, seg1_idx = 0;
+	size_t i;
 
 	hostapd_logger(hapd, NULL, HOSTAPD_MODULE_IEEE80211,
 		       HOSTAPD_LEVEL_INFO,
@@ -466,6 +467,8 @@ void hostapd_event_ch_switch(struct hostapd_data *hapd, int freq, int ht,
 		       cf1, cf2);
 
 	hapd->iface->freq = freq;
+	for (i = 0; i < hapd->iface->num_bss; i++)
+		hostapd_status_page_update(hapd->iface->bss[i]);
 
 	channel = hostapd_hw_get_channel(hapd, freq);
 	if (!channel) {
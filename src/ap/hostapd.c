@@ -10,9 +10,11 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/status_page.h"
 #include "common/ieee802_11_defs.h"
 #include "common/wpa_ctrl.h"
 #include "common/hw_features_common.h"
+#include "common/sae.h"
 #include "radius/radius_client.h"
 #include "radius/radius_das.h"
 #include "eap_server/tncs.h"
@@ -271,6 +273,9 @@ static void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	hapd->p2p_probe_resp_ie = NULL;
 #endif /* CONFIG_P2P */
 
+	status_page_deinit(hapd->status_page);
+	hapd->status_page = NULL;
+
 	if (!hapd->started) {
 		wpa_printf(MSG_ERROR, "%s: Interface %s wasn't started",
 			   __func__, hapd->conf->iface);
@@ -868,6 +873,30 @@ hostapd_das_disconnect(void *ctx, struct radius_das_attrs *attr)
 #endif /* CONFIG_NO_RADIUS */
 
 
+#ifdef CONFIG_SAE
+static void hostapd_sae_pwe_cache_update(struct hostapd_data *hapd)
+{
+	struct hapd_interfaces *interfaces = hapd->iface->interfaces;
+	unsigned int size = hapd->conf->sae_pwe_cache_size;
+	size_t i, j;
+
+	/* The PWE cache is process-wide; use the largest configured size */
+	for (i = 0; interfaces && i < interfaces->count; i++) {
+		struct hostapd_iface *iface = interfaces->iface[i];
+
+		for (j = 0; j < iface->num_bss; j++) {
+			struct hostapd_bss_config *conf = iface->bss[j]->conf;
+
+			if (conf && conf->sae_pwe_cache_size > size)
+				size = conf->sae_pwe_cache_size;
+		}
+	}
+
+	sae_pwe_cache_set_size(size);
+}
+#endif /* CONFIG_SAE */
+
+
 /**
  * hostapd_setup_bss - Per-BSS setup (initialization)
  * @hapd: Pointer to BSS data
@@ -905,6 +934,10 @@ static int hostapd_setup_bss(struct hostapd_data *hapd, int first)
 	}
 	hapd->started = 1;
 
+#ifdef CONFIG_SAE
+	hostapd_sae_pwe_cache_update(hapd);
+#endif /* CONFIG_SAE */
+
 	if (!first || first == -1) {
 		if (hostapd_mac_comp_empty(conf->bssid) == 0) {
 			/* Allocate the next available BSSID. */
@@ -1115,6 +1148,22 @@ static int hostapd_setup_bss(struct hostapd_data *hapd, int first)
 		return -1;
 	}
 
+	if (conf->status_page) {
+		hapd->status_page = status_page_init(conf->status_page,
+						     STATUS_PAGE_MODE_AP);
+		if (!hapd->status_page) {
+#ifdef CONFIG_STATUS_PAGE
+			wpa_printf(MSG_ERROR,
+				   "Failed to initialize status page");
+#else /* CONFIG_STATUS_PAGE */
+			wpa_printf(MSG_ERROR,
+				   "status_page requires CONFIG_STATUS_PAGE=y build option");
+#endif /* CONFIG_STATUS_PAGE */
+			return -1;
+		}
+		hostapd_status_page_update(hapd);
+	}
+
 	if (!conf->start_disabled && ieee802_11_set_beacon(hapd) < 0)
 		return -1;
 
@@ -2712,10 +2761,61 @@ const char * hostapd_state_text(enum hostapd_iface_state s)
 
 void hostapd_set_state(struct hostapd_iface *iface, enum hostapd_iface_state s)
 {
+	size_t i;
+
 	wpa_printf(MSG_INFO, "%s: interface state %s->%s",
 		   iface->conf->bss[0]->iface, hostapd_state_text(iface->state),
 		   hostapd_state_text(s));
 	iface->state = s;
+
+	for (i = 0; i < iface->num_bss; i++)
+		hostapd_status_page_update(iface->bss[i]);
+}
+
+
+/**
+ * hostapd_status_page_update - Update the memory-mapped status page
+ * @hapd: Pointer to BSS data
+ *
+ * Publishes the interface state and station counts of the BSS in the
+ * status_page file if one is configured.
+ */
+void hostapd_status_page_update(struct hostapd_data *hapd)
+{
+#ifdef CONFIG_STATUS_PAGE
+	struct status_page_data *page;
+
+	if (!hapd->status_page)
+		return;
+
+	page = status_page_begin(hapd->status_page);
+	page->state = hapd->iface->state;
+	page->freq = hapd->iface->freq;
+	os_memcpy(page->bssid, hapd->own_addr, ETH_ALEN);
+	page->ssid_len = hapd->conf->ssid.ssid_len;
+	os_memcpy(page->ssid, hapd->conf->ssid.ssid, page->ssid_len);
+	page->num_sta = hapd->num_sta;
+	page->num_sta_authorized = hapd->num_sta_authorized;
+	status_page_end(hapd->status_page);
+#endif /* CONFIG_STATUS_PAGE */
+}
+
+
+void hostapd_status_page_key(struct hostapd_data *hapd, int group)
+{
+#ifdef CONFIG_STATUS_PAGE
+	struct status_page_data *page;
+
+	if (!hapd->status_page)
+		return;
+
+	page = status_page_begin(hapd->status_page);
+	if (group)
+		page->group_keys++;
+	else
+		page->pairwise_keys++;
+	status_page_end(hapd->status_page);
+#endif /* CONFIG_STATUS_PAGE */
 }
 
 
@@ -115,6 +115,7 @@ struct hostapd_data {
 	u8 own_addr[ETH_ALEN];
 
 	int num_sta; /* number of entries in sta_list */
+	int num_sta_authorized; /* number of STAs with WLAN_STA_AUTHORIZED */
 	struct sta_info *sta_list; /* STA info list head */
 #define STA_HASH_SIZE 256
 #define STA_HASH(sta) (sta[5])
@@ -175,6 +176,8 @@ struct hostapd_data {
 	struct l2_packet_data *l2;
 	struct wps_context *wps;
 
+	struct status_page *status_page;
+
 	int beacon_set_done;
 	struct wpabuf *wps_beacon_ie;
 	struct wpabuf *wps_probe_resp_ie;
@@ -464,6 +467,8 @@ void hostapd_channel_list_updated(struct hostapd_iface *iface, int initiator);
 void hostapd_set_state(struct hostapd_iface *iface, enum hostapd_iface_state s);
 const char * hostapd_state_text(enum hostapd_iface_state s);
 int hostapd_csa_in_progress(struct hostapd_iface *iface);
+void hostapd_status_page_update(struct hostapd_data *hapd);
+void hostapd_status_page_key(struct hostapd_data *hapd, int group);
 int hostapd_switch_channel(struct hostapd_data *hapd,
 			   struct csa_settings *settings);
 void
@@ -12,6 +12,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/trace_ring.h"
 #include "crypto/crypto.h"
 #include "crypto/sha256.h"
 #include "crypto/random.h"
@@ -2307,6 +2308,9 @@ int ieee802_11_mgmt(struct hostapd_data *hapd, const u8 *buf, size_t len,
 		return 1;
 	}
 
+	if (stype != WLAN_FC_STYPE_PROBE_REQ)
+		trace_ring_mgmt(TRACE_RING_MGMT_RX, buf, len, 0);
+
 	broadcast = mgmt->bssid[0] == 0xff && mgmt->bssid[1] == 0xff &&
 		mgmt->bssid[2] == 0xff && mgmt->bssid[3] == 0xff &&
 		mgmt->bssid[4] == 0xff && mgmt->bssid[5] == 0xff;
@@ -2659,6 +2663,9 @@ void ieee802_11_mgmt_cb(struct hostapd_data *hapd, const u8 *buf, size_t len,
 	}
 #endif /* CONFIG_TESTING_OPTIONS */
 
+	if (stype != WLAN_FC_STYPE_PROBE_RESP)
+		trace_ring_mgmt(TRACE_RING_MGMT_TX_STATUS, buf, len, ok);
+
 	switch (stype) {
 	case WLAN_FC_STYPE_AUTH:
 		wpa_printf(MSG_DEBUG, "mgmt::auth cb");
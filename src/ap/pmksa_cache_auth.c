@@ -7,26 +7,49 @@
  */
 
 #include "utils/includes.h"
+#ifdef CONFIG_PMKSA_CACHE_FILE
+#include <fcntl.h>
+#endif /* CONFIG_PMKSA_CACHE_FILE */
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/list.h"
 #include "eapol_auth/eapol_auth_sm.h"
 #include "eapol_auth/eapol_auth_sm_i.h"
 #include "radius/radius_das.h"
+#include "crypto/aes_wrap.h"
 #include "sta_info.h"
 #include "ap_config.h"
 #include "pmksa_cache_auth.h"
+#include "pmksa_cache_shared.h"
 
 
-static const int pmksa_cache_max_entries = 1024;
 static const int dot11RSNAConfigPMKLifetime = 43200;
 
 struct rsn_pmksa_cache {
-#define PMKID_HASH_SIZE 128
-#define PMKID_HASH(pmkid) (unsigned int) ((pmkid)[0] & 0x7f)
-	struct rsn_pmksa_cache_entry *pmkid[PMKID_HASH_SIZE];
-	struct rsn_pmksa_cache_entry *pmksa;
-	int pmksa_count;
+#define PMKSA_HASH_SIZE 1024
+	/* Hash tables keyed on the full PMKID and on the SPA */
+	struct rsn_pmksa_cache_entry *pmkid[PMKSA_HASH_SIZE];
+	struct rsn_pmksa_cache_entry *spa[PMKSA_HASH_SIZE];
+	/* All entries in least recently used order (most recent first) */
+	struct dl_list lru;
+	/* Binary min-heap of entries ordered by expiration time */
+	struct rsn_pmksa_cache_entry **heap;
+	size_t heap_size;
+	unsigned int pmksa_count;
+	unsigned int max_entries;
+	struct rsn_pmksa_cache_stats stats;
+	int dirty; /* entries changed since the last snapshot */
+#ifdef CONFIG_PMKSA_CACHE_FILE
+	char *file;
+	u8 file_key[32];
+	size_t file_key_len;
+	unsigned int file_interval;
+	u8 aa[ETH_ALEN];
+#endif /* CONFIG_PMKSA_CACHE_FILE */
+#ifdef CONFIG_PMKSA_CACHE_SHARED
+	struct pmksa_cache_shared *shared;
+#endif /* CONFIG_PMKSA_CACHE_SHARED */
 
 	void (*free_cb)(struct rsn_pmksa_cache_entry *entry, void *ctx);
 	void *ctx;
@@ -36,6 +59,118 @@ struct rsn_pmksa_cache {
 static void pmksa_cache_set_expiration(struct rsn_pmksa_cache *pmksa);
 
 
+static unsigned int pmksa_hash(const u8 *data, size_t len)
+{
+	unsigned int hash = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		hash = hash * 31 + data[i];
+	return (hash ^ (hash >> 10) ^ (hash >> 20)) & (PMKSA_HASH_SIZE - 1);
+}
+
+
+#define PMKID_HASH(pmkid) pmksa_hash((pmkid), PMKID_LEN)
+#define SPA_HASH(spa) pmksa_hash((spa), ETH_ALEN)
+
+
+static void pmksa_heap_swap(struct rsn_pmksa_cache *pmksa, size_t a, size_t b)
+{
+	struct rsn_pmksa_cache_entry *tmp = pmksa->heap[a];
+
+	pmksa->heap[a] = pmksa->heap[b];
+	pmksa->heap[b] = tmp;
+	pmksa->heap[a]->heap_idx = a;
+	pmksa->heap[b]->heap_idx = b;
+}
+
+
+static void pmksa_heap_up(struct rsn_pmksa_cache *pmksa, size_t idx)
+{
+	while (idx > 0) {
+		size_t parent = (idx - 1) / 2;
+
+		if (pmksa->heap[parent]->expiration <=
+		    pmksa->heap[idx]->expiration)
+			break;
+		pmksa_heap_swap(pmksa, parent, idx);
+		idx = parent;
+	}
+}
+
+
+static void pmksa_heap_down(struct rsn_pmksa_cache *pmksa, size_t idx)
+{
+	for (;;) {
+		size_t left = 2 * idx + 1, right = left + 1, min = idx;
+
+		if (left < pmksa->pmksa_count &&
+		    pmksa->heap[left]->expiration <
+		    pmksa->heap[min]->expiration)
+			min = left;
+		if (right < pmksa->pmksa_count &&
+		    pmksa->heap[right]->expiration <
+		    pmksa->heap[min]->expiration)
+			min = right;
+		if (min == idx)
+			break;
+		pmksa_heap_swap(pmksa, idx, min);
+		idx = min;
+	}
+}
+
+
+static int pmksa_heap_add(struct rsn_pmksa_cache *pmksa,
+			  struct rsn_pmksa_cache_entry *entry)
+{
+	if (pmksa->pmksa_count == pmksa->heap_size) {
+		struct rsn_pmksa_cache_entry **n;
+		size_t size = pmksa->heap_size ? 2 * pmksa->heap_size : 16;
+
+		n = os_realloc_array(pmksa->heap, size, sizeof(*n));
+		if (n == NULL)
+			return -1;
+		pmksa->heap = n;
+		pmksa->heap_size = size;
+	}
+
+	entry->heap_idx = pmksa->pmksa_count;
+	pmksa->heap[entry->heap_idx] = entry;
+	pmksa->pmksa_count++;
+	pmksa_heap_up(pmksa, entry->heap_idx);
+	return 0;
+}
+
+
+static void pmksa_heap_del(struct rsn_pmksa_cache *pmksa,
+			   struct rsn_pmksa_cache_entry *entry)
+{
+	size_t idx = entry->heap_idx;
+
+	pmksa->pmksa_count--;
+	if (idx == pmksa->pmksa_count)
+		return;
+	pmksa->heap[idx] = pmksa->heap[pmksa->pmksa_count];
+	pmksa->heap[idx]->heap_idx = idx;
+	pmksa_heap_up(pmksa, idx);
+	pmksa_heap_down(pmksa, pmksa->heap[idx]->heap_idx);
+}
+
+
+static void pmksa_hash_del(struct rsn_pmksa_cache_entry **bucket,
+			   struct rsn_pmksa_cache_entry *entry, int spa)
+{
+	struct rsn_pmksa_cache_entry **pos;
+
+	for (pos = bucket; *pos; pos = spa ? &(*pos)->snext : &(*pos)->hnext) {
+		if (*pos == entry) {
+			*pos = spa ? entry->snext : entry->hnext;
+			break;
+		}
+	}
+}
+
+
 static void _pmksa_cache_free_entry(struct rsn_pmksa_cache_entry *entry)
 {
 	os_free(entry->identity);
@@ -50,42 +185,13 @@ static void _pmksa_cache_free_entry(struct rsn_pmksa_cache_entry *entry)
 void pmksa_cache_free_entry(struct rsn_pmksa_cache *pmksa,
 			    struct rsn_pmksa_cache_entry *entry)
 {
-	struct rsn_pmksa_cache_entry *pos, *prev;
-	unsigned int hash;
-
-	pmksa->pmksa_count--;
 	pmksa->free_cb(entry, pmksa->ctx);
 
-	/* unlink from hash list */
-	hash = PMKID_HASH(entry->pmkid);
-	pos = pmksa->pmkid[hash];
-	prev = NULL;
-	while (pos) {
-		if (pos == entry) {
-			if (prev != NULL)
-				prev->hnext = entry->hnext;
-			else
-				pmksa->pmkid[hash] = entry->hnext;
-			break;
-		}
-		prev = pos;
-		pos = pos->hnext;
-	}
-
-	/* unlink from entry list */
-	pos = pmksa->pmksa;
-	prev = NULL;
-	while (pos) {
-		if (pos == entry) {
-			if (prev != NULL)
-				prev->next = entry->next;
-			else
-				pmksa->pmksa = entry->next;
-			break;
-		}
-		prev = pos;
-		pos = pos->next;
-	}
+	pmksa_hash_del(&pmksa->pmkid[PMKID_HASH(entry->pmkid)], entry, 0);
+	pmksa_hash_del(&pmksa->spa[SPA_HASH(entry->spa)], entry, 1);
+	dl_list_del(&entry->lru);
+	pmksa_heap_del(pmksa, entry);
+	pmksa->dirty = 1;
 
 	_pmksa_cache_free_entry(entry);
 }
@@ -97,10 +203,11 @@ static void pmksa_cache_expire(void *eloop_ctx, void *timeout_ctx)
 	struct os_reltime now;
 
 	os_get_reltime(&now);
-	while (pmksa->pmksa && pmksa->pmksa->expiration <= now.sec) {
+	while (pmksa->pmksa_count && pmksa->heap[0]->expiration <= now.sec) {
 		wpa_printf(MSG_DEBUG, "RSN: expired PMKSA cache entry for "
-			   MACSTR, MAC2STR(pmksa->pmksa->spa));
-		pmksa_cache_free_entry(pmksa, pmksa->pmksa);
+			   MACSTR, MAC2STR(pmksa->heap[0]->spa));
+		pmksa->stats.expirations++;
+		pmksa_cache_free_entry(pmksa, pmksa->heap[0]);
 	}
 
 	pmksa_cache_set_expiration(pmksa);
@@ -113,16 +220,31 @@ static void pmksa_cache_set_expiration(struct rsn_pmksa_cache *pmksa)
 	struct os_reltime now;
 
 	eloop_cancel_timeout(pmksa_cache_expire, pmksa, NULL);
-	if (pmksa->pmksa == NULL)
+	if (pmksa->pmksa_count == 0)
 		return;
 	os_get_reltime(&now);
-	sec = pmksa->pmksa->expiration - now.sec;
+	sec = pmksa->heap[0]->expiration - now.sec;
 	if (sec < 0)
 		sec = 0;
 	eloop_register_timeout(sec + 1, 0, pmksa_cache_expire, pmksa, NULL);
 }
 
 
+static void pmksa_cache_evict_lru(struct rsn_pmksa_cache *pmksa)
+{
+	struct rsn_pmksa_cache_entry *entry;
+
+	entry = dl_list_last(&pmksa->lru, struct rsn_pmksa_cache_entry, lru);
+	if (entry == NULL)
+		return;
+	wpa_printf(MSG_DEBUG, "RSN: removed the least recently used PMKSA "
+		   "cache entry (for " MACSTR ") to make room for new one",
+		   MAC2STR(entry->spa));
+	pmksa->stats.evictions++;
+	pmksa_cache_free_entry(pmksa, entry);
+}
+
+
 static void pmksa_cache_from_eapol_data(struct rsn_pmksa_cache_entry *entry,
 					struct eapol_state_machine *eapol)
 {
@@ -193,39 +315,35 @@ void pmksa_cache_to_eapol_data(struct rsn_pmksa_cache_entry *entry,
 }
 
 
-static void pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
-				   struct rsn_pmksa_cache_entry *entry)
+static int pmksa_cache_link_entry(struct rsn_pmksa_cache *pmksa,
+				  struct rsn_pmksa_cache_entry *entry)
 {
-	struct rsn_pmksa_cache_entry *pos, *prev;
-	int hash;
+	unsigned int hash;
 
-	/* Add the new entry; order by expiration time */
-	pos = pmksa->pmksa;
-	prev = NULL;
-	while (pos) {
-		if (pos->expiration > entry->expiration)
-			break;
-		prev = pos;
-		pos = pos->next;
-	}
-	if (prev == NULL) {
-		entry->next = pmksa->pmksa;
-		pmksa->pmksa = entry;
-	} else {
-		entry->next = prev->next;
-		prev->next = entry;
-	}
+	while (pmksa->pmksa_count >= pmksa->max_entries &&
+	       pmksa->pmksa_count > 0)
+		pmksa_cache_evict_lru(pmksa);
+
+	if (pmksa_heap_add(pmksa, entry) < 0)
+		return -1;
 
 	hash = PMKID_HASH(entry->pmkid);
 	entry->hnext = pmksa->pmkid[hash];
 	pmksa->pmkid[hash] = entry;
 
-	pmksa->pmksa_count++;
-	if (prev == NULL)
+	hash = SPA_HASH(entry->spa);
+	entry->snext = pmksa->spa[hash];
+	pmksa->spa[hash] = entry;
+
+	dl_list_add(&pmksa->lru, &entry->lru);
+	pmksa->dirty = 1;
+
+	if (entry->heap_idx == 0)
 		pmksa_cache_set_expiration(pmksa);
 	wpa_printf(MSG_DEBUG, "RSN: added PMKSA cache entry for " MACSTR,
 		   MAC2STR(entry->spa));
 	wpa_hexdump(MSG_DEBUG, "RSN: added PMKID", entry->pmkid, PMKID_LEN);
+	return 0;
 }
 
 
@@ -292,15 +410,15 @@ pmksa_cache_auth_add(struct rsn_pmksa_cache *pmksa,
 	if (pos)
 		pmksa_cache_free_entry(pmksa, pos);
 
-	if (pmksa->pmksa_count >= pmksa_cache_max_entries && pmksa->pmksa) {
-		/* Remove the oldest entry to make room for the new entry */
-		wpa_printf(MSG_DEBUG, "RSN: removed the oldest PMKSA cache "
-			   "entry (for " MACSTR ") to make room for new one",
-			   MAC2STR(pmksa->pmksa->spa));
-		pmksa_cache_free_entry(pmksa, pmksa->pmksa);
+	if (pmksa_cache_link_entry(pmksa, entry) < 0) {
+		_pmksa_cache_free_entry(entry);
+		return NULL;
 	}
 
-	pmksa_cache_link_entry(pmksa, entry);
+#ifdef CONFIG_PMKSA_CACHE_SHARED
+	if (pmksa->shared)
+		pmksa_cache_shared_store(pmksa->shared, entry);
+#endif /* CONFIG_PMKSA_CACHE_SHARED */
 
 	return entry;
 }
@@ -340,35 +458,342 @@ pmksa_cache_add_okc(struct rsn_pmksa_cache *pmksa,
 	entry->vlan_id = old_entry->vlan_id;
 	entry->opportunistic = 1;
 
-	pmksa_cache_link_entry(pmksa, entry);
+	if (pmksa_cache_link_entry(pmksa, entry) < 0) {
+		_pmksa_cache_free_entry(entry);
+		return NULL;
+	}
 
 	return entry;
 }
 
 
+#ifdef CONFIG_PMKSA_CACHE_FILE
+
+/*
+ * PMKSA cache snapshot file format: "HPMK" followed by the snapshot data
+ * encrypted and integrity protected with AES key wrap (RFC 3394) using the
+ * configured key. The snapshot data is:
+ * AA (6) | version (1) | reserved (1) | number of entries (4) |
+ * time of the snapshot in seconds since the Epoch (8) | entries | zero padding
+ * Each entry is:
+ * SPA (6) | PMKID (16) | PMK length (1) | PMK | AKM (4) |
+ * remaining lifetime in seconds (4) | VLAN ID (4) | EAP type (1) |
+ * Acct-Multi-Session-Id (8) | identity length (2) | identity |
+ * CUI length (2) | CUI
+ */
+#define PMKSA_FILE_MAGIC "HPMK"
+#define PMKSA_FILE_VERSION 1
+#define PMKSA_FILE_HDR_LEN 20
+
+static struct wpabuf * pmksa_cache_file_build(struct rsn_pmksa_cache *pmksa)
+{
+	struct rsn_pmksa_cache_entry *entry;
+	struct wpabuf *plain, *buf;
+	struct os_reltime now;
+	struct os_time t;
+	size_t cui_len;
+	u32 count = 0;
+
+	plain = wpabuf_alloc(PMKSA_FILE_HDR_LEN + 8 + pmksa->pmksa_count * 120);
+	if (plain == NULL)
+		return NULL;
+
+	os_get_reltime(&now);
+	os_get_time(&t);
+	wpabuf_put_data(plain, pmksa->aa, ETH_ALEN);
+	wpabuf_put_u8(plain, PMKSA_FILE_VERSION);
+	wpabuf_put_u8(plain, 0);
+	wpabuf_put_be32(plain, 0); /* number of entries; filled in below */
+	WPA_PUT_BE64(wpabuf_put(plain, 8), t.sec);
+
+	dl_list_for_each(entry, &pmksa->lru, struct rsn_pmksa_cache_entry,
+			 lru) {
+		if (entry->expiration <= now.sec ||
+		    entry->identity_len > 0xffff)
+			continue;
+		cui_len = entry->cui ? wpabuf_len(entry->cui) : 0;
+		if (cui_len > 0xffff)
+			continue;
+		if (wpabuf_resize(&plain, 54 + entry->pmk_len +
+				  entry->identity_len + cui_len + 8) < 0) {
+			wpabuf_clear_free(plain);
+			return NULL;
+		}
+		wpabuf_put_data(plain, entry->spa, ETH_ALEN);
+		wpabuf_put_data(plain, entry->pmkid, PMKID_LEN);
+		wpabuf_put_u8(plain, entry->pmk_len);
+		wpabuf_put_data(plain, entry->pmk, entry->pmk_len);
+		wpabuf_put_be32(plain, entry->akmp);
+		wpabuf_put_be32(plain, entry->expiration - now.sec);
+		wpabuf_put_be32(plain, entry->vlan_id);
+		wpabuf_put_u8(plain, entry->eap_type_authsrv);
+		wpabuf_put_be32(plain, entry->acct_multi_session_id_hi);
+		wpabuf_put_be32(plain, entry->acct_multi_session_id_lo);
+		wpabuf_put_be16(plain, entry->identity_len);
+		if (entry->identity_len)
+			wpabuf_put_data(plain, entry->identity,
+					entry->identity_len);
+		wpabuf_put_be16(plain, cui_len);
+		if (cui_len)
+			wpabuf_put_buf(plain, entry->cui);
+		count++;
+	}
+	WPA_PUT_BE32(wpabuf_mhead_u8(plain) + 8, count);
+	while (wpabuf_len(plain) % 8)
+		wpabuf_put_u8(plain, 0);
+
+	buf = wpabuf_alloc(4 + wpabuf_len(plain) + 8);
+	if (buf == NULL) {
+		wpabuf_clear_free(plain);
+		return NULL;
+	}
+	wpabuf_put_str(buf, PMKSA_FILE_MAGIC);
+	if (aes_wrap(pmksa->file_key, pmksa->file_key_len,
+		     wpabuf_len(plain) / 8, wpabuf_head(plain),
+		     wpabuf_put(buf, wpabuf_len(plain) + 8)) < 0) {
+		wpabuf_free(buf);
+		buf = NULL;
+	}
+	wpabuf_clear_free(plain);
+
+	return buf;
+}
+
+
+static int pmksa_cache_file_parse(struct rsn_pmksa_cache *pmksa,
+				  const u8 *pos, const u8 *end)
+{
+	struct rsn_pmksa_cache_entry *entry;
+	struct os_reltime now;
+	struct os_time t;
+	os_time_t elapsed;
+	u32 count, remaining;
+	u16 len;
+	int added = 0;
+
+	if (end - pos < PMKSA_FILE_HDR_LEN ||
+	    pos[ETH_ALEN] != PMKSA_FILE_VERSION)
+		return -1;
+	if (os_memcmp(pos, pmksa->aa, ETH_ALEN) != 0) {
+		wpa_printf(MSG_DEBUG,
+			   "RSN: PMKSA cache snapshot is for another BSSID ("
+			   MACSTR ")", MAC2STR(pos));
+		return 0;
+	}
+	count = WPA_GET_BE32(pos + 8);
+	os_get_time(&t);
+	elapsed = t.sec - (os_time_t) WPA_GET_BE64(pos + 12);
+	if (elapsed < 0)
+		elapsed = 0;
+	pos += PMKSA_FILE_HDR_LEN;
+	os_get_reltime(&now);
+
+	while (count-- > 0) {
+		if (end - pos < ETH_ALEN + PMKID_LEN + 1)
+			return -1;
+		entry = os_zalloc(sizeof(*entry));
+		if (entry == NULL)
+			return -1;
+		os_memcpy(entry->spa, pos, ETH_ALEN);
+		pos += ETH_ALEN;
+		os_memcpy(entry->pmkid, pos, PMKID_LEN);
+		pos += PMKID_LEN;
+		entry->pmk_len = *pos++;
+		if (entry->pmk_len > PMK_LEN_MAX ||
+		    end - pos < (int) entry->pmk_len + 25)
+			goto fail;
+		os_memcpy(entry->pmk, pos, entry->pmk_len);
+		pos += entry->pmk_len;
+		entry->akmp = WPA_GET_BE32(pos);
+		remaining = WPA_GET_BE32(pos + 4);
+		entry->vlan_id = (int) WPA_GET_BE32(pos + 8);
+		entry->eap_type_authsrv = pos[12];
+		entry->acct_multi_session_id_hi = WPA_GET_BE32(pos + 13);
+		entry->acct_multi_session_id_lo = WPA_GET_BE32(pos + 17);
+		pos += 21;
+		len = WPA_GET_BE16(pos);
+		pos += 2;
+		if (end - pos < len + 2)
+			goto fail;
+		if (len) {
+			entry->identity = os_malloc(len);
+			if (entry->identity == NULL)
+				goto fail;
+			os_memcpy(entry->identity, pos, len);
+			entry->identity_len = len;
+			pos += len;
+		}
+		len = WPA_GET_BE16(pos);
+		pos += 2;
+		if (end - pos < len)
+			goto fail;
+		if (len) {
+			entry->cui = wpabuf_alloc_copy(pos, len);
+			if (entry->cui == NULL)
+				goto fail;
+			pos += len;
+		}
+
+		if (remaining <= elapsed || pmksa_cache_auth_get(
+			    pmksa, entry->spa, NULL)) {
+			_pmksa_cache_free_entry(entry);
+			continue;
+		}
+		entry->expiration = now.sec + remaining - elapsed;
+		if (pmksa_cache_link_entry(pmksa, entry) < 0) {
+			_pmksa_cache_free_entry(entry);
+			return -1;
+		}
+		added++;
+	}
+
+	wpa_printf(MSG_DEBUG, "RSN: Restored %d PMKSA cache entries", added);
+	return 0;
+
+fail:
+	_pmksa_cache_free_entry(entry);
+	return -1;
+}
+
+
+static int pmksa_cache_file_load(struct rsn_pmksa_cache *pmksa)
+{
+	char *buf;
+	u8 *plain;
+	size_t len;
+	int ret = -1;
+
+	buf = os_readfile(pmksa->file, &len);
+	if (buf == NULL) {
+		wpa_printf(MSG_DEBUG, "RSN: No PMKSA cache snapshot in %s",
+			   pmksa->file);
+		return 0;
+	}
+
+	if (len < 4 + PMKSA_FILE_HDR_LEN + 8 || (len - 4) % 8 ||
+	    os_memcmp(buf, PMKSA_FILE_MAGIC, 4) != 0) {
+		wpa_printf(MSG_INFO, "RSN: Invalid PMKSA cache snapshot in %s",
+			   pmksa->file);
+		goto out;
+	}
+
+	len -= 4 + 8;
+	plain = os_malloc(len);
+	if (plain == NULL)
+		goto out;
+	if (aes_unwrap(pmksa->file_key, pmksa->file_key_len, len / 8,
+		       (u8 *) buf + 4, plain) < 0) {
+		wpa_printf(MSG_INFO,
+			   "RSN: Failed to decrypt PMKSA cache snapshot in %s",
+			   pmksa->file);
+	} else if (pmksa_cache_file_parse(pmksa, plain, plain + len) < 0) {
+		wpa_printf(MSG_INFO, "RSN: Invalid PMKSA cache snapshot in %s",
+			   pmksa->file);
+	} else {
+		ret = 0;
+	}
+	bin_clear_free(plain, len);
+
+out:
+	os_free(buf);
+	return ret;
+}
+
+
+static int pmksa_cache_file_save(struct rsn_pmksa_cache *pmksa)
+{
+	struct wpabuf *buf;
+	char *tmp;
+	size_t len;
+	int fd, ret = -1;
+
+	buf = pmksa_cache_file_build(pmksa);
+	if (buf == NULL)
+		return -1;
+
+	len = os_strlen(pmksa->file) + 5;
+	tmp = os_malloc(len);
+	if (tmp == NULL) {
+		wpabuf_free(buf);
+		return -1;
+	}
+	os_snprintf(tmp, len, "%s.tmp", pmksa->file);
+
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
+		  S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		wpa_printf(MSG_INFO, "RSN: Failed to open %s: %s",
+			   tmp, strerror(errno));
+		goto out;
+	}
+	if (write(fd, wpabuf_head(buf), wpabuf_len(buf)) !=
+	    (ssize_t) wpabuf_len(buf) || fsync(fd) < 0) {
+		wpa_printf(MSG_INFO, "RSN: Failed to write %s: %s",
+			   tmp, strerror(errno));
+		close(fd);
+		unlink(tmp);
+		goto out;
+	}
+	close(fd);
+	if (rename(tmp, pmksa->file) < 0) {
+		wpa_printf(MSG_INFO, "RSN: Failed to rename %s: %s",
+			   tmp, strerror(errno));
+		unlink(tmp);
+		goto out;
+	}
+
+	pmksa->dirty = 0;
+	wpa_printf(MSG_DEBUG, "RSN: Wrote PMKSA cache snapshot to %s",
+		   pmksa->file);
+	ret = 0;
+out:
+	os_free(tmp);
+	wpabuf_free(buf);
+	return ret;
+}
+
+
+static void pmksa_cache_file_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct rsn_pmksa_cache *pmksa = eloop_ctx;
+
+	if (pmksa->dirty)
+		pmksa_cache_file_save(pmksa);
+	eloop_register_timeout(pmksa->file_interval, 0,
+			       pmksa_cache_file_timeout, pmksa, NULL);
+}
+
+#endif /* CONFIG_PMKSA_CACHE_FILE */
+
+
 /**
  * pmksa_cache_auth_deinit - Free all entries in PMKSA cache
  * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
  */
 void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa)
 {
-	struct rsn_pmksa_cache_entry *entry, *prev;
-	int i;
+	struct rsn_pmksa_cache_entry *entry, *n;
 
 	if (pmksa == NULL)
 		return;
 
-	entry = pmksa->pmksa;
-	while (entry) {
-		prev = entry;
-		entry = entry->next;
-		_pmksa_cache_free_entry(prev);
+#ifdef CONFIG_PMKSA_CACHE_FILE
+	if (pmksa->file) {
+		eloop_cancel_timeout(pmksa_cache_file_timeout, pmksa, NULL);
+		if (pmksa->dirty)
+			pmksa_cache_file_save(pmksa);
+		os_free(pmksa->file);
 	}
+#endif /* CONFIG_PMKSA_CACHE_FILE */
+
+	dl_list_for_each_safe(entry, n, &pmksa->lru,
+			      struct rsn_pmksa_cache_entry, lru)
+		_pmksa_cache_free_entry(entry);
 	eloop_cancel_timeout(pmksa_cache_expire, pmksa, NULL);
-	pmksa->pmksa_count = 0;
-	pmksa->pmksa = NULL;
-	for (i = 0; i < PMKID_HASH_SIZE; i++)
-		pmksa->pmkid[i] = NULL;
+#ifdef CONFIG_PMKSA_CACHE_SHARED
+	pmksa_cache_shared_close(pmksa->shared);
+#endif /* CONFIG_PMKSA_CACHE_SHARED */
+	os_free(pmksa->heap);
 	os_free(pmksa);
 }
 
@@ -379,6 +804,9 @@ void pmksa_cache_auth_deinit(struct rsn_pmksa_cache *pmksa)
  * @spa: Supplicant address or %NULL to match any
  * @pmkid: PMKID or %NULL to match any
  * Returns: Pointer to PMKSA cache entry or %NULL if no match was found
+ *
+ * Lookups by PMKID are accounted in the cache hit/miss counters and a matching
+ * entry is marked as the most recently used one.
  */
 struct rsn_pmksa_cache_entry *
 pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
@@ -391,15 +819,23 @@ pmksa_cache_auth_get(struct rsn_pmksa_cache *pmksa,
 		     entry = entry->hnext) {
 			if ((spa == NULL ||
 			     os_memcmp(entry->spa, spa, ETH_ALEN) == 0) &&
-			    os_memcmp(entry->pmkid, pmkid, PMKID_LEN) == 0)
+			    os_memcmp(entry->pmkid, pmkid, PMKID_LEN) == 0) {
+				pmksa->stats.hits++;
+				dl_list_del(&entry->lru);
+				dl_list_add(&pmksa->lru, &entry->lru);
 				return entry;
+			}
 		}
-	} else {
-		for (entry = pmksa->pmksa; entry; entry = entry->next) {
-			if (spa == NULL ||
-			    os_memcmp(entry->spa, spa, ETH_ALEN) == 0)
+		pmksa->stats.misses++;
+	} else if (spa) {
+		for (entry = pmksa->spa[SPA_HASH(spa)]; entry;
+		     entry = entry->snext) {
+			if (os_memcmp(entry->spa, spa, ETH_ALEN) == 0)
 				return entry;
 		}
+	} else {
+		return dl_list_first(&pmksa->lru, struct rsn_pmksa_cache_entry,
+				     lru);
 	}
 
 	return NULL;
@@ -423,15 +859,75 @@ struct rsn_pmksa_cache_entry * pmksa_cache_get_okc(
 	struct rsn_pmksa_cache_entry *entry;
 	u8 new_pmkid[PMKID_LEN];
 
-	for (entry = pmksa->pmksa; entry; entry = entry->next) {
+	for (entry = pmksa->spa[SPA_HASH(spa)]; entry; entry = entry->snext) {
 		if (os_memcmp(entry->spa, spa, ETH_ALEN) != 0)
 			continue;
 		rsn_pmkid(entry->pmk, entry->pmk_len, aa, spa, new_pmkid,
 			  wpa_key_mgmt_sha256(entry->akmp));
-		if (os_memcmp(new_pmkid, pmkid, PMKID_LEN) == 0)
+		if (os_memcmp(new_pmkid, pmkid, PMKID_LEN) == 0) {
+			pmksa->stats.okc_hits++;
 			return entry;
+		}
+	}
+	return NULL;
+}
+
+
+/**
+ * pmksa_cache_get_shared - Fetch a PMKSA cache entry from the shared store
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @aa: Authenticator address
+ * @spa: Supplicant address
+ * @pmkid: PMKID
+ * Returns: Pointer to PMKSA cache entry or %NULL if no match was found
+ *
+ * Look for a PMK that was added by another BSS or another hostapd process
+ * using the same shared store (see pmksa_cache_auth_set_shared()). A match is
+ * added to the local cache.
+ */
+struct rsn_pmksa_cache_entry *
+pmksa_cache_get_shared(struct rsn_pmksa_cache *pmksa, const u8 *aa,
+		       const u8 *spa, const u8 *pmkid)
+{
+#ifdef CONFIG_PMKSA_CACHE_SHARED
+	struct rsn_pmksa_cache_entry *entry, *pos;
+
+	if (pmksa->shared == NULL)
+		return NULL;
+
+	entry = pmksa_cache_shared_fetch(pmksa->shared, aa, spa, pmkid);
+	if (entry == NULL)
+		return NULL;
+
+	pos = pmksa_cache_auth_get(pmksa, spa, NULL);
+	if (pos)
+		pmksa_cache_free_entry(pmksa, pos);
+
+	if (pmksa_cache_link_entry(pmksa, entry) < 0) {
+		_pmksa_cache_free_entry(entry);
+		return NULL;
 	}
+	pmksa->stats.shared_hits++;
+
+	return entry;
+#else /* CONFIG_PMKSA_CACHE_SHARED */
 	return NULL;
+#endif /* CONFIG_PMKSA_CACHE_SHARED */
+}
+
+
+/**
+ * pmksa_cache_auth_remove_shared - Remove a STA from the shared store
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @spa: Supplicant address
+ */
+void pmksa_cache_auth_remove_shared(struct rsn_pmksa_cache *pmksa,
+				    const u8 *spa)
+{
+#ifdef CONFIG_PMKSA_CACHE_SHARED
+	if (pmksa->shared)
+		pmksa_cache_shared_remove(pmksa->shared, spa);
+#endif /* CONFIG_PMKSA_CACHE_SHARED */
 }
 
 
@@ -451,12 +947,145 @@ pmksa_cache_auth_init(void (*free_cb)(struct rsn_pmksa_cache_entry *entry,
 	if (pmksa) {
 		pmksa->free_cb = free_cb;
 		pmksa->ctx = ctx;
+		pmksa->max_entries = PMKSA_CACHE_AUTH_DEFAULT_MAX_ENTRIES;
+		dl_list_init(&pmksa->lru);
 	}
 
 	return pmksa;
 }
 
 
+/**
+ * pmksa_cache_auth_set_max_entries - Set the maximum number of cache entries
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @max_entries: Maximum number of entries; 0 = use the default
+ *
+ * If the cache currently has more entries than the new limit, the least
+ * recently used entries are removed.
+ */
+void pmksa_cache_auth_set_max_entries(struct rsn_pmksa_cache *pmksa,
+				      unsigned int max_entries)
+{
+	if (max_entries == 0)
+		max_entries = PMKSA_CACHE_AUTH_DEFAULT_MAX_ENTRIES;
+	pmksa->max_entries = max_entries;
+	while (pmksa->pmksa_count > pmksa->max_entries)
+		pmksa_cache_evict_lru(pmksa);
+}
+
+
+/**
+ * pmksa_cache_auth_set_shared - Configure the shared PMKSA cache store
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @path: Path to the shared store file or %NULL to not use a shared store
+ * Returns: 0 on success, -1 on failure
+ */
+int pmksa_cache_auth_set_shared(struct rsn_pmksa_cache *pmksa,
+				const char *path)
+{
+#ifdef CONFIG_PMKSA_CACHE_SHARED
+	if (pmksa->shared && path &&
+	    os_strcmp(pmksa_cache_shared_path(pmksa->shared), path) == 0)
+		return 0;
+
+	pmksa_cache_shared_close(pmksa->shared);
+	pmksa->shared = NULL;
+	if (path == NULL)
+		return 0;
+
+	pmksa->shared = pmksa_cache_shared_open(path);
+	return pmksa->shared ? 0 : -1;
+#else /* CONFIG_PMKSA_CACHE_SHARED */
+	if (path) {
+		wpa_printf(MSG_ERROR,
+			   "PMKSA: Shared PMKSA cache support not included in the build");
+		return -1;
+	}
+	return 0;
+#endif /* CONFIG_PMKSA_CACHE_SHARED */
+}
+
+
+/**
+ * pmksa_cache_auth_set_file - Configure the PMKSA cache snapshot file
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @path: Path to the snapshot file or %NULL to not use a snapshot file
+ * @key: Key for encrypting the snapshot
+ * @key_len: Length of the key in octets (16 or 32)
+ * @interval: Interval in seconds for writing the snapshot; 0 = only write it
+ *	when the cache is deinitialized
+ * @aa: Authenticator address
+ * Returns: 0 on success, -1 on failure
+ *
+ * When a new snapshot file is configured, the entries that have not yet
+ * expired are restored from it. The remaining lifetime of the entries is
+ * reduced by the time that has passed since the snapshot was written.
+ */
+int pmksa_cache_auth_set_file(struct rsn_pmksa_cache *pmksa, const char *path,
+			      const u8 *key, size_t key_len,
+			      unsigned int interval, const u8 *aa)
+{
+#ifdef CONFIG_PMKSA_CACHE_FILE
+	int load;
+
+	if (path && key_len != 16 && key_len != 32) {
+		wpa_printf(MSG_ERROR,
+			   "RSN: Invalid PMKSA cache snapshot key length");
+		return -1;
+	}
+
+	eloop_cancel_timeout(pmksa_cache_file_timeout, pmksa, NULL);
+	load = path && (!pmksa->file || os_strcmp(pmksa->file, path) != 0);
+	if (pmksa->file && load && pmksa->dirty)
+		pmksa_cache_file_save(pmksa);
+	if (path == NULL || load) {
+		os_free(pmksa->file);
+		pmksa->file = NULL;
+	}
+	if (path == NULL)
+		return 0;
+
+	if (load) {
+		pmksa->file = os_strdup(path);
+		if (pmksa->file == NULL)
+			return -1;
+	}
+	os_memcpy(pmksa->file_key, key, key_len);
+	pmksa->file_key_len = key_len;
+	pmksa->file_interval = interval;
+	os_memcpy(pmksa->aa, aa, ETH_ALEN);
+
+	if (load)
+		pmksa_cache_file_load(pmksa);
+	if (interval)
+		eloop_register_timeout(interval, 0, pmksa_cache_file_timeout,
+				       pmksa, NULL);
+	return 0;
+#else /* CONFIG_PMKSA_CACHE_FILE */
+	if (path) {
+		wpa_printf(MSG_ERROR,
+			   "RSN: PMKSA cache snapshot support not included in the build");
+		return -1;
+	}
+	return 0;
+#endif /* CONFIG_PMKSA_CACHE_FILE */
+}
+
+
+/**
+ * pmksa_cache_auth_get_stats - Get PMKSA cache statistics
+ * @pmksa: Pointer to PMKSA cache data from pmksa_cache_auth_init()
+ * @stats: Buffer for returning the statistics
+ */
+void pmksa_cache_auth_get_stats(struct rsn_pmksa_cache *pmksa,
+				struct rsn_pmksa_cache_stats *stats)
+{
+	os_memcpy(stats, &pmksa->stats, sizeof(*stats));
+	stats->entries = pmksa->pmksa_count;
+	stats->max_entries = pmksa->max_entries;
+}
+
+
 static int das_attr_match(struct rsn_pmksa_cache_entry *entry,
 			  struct radius_das_attrs *attr)
 {
@@ -507,21 +1136,35 @@ int pmksa_cache_auth_radius_das_disconnect(struct rsn_pmksa_cache *pmksa,
 					   struct radius_das_attrs *attr)
 {
 	int found = 0;
-	struct rsn_pmksa_cache_entry *entry, *prev;
+	struct rsn_pmksa_cache_entry *entry, *n;
 
 	if (attr->acct_session_id)
 		return -1;
 
-	entry = pmksa->pmksa;
-	while (entry) {
+	if (attr->sta_addr) {
+		struct rsn_pmksa_cache_entry *next;
+
+		entry = pmksa->spa[SPA_HASH(attr->sta_addr)];
+		while (entry) {
+			next = entry->snext;
+			if (das_attr_match(entry, attr)) {
+				found++;
+				pmksa_cache_free_entry(pmksa, entry);
+			}
+			entry = next;
+		}
+		if (found)
+			pmksa_cache_auth_remove_shared(pmksa, attr->sta_addr);
+		return found ? 0 : -1;
+	}
+
+	dl_list_for_each_safe(entry, n, &pmksa->lru,
+			      struct rsn_pmksa_cache_entry, lru) {
 		if (das_attr_match(entry, attr)) {
 			found++;
-			prev = entry;
-			entry = entry->next;
-			pmksa_cache_free_entry(pmksa, prev);
-			continue;
+			pmksa_cache_auth_remove_shared(pmksa, entry->spa);
+			pmksa_cache_free_entry(pmksa, entry);
 		}
-		entry = entry->next;
 	}
 
 	return found ? 0 : -1;
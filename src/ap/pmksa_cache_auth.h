@@ -9,13 +9,19 @@
 #ifndef PMKSA_CACHE_H
 #define PMKSA_CACHE_H
 
+#include "utils/list.h"
 #include "radius/radius.h"
 
+#define PMKSA_CACHE_AUTH_DEFAULT_MAX_ENTRIES 1024
+
 /**
  * struct rsn_pmksa_cache_entry - PMKSA cache entry
  */
 struct rsn_pmksa_cache_entry {
-	struct rsn_pmksa_cache_entry *next, *hnext;
+	struct rsn_pmksa_cache_entry *hnext; /* PMKID hash chain */
+	struct rsn_pmksa_cache_entry *snext; /* SPA hash chain */
+	struct dl_list lru;
+	size_t heap_idx;
 	u8 pmkid[PMKID_LEN];
 	u8 pmk[PMK_LEN_MAX];
 	size_t pmk_len;
@@ -35,6 +41,20 @@ struct rsn_pmksa_cache_entry {
 	u32 acct_multi_session_id_lo;
 };
 
+/**
+ * struct rsn_pmksa_cache_stats - PMKSA cache statistics
+ */
+struct rsn_pmksa_cache_stats {
+	unsigned int entries;
+	unsigned int max_entries;
+	unsigned long hits; /* PMKID lookups that found an entry */
+	unsigned long misses; /* PMKID lookups that did not find an entry */
+	unsigned long okc_hits; /* entries found with OKC */
+	unsigned long evictions; /* entries removed to make room */
+	unsigned long expirations; /* entries removed due to expiration */
+	unsigned long shared_hits; /* entries found from the shared store */
+};
+
 struct rsn_pmksa_cache;
 
 struct rsn_pmksa_cache *
@@ -63,5 +83,19 @@ void pmksa_cache_free_entry(struct rsn_pmksa_cache *pmksa,
 			    struct rsn_pmksa_cache_entry *entry);
 int pmksa_cache_auth_radius_das_disconnect(struct rsn_pmksa_cache *pmksa,
 					   struct radius_das_attrs *attr);
+void pmksa_cache_auth_set_max_entries(struct rsn_pmksa_cache *pmksa,
+				      unsigned int max_entries);
+int pmksa_cache_auth_set_shared(struct rsn_pmksa_cache *pmksa,
+				const char *path);
+struct rsn_pmksa_cache_entry *
+pmksa_cache_get_shared(struct rsn_pmksa_cache *pmksa, const u8 *aa,
+		       const u8 *spa, const u8 *pmkid);
+void pmksa_cache_auth_remove_shared(struct rsn_pmksa_cache *pmksa,
+				    const u8 *spa);
+int pmksa_cache_auth_set_file(struct rsn_pmksa_cache *pmksa, const char *path,
+			      const u8 *key, size_t key_len,
+			      unsigned int interval, const u8 *aa);
+void pmksa_cache_auth_get_stats(struct rsn_pmksa_cache *pmksa,
+				struct rsn_pmksa_cache_stats *stats);
 
 #endif /* PMKSA_CACHE_H */
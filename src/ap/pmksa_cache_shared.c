@@ -0,0 +1,461 @@
+/*
+ * hostapd - Shared PMKSA cache store
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This store allows PMKSA cache entries to be shared between BSSes and
+ * between hostapd processes on the same host. It is a fixed size table of
+ * slots in a memory mapped file that is locked with flock() for each
+ * operation. Only the PMK and the parameters needed to rebuild a local PMKSA
+ * cache entry are stored and since the PMKID depends on the authenticator
+ * address, entries are matched by SPA and the PMKID is recomputed with the
+ * local authenticator address, i.e., in the same way as with opportunistic key
+ * caching.
+ *
+ * The file outlives the processes and reboots, so expiration times are stored
+ * as wall clock time and converted to and from the monotonic time used in the
+ * local PMKSA caches.
+ *
+ * Access control is based on the file: it is created with mode 0600, it must
+ * be a regular file owned by the effective user, and it must not be
+ * accessible by group or others.
+ */
+
+#include "utils/includes.h"
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "utils/common.h"
+#include "utils/list.h"
+#include "common/defs.h"
+#include "common/wpa_common.h"
+#include "radius/radius_das.h"
+#include "eapol_auth/eapol_auth_sm.h"
+#include "pmksa_cache_auth.h"
+#include "pmksa_cache_shared.h"
+
+
+#define PMKSA_SHARED_MAGIC 0x504d4b53
+#define PMKSA_SHARED_VERSION 2
+#define PMKSA_SHARED_SLOTS 4096
+#define PMKSA_SHARED_PROBES 32
+#define PMKSA_SHARED_IDENTITY_LEN 128
+
+struct pmksa_shared_hdr {
+	u32 magic;
+	u32 version;
+	u32 num_slots;
+	u32 slot_size;
+};
+
+struct pmksa_shared_slot {
+	u8 in_use;
+	u8 spa[ETH_ALEN];
+	u8 eap_type_authsrv;
+	u8 pmk_len;
+	u8 identity_len;
+	int akmp;
+	int vlan_id;
+	os_time_t expiration; /* wall clock time (os_get_time()) */
+	u8 pmk[PMK_LEN_MAX];
+	u8 identity[PMKSA_SHARED_IDENTITY_LEN];
+};
+
+struct pmksa_cache_shared {
+	struct dl_list list;
+	unsigned int refcount;
+	char *path;
+	int fd;
+	void *map;
+	size_t map_len;
+	struct pmksa_shared_hdr *hdr;
+	struct pmksa_shared_slot *slots;
+};
+
+static struct dl_list pmksa_shared_stores =
+	DL_LIST_HEAD_INIT(pmksa_shared_stores);
+
+
+static size_t pmksa_shared_map_len(void)
+{
+	return sizeof(struct pmksa_shared_hdr) +
+		PMKSA_SHARED_SLOTS * sizeof(struct pmksa_shared_slot);
+}
+
+
+static int pmksa_shared_lock(struct pmksa_cache_shared *shared)
+{
+	if (flock(shared->fd, LOCK_EX) < 0) {
+		wpa_printf(MSG_INFO, "PMKSA shared: flock(%s) failed: %s",
+			   shared->path, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+
+static void pmksa_shared_unlock(struct pmksa_cache_shared *shared)
+{
+	flock(shared->fd, LOCK_UN);
+}
+
+
+static int pmksa_shared_check_file(int fd, const char *path)
+{
+	struct stat st;
+
+	if (fstat(fd, &st) < 0) {
+		wpa_printf(MSG_ERROR, "PMKSA shared: fstat(%s) failed: %s",
+			   path, strerror(errno));
+		return -1;
+	}
+
+	if (!S_ISREG(st.st_mode) || st.st_uid != geteuid() ||
+	    (st.st_mode & (S_IRWXG | S_IRWXO))) {
+		wpa_printf(MSG_ERROR,
+			   "PMKSA shared: %s must be a regular file owned by uid %d and not accessible by group or others",
+			   path, (int) geteuid());
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static int pmksa_shared_init_file(struct pmksa_cache_shared *shared)
+{
+	struct stat st;
+	struct pmksa_shared_hdr hdr;
+
+	if (fstat(shared->fd, &st) < 0)
+		return -1;
+
+	if (st.st_size == 0) {
+		os_memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = PMKSA_SHARED_MAGIC;
+		hdr.version = PMKSA_SHARED_VERSION;
+		hdr.num_slots = PMKSA_SHARED_SLOTS;
+		hdr.slot_size = sizeof(struct pmksa_shared_slot);
+		if (ftruncate(shared->fd, shared->map_len) < 0 ||
+		    pwrite(shared->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+			wpa_printf(MSG_ERROR,
+				   "PMKSA shared: Failed to initialize %s: %s",
+				   shared->path, strerror(errno));
+			return -1;
+		}
+		wpa_printf(MSG_DEBUG, "PMKSA shared: Initialized %s",
+			   shared->path);
+		return 0;
+	}
+
+	if ((size_t) st.st_size != shared->map_len ||
+	    pread(shared->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+	    hdr.magic != PMKSA_SHARED_MAGIC ||
+	    hdr.version != PMKSA_SHARED_VERSION ||
+	    hdr.num_slots != PMKSA_SHARED_SLOTS ||
+	    hdr.slot_size != sizeof(struct pmksa_shared_slot)) {
+		wpa_printf(MSG_ERROR,
+			   "PMKSA shared: %s has unexpected format", shared->path);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * pmksa_cache_shared_open - Open a shared PMKSA cache store
+ * @path: Path to the store file; created if it does not exist
+ * Returns: Pointer to the store or %NULL on failure
+ *
+ * The same store is returned for all users of the same path within the
+ * process and it is freed once every user has called
+ * pmksa_cache_shared_close().
+ */
+struct pmksa_cache_shared * pmksa_cache_shared_open(const char *path)
+{
+	struct pmksa_cache_shared *shared;
+	int res;
+
+	dl_list_for_each(shared, &pmksa_shared_stores,
+			 struct pmksa_cache_shared, list) {
+		if (os_strcmp(shared->path, path) == 0) {
+			shared->refcount++;
+			return shared;
+		}
+	}
+
+	shared = os_zalloc(sizeof(*shared));
+	if (shared == NULL)
+		return NULL;
+	shared->fd = -1;
+	shared->map = MAP_FAILED;
+	shared->map_len = pmksa_shared_map_len();
+	shared->path = os_strdup(path);
+	if (shared->path == NULL)
+		goto fail;
+
+	shared->fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW, S_IRUSR | S_IWUSR);
+	if (shared->fd < 0) {
+		wpa_printf(MSG_ERROR, "PMKSA shared: open(%s) failed: %s",
+			   path, strerror(errno));
+		goto fail;
+	}
+	if (pmksa_shared_check_file(shared->fd, path) < 0 ||
+	    pmksa_shared_lock(shared) < 0)
+		goto fail;
+	res = pmksa_shared_init_file(shared);
+	pmksa_shared_unlock(shared);
+	if (res < 0)
+		goto fail;
+
+	shared->map = mmap(NULL, shared->map_len, PROT_READ | PROT_WRITE,
+			   MAP_SHARED, shared->fd, 0);
+	if (shared->map == MAP_FAILED) {
+		wpa_printf(MSG_ERROR, "PMKSA shared: mmap(%s) failed: %s",
+			   path, strerror(errno));
+		goto fail;
+	}
+	shared->hdr = shared->map;
+	shared->slots = (struct pmksa_shared_slot *) (shared->hdr + 1);
+
+	shared->refcount = 1;
+	dl_list_add(&pmksa_shared_stores, &shared->list);
+	wpa_printf(MSG_DEBUG, "PMKSA shared: Opened %s", path);
+	return shared;
+
+fail:
+	if (shared->fd >= 0)
+		close(shared->fd);
+	os_free(shared->path);
+	os_free(shared);
+	return NULL;
+}
+
+
+/**
+ * pmksa_cache_shared_close - Release a shared PMKSA cache store
+ * @shared: Pointer to the store from pmksa_cache_shared_open()
+ */
+void pmksa_cache_shared_close(struct pmksa_cache_shared *shared)
+{
+	if (shared == NULL || --shared->refcount > 0)
+		return;
+
+	dl_list_del(&shared->list);
+	munmap(shared->map, shared->map_len);
+	close(shared->fd);
+	wpa_printf(MSG_DEBUG, "PMKSA shared: Closed %s", shared->path);
+	os_free(shared->path);
+	os_free(shared);
+}
+
+
+const char * pmksa_cache_shared_path(struct pmksa_cache_shared *shared)
+{
+	return shared->path;
+}
+
+
+static unsigned int pmksa_shared_hash(const u8 *spa)
+{
+	unsigned int hash = 0;
+	int i;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = hash * 31 + spa[i];
+	return hash % PMKSA_SHARED_SLOTS;
+}
+
+
+static struct pmksa_shared_slot *
+pmksa_shared_get_slot(struct pmksa_cache_shared *shared, const u8 *spa,
+		      unsigned int i)
+{
+	return &shared->slots[(pmksa_shared_hash(spa) + i) %
+			      PMKSA_SHARED_SLOTS];
+}
+
+
+static struct pmksa_shared_slot *
+pmksa_shared_find(struct pmksa_cache_shared *shared, const u8 *spa,
+		  os_time_t now)
+{
+	struct pmksa_shared_slot *slot;
+	unsigned int i;
+
+	for (i = 0; i < PMKSA_SHARED_PROBES; i++) {
+		slot = pmksa_shared_get_slot(shared, spa, i);
+		if (slot->in_use && slot->expiration > now &&
+		    os_memcmp(slot->spa, spa, ETH_ALEN) == 0)
+			return slot;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * pmksa_cache_shared_store - Store a PMKSA cache entry in the shared store
+ * @shared: Pointer to the store from pmksa_cache_shared_open()
+ * @entry: PMKSA cache entry
+ * Returns: 0 on success, -1 on failure
+ *
+ * An existing entry for the same SPA is replaced. If there is no free slot
+ * for the SPA, the slot with the entry that expires first is reused.
+ */
+int pmksa_cache_shared_store(struct pmksa_cache_shared *shared,
+			     const struct rsn_pmksa_cache_entry *entry)
+{
+	struct pmksa_shared_slot *slot, *pos;
+	struct os_reltime rel;
+	struct os_time now;
+	unsigned int i;
+
+	/*
+	 * Suite B PMKIDs are derived from KCK instead of PMK, so they cannot
+	 * be recomputed from the stored data.
+	 */
+	if (wpa_key_mgmt_suite_b(entry->akmp) || entry->pmk_len > PMK_LEN_MAX)
+		return -1;
+
+	if (pmksa_shared_lock(shared) < 0)
+		return -1;
+
+	os_get_reltime(&rel);
+	os_get_time(&now);
+	slot = pmksa_shared_find(shared, entry->spa, now.sec);
+	for (i = 0; slot == NULL && i < PMKSA_SHARED_PROBES; i++) {
+		pos = pmksa_shared_get_slot(shared, entry->spa, i);
+		if (!pos->in_use || pos->expiration <= now.sec)
+			slot = pos;
+	}
+	for (i = 0; slot == NULL && i < PMKSA_SHARED_PROBES; i++) {
+		/* No free slot; replace the entry that expires first */
+		pos = pmksa_shared_get_slot(shared, entry->spa, i);
+		if (i == 0 || pos->expiration < slot->expiration)
+			slot = pos;
+		if (i == PMKSA_SHARED_PROBES - 1)
+			wpa_printf(MSG_DEBUG,
+				   "PMKSA shared: Replace entry for " MACSTR,
+				   MAC2STR(slot->spa));
+	}
+
+	os_memset(slot, 0, sizeof(*slot));
+	os_memcpy(slot->spa, entry->spa, ETH_ALEN);
+	os_memcpy(slot->pmk, entry->pmk, entry->pmk_len);
+	slot->pmk_len = entry->pmk_len;
+	slot->akmp = entry->akmp;
+	slot->expiration = now.sec + (entry->expiration - rel.sec);
+	slot->vlan_id = entry->vlan_id;
+	slot->eap_type_authsrv = entry->eap_type_authsrv;
+	if (entry->identity &&
+	    entry->identity_len <= PMKSA_SHARED_IDENTITY_LEN) {
+		os_memcpy(slot->identity, entry->identity,
+			  entry->identity_len);
+		slot->identity_len = entry->identity_len;
+	}
+	slot->in_use = 1;
+
+	pmksa_shared_unlock(shared);
+
+	wpa_printf(MSG_DEBUG, "PMKSA shared: Stored entry for " MACSTR,
+		   MAC2STR(entry->spa));
+	return 0;
+}
+
+
+/**
+ * pmksa_cache_shared_fetch - Fetch a PMKSA cache entry from the shared store
+ * @shared: Pointer to the store from pmksa_cache_shared_open()
+ * @aa: Local authenticator address
+ * @spa: Supplicant address
+ * @pmkid: PMKID from the supplicant
+ * Returns: Pointer to a new PMKSA cache entry or %NULL if no match was found
+ *
+ * The returned entry is not added to any local PMKSA cache; the caller is
+ * responsible for that.
+ */
+struct rsn_pmksa_cache_entry *
+pmksa_cache_shared_fetch(struct pmksa_cache_shared *shared, const u8 *aa,
+			 const u8 *spa, const u8 *pmkid)
+{
+	struct pmksa_shared_slot *slot;
+	struct rsn_pmksa_cache_entry *entry = NULL;
+	struct os_reltime rel;
+	struct os_time now;
+	u8 new_pmkid[PMKID_LEN];
+
+	if (pmksa_shared_lock(shared) < 0)
+		return NULL;
+
+	os_get_time(&now);
+	slot = pmksa_shared_find(shared, spa, now.sec);
+	if (slot == NULL)
+		goto out;
+
+	rsn_pmkid(slot->pmk, slot->pmk_len, aa, spa, new_pmkid,
+		  wpa_key_mgmt_sha256(slot->akmp));
+	if (os_memcmp(new_pmkid, pmkid, PMKID_LEN) != 0)
+		goto out;
+
+	entry = os_zalloc(sizeof(*entry));
+	if (entry == NULL)
+		goto out;
+	os_memcpy(entry->pmkid, pmkid, PMKID_LEN);
+	os_memcpy(entry->pmk, slot->pmk, slot->pmk_len);
+	entry->pmk_len = slot->pmk_len;
+	entry->akmp = slot->akmp;
+	os_get_reltime(&rel);
+	entry->expiration = rel.sec + (slot->expiration - now.sec);
+	os_memcpy(entry->spa, spa, ETH_ALEN);
+	entry->vlan_id = slot->vlan_id;
+	entry->eap_type_authsrv = slot->eap_type_authsrv;
+	if (slot->identity_len) {
+		entry->identity = os_malloc(slot->identity_len);
+		if (entry->identity) {
+			os_memcpy(entry->identity, slot->identity,
+				  slot->identity_len);
+			entry->identity_len = slot->identity_len;
+		}
+	}
+
+	wpa_printf(MSG_DEBUG, "PMKSA shared: Found entry for " MACSTR,
+		   MAC2STR(spa));
+
+out:
+	pmksa_shared_unlock(shared);
+	return entry;
+}
+
+
+/**
+ * pmksa_cache_shared_remove - Remove a STA from the shared store
+ * @shared: Pointer to the store from pmksa_cache_shared_open()
+ * @spa: Supplicant address
+ */
+void pmksa_cache_shared_remove(struct pmksa_cache_shared *shared,
+			       const u8 *spa)
+{
+	struct pmksa_shared_slot *slot;
+	unsigned int i;
+
+	if (pmksa_shared_lock(shared) < 0)
+		return;
+
+	for (i = 0; i < PMKSA_SHARED_PROBES; i++) {
+		slot = pmksa_shared_get_slot(shared, spa, i);
+		if (slot->in_use && os_memcmp(slot->spa, spa, ETH_ALEN) == 0) {
+			wpa_printf(MSG_DEBUG,
+				   "PMKSA shared: Removed entry for " MACSTR,
+				   MAC2STR(spa));
+			os_memset(slot, 0, sizeof(*slot));
+		}
+	}
+
+	pmksa_shared_unlock(shared);
+}
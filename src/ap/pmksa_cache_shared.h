@@ -0,0 +1,26 @@
+/*
+ * hostapd - Shared PMKSA cache store
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef PMKSA_CACHE_SHARED_H
+#define PMKSA_CACHE_SHARED_H
+
+struct rsn_pmksa_cache_entry;
+struct pmksa_cache_shared;
+
+struct pmksa_cache_shared * pmksa_cache_shared_open(const char *path);
+void pmksa_cache_shared_close(struct pmksa_cache_shared *shared);
+const char * pmksa_cache_shared_path(struct pmksa_cache_shared *shared);
+int pmksa_cache_shared_store(struct pmksa_cache_shared *shared,
+			     const struct rsn_pmksa_cache_entry *entry);
+struct rsn_pmksa_cache_entry *
+pmksa_cache_shared_fetch(struct pmksa_cache_shared *shared, const u8 *aa,
+			 const u8 *spa, const u8 *pmkid);
+void pmksa_cache_shared_remove(struct pmksa_cache_shared *shared,
+			       const u8 *spa);
+
+#endif /* PMKSA_CACHE_SHARED_H */
@@ -180,6 +180,7 @@ void ap_free_sta(struct hostapd_data *hapd, struct sta_info *sta)
 			~BIT((sta->aid - 1) % 32);
 
 	hapd->num_sta--;
+	hostapd_status_page_update(hapd);
 	if (sta->nonerp_set) {
 		sta->nonerp_set = 0;
 		hapd->iface->num_sta_non_erp--;
@@ -640,6 +641,7 @@ struct sta_info * ap_sta_add(struct hostapd_data *hapd, const u8 *addr)
 	sta->next = hapd->sta_list;
 	hapd->sta_list = sta;
 	hapd->num_sta++;
+	hostapd_status_page_update(hapd);
 	ap_sta_hash_add(hapd, sta);
 	ap_sta_remove_in_other_bss(hapd, sta);
 	sta->last_seq_ctrl = WLAN_INVALID_MGMT_SEQ;
@@ -993,10 +995,14 @@ void ap_sta_set_authorized(struct hostapd_data *hapd, struct sta_info *sta,
 	if (!!authorized == !!(sta->flags & WLAN_STA_AUTHORIZED))
 		return;
 
-	if (authorized)
+	if (authorized) {
 		sta->flags |= WLAN_STA_AUTHORIZED;
-	else
+		hapd->num_sta_authorized++;
+	} else {
 		sta->flags &= ~WLAN_STA_AUTHORIZED;
+		hapd->num_sta_authorized--;
+	}
+	hostapd_status_page_update(hapd);
 
 #ifdef CONFIG_P2P
 	if (hapd->p2p_group == NULL) {
@@ -10,7 +10,6 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
-#include "utils/state_machine.h"
 #include "utils/bitfield.h"
 #include "common/ieee802_11_defs.h"
 #include "crypto/aes_wrap.h"
@@ -29,6 +28,8 @@
 #define STATE_MACHINE_DATA struct wpa_state_machine
 #define STATE_MACHINE_DEBUG_PREFIX "WPA"
 #define STATE_MACHINE_ADDR sm->addr
+#define STATE_MACHINE_TRACE(machine) TRACE_RING_ ## machine
+#include "utils/state_machine.h"
 
 
 static void wpa_send_eapol_timeout(void *eloop_ctx, void *timeout_ctx);
@@ -442,6 +443,22 @@ struct wpa_authenticator * wpa_init(const u8 *addr,
 		os_free(wpa_auth);
 		return NULL;
 	}
+	pmksa_cache_auth_set_max_entries(wpa_auth->pmksa,
+					 conf->pmksa_cache_max_entries);
+	if (pmksa_cache_auth_set_shared(wpa_auth->pmksa,
+					conf->pmksa_cache_shared) < 0 ||
+	    pmksa_cache_auth_set_file(wpa_auth->pmksa, conf->pmksa_cache_file,
+				      conf->pmksa_cache_file_key,
+				      conf->pmksa_cache_file_key_len,
+				      conf->pmksa_cache_file_interval,
+				      wpa_auth->addr) < 0) {
+		wpa_printf(MSG_ERROR, "PMKSA cache configuration failed.");
+		os_free(wpa_auth->group);
+		os_free(wpa_auth->wpa_ie);
+		pmksa_cache_auth_deinit(wpa_auth->pmksa);
+		os_free(wpa_auth);
+		return NULL;
+	}
 
 #ifdef CONFIG_IEEE80211R
 	wpa_auth->ft_pmk_cache = wpa_ft_pmk_cache_init();
@@ -554,6 +571,17 @@ int wpa_reconfig(struct wpa_authenticator *wpa_auth,
 		return -1;
 	}
 
+	pmksa_cache_auth_set_max_entries(wpa_auth->pmksa,
+					 conf->pmksa_cache_max_entries);
+	if (pmksa_cache_auth_set_shared(wpa_auth->pmksa,
+					conf->pmksa_cache_shared) < 0 ||
+	    pmksa_cache_auth_set_file(wpa_auth->pmksa, conf->pmksa_cache_file,
+				      conf->pmksa_cache_file_key,
+				      conf->pmksa_cache_file_key_len,
+				      conf->pmksa_cache_file_interval,
+				      wpa_auth->addr) < 0)
+		return -1;
+
 	/*
 	 * Reinitialize GTK to make sure it is suitable for the new
 	 * configuration.
@@ -3078,6 +3106,7 @@ int wpa_get_mib(struct wpa_authenticator *wpa_auth, char *buf, size_t buflen)
 {
 	int len = 0, ret;
 	char pmkid_txt[PMKID_LEN * 2 + 1];
+	struct rsn_pmksa_cache_stats stats;
 #ifdef CONFIG_RSN_PREAUTH
 	const int preauth = 1;
 #else /* CONFIG_RSN_PREAUTH */
@@ -3159,6 +3188,24 @@ int wpa_get_mib(struct wpa_authenticator *wpa_auth, char *buf, size_t buflen)
 		return len;
 	len += ret;
 
+	pmksa_cache_auth_get_stats(wpa_auth->pmksa, &stats);
+	ret = os_snprintf(buf + len, buflen - len,
+			  "hostapdPMKSACacheEntries=%u\n"
+			  "hostapdPMKSACacheMaxEntries=%u\n"
+			  "hostapdPMKSACacheHits=%lu\n"
+			  "hostapdPMKSACacheMisses=%lu\n"
+			  "hostapdPMKSACacheOKCHits=%lu\n"
+			  "hostapdPMKSACacheEvictions=%lu\n"
+			  "hostapdPMKSACacheExpirations=%lu\n"
+			  "hostapdPMKSACacheSharedHits=%lu\n",
+			  stats.entries, stats.max_entries,
+			  stats.hits, stats.misses, stats.okc_hits,
+			  stats.evictions, stats.expirations,
+			  stats.shared_hits);
+	if (os_snprintf_error(buflen - len, ret))
+		return len;
+	len += ret;
+
 	return len;
 }
 
@@ -3356,6 +3403,7 @@ void wpa_auth_pmksa_remove(struct wpa_authenticator *wpa_auth,
 			   MACSTR " based on request", MAC2STR(sta_addr));
 		pmksa_cache_free_entry(wpa_auth->pmksa, pmksa);
 	}
+	pmksa_cache_auth_remove_shared(wpa_auth->pmksa, sta_addr);
 }
 
 
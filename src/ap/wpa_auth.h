@@ -143,6 +143,12 @@ struct wpa_auth_config {
 	int wmm_uapsd;
 	int disable_pmksa_caching;
 	int okc;
+	unsigned int pmksa_cache_max_entries;
+	const char *pmksa_cache_shared;
+	const char *pmksa_cache_file;
+	const u8 *pmksa_cache_file_key;
+	size_t pmksa_cache_file_key_len;
+	unsigned int pmksa_cache_file_interval;
 	int tx_status;
 #ifdef CONFIG_IEEE80211W
 	enum mfp_options ieee80211w;
@@ -48,6 +48,12 @@ static void hostapd_wpa_auth_conf(struct hostapd_bss_config *conf,
 	wconf->wmm_uapsd = conf->wmm_uapsd;
 	wconf->disable_pmksa_caching = conf->disable_pmksa_caching;
 	wconf->okc = conf->okc;
+	wconf->pmksa_cache_max_entries = conf->pmksa_cache_max_entries;
+	wconf->pmksa_cache_shared = conf->pmksa_cache_shared;
+	wconf->pmksa_cache_file = conf->pmksa_cache_file;
+	wconf->pmksa_cache_file_key = conf->pmksa_cache_file_key;
+	wconf->pmksa_cache_file_key_len = conf->pmksa_cache_file_key_len;
+	wconf->pmksa_cache_file_interval = conf->pmksa_cache_file_interval;
 #ifdef CONFIG_IEEE80211W
 	wconf->ieee80211w = conf->ieee80211w;
 	wconf->group_mgmt_cipher = conf->group_mgmt_cipher;
@@ -292,6 +298,7 @@ static int hostapd_wpa_auth_set_key(void *ctx, int vlan_id, enum wpa_alg alg,
 {
 	struct hostapd_data *hapd = ctx;
 	const char *ifname = hapd->conf->iface;
+	int ret;
 
 	if (vlan_id > 0) {
 		ifname = hostapd_get_vlan_id_ifname(hapd->conf->vlan, vlan_id);
@@ -299,8 +306,12 @@ static int hostapd_wpa_auth_set_key(void *ctx, int vlan_id, enum wpa_alg alg,
 			return -1;
 	}
 
-	return hostapd_drv_set_key(ifname, hapd, alg, addr, idx, 1, NULL, 0,
-				   key, key_len);
+	ret = hostapd_drv_set_key(ifname, hapd, alg, addr, idx, 1, NULL, 0,
+				  key, key_len);
+	if (ret == 0 && alg != WPA_ALG_NONE)
+		hostapd_status_page_key(hapd, !addr ||
+					is_broadcast_ether_addr(addr));
+	return ret;
 }
 
 
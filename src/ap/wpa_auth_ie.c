@@ -711,6 +711,18 @@ int wpa_validate_wpa_ie(struct wpa_authenticator *wpa_auth,
 			break;
 		}
 	}
+	for (i = 0; sm->pmksa == NULL && wpa_auth->conf.pmksa_cache_shared &&
+		     i < data.num_pmkid; i++) {
+		sm->pmksa = pmksa_cache_get_shared(wpa_auth->pmksa,
+						   wpa_auth->addr, sm->addr,
+						   &data.pmkid[i * PMKID_LEN]);
+		if (sm->pmksa) {
+			wpa_auth_vlogger(wpa_auth, sm->addr, LOGGER_DEBUG,
+					 "Shared PMKSA cache match for PMKID");
+			pmkid = sm->pmksa->pmkid;
+			break;
+		}
+	}
 	if (sm->pmksa && pmkid) {
 		wpa_auth_vlogger(wpa_auth, sm->addr, LOGGER_DEBUG,
 				 "PMKID found from PMKSA cache "
@@ -13,10 +13,33 @@
 #include "crypto/sha256.h"
 #include "crypto/random.h"
 #include "crypto/dh_groups.h"
+#include "utils/list.h"
 #include "ieee802_11_defs.h"
 #include "sae.h"
 
 
+/*
+ * Optional cache of derived PWE values. The hunting-and-pecking loop is the
+ * most expensive part of SAE and its result depends only on the MAC address
+ * pair, the password, and the group, so a repeated attempt with the same
+ * parameters (e.g., after a lost frame) can reuse the earlier result. The
+ * password is stored only as a hash and all entries are cleared from memory
+ * when evicted.
+ */
+struct sae_pwe_cache_entry {
+	struct dl_list list;
+	u8 addrs[2 * ETH_ALEN];
+	u8 pw_hash[SHA256_MAC_LEN];
+	int group;
+	size_t pwe_len;
+	u8 pwe[SAE_MAX_PRIME_LEN];
+};
+
+static struct dl_list sae_pwe_cache = DL_LIST_HEAD_INIT(sae_pwe_cache);
+static unsigned int sae_pwe_cache_len;
+static unsigned int sae_pwe_cache_max;
+
+
 int sae_set_group(struct sae_data *sae, int group)
 {
 	struct sae_temporary_data *tmp;
@@ -103,6 +126,166 @@ void sae_clear_data(struct sae_data *sae)
 }
 
 
+static void sae_pwe_cache_free_entry(struct sae_pwe_cache_entry *entry)
+{
+	dl_list_del(&entry->list);
+	sae_pwe_cache_len--;
+	bin_clear_free(entry, sizeof(*entry));
+}
+
+
+/**
+ * sae_pwe_cache_set_size - Set the maximum number of cached PWE entries
+ * @size: Maximum number of entries; 0 disables the cache
+ *
+ * The cache is shared by all SAE instances in the process. Reducing the size
+ * evicts the least recently used entries.
+ */
+void sae_pwe_cache_set_size(unsigned int size)
+{
+	struct sae_pwe_cache_entry *entry;
+
+	if (size > SAE_PWE_CACHE_MAX_SIZE)
+		size = SAE_PWE_CACHE_MAX_SIZE;
+	if (size != sae_pwe_cache_max)
+		wpa_printf(MSG_DEBUG, "SAE: PWE cache size %u -> %u",
+			   sae_pwe_cache_max, size);
+	sae_pwe_cache_max = size;
+
+	while (sae_pwe_cache_len > sae_pwe_cache_max) {
+		entry = dl_list_last(&sae_pwe_cache,
+				     struct sae_pwe_cache_entry, list);
+		sae_pwe_cache_free_entry(entry);
+	}
+}
+
+
+/**
+ * sae_pwe_cache_flush - Remove all entries from the PWE cache
+ */
+void sae_pwe_cache_flush(void)
+{
+	struct sae_pwe_cache_entry *entry, *n;
+
+	dl_list_for_each_safe(entry, n, &sae_pwe_cache,
+			      struct sae_pwe_cache_entry, list)
+		sae_pwe_cache_free_entry(entry);
+}
+
+
+static int sae_pwe_cache_key(const u8 *addrs, const u8 *password,
+			     size_t password_len, u8 *pw_hash)
+{
+	return hmac_sha256(addrs, 2 * ETH_ALEN, password, password_len,
+			   pw_hash);
+}
+
+
+static struct sae_pwe_cache_entry *
+sae_pwe_cache_find(int group, const u8 *addrs, const u8 *pw_hash)
+{
+	struct sae_pwe_cache_entry *entry;
+
+	dl_list_for_each(entry, &sae_pwe_cache, struct sae_pwe_cache_entry,
+			 list) {
+		if (entry->group == group &&
+		    os_memcmp(entry->addrs, addrs, 2 * ETH_ALEN) == 0 &&
+		    os_memcmp_const(entry->pw_hash, pw_hash,
+				    SHA256_MAC_LEN) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+static int sae_pwe_cache_get(struct sae_data *sae, const u8 *addrs,
+			     const u8 *pw_hash)
+{
+	struct sae_temporary_data *tmp = sae->tmp;
+	struct sae_pwe_cache_entry *entry;
+
+	entry = sae_pwe_cache_find(sae->group, addrs, pw_hash);
+	if (entry == NULL)
+		return -1;
+
+	if (tmp->ec) {
+		struct crypto_ec_point *pwe;
+
+		pwe = crypto_ec_point_from_bin(tmp->ec, entry->pwe);
+		if (pwe == NULL)
+			return -1;
+		crypto_ec_point_deinit(tmp->pwe_ecc, 1);
+		tmp->pwe_ecc = pwe;
+	} else {
+		struct crypto_bignum *pwe;
+
+		pwe = crypto_bignum_init_set(entry->pwe, entry->pwe_len);
+		if (pwe == NULL)
+			return -1;
+		crypto_bignum_deinit(tmp->pwe_ffc, 1);
+		tmp->pwe_ffc = pwe;
+	}
+
+	/* Move to the front to maintain LRU order */
+	dl_list_del(&entry->list);
+	dl_list_add(&sae_pwe_cache, &entry->list);
+
+	wpa_printf(MSG_DEBUG, "SAE: Use cached PWE for group %d", sae->group);
+	return 0;
+}
+
+
+static void sae_pwe_cache_add(struct sae_data *sae, const u8 *addrs,
+			      const u8 *pw_hash)
+{
+	struct sae_temporary_data *tmp = sae->tmp;
+	struct sae_pwe_cache_entry *entry;
+	int res;
+
+	entry = sae_pwe_cache_find(sae->group, addrs, pw_hash);
+	if (entry)
+		sae_pwe_cache_free_entry(entry);
+
+	entry = os_zalloc(sizeof(*entry));
+	if (entry == NULL)
+		return;
+
+	if (tmp->ec) {
+		entry->pwe_len = 2 * tmp->prime_len;
+		res = crypto_ec_point_to_bin(tmp->ec, tmp->pwe_ecc, entry->pwe,
+					     entry->pwe + tmp->prime_len);
+	} else {
+		entry->pwe_len = tmp->prime_len;
+		res = crypto_bignum_to_bin(tmp->pwe_ffc, entry->pwe,
+					   sizeof(entry->pwe), tmp->prime_len);
+	}
+	if (res < 0 || entry->pwe_len > sizeof(entry->pwe)) {
+		bin_clear_free(entry, sizeof(*entry));
+		return;
+	}
+
+	entry->group = sae->group;
+	os_memcpy(entry->addrs, addrs, sizeof(entry->addrs));
+	os_memcpy(entry->pw_hash, pw_hash, sizeof(entry->pw_hash));
+
+	while (sae_pwe_cache_len >= sae_pwe_cache_max) {
+		struct sae_pwe_cache_entry *last;
+
+		last = dl_list_last(&sae_pwe_cache,
+				    struct sae_pwe_cache_entry, list);
+		if (last == NULL)
+			break;
+		wpa_printf(MSG_DEBUG, "SAE: Evict PWE cache entry for group %d",
+			   last->group);
+		sae_pwe_cache_free_entry(last);
+	}
+
+	dl_list_add(&sae_pwe_cache, &entry->list);
+	sae_pwe_cache_len++;
+}
+
+
 static void buf_shift_right(u8 *buf, size_t len, size_t bits)
 {
 	size_t i;
@@ -694,15 +877,46 @@ fail:
 }
 
 
+static int sae_derive_pwe(struct sae_data *sae, const u8 *addr1,
+			  const u8 *addr2, const u8 *password,
+			  size_t password_len)
+{
+	u8 addrs[2 * ETH_ALEN];
+	u8 pw_hash[SHA256_MAC_LEN];
+	int use_cache;
+
+	use_cache = sae_pwe_cache_max > 0;
+	if (use_cache) {
+		sae_pwd_seed_key(addr1, addr2, addrs);
+		if (sae_pwe_cache_key(addrs, password, password_len,
+				      pw_hash) < 0)
+			use_cache = 0;
+		else if (sae_pwe_cache_get(sae, addrs, pw_hash) == 0)
+			goto done;
+	}
+
+	if ((sae->tmp->ec && sae_derive_pwe_ecc(sae, addr1, addr2, password,
+						password_len) < 0) ||
+	    (sae->tmp->dh && sae_derive_pwe_ffc(sae, addr1, addr2, password,
+						password_len) < 0)) {
+		os_memset(pw_hash, 0, sizeof(pw_hash));
+		return -1;
+	}
+
+	if (use_cache)
+		sae_pwe_cache_add(sae, addrs, pw_hash);
+done:
+	os_memset(pw_hash, 0, sizeof(pw_hash));
+	return 0;
+}
+
+
 int sae_prepare_commit(const u8 *addr1, const u8 *addr2,
 		       const u8 *password, size_t password_len,
 		       struct sae_data *sae)
 {
 	if (sae->tmp == NULL ||
-	    (sae->tmp->ec && sae_derive_pwe_ecc(sae, addr1, addr2, password,
-						password_len) < 0) ||
-	    (sae->tmp->dh && sae_derive_pwe_ffc(sae, addr1, addr2, password,
-						password_len) < 0) ||
+	    sae_derive_pwe(sae, addr1, addr2, password, password_len) < 0 ||
 	    sae_derive_commit(sae) < 0)
 		return -1;
 	return 0;
@@ -22,6 +22,9 @@
 #define SAE_COMMIT_MAX_LEN (2 + 3 * SAE_MAX_PRIME_LEN)
 #define SAE_CONFIRM_MAX_LEN (2 + SAE_MAX_PRIME_LEN)
 
+/* Upper bound for sae_pwe_cache_set_size() */
+#define SAE_PWE_CACHE_MAX_SIZE 1024
+
 /* Special value returned by sae_parse_commit() */
 #define SAE_SILENTLY_DISCARD 65535
 
@@ -71,5 +74,7 @@ u16 sae_parse_commit(struct sae_data *sae, const u8 *data, size_t len,
 void sae_write_confirm(struct sae_data *sae, struct wpabuf *buf);
 int sae_check_confirm(struct sae_data *sae, const u8 *data, size_t len);
 u16 sae_group_allowed(struct sae_data *sae, int *allowed_groups, u16 group);
+void sae_pwe_cache_set_size(unsigned int size);
+void sae_pwe_cache_flush(void);
 
 #endif /* SAE_H */
@@ -32,6 +32,7 @@
 
 #include "wpa_ctrl.h"
 #include "common.h"
+#include "list.h"
 
 
 #if defined(CONFIG_CTRL_IFACE_UNIX) || defined(CONFIG_CTRL_IFACE_UDP)
@@ -39,6 +40,46 @@
 #endif /* CONFIG_CTRL_IFACE_UNIX || CONFIG_CTRL_IFACE_UDP */
 
 
+#ifdef CTRL_IFACE_SOCKET
+/* Maximum number of requests sent without having received their replies */
+#define WPA_CTRL_MAX_IN_FLIGHT 8
+#define WPA_CTRL_REQUEST_TIMEOUT 10000
+/* Time to wait for the reply to a timed out or cancelled request (ms) */
+#define WPA_CTRL_LATE_REPLY_WAIT 1000
+#define WPA_CTRL_RECV_BUF_MIN 4096
+
+/**
+ * struct wpa_ctrl_req - Pending control interface request
+ *
+ * The control interface protocol does not carry any request identifiers.
+ * wpa_supplicant and hostapd process the commands from a client socket in
+ * order and send exactly one reply for each of them, so the replies are
+ * matched to the requests in the order the requests were sent.
+ *
+ * A request that was sent, but timed out or was cancelled, is abandoned: it
+ * keeps its place in the queue for WPA_CTRL_LATE_REPLY_WAIT so that a late
+ * reply is not matched to a later request, and no new requests are sent
+ * during that time. If the reply does not arrive by then, it is assumed to be
+ * lost (e.g., the daemon failed to send it) and the request is dropped.
+ */
+struct wpa_ctrl_req {
+	struct dl_list list;
+	int id;
+	int sent;
+	int abandoned; /* timed out or cancelled; reply will be discarded */
+	struct os_reltime deadline; /* drop time once abandoned */
+	size_t reply_len;
+	void (*cb)(void *ctx, int id, int status, char *reply,
+		   size_t reply_len);
+	void *ctx;
+	size_t cmd_len;
+	char cmd[];
+};
+
+static void wpa_ctrl_flush_requests(struct wpa_ctrl *ctrl);
+#endif /* CTRL_IFACE_SOCKET */
+
+
 /**
  * struct wpa_ctrl - Internal structure for control interface library
  *
@@ -66,10 +107,25 @@ struct wpa_ctrl {
 	int s;
 	struct sockaddr_un local;
 	struct sockaddr_un dest;
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	int stream;
+#endif /* CONFIG_CTRL_IFACE_STREAM */
 #endif /* CONFIG_CTRL_IFACE_UNIX */
 #ifdef CONFIG_CTRL_IFACE_NAMED_PIPE
 	HANDLE pipe;
 #endif /* CONFIG_CTRL_IFACE_NAMED_PIPE */
+#ifdef CTRL_IFACE_SOCKET
+	struct dl_list requests; /* struct wpa_ctrl_req; in sending order */
+	unsigned int in_flight;
+	unsigned int abandoned; /* abandoned requests in flight */
+	int next_id;
+	unsigned int timeout;
+	char *rbuf;
+	size_t rbuf_len;
+	void (*event_cb)(void *ctx, char *msg, size_t len);
+	void *event_ctx;
+	void (*msg_cb)(char *msg, size_t len);
+#endif /* CTRL_IFACE_SOCKET */
 };
 
 
@@ -105,6 +161,7 @@ struct wpa_ctrl * wpa_ctrl_open2(const char *ctrl_path,
 	ctrl = os_zalloc(sizeof(*ctrl));
 	if (ctrl == NULL)
 		return NULL;
+	dl_list_init(&ctrl->requests);
 
 	ctrl->s = socket(PF_UNIX, SOCK_DGRAM, 0);
 	if (ctrl->s < 0) {
@@ -230,13 +287,149 @@ try_again:
 }
 
 
+#ifdef CONFIG_CTRL_IFACE_STREAM
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif /* MSG_NOSIGNAL */
+
+struct wpa_ctrl * wpa_ctrl_open_stream(const char *ctrl_path)
+{
+	struct wpa_ctrl *ctrl;
+	int ret;
+
+	if (ctrl_path == NULL)
+		return NULL;
+
+	ctrl = os_zalloc(sizeof(*ctrl));
+	if (ctrl == NULL)
+		return NULL;
+	dl_list_init(&ctrl->requests);
+	ctrl->stream = 1;
+
+	ctrl->dest.sun_family = AF_UNIX;
+	ret = os_snprintf(ctrl->dest.sun_path, sizeof(ctrl->dest.sun_path),
+			  "%s" WPA_CTRL_STREAM_SUFFIX, ctrl_path);
+	if (os_snprintf_error(sizeof(ctrl->dest.sun_path), ret)) {
+		os_free(ctrl);
+		return NULL;
+	}
+
+	ctrl->s = socket(PF_UNIX, SOCK_STREAM, 0);
+	if (ctrl->s < 0) {
+		os_free(ctrl);
+		return NULL;
+	}
+
+	if (connect(ctrl->s, (struct sockaddr *) &ctrl->dest,
+		    sizeof(ctrl->dest)) < 0) {
+		close(ctrl->s);
+		os_free(ctrl);
+		return NULL;
+	}
+
+	return ctrl;
+}
+
+
+static int wpa_ctrl_stream_read(struct wpa_ctrl *ctrl, void *buf, size_t len)
+{
+	u8 *pos = buf;
+	int res;
+
+	while (len > 0) {
+		res = recv(ctrl->s, pos, len, 0);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			return -1;
+		pos += res;
+		len -= res;
+	}
+
+	return 0;
+}
+
+
+static int wpa_ctrl_stream_recv(struct wpa_ctrl *ctrl, char *buf, size_t len)
+{
+	u8 hdr[WPA_CTRL_STREAM_HDR_LEN];
+	char discard[256];
+	size_t msg_len, copy, skip;
+
+	if (wpa_ctrl_stream_read(ctrl, hdr, sizeof(hdr)) < 0)
+		return -1;
+	msg_len = WPA_GET_BE32(hdr);
+
+	/* Truncate messages that do not fit into the buffer */
+	copy = msg_len < len ? msg_len : len;
+	if (wpa_ctrl_stream_read(ctrl, buf, copy) < 0)
+		return -1;
+	for (skip = msg_len - copy; skip > 0; skip -= copy) {
+		copy = skip < sizeof(discard) ? skip : sizeof(discard);
+		if (wpa_ctrl_stream_read(ctrl, discard, copy) < 0)
+			return -1;
+	}
+
+	return msg_len < len ? msg_len : len;
+}
+
+
+static int wpa_ctrl_stream_send(struct wpa_ctrl *ctrl, const char *buf,
+				size_t len)
+{
+	u8 hdr[WPA_CTRL_STREAM_HDR_LEN];
+	struct msghdr msg;
+	struct iovec io[2];
+	size_t sent = 0, total = sizeof(hdr) + len;
+	int res;
+
+	if (len > WPA_CTRL_STREAM_MAX_CMD_LEN) {
+		errno = EMSGSIZE;
+		return -1;
+	}
+
+	WPA_PUT_BE32(hdr, len);
+	while (sent < total) {
+		os_memset(&msg, 0, sizeof(msg));
+		if (sent < sizeof(hdr)) {
+			io[0].iov_base = hdr + sent;
+			io[0].iov_len = sizeof(hdr) - sent;
+			io[1].iov_base = (char *) buf;
+			io[1].iov_len = len;
+			msg.msg_iovlen = 2;
+		} else {
+			io[0].iov_base = (char *) buf + sent - sizeof(hdr);
+			io[0].iov_len = total - sent;
+			msg.msg_iovlen = 1;
+		}
+		msg.msg_iov = io;
+		res = sendmsg(ctrl->s, &msg, MSG_NOSIGNAL);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res < 0)
+			return -1;
+		sent += res;
+	}
+
+	return len;
+}
+
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+
+
 void wpa_ctrl_close(struct wpa_ctrl *ctrl)
 {
 	if (ctrl == NULL)
 		return;
-	unlink(ctrl->local.sun_path);
+	wpa_ctrl_flush_requests(ctrl);
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	if (!ctrl->stream)
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+		unlink(ctrl->local.sun_path);
 	if (ctrl->s >= 0)
 		close(ctrl->s);
+	os_free(ctrl->rbuf);
 	os_free(ctrl);
 }
 
@@ -303,6 +496,7 @@ struct wpa_ctrl * wpa_ctrl_open(const char *ctrl_path)
 	ctrl = os_zalloc(sizeof(*ctrl));
 	if (ctrl == NULL)
 		return NULL;
+	dl_list_init(&ctrl->requests);
 
 #ifdef CONFIG_CTRL_IFACE_UDP_IPV6
 	ctrl->s = socket(PF_INET6, SOCK_DGRAM, 0);
@@ -454,7 +648,9 @@ char * wpa_ctrl_get_remote_ifname(struct wpa_ctrl *ctrl)
 
 void wpa_ctrl_close(struct wpa_ctrl *ctrl)
 {
+	wpa_ctrl_flush_requests(ctrl);
 	close(ctrl->s);
+	os_free(ctrl->rbuf);
 	os_free(ctrl->cookie);
 	os_free(ctrl->remote_ifname);
 	os_free(ctrl->remote_ip);
@@ -465,43 +661,54 @@ void wpa_ctrl_close(struct wpa_ctrl *ctrl)
 
 
 #ifdef CTRL_IFACE_SOCKET
-int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
-		     char *reply, size_t *reply_len,
-		     void (*msg_cb)(char *msg, size_t len))
+static int wpa_ctrl_sock_send(struct wpa_ctrl *ctrl, const char *buf,
+			      size_t len)
 {
-	struct timeval tv;
-	struct os_reltime started_at;
-	int res;
-	fd_set rfds;
-	const char *_cmd;
-	char *cmd_buf = NULL;
-	size_t _cmd_len;
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	if (ctrl->stream)
+		return wpa_ctrl_stream_send(ctrl, buf, len);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+	return send(ctrl->s, buf, len, 0);
+}
 
-#ifdef CONFIG_CTRL_IFACE_UDP
-	if (ctrl->cookie) {
-		char *pos;
-		_cmd_len = os_strlen(ctrl->cookie) + 1 + cmd_len;
-		cmd_buf = os_malloc(_cmd_len);
-		if (cmd_buf == NULL)
-			return -1;
-		_cmd = cmd_buf;
-		pos = cmd_buf;
-		os_strlcpy(pos, ctrl->cookie, _cmd_len);
-		pos += os_strlen(ctrl->cookie);
-		*pos++ = ' ';
-		os_memcpy(pos, cmd, cmd_len);
-	} else
-#endif /* CONFIG_CTRL_IFACE_UDP */
-	{
-		_cmd = cmd;
-		_cmd_len = cmd_len;
+
+static int wpa_ctrl_sock_recv(struct wpa_ctrl *ctrl, char *buf, size_t len)
+{
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	if (ctrl->stream)
+		return wpa_ctrl_stream_recv(ctrl, buf, len);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+	return recv(ctrl->s, buf, len, 0);
+}
+
+
+static int wpa_ctrl_sock_recv_nowait(struct wpa_ctrl *ctrl, char *buf,
+				     size_t len)
+{
+#ifdef MSG_DONTWAIT
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	if (!ctrl->stream)
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+		return recv(ctrl->s, buf, len, MSG_DONTWAIT);
+#endif /* MSG_DONTWAIT */
+	if (wpa_ctrl_pending(ctrl) <= 0) {
+		errno = EAGAIN;
+		return -1;
 	}
+	return wpa_ctrl_sock_recv(ctrl, buf, len);
+}
+
+
+static int wpa_ctrl_send_cmd(struct wpa_ctrl *ctrl, const char *cmd,
+			     size_t cmd_len)
+{
+	struct os_reltime started_at;
 
 	errno = 0;
 	started_at.sec = 0;
 	started_at.usec = 0;
 retry_send:
-	if (send(ctrl->s, _cmd, _cmd_len, 0) < 0) {
+	if (wpa_ctrl_sock_send(ctrl, cmd, cmd_len) < 0) {
 		if (errno == EAGAIN || errno == EBUSY || errno == EWOULDBLOCK)
 		{
 			/*
@@ -515,51 +722,582 @@ retry_send:
 				os_get_reltime(&n);
 				/* Try for a few seconds. */
 				if (os_reltime_expired(&n, &started_at, 5))
-					goto send_err;
+					return -1;
 			}
 			os_sleep(1, 0);
 			goto retry_send;
 		}
-	send_err:
-		os_free(cmd_buf);
 		return -1;
 	}
-	os_free(cmd_buf);
 
-	for (;;) {
-		tv.tv_sec = 10;
-		tv.tv_usec = 0;
+	return 0;
+}
+
+
+static int wpa_ctrl_rbuf_alloc(struct wpa_ctrl *ctrl, size_t len)
+{
+	char *buf;
+
+	if (len < WPA_CTRL_RECV_BUF_MIN)
+		len = WPA_CTRL_RECV_BUF_MIN;
+	if (ctrl->rbuf && ctrl->rbuf_len >= len)
+		return 0;
+
+	/* Reserve room for nul termination */
+	buf = os_realloc(ctrl->rbuf, len + 1);
+	if (buf == NULL)
+		return -1;
+	ctrl->rbuf = buf;
+	ctrl->rbuf_len = len;
+	return 0;
+}
+
+
+static void wpa_ctrl_req_remove(struct wpa_ctrl *ctrl,
+				struct wpa_ctrl_req *req)
+{
+	dl_list_del(&req->list);
+	if (req->sent)
+		ctrl->in_flight--;
+	if (req->abandoned)
+		ctrl->abandoned--;
+	os_free(req);
+}
+
+
+static void wpa_ctrl_set_deadline(struct os_reltime *deadline,
+				  unsigned int timeout)
+{
+	os_get_reltime(deadline);
+	deadline->sec += timeout / 1000;
+	deadline->usec += (timeout % 1000) * 1000;
+	if (deadline->usec >= 1000000) {
+		deadline->sec++;
+		deadline->usec -= 1000000;
+	}
+}
+
+
+/* Mark a request that was already sent as abandoned */
+static void wpa_ctrl_req_abandon(struct wpa_ctrl *ctrl,
+				 struct wpa_ctrl_req *req)
+{
+	req->abandoned = 1;
+	ctrl->abandoned++;
+	wpa_ctrl_set_deadline(&req->deadline, WPA_CTRL_LATE_REPLY_WAIT);
+}
+
+
+static int wpa_ctrl_can_send(struct wpa_ctrl *ctrl)
+{
+	/*
+	 * Hold new requests while the reply to an abandoned request may still
+	 * arrive. If that reply was lost, the replies to any requests sent
+	 * after it would be matched to the wrong requests.
+	 */
+	return ctrl->in_flight < WPA_CTRL_MAX_IN_FLIGHT && !ctrl->abandoned;
+}
+
+
+static int wpa_ctrl_send_queued(struct wpa_ctrl *ctrl)
+{
+	struct wpa_ctrl_req *req;
+
+	dl_list_for_each(req, &ctrl->requests, struct wpa_ctrl_req, list) {
+		if (!wpa_ctrl_can_send(ctrl))
+			break;
+		if (req->sent)
+			continue;
+		if (wpa_ctrl_send_cmd(ctrl, req->cmd, req->cmd_len) < 0)
+			return -1;
+		req->sent = 1;
+		ctrl->in_flight++;
+	}
+
+	return 0;
+}
+
+
+static void wpa_ctrl_flush_requests(struct wpa_ctrl *ctrl)
+{
+	struct wpa_ctrl_req *req, *tmp;
+
+	dl_list_for_each_safe(req, tmp, &ctrl->requests, struct wpa_ctrl_req,
+			      list)
+		wpa_ctrl_req_remove(ctrl, req);
+}
+
+
+static void wpa_ctrl_fail_requests(struct wpa_ctrl *ctrl)
+{
+	struct wpa_ctrl_req *req;
+	unsigned int count;
+	void (*cb)(void *ctx, int id, int status, char *reply,
+		   size_t reply_len);
+	void *ctx;
+	int id, abandoned;
+
+	/*
+	 * Callbacks may add new requests; only fail the ones that were pending
+	 * when the connection failed.
+	 */
+	count = dl_list_len(&ctrl->requests);
+	while (count-- > 0) {
+		req = dl_list_first(&ctrl->requests, struct wpa_ctrl_req, list);
+		if (req == NULL)
+			break;
+		cb = req->cb;
+		ctx = req->ctx;
+		id = req->id;
+		abandoned = req->abandoned;
+		wpa_ctrl_req_remove(ctrl, req);
+		if (cb && !abandoned)
+			cb(ctx, id, -1, NULL, 0);
+	}
+}
+
+
+static int wpa_ctrl_expire_requests(struct wpa_ctrl *ctrl)
+{
+	struct wpa_ctrl_req *req, *prev;
+	struct os_reltime now;
+	void (*cb)(void *ctx, int id, int status, char *reply,
+		   size_t reply_len);
+	void *ctx;
+	int id;
+
+	os_get_reltime(&now);
+restart:
+	dl_list_for_each(req, &ctrl->requests, struct wpa_ctrl_req, list) {
+		if (os_reltime_before(&now, &req->deadline))
+			continue;
+		if (req->abandoned) {
+			/* The reply was lost; stop waiting for it */
+			wpa_ctrl_req_remove(ctrl, req);
+			goto restart;
+		}
+		cb = req->cb;
+		ctx = req->ctx;
+		id = req->id;
+		if (req->sent) {
+			/*
+			 * The replies to the abandoned requests before this one
+			 * would have arrived before the reply to this one, so
+			 * they were lost. The reply to this request may still
+			 * arrive, so keep the place in the queue to avoid
+			 * matching it to a later request.
+			 */
+			while ((prev = dl_list_first(&ctrl->requests,
+						     struct wpa_ctrl_req,
+						     list)) != req &&
+			       prev->abandoned)
+				wpa_ctrl_req_remove(ctrl, prev);
+			wpa_ctrl_req_abandon(ctrl, req);
+		} else {
+			wpa_ctrl_req_remove(ctrl, req);
+		}
+		if (cb)
+			cb(ctx, id, -2, NULL, 0);
+		/* The callback may have modified the list */
+		goto restart;
+	}
+
+	return wpa_ctrl_send_queued(ctrl);
+}
+
+
+static int wpa_ctrl_process_msgs(struct wpa_ctrl *ctrl, const int *stop)
+{
+	struct wpa_ctrl_req *req;
+	void (*cb)(void *ctx, int id, int status, char *reply,
+		   size_t reply_len);
+	void *ctx;
+	int id, abandoned, res, count = 0;
+	size_t len;
+
+	if (wpa_ctrl_rbuf_alloc(ctrl, 0) < 0)
+		return -1;
+
+	while (stop == NULL || !*stop) {
+		res = wpa_ctrl_sock_recv_nowait(ctrl, ctrl->rbuf,
+						ctrl->rbuf_len);
+		if (res < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK ||
+			    errno == EINTR)
+				break;
+			wpa_ctrl_fail_requests(ctrl);
+			return -1;
+		}
+		count++;
+		ctrl->rbuf[res] = '\0';
+
+		if (res > 0 && ctrl->rbuf[0] == '<') {
+			/* This is an unsolicited message from wpa_supplicant,
+			 * not a reply to any of the requests. */
+			if (ctrl->msg_cb)
+				ctrl->msg_cb(ctrl->rbuf, res);
+			else if (ctrl->event_cb)
+				ctrl->event_cb(ctrl->event_ctx, ctrl->rbuf,
+					       res);
+			continue;
+		}
+
+		req = dl_list_first(&ctrl->requests, struct wpa_ctrl_req,
+				    list);
+		if (req == NULL || !req->sent)
+			continue; /* reply to no known request */
+
+		cb = req->cb;
+		ctx = req->ctx;
+		id = req->id;
+		abandoned = req->abandoned;
+		len = (size_t) res < req->reply_len ? (size_t) res :
+			req->reply_len;
+		wpa_ctrl_req_remove(ctrl, req);
+		if (cb && !abandoned) {
+			ctrl->rbuf[len] = '\0';
+			cb(ctx, id, 0, ctrl->rbuf, len);
+		}
+
+		if (wpa_ctrl_send_queued(ctrl) < 0) {
+			wpa_ctrl_fail_requests(ctrl);
+			return -1;
+		}
+	}
+
+	return count;
+}
+
+
+int wpa_ctrl_request_async(struct wpa_ctrl *ctrl, const char *cmd,
+			   size_t cmd_len, size_t reply_len,
+			   void (*cb)(void *ctx, int id, int status,
+				      char *reply, size_t reply_len),
+			   void *ctx)
+{
+	struct wpa_ctrl_req *req;
+	unsigned int timeout;
+	size_t len = cmd_len;
+	char *pos;
+
+	if (wpa_ctrl_rbuf_alloc(ctrl, reply_len) < 0)
+		return -1;
+
+#ifdef CONFIG_CTRL_IFACE_UDP
+	if (ctrl->cookie)
+		len += os_strlen(ctrl->cookie) + 1;
+#endif /* CONFIG_CTRL_IFACE_UDP */
+	req = os_zalloc(sizeof(*req) + len);
+	if (req == NULL)
+		return -1;
+	pos = req->cmd;
+#ifdef CONFIG_CTRL_IFACE_UDP
+	if (ctrl->cookie) {
+		os_memcpy(pos, ctrl->cookie, os_strlen(ctrl->cookie));
+		pos += os_strlen(ctrl->cookie);
+		*pos++ = ' ';
+	}
+#endif /* CONFIG_CTRL_IFACE_UDP */
+	os_memcpy(pos, cmd, cmd_len);
+	req->cmd_len = len;
+	req->reply_len = reply_len;
+	req->cb = cb;
+	req->ctx = ctx;
+
+	timeout = ctrl->timeout ? ctrl->timeout : WPA_CTRL_REQUEST_TIMEOUT;
+	wpa_ctrl_set_deadline(&req->deadline, timeout);
+
+	/*
+	 * Requests are queued only while they cannot be sent, and the queued
+	 * ones are sent as soon as that changes, so there cannot be any earlier
+	 * unsent requests here.
+	 */
+	if (wpa_ctrl_can_send(ctrl)) {
+		if (wpa_ctrl_send_cmd(ctrl, req->cmd, req->cmd_len) < 0) {
+			os_free(req);
+			return -1;
+		}
+		req->sent = 1;
+		ctrl->in_flight++;
+	}
+
+	if (ctrl->next_id == 0x7fffffff)
+		ctrl->next_id = 0;
+	req->id = ++ctrl->next_id;
+	dl_list_add_tail(&ctrl->requests, &req->list);
+
+	return req->id;
+}
+
+
+int wpa_ctrl_cancel(struct wpa_ctrl *ctrl, int id)
+{
+	struct wpa_ctrl_req *req;
+
+	dl_list_for_each(req, &ctrl->requests, struct wpa_ctrl_req, list) {
+		if (req->id != id || req->abandoned)
+			continue;
+		if (req->sent)
+			wpa_ctrl_req_abandon(ctrl, req);
+		else
+			wpa_ctrl_req_remove(ctrl, req);
+		return 0;
+	}
+
+	return -1;
+}
+
+
+int wpa_ctrl_process(struct wpa_ctrl *ctrl)
+{
+	int res;
+
+	res = wpa_ctrl_process_msgs(ctrl, NULL);
+	if (res < 0)
+		return -1;
+	if (wpa_ctrl_expire_requests(ctrl) < 0) {
+		wpa_ctrl_fail_requests(ctrl);
+		return -1;
+	}
+	return res;
+}
+
+
+int wpa_ctrl_next_timeout(struct wpa_ctrl *ctrl)
+{
+	struct wpa_ctrl_req *req, *next = NULL;
+	struct os_reltime now, diff;
+
+	dl_list_for_each(req, &ctrl->requests, struct wpa_ctrl_req, list) {
+		if (next == NULL ||
+		    os_reltime_before(&req->deadline, &next->deadline))
+			next = req;
+	}
+	if (next == NULL)
+		return -1;
+
+	os_get_reltime(&now);
+	if (!os_reltime_before(&now, &next->deadline))
+		return 0;
+	os_reltime_sub(&next->deadline, &now, &diff);
+	return diff.sec * 1000 + (diff.usec + 999) / 1000;
+}
+
+
+void wpa_ctrl_set_event_cb(struct wpa_ctrl *ctrl,
+			   void (*event_cb)(void *ctx, char *msg, size_t len),
+			   void *ctx)
+{
+	ctrl->event_cb = event_cb;
+	ctrl->event_ctx = ctx;
+}
+
+
+void wpa_ctrl_set_timeout(struct wpa_ctrl *ctrl, unsigned int timeout)
+{
+	ctrl->timeout = timeout;
+}
+
+
+struct wpa_ctrl_sync {
+	int done;
+	int status;
+	char *reply;
+	size_t reply_len;
+};
+
+
+static void wpa_ctrl_sync_cb(void *ctx, int id, int status, char *reply,
+			     size_t reply_len)
+{
+	struct wpa_ctrl_sync *sync = ctx;
+
+	sync->done = 1;
+	sync->status = status;
+	if (status == 0) {
+		os_memcpy(sync->reply, reply, reply_len);
+		sync->reply_len = reply_len;
+	}
+}
+
+
+int wpa_ctrl_request(struct wpa_ctrl *ctrl, const char *cmd, size_t cmd_len,
+		     char *reply, size_t *reply_len,
+		     void (*msg_cb)(char *msg, size_t len))
+{
+	struct wpa_ctrl_sync sync;
+	void (*prev_msg_cb)(char *msg, size_t len);
+	struct timeval tv;
+	fd_set rfds;
+	int id, res, timeout;
+
+	os_memset(&sync, 0, sizeof(sync));
+	sync.reply = reply;
+	id = wpa_ctrl_request_async(ctrl, cmd, cmd_len, *reply_len,
+				    wpa_ctrl_sync_cb, &sync);
+	if (id < 0)
+		return -1;
+
+	/*
+	 * Replies to earlier asynchronous requests on the same connection are
+	 * delivered to their callbacks while waiting here.
+	 */
+	prev_msg_cb = ctrl->msg_cb;
+	ctrl->msg_cb = msg_cb;
+	while (!sync.done) {
+		timeout = wpa_ctrl_next_timeout(ctrl);
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
 		FD_ZERO(&rfds);
 		FD_SET(ctrl->s, &rfds);
 		res = select(ctrl->s + 1, &rfds, NULL, NULL, &tv);
-		if (res < 0)
+		if (res > 0 &&
+		    wpa_ctrl_process_msgs(ctrl, &sync.done) < 0 && !sync.done)
+			res = -1;
+		if (res < 0) {
+			wpa_ctrl_cancel(ctrl, id);
+			ctrl->msg_cb = prev_msg_cb;
 			return res;
-		if (FD_ISSET(ctrl->s, &rfds)) {
-			res = recv(ctrl->s, reply, *reply_len, 0);
-			if (res < 0)
-				return res;
-			if (res > 0 && reply[0] == '<') {
-				/* This is an unsolicited message from
-				 * wpa_supplicant, not the reply to the
-				 * request. Use msg_cb to report this to the
-				 * caller. */
-				if (msg_cb) {
-					/* Make sure the message is nul
-					 * terminated. */
-					if ((size_t) res == *reply_len)
-						res = (*reply_len) - 1;
-					reply[res] = '\0';
-					msg_cb(reply, res);
-				}
-				continue;
-			}
-			*reply_len = res;
-			break;
-		} else {
-			return -2;
+		}
+		if (!sync.done && wpa_ctrl_expire_requests(ctrl) < 0) {
+			wpa_ctrl_fail_requests(ctrl);
+			ctrl->msg_cb = prev_msg_cb;
+			return -1;
 		}
 	}
-	return 0;
+	ctrl->msg_cb = prev_msg_cb;
+
+	if (sync.status == 0)
+		*reply_len = sync.reply_len;
+	return sync.status;
+}
+
+
+struct wpa_ctrl_pool_conn {
+	struct dl_list list;
+	struct wpa_ctrl *ctrl;
+	char *path;
+};
+
+struct wpa_ctrl_pool {
+	struct dl_list conns; /* struct wpa_ctrl_pool_conn */
+	void (*conn_cb)(void *ctx, struct wpa_ctrl *ctrl, int added);
+	void *ctx;
+};
+
+
+struct wpa_ctrl_pool *
+wpa_ctrl_pool_init(void (*conn_cb)(void *ctx, struct wpa_ctrl *ctrl,
+				   int added),
+		   void *ctx)
+{
+	struct wpa_ctrl_pool *pool;
+
+	pool = os_zalloc(sizeof(*pool));
+	if (pool == NULL)
+		return NULL;
+	dl_list_init(&pool->conns);
+	pool->conn_cb = conn_cb;
+	pool->ctx = ctx;
+	return pool;
+}
+
+
+static void wpa_ctrl_pool_conn_free(struct wpa_ctrl_pool *pool,
+				    struct wpa_ctrl_pool_conn *conn)
+{
+	dl_list_del(&conn->list);
+	if (pool->conn_cb)
+		pool->conn_cb(pool->ctx, conn->ctrl, 0);
+	wpa_ctrl_close(conn->ctrl);
+	os_free(conn->path);
+	os_free(conn);
+}
+
+
+void wpa_ctrl_pool_deinit(struct wpa_ctrl_pool *pool)
+{
+	struct wpa_ctrl_pool_conn *conn;
+
+	if (pool == NULL)
+		return;
+	while ((conn = dl_list_first(&pool->conns, struct wpa_ctrl_pool_conn,
+				     list)))
+		wpa_ctrl_pool_conn_free(pool, conn);
+	os_free(pool);
+}
+
+
+struct wpa_ctrl * wpa_ctrl_pool_get(struct wpa_ctrl_pool *pool,
+				    const char *ctrl_path)
+{
+	struct wpa_ctrl_pool_conn *conn;
+	const char *key = ctrl_path ? ctrl_path : "";
+
+	dl_list_for_each(conn, &pool->conns, struct wpa_ctrl_pool_conn, list) {
+		if (os_strcmp(conn->path, key) == 0)
+			return conn->ctrl;
+	}
+
+	conn = os_zalloc(sizeof(*conn));
+	if (conn == NULL)
+		return NULL;
+	conn->path = os_strdup(key);
+	if (conn->path == NULL) {
+		os_free(conn);
+		return NULL;
+	}
+	conn->ctrl = wpa_ctrl_open(ctrl_path);
+	if (conn->ctrl == NULL) {
+		os_free(conn->path);
+		os_free(conn);
+		return NULL;
+	}
+	dl_list_add(&pool->conns, &conn->list);
+	if (pool->conn_cb)
+		pool->conn_cb(pool->ctx, conn->ctrl, 1);
+
+	return conn->ctrl;
+}
+
+
+void wpa_ctrl_pool_drop(struct wpa_ctrl_pool *pool, struct wpa_ctrl *ctrl)
+{
+	struct wpa_ctrl_pool_conn *conn;
+
+	dl_list_for_each(conn, &pool->conns, struct wpa_ctrl_pool_conn, list) {
+		if (conn->ctrl == ctrl) {
+			wpa_ctrl_pool_conn_free(pool, conn);
+			return;
+		}
+	}
+}
+
+
+void wpa_ctrl_pool_process(struct wpa_ctrl_pool *pool)
+{
+	struct wpa_ctrl_pool_conn *conn, *tmp;
+
+	dl_list_for_each_safe(conn, tmp, &pool->conns,
+			      struct wpa_ctrl_pool_conn, list) {
+		if (wpa_ctrl_process(conn->ctrl) < 0)
+			wpa_ctrl_pool_conn_free(pool, conn);
+	}
+}
+
+
+int wpa_ctrl_pool_next_timeout(struct wpa_ctrl_pool *pool)
+{
+	struct wpa_ctrl_pool_conn *conn;
+	int timeout, next = -1;
+
+	dl_list_for_each(conn, &pool->conns, struct wpa_ctrl_pool_conn, list) {
+		timeout = wpa_ctrl_next_timeout(conn->ctrl);
+		if (timeout >= 0 && (next < 0 || timeout < next))
+			next = timeout;
+	}
+
+	return next;
 }
 #endif /* CTRL_IFACE_SOCKET */
 
@@ -598,7 +1336,7 @@ int wpa_ctrl_recv(struct wpa_ctrl *ctrl, char *reply, size_t *reply_len)
 {
 	int res;
 
-	res = recv(ctrl->s, reply, *reply_len, 0);
+	res = wpa_ctrl_sock_recv(ctrl, reply, *reply_len);
 	if (res < 0)
 		return res;
 	*reply_len = res;
@@ -101,6 +101,9 @@ extern "C" {
 #define WPA_EVENT_FREQ_CONFLICT "CTRL-EVENT-FREQ-CONFLICT "
 /** Frequency ranges that the driver recommends to avoid */
 #define WPA_EVENT_AVOID_FREQ "CTRL-EVENT-AVOID-FREQ "
+/** Event messages were dropped because the monitor did not receive them fast
+ * enough (count=<number of dropped messages>) */
+#define WPA_EVENT_MONITOR_DROPPED "CTRL-EVENT-MONITOR-DROPPED "
 /** WPS overlap detected in PBC mode */
 #define WPS_EVENT_OVERLAP "WPS-OVERLAP-DETECTED "
 /** Available WPS AP with active PBC found in scan results */
@@ -345,6 +348,33 @@ struct wpa_ctrl * wpa_ctrl_open(const char *ctrl_path);
  */
 struct wpa_ctrl * wpa_ctrl_open2(const char *ctrl_path, const char *cli_path);
 
+#ifdef CONFIG_CTRL_IFACE_STREAM
+/*
+ * Stream control interface socket. This is a SOCK_STREAM UNIX domain socket
+ * next to the datagram socket with WPA_CTRL_STREAM_SUFFIX appended to its
+ * name. Each command, reply, and event message is preceded by its length as a
+ * 32-bit unsigned integer in network byte order. Commands on a connection are
+ * processed in order, so multiple commands can be sent without waiting for the
+ * replies. Replies are not limited to the datagram size.
+ */
+#define WPA_CTRL_STREAM_SUFFIX ".stream"
+#define WPA_CTRL_STREAM_HDR_LEN 4
+#define WPA_CTRL_STREAM_MAX_CMD_LEN 65536
+
+/**
+ * wpa_ctrl_open_stream - Open a stream control interface connection
+ * @ctrl_path: Path for the datagram UNIX domain socket of the interface
+ * Returns: Pointer to abstract control interface data or %NULL on failure
+ *
+ * This function is used to open a connection to the stream control interface
+ * socket of wpa_supplicant, i.e., ctrl_path with WPA_CTRL_STREAM_SUFFIX
+ * appended. The returned connection can be used with the other wpa_ctrl_*()
+ * functions in the same way as a connection from wpa_ctrl_open(). No client
+ * socket file is created for stream connections.
+ */
+struct wpa_ctrl * wpa_ctrl_open_stream(const char *ctrl_path);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+
 
 /**
  * wpa_ctrl_close - Close a control interface to wpa_supplicant/hostapd
@@ -367,9 +397,10 @@ void wpa_ctrl_close(struct wpa_ctrl *ctrl);
  *
  * This function is used to send commands to wpa_supplicant/hostapd. Received
  * response will be written to reply and reply_len is set to the actual length
- * of the reply. This function will block for up to two seconds while waiting
- * for the reply. If unsolicited messages are received, the blocking time may
- * be longer.
+ * of the reply. This function will block for up to ten seconds (see
+ * wpa_ctrl_set_timeout()) while waiting for the reply. Replies to earlier
+ * requests sent with wpa_ctrl_request_async() on the same connection are
+ * delivered to their callbacks while waiting.
  *
  * msg_cb can be used to register a callback function that will be called for
  * unsolicited messages received while waiting for the command response. These
@@ -456,6 +487,189 @@ int wpa_ctrl_pending(struct wpa_ctrl *ctrl);
  */
 int wpa_ctrl_get_fd(struct wpa_ctrl *ctrl);
 
+
+/*
+ * Asynchronous requests
+ *
+ * The following functions allow multiple requests to be outstanding on a
+ * single control interface connection and integrate the connection into an
+ * external event loop. They are available with UNIX domain and UDP sockets.
+ *
+ * The control interface protocol does not include request identifiers.
+ * Commands from a client socket are processed in order and answered with one
+ * reply each, so the library assigns the identifiers locally and matches the
+ * replies to the requests in sending order. Messages starting with '<' are
+ * unsolicited event messages and are delivered to the callback registered with
+ * wpa_ctrl_set_event_cb(). At most eight requests are sent without having
+ * received their replies; further requests are queued in the library to avoid
+ * overflowing the receive queue of the socket. After a request that was
+ * already sent times out or is cancelled, its late reply is waited for up to
+ * one second before the reply is assumed to be lost. Further requests are
+ * queued during that time so that their replies are not matched to the wrong
+ * requests.
+ *
+ * A typical event loop registers the file descriptor from wpa_ctrl_get_fd()
+ * for reading, calls wpa_ctrl_process() when it is readable, and uses
+ * wpa_ctrl_next_timeout() as the maximum time to wait. wpa_ctrl_recv() must
+ * not be used on a connection that has outstanding asynchronous requests
+ * since it would consume their replies.
+ */
+
+/**
+ * wpa_ctrl_request_async - Send a command without waiting for the reply
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @cmd: Command; usually, ASCII text, e.g., "PING"
+ * @cmd_len: Length of the cmd in bytes
+ * @reply_len: Maximum length of the reply; longer replies are truncated
+ * @cb: Callback function for the completion of the request or %NULL
+ * @ctx: Context data for the callback
+ * Returns: Request identifier (> 0) on success, -1 on failure
+ *
+ * The callback is called from wpa_ctrl_process() or wpa_ctrl_request() when
+ * the request is completed. status is 0 when the reply was received, -1 if
+ * receiving failed, or -2 on timeout (see wpa_ctrl_set_timeout()). The reply is
+ * nul terminated and only valid until the callback returns; it is %NULL if
+ * status is not 0.
+ */
+int wpa_ctrl_request_async(struct wpa_ctrl *ctrl, const char *cmd,
+			   size_t cmd_len, size_t reply_len,
+			   void (*cb)(void *ctx, int id, int status,
+				      char *reply, size_t reply_len),
+			   void *ctx);
+
+
+/**
+ * wpa_ctrl_cancel - Cancel an asynchronous request
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @id: Request identifier from wpa_ctrl_request_async()
+ * Returns: 0 on success, -1 if the request was not pending
+ *
+ * The callback of a cancelled request is not called. If the command was
+ * already sent, its reply is discarded when it is received.
+ */
+int wpa_ctrl_cancel(struct wpa_ctrl *ctrl, int id);
+
+
+/**
+ * wpa_ctrl_process - Process received messages and request timeouts
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * Returns: Number of received messages or -1 if the connection failed
+ *
+ * This function receives all pending messages without blocking, calls the
+ * request and event callbacks, and completes the requests that have timed out.
+ * It is called when the file descriptor from wpa_ctrl_get_fd() is readable and
+ * when the time from wpa_ctrl_next_timeout() has passed. On failure, all
+ * pending requests are completed with status -1 and the connection should be
+ * closed. The callbacks must not close the connection.
+ */
+int wpa_ctrl_process(struct wpa_ctrl *ctrl);
+
+
+/**
+ * wpa_ctrl_next_timeout - Get the time until the next request timeout
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * Returns: Time in milliseconds or -1 if no request is pending
+ *
+ * This includes the time after which a late reply to an abandoned request is
+ * no longer waited for, so wpa_ctrl_process() needs to be called at that point
+ * even if no callback is pending.
+ */
+int wpa_ctrl_next_timeout(struct wpa_ctrl *ctrl);
+
+
+/**
+ * wpa_ctrl_set_event_cb - Register a callback for event messages
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @event_cb: Callback function for event messages or %NULL to discard them
+ * @ctx: Context data for the callback
+ *
+ * The callback is called for the unsolicited messages received by
+ * wpa_ctrl_process() and by wpa_ctrl_request() calls that do not specify
+ * msg_cb. The message is nul terminated.
+ */
+void wpa_ctrl_set_event_cb(struct wpa_ctrl *ctrl,
+			   void (*event_cb)(void *ctx, char *msg, size_t len),
+			   void *ctx);
+
+
+/**
+ * wpa_ctrl_set_timeout - Set the timeout for new requests
+ * @ctrl: Control interface data from wpa_ctrl_open()
+ * @timeout: Timeout in milliseconds or 0 to use the default (10 seconds)
+ */
+void wpa_ctrl_set_timeout(struct wpa_ctrl *ctrl, unsigned int timeout);
+
+
+/*
+ * Connection pool
+ *
+ * A connection pool keeps one connection per control interface path open so
+ * that programs managing many interfaces can issue requests without opening a
+ * new client socket for each of them. The requests are multiplexed on the
+ * pooled connection with wpa_ctrl_request_async().
+ */
+struct wpa_ctrl_pool;
+
+/**
+ * wpa_ctrl_pool_init - Initialize a connection pool
+ * @conn_cb: Callback for added and removed connections or %NULL
+ * @ctx: Context data for the callback
+ * Returns: Pointer to the pool or %NULL on failure
+ *
+ * conn_cb is called with added=1 after a connection has been opened and with
+ * added=0 before a connection is closed. It can be used to register and
+ * unregister the file descriptor of the connection with an event loop.
+ */
+struct wpa_ctrl_pool *
+wpa_ctrl_pool_init(void (*conn_cb)(void *ctx, struct wpa_ctrl *ctrl,
+				   int added),
+		   void *ctx);
+
+/**
+ * wpa_ctrl_pool_deinit - Close all connections and free a connection pool
+ * @pool: Pool from wpa_ctrl_pool_init() or %NULL
+ */
+void wpa_ctrl_pool_deinit(struct wpa_ctrl_pool *pool);
+
+/**
+ * wpa_ctrl_pool_get - Get a pooled connection
+ * @pool: Pool from wpa_ctrl_pool_init()
+ * @ctrl_path: Control interface path as with wpa_ctrl_open()
+ * Returns: Connection for ctrl_path or %NULL on failure
+ *
+ * The connection is opened on the first use of ctrl_path and it remains owned
+ * by the pool, i.e., it must not be closed with wpa_ctrl_close().
+ */
+struct wpa_ctrl * wpa_ctrl_pool_get(struct wpa_ctrl_pool *pool,
+				    const char *ctrl_path);
+
+/**
+ * wpa_ctrl_pool_drop - Close a pooled connection
+ * @pool: Pool from wpa_ctrl_pool_init()
+ * @ctrl: Connection from wpa_ctrl_pool_get()
+ *
+ * This can be used after a connection has failed. The next
+ * wpa_ctrl_pool_get() call for the same path opens a new connection.
+ */
+void wpa_ctrl_pool_drop(struct wpa_ctrl_pool *pool, struct wpa_ctrl *ctrl);
+
+/**
+ * wpa_ctrl_pool_process - Process all connections in a pool
+ * @pool: Pool from wpa_ctrl_pool_init()
+ *
+ * This calls wpa_ctrl_process() for each connection and closes the
+ * connections that have failed. The request and event callbacks must not
+ * drop connections from the pool.
+ */
+void wpa_ctrl_pool_process(struct wpa_ctrl_pool *pool);
+
+/**
+ * wpa_ctrl_pool_next_timeout - Get the time until the next request timeout
+ * @pool: Pool from wpa_ctrl_pool_init()
+ * Returns: Time in milliseconds or -1 if no request is pending
+ */
+int wpa_ctrl_pool_next_timeout(struct wpa_ctrl_pool *pool);
+
 #ifdef ANDROID
 /**
  * wpa_ctrl_cleanup() - Delete any local UNIX domain socket files that
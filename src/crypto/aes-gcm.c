@@ -12,6 +12,7 @@
 #include "common.h"
 #include "aes.h"
 #include "aes_wrap.h"
+#include "crypto_accel.h"
 
 static void inc32(u8 *block)
 {
@@ -61,12 +62,81 @@ static void shift_right_block(u8 *v)
 }
 
 
+#ifdef CRYPTO_ACCEL_X86
+/*
+ * Multiplication in GF(2^128) using carry-less multiplication (PCLMULQDQ) as
+ * described in Intel's "Carry-Less Multiplication Instruction and its Usage
+ * for Computing the GCM Mode" white paper
+ */
+__attribute__((target("pclmul,sse4.1")))
+static void gf_mult_accel(const u8 *x, const u8 *y, u8 *z)
+{
+	const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+					   11, 12, 13, 14, 15);
+	__m128i a, b, t0, t1, t2, t3, t4, t5;
+
+	a = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) x), bswap);
+	b = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) y), bswap);
+
+	/* 256-bit carry-less product t3:t0 */
+	t0 = _mm_clmulepi64_si128(a, b, 0x00);
+	t1 = _mm_clmulepi64_si128(a, b, 0x10);
+	t2 = _mm_clmulepi64_si128(a, b, 0x01);
+	t3 = _mm_clmulepi64_si128(a, b, 0x11);
+	t1 = _mm_xor_si128(t1, t2);
+	t2 = _mm_slli_si128(t1, 8);
+	t1 = _mm_srli_si128(t1, 8);
+	t0 = _mm_xor_si128(t0, t2);
+	t3 = _mm_xor_si128(t3, t1);
+
+	/* shift the product left by one bit due to the reflected bit order */
+	t4 = _mm_srli_epi32(t0, 31);
+	t5 = _mm_srli_epi32(t3, 31);
+	t0 = _mm_slli_epi32(t0, 1);
+	t3 = _mm_slli_epi32(t3, 1);
+	t2 = _mm_srli_si128(t4, 12);
+	t5 = _mm_slli_si128(t5, 4);
+	t4 = _mm_slli_si128(t4, 4);
+	t0 = _mm_or_si128(t0, t4);
+	t3 = _mm_or_si128(t3, t5);
+	t3 = _mm_or_si128(t3, t2);
+
+	/* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+	t4 = _mm_slli_epi32(t0, 31);
+	t5 = _mm_slli_epi32(t0, 30);
+	t2 = _mm_slli_epi32(t0, 25);
+	t4 = _mm_xor_si128(t4, t5);
+	t4 = _mm_xor_si128(t4, t2);
+	t5 = _mm_srli_si128(t4, 4);
+	t4 = _mm_slli_si128(t4, 12);
+	t0 = _mm_xor_si128(t0, t4);
+	t2 = _mm_srli_epi32(t0, 1);
+	t1 = _mm_srli_epi32(t0, 2);
+	t4 = _mm_srli_epi32(t0, 7);
+	t2 = _mm_xor_si128(t2, t1);
+	t2 = _mm_xor_si128(t2, t4);
+	t2 = _mm_xor_si128(t2, t5);
+	t0 = _mm_xor_si128(t0, t2);
+	t3 = _mm_xor_si128(t3, t0);
+
+	_mm_storeu_si128((__m128i *) z, _mm_shuffle_epi8(t3, bswap));
+}
+#endif /* CRYPTO_ACCEL_X86 */
+
+
 /* Multiplication in GF(2^128) */
 static void gf_mult(const u8 *x, const u8 *y, u8 *z)
 {
 	u8 v[16];
 	int i, j;
 
+#ifdef CRYPTO_ACCEL_X86
+	if (crypto_accel_x86() & CRYPTO_ACCEL_PCLMUL) {
+		gf_mult_accel(x, y, z);
+		return;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
+
 	os_memset(z, 0, 16); /* Z_0 = 0^128 */
 	os_memcpy(v, y, 16); /* V_0 = Y */
 
@@ -69,6 +69,12 @@ void * aes_decrypt_init(const u8 *key, size_t len)
 		return NULL;
 	}
 	rk[AES_PRIV_NR_POS] = res;
+#ifdef CRYPTO_ACCEL_X86
+	if (crypto_accel_x86() & CRYPTO_ACCEL_AES) {
+		rijndaelKeyToBytes(rk, res);
+		rk[AES_PRIV_NR_POS] |= AES_PRIV_ACCEL;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
 	return rk;
 }
 
@@ -147,9 +153,33 @@ d##3 = TD0(s##3) ^ TD1(s##2) ^ TD2(s##1) ^ TD3(s##0) ^ rk[4 * i + 3]
 	PUTU32(pt + 12, s3);
 }
 
+#ifdef CRYPTO_ACCEL_X86
+__attribute__((target("aes,sse2")))
+static void aesniDecrypt(const u32 rk[], int Nr, const u8 ct[16], u8 pt[16])
+{
+	const __m128i *k = (const __m128i *) rk;
+	__m128i s;
+	int r;
+
+	s = _mm_xor_si128(_mm_loadu_si128((const __m128i *) ct),
+			  _mm_loadu_si128(k));
+	for (r = 1; r < Nr; r++)
+		s = _mm_aesdec_si128(s, _mm_loadu_si128(k + r));
+	s = _mm_aesdeclast_si128(s, _mm_loadu_si128(k + Nr));
+	_mm_storeu_si128((__m128i *) pt, s);
+}
+#endif /* CRYPTO_ACCEL_X86 */
+
 void aes_decrypt(void *ctx, const u8 *crypt, u8 *plain)
 {
 	u32 *rk = ctx;
+#ifdef CRYPTO_ACCEL_X86
+	if (rk[AES_PRIV_NR_POS] & AES_PRIV_ACCEL) {
+		aesniDecrypt(rk, rk[AES_PRIV_NR_POS] & ~AES_PRIV_ACCEL,
+			     crypt, plain);
+		return;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
 	rijndaelDecrypt(ctx, rk[AES_PRIV_NR_POS], crypt, plain);
 }
 
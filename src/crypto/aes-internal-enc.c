@@ -95,6 +95,24 @@ d##3 = TE0(s##3) ^ TE1(s##0) ^ TE2(s##1) ^ TE3(s##2) ^ rk[4 * i + 3]
 }
 
 
+#ifdef CRYPTO_ACCEL_X86
+__attribute__((target("aes,sse2")))
+static void aesniEncrypt(const u32 rk[], int Nr, const u8 pt[16], u8 ct[16])
+{
+	const __m128i *k = (const __m128i *) rk;
+	__m128i s;
+	int r;
+
+	s = _mm_xor_si128(_mm_loadu_si128((const __m128i *) pt),
+			  _mm_loadu_si128(k));
+	for (r = 1; r < Nr; r++)
+		s = _mm_aesenc_si128(s, _mm_loadu_si128(k + r));
+	s = _mm_aesenclast_si128(s, _mm_loadu_si128(k + Nr));
+	_mm_storeu_si128((__m128i *) ct, s);
+}
+#endif /* CRYPTO_ACCEL_X86 */
+
+
 void * aes_encrypt_init(const u8 *key, size_t len)
 {
 	u32 *rk;
@@ -108,6 +126,12 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 		return NULL;
 	}
 	rk[AES_PRIV_NR_POS] = res;
+#ifdef CRYPTO_ACCEL_X86
+	if (crypto_accel_x86() & CRYPTO_ACCEL_AES) {
+		rijndaelKeyToBytes(rk, res);
+		rk[AES_PRIV_NR_POS] |= AES_PRIV_ACCEL;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
 	return rk;
 }
 
@@ -115,6 +139,13 @@ void * aes_encrypt_init(const u8 *key, size_t len)
 void aes_encrypt(void *ctx, const u8 *plain, u8 *crypt)
 {
 	u32 *rk = ctx;
+#ifdef CRYPTO_ACCEL_X86
+	if (rk[AES_PRIV_NR_POS] & AES_PRIV_ACCEL) {
+		aesniEncrypt(rk, rk[AES_PRIV_NR_POS] & ~AES_PRIV_ACCEL,
+			     plain, crypt);
+		return;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
 	rijndaelEncrypt(ctx, rk[AES_PRIV_NR_POS], plain, crypt);
 }
 
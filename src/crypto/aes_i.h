@@ -10,6 +10,7 @@
 #define AES_I_H
 
 #include "aes.h"
+#include "crypto_accel.h"
 
 /* #define FULL_UNROLL */
 #define AES_SMALL_TABLES
@@ -122,4 +123,27 @@ static inline u32 rotr(u32 val, int bits)
 
 int rijndaelKeySetupEnc(u32 rk[], const u8 cipherKey[], int keyBits);
 
+#ifdef CRYPTO_ACCEL_X86
+
+/* Flag in rk[AES_PRIV_NR_POS] for round keys in the AES-NI format */
+#define AES_PRIV_ACCEL 0x100
+
+/*
+ * AES-NI uses the same round keys as the portable implementation (including
+ * the equivalent inverse cipher keys for decryption), but stored as byte
+ * strings instead of big endian words.
+ */
+static inline void rijndaelKeyToBytes(u32 rk[], int Nr)
+{
+	int i;
+	u32 val;
+
+	for (i = 0; i < 4 * (Nr + 1); i++) {
+		val = rk[i];
+		PUTU32((u8 *) &rk[i], val);
+	}
+}
+
+#endif /* CRYPTO_ACCEL_X86 */
+
 #endif /* AES_I_H */
@@ -0,0 +1,58 @@
+/*
+ * Runtime CPU feature detection for the internal crypto implementation
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef CRYPTO_ACCEL_H
+#define CRYPTO_ACCEL_H
+
+/*
+ * With CONFIG_INTERNAL_CRYPTO_ACCEL, the internal AES, SHA-1, SHA-256, and
+ * GHASH implementations use the AES-NI, SHA, and PCLMULQDQ instructions when
+ * the CPU supports them and fall back to the portable C code otherwise. The
+ * accelerated functions are compiled with function specific target attributes,
+ * so the rest of the build does not need any special compiler flags.
+ */
+
+#if defined(CONFIG_INTERNAL_CRYPTO_ACCEL) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+
+#define CRYPTO_ACCEL_X86
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define CRYPTO_ACCEL_AES BIT(0)
+#define CRYPTO_ACCEL_PCLMUL BIT(1)
+#define CRYPTO_ACCEL_SHA BIT(2)
+
+static inline unsigned int crypto_accel_x86(void)
+{
+	static int checked = 0;
+	static unsigned int features = 0;
+	unsigned int eax, ebx, ecx, edx;
+
+	if (checked)
+		return features;
+	checked = 1;
+
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+	    !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+		return features;
+	if (ecx & bit_AES)
+		features |= CRYPTO_ACCEL_AES;
+	if (ecx & bit_PCLMUL)
+		features |= CRYPTO_ACCEL_PCLMUL;
+	if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+	    (ebx & bit_SHA))
+		features |= CRYPTO_ACCEL_SHA;
+
+	return features;
+}
+
+#endif /* CONFIG_INTERNAL_CRYPTO_ACCEL && __GNUC__ && x86 */
+
+#endif /* CRYPTO_ACCEL_H */
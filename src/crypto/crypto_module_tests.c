@@ -1192,6 +1192,128 @@ static const struct rfc6070_test rfc6070_tests[] =
 #define NUM_RFC6070_TESTS ARRAY_SIZE(rfc6070_tests)
 
 
+static int test_aes_block(void)
+{
+	/* FIPS-197, Appendix C - Example Vectors */
+	const char *plaintext = "00112233445566778899aabbccddeeff";
+	struct aes_test_vector {
+		const char *key;
+		const char *ciphertext;
+	} vectors[] = {
+		{
+			"000102030405060708090a0b0c0d0e0f",
+			"69c4e0d86a7b0430d8cdb78070b4c55a"
+		},
+		{
+			"000102030405060708090a0b0c0d0e0f1011121314151617",
+			"dda97ca4864cdfe06eaf70a0ec0d7191"
+		},
+		{
+			"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+			"8ea2b7ca516745bfeafc49904b496089"
+		}
+	};
+	int ret = 0;
+	unsigned int i;
+	size_t key_len;
+	u8 key[32], plain[16], cipher[16], out[16];
+	void *ctx;
+
+	for (i = 0; i < ARRAY_SIZE(vectors); i++) {
+		struct aes_test_vector *tv = &vectors[i];
+
+		key_len = os_strlen(tv->key) / 2;
+		if (hexstr2bin(tv->key, key, key_len) ||
+		    hexstr2bin(plaintext, plain, sizeof(plain)) ||
+		    hexstr2bin(tv->ciphertext, cipher, sizeof(cipher))) {
+			wpa_printf(MSG_ERROR, "Invalid AES test vector %u", i);
+			ret++;
+			continue;
+		}
+
+		ctx = aes_encrypt_init(key, key_len);
+		if (ctx == NULL) {
+			/* Not all crypto libraries support 192-bit keys */
+			wpa_printf(MSG_INFO, "AES-%u not supported",
+				   (unsigned int) key_len * 8);
+			continue;
+		}
+		aes_encrypt(ctx, plain, out);
+		aes_encrypt_deinit(ctx);
+		if (os_memcmp(out, cipher, 16) != 0) {
+			wpa_printf(MSG_ERROR, "AES-%u encrypt failed",
+				   (unsigned int) key_len * 8);
+			ret++;
+		}
+
+		ctx = aes_decrypt_init(key, key_len);
+		if (ctx == NULL) {
+			wpa_printf(MSG_ERROR, "AES-%u decrypt init failed",
+				   (unsigned int) key_len * 8);
+			ret++;
+			continue;
+		}
+		aes_decrypt(ctx, cipher, out);
+		aes_decrypt_deinit(ctx);
+		if (os_memcmp(out, plain, 16) != 0) {
+			wpa_printf(MSG_ERROR, "AES-%u decrypt failed",
+				   (unsigned int) key_len * 8);
+			ret++;
+		}
+	}
+
+	if (!ret)
+		wpa_printf(MSG_INFO, "AES block test cases passed");
+
+	return ret;
+}
+
+
+static int test_long_hash(void)
+{
+	/* 1,000,000 repetitions of 'a' from FIPS 180-2 */
+	const u8 sha1_hash[20] = {
+		0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4,
+		0xf6, 0x1e, 0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31,
+		0x65, 0x34, 0x01, 0x6f
+	};
+	const u8 sha256_hash[32] = {
+		0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+		0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+		0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+		0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0
+	};
+	u8 data[1000], hash[32];
+	const u8 *addr[1000];
+	size_t len[1000];
+	unsigned int i;
+	int ret = 0;
+
+	os_memset(data, 'a', sizeof(data));
+	for (i = 0; i < ARRAY_SIZE(addr); i++) {
+		addr[i] = data;
+		len[i] = sizeof(data);
+	}
+
+	if (sha1_vector(ARRAY_SIZE(addr), addr, len, hash) < 0 ||
+	    os_memcmp(hash, sha1_hash, sizeof(sha1_hash)) != 0) {
+		wpa_printf(MSG_INFO, "SHA1 long message test case failed");
+		ret++;
+	}
+
+	if (sha256_vector(ARRAY_SIZE(addr), addr, len, hash) < 0 ||
+	    os_memcmp(hash, sha256_hash, sizeof(sha256_hash)) != 0) {
+		wpa_printf(MSG_INFO, "SHA256 long message test case failed");
+		ret++;
+	}
+
+	if (!ret)
+		wpa_printf(MSG_INFO, "Long message hash test cases passed");
+
+	return ret;
+}
+
+
 static int test_sha1(void)
 {
 	u8 res[512];
@@ -1266,6 +1388,77 @@ static int test_sha1(void)
 }
 
 
+#define PBKDF2_MULTI_TESTS 16
+
+static int test_pbkdf2_sha1_multi(void)
+{
+	const char *passphrase[PBKDF2_MULTI_TESTS];
+	const u8 *ssid[PBKDF2_MULTI_TESTS];
+	size_t ssid_len[PBKDF2_MULTI_TESTS];
+	u8 psk[PBKDF2_MULTI_TESTS][32], *buf[PBKDF2_MULTI_TESTS];
+	struct os_reltime start, multi, single;
+	unsigned int i;
+	int ret = 0;
+
+	wpa_printf(MSG_INFO, "PBKDF2-SHA1 multi-buffer test cases:");
+
+	for (i = 0; i < PBKDF2_MULTI_TESTS; i++) {
+		const struct passphrase_test *test =
+			&passphrase_tests[i % NUM_PASSPHRASE_TESTS];
+
+		passphrase[i] = test->passphrase;
+		ssid[i] = (const u8 *) test->ssid;
+		ssid_len[i] = os_strlen(test->ssid);
+		buf[i] = psk[i];
+	}
+
+	/* A batch that does not fill all lanes */
+	os_memset(psk, 0, sizeof(psk));
+	if (pbkdf2_sha1_multi(NUM_PASSPHRASE_TESTS, passphrase, ssid, ssid_len,
+			      4096, buf, 32) < 0)
+		ret++;
+	for (i = 0; !ret && i < NUM_PASSPHRASE_TESTS; i++) {
+		if (os_memcmp(psk[i], passphrase_tests[i].psk, 32) != 0)
+			ret++;
+	}
+
+	os_memset(psk, 0, sizeof(psk));
+	os_get_reltime(&start);
+	if (pbkdf2_sha1_multi(PBKDF2_MULTI_TESTS, passphrase, ssid, ssid_len,
+			      4096, buf, 32) < 0)
+		ret++;
+	os_get_reltime(&multi);
+	os_reltime_sub(&multi, &start, &multi);
+	for (i = 0; !ret && i < PBKDF2_MULTI_TESTS; i++) {
+		if (os_memcmp(psk[i],
+			      passphrase_tests[i % NUM_PASSPHRASE_TESTS].psk,
+			      32) != 0)
+			ret++;
+	}
+
+	os_get_reltime(&start);
+	for (i = 0; i < PBKDF2_MULTI_TESTS; i++) {
+		if (pbkdf2_sha1(passphrase[i], ssid[i], ssid_len[i], 4096,
+				psk[i], 32) < 0)
+			ret++;
+	}
+	os_get_reltime(&single);
+	os_reltime_sub(&single, &start, &single);
+
+	if (ret) {
+		wpa_printf(MSG_INFO, "PBKDF2-SHA1 multi-buffer test failed");
+		return ret;
+	}
+
+	wpa_printf(MSG_INFO,
+		   "PBKDF2-SHA1: %d PSKs in %ld.%06ld s (multi-buffer), %ld.%06ld s (one at a time)",
+		   PBKDF2_MULTI_TESTS, multi.sec, multi.usec,
+		   single.sec, single.usec);
+
+	return 0;
+}
+
+
 const struct {
 	char *data;
 	u8 hash[32];
@@ -1746,10 +1939,13 @@ int crypto_module_tests(void)
 	    test_eax() ||
 	    test_cbc() ||
 	    test_ecb() ||
+	    test_aes_block() ||
 	    test_key_wrap() ||
 	    test_md5() ||
 	    test_sha1() ||
+	    test_pbkdf2_sha1_multi() ||
 	    test_sha256() ||
+	    test_long_hash() ||
 	    test_fips186_2_prf() ||
 	    test_ms_funcs())
 		ret = -1;
@@ -13,6 +13,7 @@
 #include "sha1_i.h"
 #include "md5.h"
 #include "crypto.h"
+#include "crypto_accel.h"
 
 typedef struct SHA1Context SHA1_CTX;
 
@@ -171,6 +172,68 @@ void SHAPrintContext(SHA1_CTX *context, char *msg)
 }
 #endif
 
+#ifdef CRYPTO_ACCEL_X86
+/* Hash a single 512-bit block using the SHA instructions. */
+
+__attribute__((target("sha,sse4.1")))
+static void SHA1TransformAccel(u32 state[5], const unsigned char buffer[64])
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+					    0x08090a0b0c0d0e0fULL);
+	__m128i abcd, abcd_save, abcd_prev, e0, e_save, w[4];
+	int i;
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state),
+				 0x1b);
+	e0 = _mm_set_epi32(state[4], 0, 0, 0);
+	abcd_save = abcd;
+	e_save = e0;
+
+	for (i = 0; i < 4; i++)
+		w[i] = _mm_shuffle_epi8(
+			_mm_loadu_si128((const __m128i *) (buffer + 16 * i)),
+			mask);
+
+	/* 20 groups of four rounds; w[] holds the last four message groups */
+	abcd_prev = abcd;
+	for (i = 0; i < 20; i++) {
+		if (i >= 4)
+			w[i & 3] = _mm_sha1msg2_epu32(
+				_mm_xor_si128(_mm_sha1msg1_epu32(
+						      w[i & 3],
+						      w[(i + 1) & 3]),
+					      w[(i + 2) & 3]),
+				w[(i + 3) & 3]);
+		if (i == 0)
+			e0 = _mm_add_epi32(e0, w[0]);
+		else
+			e0 = _mm_sha1nexte_epu32(abcd_prev, w[i & 3]);
+		abcd_prev = abcd;
+		switch (i / 5) {
+		case 0:
+			abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+			break;
+		case 1:
+			abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+			break;
+		case 2:
+			abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+			break;
+		default:
+			abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+			break;
+		}
+	}
+
+	e0 = _mm_sha1nexte_epu32(abcd_prev, e_save);
+	abcd = _mm_add_epi32(abcd, abcd_save);
+
+	_mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+#endif /* CRYPTO_ACCEL_X86 */
+
+
 /* Hash a single 512-bit block. This is the core of the algorithm. */
 
 void SHA1Transform(u32 state[5], const unsigned char buffer[64])
@@ -181,6 +244,13 @@ void SHA1Transform(u32 state[5], const unsigned char buffer[64])
 		u32 l[16];
 	} CHAR64LONG16;
 	CHAR64LONG16* block;
+
+#ifdef CRYPTO_ACCEL_X86
+	if (crypto_accel_x86() & CRYPTO_ACCEL_SHA) {
+		SHA1TransformAccel(state, buffer);
+		return;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
 #ifdef SHA1HANDSOFF
 	CHAR64LONG16 workspace;
 	block = &workspace;
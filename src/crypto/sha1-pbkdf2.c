@@ -10,6 +10,244 @@
 
 #include "common.h"
 #include "sha1.h"
+#include "crypto.h"
+
+#ifdef __GNUC__
+
+/*
+ * Multi-buffer PBKDF2-SHA1
+ *
+ * Once the HMAC inner and outer hash states for the passphrase have been
+ * computed, each output block of PBKDF2 needs two SHA-1 compressions per
+ * iteration. The output blocks are independent of each other, so they are
+ * processed in lanes with each SHA-1 word holding one lane per vector element.
+ * The GCC vector extensions map this to SSE2 on x86, NEON on ARM, and plain
+ * scalar operations on targets without SIMD support.
+ */
+
+#define PBKDF2_SHA1_LANES 4
+
+typedef u32 pbkdf2_sha1_vec __attribute__((vector_size(4 *
+							  PBKDF2_SHA1_LANES)));
+
+struct pbkdf2_sha1_lane {
+	const char *passphrase;
+	const u8 *ssid;
+	size_t ssid_len;
+	unsigned int count;
+	u8 *pos;
+	size_t len;
+};
+
+#define PBKDF2_ROL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define PBKDF2_SHA1_ROUND(f, k, t)					\
+	do {								\
+		if ((t) >= 16)						\
+			w[(t) & 15] = PBKDF2_ROL(w[((t) - 3) & 15] ^	\
+						 w[((t) - 8) & 15] ^	\
+						 w[((t) - 14) & 15] ^	\
+						 w[(t) & 15], 1);	\
+		tmp = PBKDF2_ROL(a, 5) + (f) + e + (k) + w[(t) & 15];	\
+		e = d;							\
+		d = c;							\
+		c = PBKDF2_ROL(b, 30);					\
+		b = a;							\
+		a = tmp;						\
+	} while (0)
+
+
+static void pbkdf2_sha1_block(pbkdf2_sha1_vec state[5], pbkdf2_sha1_vec w[16])
+{
+	pbkdf2_sha1_vec a, b, c, d, e, tmp;
+	int t;
+
+	a = state[0];
+	b = state[1];
+	c = state[2];
+	d = state[3];
+	e = state[4];
+
+	for (t = 0; t < 20; t++)
+		PBKDF2_SHA1_ROUND(((c ^ d) & b) ^ d, 0x5a827999, t);
+	for (; t < 40; t++)
+		PBKDF2_SHA1_ROUND(b ^ c ^ d, 0x6ed9eba1, t);
+	for (; t < 60; t++)
+		PBKDF2_SHA1_ROUND((b & c) | ((b | c) & d), 0x8f1bbcdc, t);
+	for (; t < 80; t++)
+		PBKDF2_SHA1_ROUND(b ^ c ^ d, 0xca62c1d6, t);
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+}
+
+
+static void pbkdf2_sha1_init_state(pbkdf2_sha1_vec state[5])
+{
+	pbkdf2_sha1_vec zero = { 0 };
+
+	state[0] = zero + 0x67452301;
+	state[1] = zero + 0xefcdab89;
+	state[2] = zero + 0x98badcfe;
+	state[3] = zero + 0x10325476;
+	state[4] = zero + 0xc3d2e1f0;
+}
+
+
+/* Hash a 20 octet value following the 64 octet HMAC key block */
+static void pbkdf2_sha1_hash_digest(pbkdf2_sha1_vec state[5],
+				    const pbkdf2_sha1_vec init[5],
+				    const pbkdf2_sha1_vec digest[5])
+{
+	pbkdf2_sha1_vec w[16], zero = { 0 };
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		state[i] = init[i];
+		w[i] = digest[i];
+	}
+	w[5] = zero + 0x80000000;
+	for (i = 6; i < 15; i++)
+		w[i] = zero;
+	w[15] = zero + (64 + SHA1_MAC_LEN) * 8;
+
+	pbkdf2_sha1_block(state, w);
+}
+
+
+static int pbkdf2_sha1_lanes(const struct pbkdf2_sha1_lane *lane,
+			     size_t num_lanes, int iterations)
+{
+	pbkdf2_sha1_vec istate[5], ostate[5], inner[5], u[5], t[5];
+	pbkdf2_sha1_vec ipad[16], opad[16];
+	u8 key[64], tmp[SHA1_MAC_LEN], count_buf[4];
+	const u8 *addr[2];
+	size_t len[2], key_len, l;
+	int i, j, ret = -1;
+
+	os_memset(ipad, 0, sizeof(ipad));
+	os_memset(opad, 0, sizeof(opad));
+	os_memset(u, 0, sizeof(u));
+
+	for (l = 0; l < num_lanes; l++) {
+		key_len = os_strlen(lane[l].passphrase);
+		addr[0] = (const u8 *) lane[l].passphrase;
+
+		/* HMAC key blocks */
+		os_memset(key, 0, sizeof(key));
+		if (key_len > sizeof(key)) {
+			if (sha1_vector(1, addr, &key_len, key) < 0)
+				goto fail;
+		} else {
+			os_memcpy(key, lane[l].passphrase, key_len);
+		}
+		for (i = 0; i < 16; i++) {
+			ipad[i][l] = WPA_GET_BE32(&key[4 * i]) ^ 0x36363636;
+			opad[i][l] = WPA_GET_BE32(&key[4 * i]) ^ 0x5c5c5c5c;
+		}
+
+		/* U1 = PRF(P, S || i) */
+		WPA_PUT_BE32(count_buf, lane[l].count);
+		addr[0] = lane[l].ssid;
+		len[0] = lane[l].ssid_len;
+		addr[1] = count_buf;
+		len[1] = 4;
+		if (hmac_sha1_vector((const u8 *) lane[l].passphrase, key_len,
+				     2, addr, len, tmp))
+			goto fail;
+		for (j = 0; j < 5; j++)
+			u[j][l] = WPA_GET_BE32(&tmp[4 * j]);
+	}
+
+	pbkdf2_sha1_init_state(istate);
+	pbkdf2_sha1_block(istate, ipad);
+	pbkdf2_sha1_init_state(ostate);
+	pbkdf2_sha1_block(ostate, opad);
+
+	/* F(P, S, c, i) = U1 xor U2 xor ... Uc
+	 * U2 = PRF(P, U1)
+	 * Uc = PRF(P, Uc-1)
+	 */
+	for (j = 0; j < 5; j++)
+		t[j] = u[j];
+	for (i = 1; i < iterations; i++) {
+		pbkdf2_sha1_hash_digest(inner, istate, u);
+		pbkdf2_sha1_hash_digest(u, ostate, inner);
+		for (j = 0; j < 5; j++)
+			t[j] ^= u[j];
+	}
+
+	for (l = 0; l < num_lanes; l++) {
+		for (j = 0; j < 5; j++)
+			WPA_PUT_BE32(&tmp[4 * j], t[j][l]);
+		os_memcpy(lane[l].pos, tmp, lane[l].len);
+	}
+
+	ret = 0;
+fail:
+	os_memset(key, 0, sizeof(key));
+	os_memset(tmp, 0, sizeof(tmp));
+	os_memset(ipad, 0, sizeof(ipad));
+	os_memset(opad, 0, sizeof(opad));
+	os_memset(istate, 0, sizeof(istate));
+	os_memset(ostate, 0, sizeof(ostate));
+	os_memset(inner, 0, sizeof(inner));
+	os_memset(u, 0, sizeof(u));
+	os_memset(t, 0, sizeof(t));
+	return ret;
+}
+
+
+/**
+ * pbkdf2_sha1_multi - Derive keys for multiple passphrases with PBKDF2-SHA1
+ * @num: Number of passphrases
+ * @passphrase: Array of ASCII passphrases
+ * @ssid: Array of SSIDs (salts) for the passphrases
+ * @ssid_len: Array of SSID lengths in bytes
+ * @iterations: Number of iterations to run
+ * @buf: Array of buffers for the generated keys
+ * @buflen: Length of each buffer in bytes
+ * Returns: 0 on success, -1 of failure
+ *
+ * This function derives the same keys as calling pbkdf2_sha1() for each
+ * passphrase, but processes several output blocks in parallel. Deriving
+ * multiple keys in a single call is faster than calling pbkdf2_sha1()
+ * separately for each passphrase.
+ */
+int pbkdf2_sha1_multi(size_t num, const char *passphrase[], const u8 *ssid[],
+		      const size_t ssid_len[], int iterations, u8 *buf[],
+		      size_t buflen)
+{
+	struct pbkdf2_sha1_lane lane[PBKDF2_SHA1_LANES];
+	size_t i, offset, num_lanes = 0;
+
+	for (i = 0; i < num; i++) {
+		for (offset = 0; offset < buflen; offset += SHA1_MAC_LEN) {
+			lane[num_lanes].passphrase = passphrase[i];
+			lane[num_lanes].ssid = ssid[i];
+			lane[num_lanes].ssid_len = ssid_len[i];
+			lane[num_lanes].count = offset / SHA1_MAC_LEN + 1;
+			lane[num_lanes].pos = buf[i] + offset;
+			lane[num_lanes].len = buflen - offset > SHA1_MAC_LEN ?
+				SHA1_MAC_LEN : buflen - offset;
+			if (++num_lanes < PBKDF2_SHA1_LANES)
+				continue;
+			if (pbkdf2_sha1_lanes(lane, num_lanes, iterations) < 0)
+				return -1;
+			num_lanes = 0;
+		}
+	}
+
+	if (num_lanes && pbkdf2_sha1_lanes(lane, num_lanes, iterations) < 0)
+		return -1;
+
+	return 0;
+}
+
+#else /* __GNUC__ */
 
 static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 			 size_t ssid_len, int iterations, unsigned int count,
@@ -55,6 +293,37 @@ static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 }
 
 
+int pbkdf2_sha1_multi(size_t num, const char *passphrase[], const u8 *ssid[],
+		      const size_t ssid_len[], int iterations, u8 *buf[],
+		      size_t buflen)
+{
+	unsigned int count;
+	unsigned char *pos;
+	size_t i, left, plen;
+	unsigned char digest[SHA1_MAC_LEN];
+
+	for (i = 0; i < num; i++) {
+		count = 0;
+		pos = buf[i];
+		left = buflen;
+		while (left > 0) {
+			count++;
+			if (pbkdf2_sha1_f(passphrase[i], ssid[i], ssid_len[i],
+					  iterations, count, digest))
+				return -1;
+			plen = left > SHA1_MAC_LEN ? SHA1_MAC_LEN : left;
+			os_memcpy(pos, digest, plen);
+			pos += plen;
+			left -= plen;
+		}
+	}
+
+	return 0;
+}
+
+#endif /* __GNUC__ */
+
+
 /**
  * pbkdf2_sha1 - SHA1-based key derivation function (PBKDF2) for IEEE 802.11i
  * @passphrase: ASCII passphrase
@@ -72,21 +341,6 @@ static int pbkdf2_sha1_f(const char *passphrase, const u8 *ssid,
 int pbkdf2_sha1(const char *passphrase, const u8 *ssid, size_t ssid_len,
 		int iterations, u8 *buf, size_t buflen)
 {
-	unsigned int count = 0;
-	unsigned char *pos = buf;
-	size_t left = buflen, plen;
-	unsigned char digest[SHA1_MAC_LEN];
-
-	while (left > 0) {
-		count++;
-		if (pbkdf2_sha1_f(passphrase, ssid, ssid_len, iterations,
-				  count, digest))
-			return -1;
-		plen = left > SHA1_MAC_LEN ? SHA1_MAC_LEN : left;
-		os_memcpy(pos, digest, plen);
-		pos += plen;
-		left -= plen;
-	}
-
-	return 0;
+	return pbkdf2_sha1_multi(1, &passphrase, &ssid, &ssid_len, iterations,
+				 &buf, buflen);
 }
@@ -12,6 +12,7 @@
 #include "sha256.h"
 #include "sha256_i.h"
 #include "crypto.h"
+#include "crypto_accel.h"
 
 
 /**
@@ -80,6 +81,63 @@ static const unsigned long K[64] = {
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #endif
 
+#ifdef CRYPTO_ACCEL_X86
+/* compress 512-bits using the SHA instructions */
+__attribute__((target("sha,sse4.1")))
+static void sha256_compress_accel(struct sha256_state *md,
+				  const unsigned char *buf)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					    0x0405060700010203ULL);
+	__m128i state0, state1, tmp, msg, abef_save, cdgh_save, w[4];
+	int i;
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *) &md->state[0]),
+				0xb1); /* CDAB */
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((__m128i *) &md->state[4]),
+				   0x1b); /* EFGH */
+	state0 = _mm_alignr_epi8(tmp, state1, 8); /* ABEF */
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0); /* CDGH */
+	abef_save = state0;
+	cdgh_save = state1;
+
+	for (i = 0; i < 4; i++)
+		w[i] = _mm_shuffle_epi8(
+			_mm_loadu_si128((const __m128i *) (buf + 16 * i)),
+			mask);
+
+	/* 16 groups of four rounds; w[] holds the last four message groups */
+	for (i = 0; i < 16; i++) {
+		if (i >= 4)
+			w[i & 3] = _mm_sha256msg2_epu32(
+				_mm_add_epi32(_mm_sha256msg1_epu32(
+						      w[i & 3],
+						      w[(i + 1) & 3]),
+					      _mm_alignr_epi8(w[(i + 3) & 3],
+							      w[(i + 2) & 3],
+							      4)),
+				w[(i + 3) & 3]);
+		msg = _mm_add_epi32(w[i & 3],
+				    _mm_set_epi32(K[4 * i + 3], K[4 * i + 2],
+						  K[4 * i + 1], K[4 * i]));
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+		msg = _mm_shuffle_epi32(msg, 0x0e);
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+	}
+
+	state0 = _mm_add_epi32(state0, abef_save);
+	state1 = _mm_add_epi32(state1, cdgh_save);
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b); /* FEBA */
+	state1 = _mm_shuffle_epi32(state1, 0xb1); /* DCHG */
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0); /* DCBA */
+	state1 = _mm_alignr_epi8(state1, tmp, 8); /* ABEF */
+	_mm_storeu_si128((__m128i *) &md->state[0], state0);
+	_mm_storeu_si128((__m128i *) &md->state[4], state1);
+}
+#endif /* CRYPTO_ACCEL_X86 */
+
+
 /* compress 512-bits */
 static int sha256_compress(struct sha256_state *md, unsigned char *buf)
 {
@@ -87,6 +145,13 @@ static int sha256_compress(struct sha256_state *md, unsigned char *buf)
 	u32 t;
 	int i;
 
+#ifdef CRYPTO_ACCEL_X86
+	if (crypto_accel_x86() & CRYPTO_ACCEL_SHA) {
+		sha256_compress_accel(md, buf);
+		return 0;
+	}
+#endif /* CRYPTO_ACCEL_X86 */
+
 	/* copy state into S */
 	for (i = 0; i < 8; i++) {
 		S[i] = md->state[i];
@@ -163,10 +163,10 @@ static void _tls_show_errors(void)
 
 static void tls_show_errors(int level, const char *func, const char *txt)
 {
-	unsigned long err;
+	unsigned long err = ERR_get_error();
 
 	wpa_printf(level, "OpenSSL: %s - %s %s",
-		   func, txt, ERR_error_string(ERR_get_error(), NULL));
+		   func, txt, ERR_error_string(err, NULL));
 
 	while ((err = ERR_get_error())) {
 		wpa_printf(MSG_INFO, "OpenSSL: pending error: %s",
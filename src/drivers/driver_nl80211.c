@@ -7640,6 +7640,19 @@ static int wpa_driver_nl80211_status(void *priv, char *buf, size_t buflen)
 		return pos - buf;
 	pos += res;
 
+	res = os_snprintf(pos, end - pos,
+			  "scan_res_fetch_count=%u\n"
+			  "scan_res_fetch_last_usec=%u\n"
+			  "scan_res_fetch_max_usec=%u\n"
+			  "scan_res_fetch_total_usec=%llu\n",
+			  drv->scan_res_fetch_count,
+			  drv->scan_res_fetch_last_usec,
+			  drv->scan_res_fetch_max_usec,
+			  (unsigned long long) drv->scan_res_fetch_total_usec);
+	if (os_snprintf_error(end - pos, res))
+		return pos - buf;
+	pos += res;
+
 	if (drv->has_capability) {
 		res = os_snprintf(pos, end - pos,
 				  "capa.key_mgmt=0x%x\n"
@@ -100,6 +100,10 @@ struct wpa_driver_nl80211_data {
 	int operstate;
 
 	int scan_complete_events;
+	unsigned int scan_res_fetch_count;
+	unsigned int scan_res_fetch_last_usec;
+	unsigned int scan_res_fetch_max_usec;
+	u64 scan_res_fetch_total_usec;
 	enum scan_states {
 		NO_SCAN, SCAN_REQUESTED, SCAN_STARTED, SCAN_COMPLETED,
 		SCAN_ABORTED, SCHED_SCAN_STARTED, SCHED_SCAN_STOPPED,
@@ -267,9 +271,18 @@ int wpa_driver_set_ap_wps_p2p_ie(void *priv, const struct wpabuf *beacon,
 
 /* driver_nl80211_scan.c */
 
+struct nl80211_scan_dedup_entry {
+	u32 hash;
+	u32 idx; /* index + 1 in res->res[]; 0 = unused */
+};
+
 struct nl80211_bss_info_arg {
 	struct wpa_driver_nl80211_data *drv;
 	struct wpa_scan_results *res;
+	size_t res_alloc; /* number of allocated entries in res->res */
+	/* Open addressing hash table of res->res[] keyed on (BSSID, SSID) */
+	struct nl80211_scan_dedup_entry *dedup;
+	size_t dedup_size;
 	unsigned int assoc_freq;
 	unsigned int ibss_freq;
 	u8 assoc_bssid[ETH_ALEN];
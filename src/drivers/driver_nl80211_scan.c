@@ -573,6 +573,81 @@ static int nl80211_scan_filtered(struct wpa_driver_nl80211_data *drv,
 }
 
 
+static u32 nl80211_scan_dedup_hash(const u8 *bssid, const u8 *ssid)
+{
+	u32 hash = 2166136261U;
+	size_t i;
+
+	/* FNV-1a over BSSID and the SSID element */
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = (hash ^ bssid[i]) * 16777619U;
+	for (i = 0; i < 2U + ssid[1]; i++)
+		hash = (hash ^ ssid[i]) * 16777619U;
+	return hash;
+}
+
+
+static const u8 * nl80211_scan_res_ssid(const struct wpa_scan_res *r)
+{
+	return nl80211_get_ie((u8 *) (r + 1), r->ie_len, WLAN_EID_SSID);
+}
+
+
+static struct nl80211_scan_dedup_entry *
+nl80211_scan_dedup_get(struct nl80211_bss_info_arg *arg, u32 hash,
+		       const u8 *bssid, const u8 *ssid)
+{
+	struct nl80211_scan_dedup_entry *e;
+	struct wpa_scan_res *r;
+	const u8 *s;
+	size_t i;
+
+	for (i = hash & (arg->dedup_size - 1);;
+	     i = (i + 1) & (arg->dedup_size - 1)) {
+		e = &arg->dedup[i];
+		if (!e->idx)
+			return e;
+		if (e->hash != hash)
+			continue;
+		r = arg->res->res[e->idx - 1];
+		if (os_memcmp(r->bssid, bssid, ETH_ALEN) != 0)
+			continue;
+		s = nl80211_scan_res_ssid(r);
+		if (s && s[1] == ssid[1] && os_memcmp(s, ssid, 2 + s[1]) == 0)
+			return e;
+	}
+}
+
+
+static int nl80211_scan_dedup_resize(struct nl80211_bss_info_arg *arg)
+{
+	struct nl80211_scan_dedup_entry *old = arg->dedup, *e;
+	size_t old_size = arg->dedup_size, i;
+	struct wpa_scan_res *r;
+	const u8 *ssid;
+
+	arg->dedup_size = old_size ? old_size * 2 : 64;
+	arg->dedup = os_calloc(arg->dedup_size, sizeof(*arg->dedup));
+	if (arg->dedup == NULL) {
+		arg->dedup = old;
+		arg->dedup_size = old_size;
+		return -1;
+	}
+
+	for (i = 0; i < old_size; i++) {
+		if (!old[i].idx)
+			continue;
+		r = arg->res->res[old[i].idx - 1];
+		ssid = nl80211_scan_res_ssid(r);
+		e = nl80211_scan_dedup_get(arg, old[i].hash, r->bssid, ssid);
+		*e = old[i];
+	}
+	os_free(old);
+
+	return 0;
+}
+
+
 int bss_info_handler(struct nl_msg *msg, void *arg)
 {
 	struct nlattr *tb[NL80211_ATTR_MAX + 1];
@@ -595,9 +670,11 @@ int bss_info_handler(struct nl_msg *msg, void *arg)
 	struct wpa_scan_results *res = _arg->res;
 	struct wpa_scan_res **tmp;
 	struct wpa_scan_res *r;
-	const u8 *ie, *beacon_ie;
+	struct nl80211_scan_dedup_entry *e = NULL;
+	const u8 *ie, *beacon_ie, *ssid;
 	size_t ie_len, beacon_ie_len;
 	u8 *pos;
+	u32 hash = 0;
 	size_t i;
 
 	nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0),
@@ -712,19 +789,21 @@ int bss_info_handler(struct nl_msg *msg, void *arg)
 	 * not use frequency as a separate key in the BSS table, so filter out
 	 * duplicated entries. Prefer associated BSS entry in such a case in
 	 * order to get the correct frequency into the BSS table. Similarly,
-	 * prefer newer entries over older.
+	 * prefer newer entries over older. The entries are indexed by
+	 * (BSSID, SSID) to avoid comparing each new entry against all the
+	 * earlier ones.
 	 */
-	for (i = 0; i < res->num; i++) {
-		const u8 *s1, *s2;
-		if (os_memcmp(res->res[i]->bssid, r->bssid, ETH_ALEN) != 0)
-			continue;
-
-		s1 = nl80211_get_ie((u8 *) (res->res[i] + 1),
-				    res->res[i]->ie_len, WLAN_EID_SSID);
-		s2 = nl80211_get_ie((u8 *) (r + 1), r->ie_len, WLAN_EID_SSID);
-		if (s1 == NULL || s2 == NULL || s1[1] != s2[1] ||
-		    os_memcmp(s1, s2, 2 + s1[1]) != 0)
-			continue;
+	ssid = nl80211_scan_res_ssid(r);
+	if (ssid &&
+	    (res->num + 1) * 2 <= _arg->dedup_size) {
+		hash = nl80211_scan_dedup_hash(r->bssid, ssid);
+		e = nl80211_scan_dedup_get(_arg, hash, r->bssid, ssid);
+	} else if (ssid && nl80211_scan_dedup_resize(_arg) == 0) {
+		hash = nl80211_scan_dedup_hash(r->bssid, ssid);
+		e = nl80211_scan_dedup_get(_arg, hash, r->bssid, ssid);
+	}
+	if (e && e->idx) {
+		i = e->idx - 1;
 
 		/* Same BSSID,SSID was already included in scan results */
 		wpa_printf(MSG_DEBUG, "nl80211: Remove duplicated scan result "
@@ -740,14 +819,23 @@ int bss_info_handler(struct nl_msg *msg, void *arg)
 		return NL_SKIP;
 	}
 
-	tmp = os_realloc_array(res->res, res->num + 1,
-			       sizeof(struct wpa_scan_res *));
-	if (tmp == NULL) {
-		os_free(r);
-		return NL_SKIP;
+	if (res->num == _arg->res_alloc) {
+		size_t count = _arg->res_alloc ? _arg->res_alloc * 2 : 32;
+
+		tmp = os_realloc_array(res->res, count,
+				       sizeof(struct wpa_scan_res *));
+		if (tmp == NULL) {
+			os_free(r);
+			return NL_SKIP;
+		}
+		res->res = tmp;
+		_arg->res_alloc = count;
+	}
+	if (e) {
+		e->hash = hash;
+		e->idx = res->num + 1;
 	}
-	tmp[res->num++] = r;
-	res->res = tmp;
+	res->res[res->num++] = r;
 
 	return NL_SKIP;
 }
@@ -807,7 +895,10 @@ nl80211_get_scan_results(struct wpa_driver_nl80211_data *drv)
 	struct wpa_scan_results *res;
 	int ret;
 	struct nl80211_bss_info_arg arg;
+	struct os_reltime start, end, diff;
+	unsigned int usec;
 
+	os_get_reltime(&start);
 	res = os_zalloc(sizeof(*res));
 	if (res == NULL)
 		return NULL;
@@ -817,13 +908,23 @@ nl80211_get_scan_results(struct wpa_driver_nl80211_data *drv)
 		return NULL;
 	}
 
+	os_memset(&arg, 0, sizeof(arg));
 	arg.drv = drv;
 	arg.res = res;
 	ret = send_and_recv_msgs(drv, msg, bss_info_handler, &arg);
+	os_free(arg.dedup);
 	if (ret == 0) {
-		wpa_printf(MSG_DEBUG, "nl80211: Received scan results (%lu "
-			   "BSSes)", (unsigned long) res->num);
 		nl80211_get_noise_for_scan_results(drv, res);
+		os_get_reltime(&end);
+		os_reltime_sub(&end, &start, &diff);
+		usec = diff.sec * 1000000 + diff.usec;
+		drv->scan_res_fetch_count++;
+		drv->scan_res_fetch_last_usec = usec;
+		if (usec > drv->scan_res_fetch_max_usec)
+			drv->scan_res_fetch_max_usec = usec;
+		drv->scan_res_fetch_total_usec += usec;
+		wpa_printf(MSG_DEBUG, "nl80211: Received scan results (%lu "
+			   "BSSes) in %u usec", (unsigned long) res->num, usec);
 		return res;
 	}
 	wpa_printf(MSG_DEBUG, "nl80211: Scan result fetch failed: ret=%d "
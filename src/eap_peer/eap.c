@@ -19,7 +19,6 @@
 
 #include "common.h"
 #include "pcsc_funcs.h"
-#include "state_machine.h"
 #include "ext_password.h"
 #include "crypto/crypto.h"
 #include "crypto/tls.h"
@@ -31,6 +30,9 @@
 
 #define STATE_MACHINE_DATA struct eap_sm
 #define STATE_MACHINE_DEBUG_PREFIX "EAP"
+#define STATE_MACHINE_ADDR NULL
+#define STATE_MACHINE_TRACE(machine) TRACE_RING_EAP_PEER
+#include "state_machine.h"
 
 //EAP Request <--> EAP Response ؽ
 #define EAP_MAX_AUTH_ROUNDS 50
@@ -17,11 +17,13 @@
 #include "common.h"
 #include "crypto/sha256.h"
 #include "eap_i.h"
-#include "state_machine.h"
 #include "common/wpa_ctrl.h"
 
 #define STATE_MACHINE_DATA struct eap_sm
 #define STATE_MACHINE_DEBUG_PREFIX "EAP"
+#define STATE_MACHINE_ADDR sm->peer_addr
+#define STATE_MACHINE_TRACE(machine) TRACE_RING_EAP_SERVER
+#include "state_machine.h"
 
 #define EAP_MAX_AUTH_ROUNDS 50
 
@@ -1067,10 +1067,10 @@ static void ocsp_debug_print_resp(OCSP_RESPONSE *rsp)
 
 static void tls_show_errors(const char *func, const char *txt)
 {
-	unsigned long err;
+	unsigned long err = ERR_get_error();
 
 	wpa_printf(MSG_DEBUG, "OpenSSL: %s - %s %s",
-		   func, txt, ERR_error_string(ERR_get_error(), NULL));
+		   func, txt, ERR_error_string(err, NULL));
 
 	while ((err = ERR_get_error())) {
 		wpa_printf(MSG_DEBUG, "OpenSSL: pending error: %s",
@@ -15,11 +15,25 @@
  * needs to be defined to point to the MAC address used in debug output.
  * SM_ENTRY_M macro can be used to define similar group of state machines
  * without this additional debug info.
+ *
+ * State transitions are also recorded in the trace ring (trace_ring.h) if
+ * STATE_MACHINE_TRACE(machine) is defined to map the state machine name to a
+ * trace ring event before including this header file. STATE_MACHINE_ADDR is
+ * used as the peer address of the trace entries in that case.
  */
 
 #ifndef STATE_MACHINE_H
 #define STATE_MACHINE_H
 
+#ifdef STATE_MACHINE_TRACE
+#include "trace_ring.h"
+#define SM_TRACE(machine, from, to) \
+trace_ring_add(STATE_MACHINE_TRACE(machine), (from), (to), \
+	       STATE_MACHINE_ADDR, 0, 0)
+#else /* STATE_MACHINE_TRACE */
+#define SM_TRACE(machine, from, to) do { } while (0)
+#endif /* STATE_MACHINE_TRACE */
+
 /**
  * SM_STATE - Declaration of a state machine function
  * @machine: State machine name
@@ -48,6 +62,7 @@ if (!global || sm->machine ## _state != machine ## _ ## state) { \
 	sm->changed = TRUE; \
 	wpa_printf(MSG_DEBUG, STATE_MACHINE_DEBUG_PREFIX ": " #machine \
 		   " entering state " #state); \
+	SM_TRACE(machine, sm->machine ## _state, machine ## _ ## state); \
 } \
 sm->machine ## _state = machine ## _ ## state;
 
@@ -67,6 +82,7 @@ if (!global || sm->data ## _ ## state != machine ## _ ## _state) { \
 	sm->changed = TRUE; \
 	wpa_printf(MSG_DEBUG, STATE_MACHINE_DEBUG_PREFIX ": " \
 		   #machine " entering state " #_state); \
+	SM_TRACE(machine, sm->data ## _ ## state, machine ## _ ## _state); \
 } \
 sm->data ## _ ## state = machine ## _ ## _state;
 
@@ -86,6 +102,7 @@ if (!global || sm->data ## _ ## state != machine ## _ ## _state) { \
 	wpa_printf(MSG_DEBUG, STATE_MACHINE_DEBUG_PREFIX ": " MACSTR " " \
 		   #machine " entering state " #_state, \
 		   MAC2STR(STATE_MACHINE_ADDR)); \
+	SM_TRACE(machine, sm->data ## _ ## state, machine ## _ ## _state); \
 } \
 sm->data ## _ ## state = machine ## _ ## _state;
 
@@ -0,0 +1,258 @@
+/*
+ * Memory-mapped status page
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "status_page.h"
+
+/*
+ * The status page is a small file that is mapped into memory and updated in
+ * place whenever the published values change. Monitoring tools can map the
+ * same file read-only and poll the current status without any system calls
+ * or control interface request parsing.
+ *
+ * The path can be changed at runtime, so an existing file is never truncated
+ * or removed unless it is a status page left behind by an earlier process.
+ * The publishing process holds an exclusive lock on the file for as long as it
+ * uses it, so a page that is still being published by another process is not
+ * taken over.
+ */
+
+struct status_page {
+	char *path;
+	int fd; /* locked with flock() while the page is published */
+	struct status_page_data *data;
+};
+
+
+static void status_page_barrier(void)
+{
+#ifdef __GNUC__
+	__sync_synchronize();
+#endif /* __GNUC__ */
+}
+
+
+/*
+ * Open an existing status page file for reuse, e.g., after the process that
+ * created it was killed. Any other file is refused. Returns the file
+ * descriptor or -1 on failure.
+ */
+static int status_page_open_stale(const char *path)
+{
+	struct stat st;
+	u32 magic;
+	int fd;
+
+	fd = open(path, O_RDWR | O_NOFOLLOW);
+	if (fd < 0) {
+		wpa_printf(MSG_ERROR, "status_page: open(%s): %s",
+			   path, strerror(errno));
+		return -1;
+	}
+	if (flock(fd, LOCK_EX | LOCK_NB) < 0) {
+		wpa_printf(MSG_ERROR,
+			   "status_page: %s is in use by another process",
+			   path);
+		close(fd);
+		return -1;
+	}
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) ||
+	    st.st_uid != geteuid() ||
+	    st.st_size != sizeof(struct status_page_data) ||
+	    read(fd, &magic, sizeof(magic)) != sizeof(magic) ||
+	    magic != STATUS_PAGE_MAGIC) {
+		wpa_printf(MSG_ERROR,
+			   "status_page: %s exists and is not a status page - not overwriting it",
+			   path);
+		close(fd);
+		return -1;
+	}
+
+	wpa_printf(MSG_DEBUG, "status_page: Reuse stale status page %s",
+		   path);
+	return fd;
+}
+
+
+/**
+ * status_page_init - Create a status page
+ * @path: Path of the status page file
+ * @mode: Which process is publishing the status
+ * Returns: Pointer to the status page or %NULL on failure
+ *
+ * The file is created and mapped into memory. An existing file is used only if
+ * it is a status page left behind by an earlier process.
+ */
+struct status_page * status_page_init(const char *path,
+				      enum status_page_mode mode)
+{
+	struct status_page *page;
+	void *data;
+	int fd;
+
+	page = os_zalloc(sizeof(*page));
+	if (!page)
+		return NULL;
+	page->path = os_strdup(path);
+	if (!page->path)
+		goto fail;
+
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW,
+		  S_IRUSR | S_IWUSR | S_IRGRP);
+	/*
+	 * Another process may hold the lock of the new file briefly while it
+	 * checks whether the file is a stale status page, so wait for it.
+	 */
+	if (fd >= 0 && flock(fd, LOCK_EX) < 0) {
+		wpa_printf(MSG_ERROR, "status_page: flock(%s): %s",
+			   path, strerror(errno));
+		close(fd);
+		unlink(path);
+		goto fail;
+	}
+	if (fd < 0 && errno == EEXIST)
+		fd = status_page_open_stale(path);
+	else if (fd < 0)
+		wpa_printf(MSG_ERROR, "status_page: open(%s): %s",
+			   path, strerror(errno));
+	if (fd < 0)
+		goto fail;
+	if (ftruncate(fd, sizeof(struct status_page_data)) < 0) {
+		wpa_printf(MSG_ERROR, "status_page: ftruncate(%s): %s",
+			   path, strerror(errno));
+		unlink(path);
+		close(fd);
+		goto fail;
+	}
+	data = mmap(NULL, sizeof(struct status_page_data),
+		    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		wpa_printf(MSG_ERROR, "status_page: mmap(%s): %s",
+			   path, strerror(errno));
+		unlink(path);
+		close(fd);
+		goto fail;
+	}
+	page->fd = fd;
+	page->data = data;
+
+	/* Clear any contents left behind in a reused status page */
+	page->data->magic = 0;
+	status_page_barrier();
+	os_memset(page->data, 0, sizeof(struct status_page_data));
+	page->data->version = STATUS_PAGE_VERSION;
+	page->data->len = sizeof(struct status_page_data);
+	page->data->mode = mode;
+	status_page_barrier();
+	page->data->magic = STATUS_PAGE_MAGIC;
+
+	wpa_printf(MSG_DEBUG, "status_page: Publishing status in %s", path);
+	return page;
+
+fail:
+	os_free(page->path);
+	os_free(page);
+	return NULL;
+}
+
+
+/**
+ * status_page_deinit - Remove a status page
+ * @page: Status page from status_page_init() or %NULL
+ *
+ * The magic value is cleared before the file is removed so that readers that
+ * still have the file mapped can notice that the status is no longer updated.
+ * The file is not removed if the path no longer refers to it.
+ */
+void status_page_deinit(struct status_page *page)
+{
+	struct stat st, path_st;
+
+	if (!page)
+		return;
+
+	page->data->magic = 0;
+	munmap(page->data, sizeof(struct status_page_data));
+	if (fstat(page->fd, &st) == 0 && lstat(page->path, &path_st) == 0 &&
+	    st.st_dev == path_st.st_dev && st.st_ino == path_st.st_ino)
+		unlink(page->path);
+	close(page->fd);
+	os_free(page->path);
+	os_free(page);
+}
+
+
+/**
+ * status_page_begin - Start updating a status page
+ * @page: Status page from status_page_init()
+ * Returns: Pointer to the page contents to update
+ *
+ * The update needs to be completed with status_page_end() before returning
+ * to the event loop.
+ */
+struct status_page_data * status_page_begin(struct status_page *page)
+{
+	page->data->seq++;
+	status_page_barrier();
+	return page->data;
+}
+
+
+/**
+ * status_page_end - Complete a status page update
+ * @page: Status page from status_page_init()
+ */
+void status_page_end(struct status_page *page)
+{
+	struct os_time now;
+
+	os_get_time(&now);
+	page->data->sec = now.sec;
+	page->data->usec = now.usec;
+	status_page_barrier();
+	page->data->seq++;
+}
+
+
+/**
+ * status_page_read - Take a consistent snapshot of a status page
+ * @page: Mapped status page
+ * @copy: Buffer for the snapshot
+ * Returns: 0 on success, -1 if the page is not valid or is being updated
+ *
+ * This is for readers that have mapped the status page file.
+ */
+int status_page_read(const struct status_page_data *page,
+		     struct status_page_data *copy)
+{
+	const volatile struct status_page_data *vpage = page;
+	int i;
+	u32 seq;
+
+	for (i = 0; i < 100; i++) {
+		seq = vpage->seq;
+		if (seq & 1)
+			continue;
+		status_page_barrier();
+		os_memcpy(copy, page, sizeof(*copy));
+		status_page_barrier();
+		if (vpage->seq != seq)
+			continue;
+		if (copy->magic != STATUS_PAGE_MAGIC)
+			return -1;
+		return 0;
+	}
+
+	return -1;
+}
@@ -0,0 +1,78 @@
+/*
+ * Memory-mapped status page
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef STATUS_PAGE_H
+#define STATUS_PAGE_H
+
+#define STATUS_PAGE_MAGIC 0x53415057 /* "WPAS" in little endian */
+#define STATUS_PAGE_VERSION 1
+
+enum status_page_mode {
+	STATUS_PAGE_MODE_STATION = 1, /* wpa_supplicant; state: wpa_states */
+	STATUS_PAGE_MODE_AP = 2, /* hostapd; state: hostapd_iface_state */
+};
+
+/**
+ * struct status_page_data - Contents of the status page file
+ *
+ * All the fields are in host byte order. New fields are added only to the end
+ * of the structure and readers can use @len to determine which fields are
+ * present. The structure is protected with a sequence lock: @seq is odd while
+ * the writer is updating the page, so readers need to copy the page and retry
+ * if @seq was odd or changed during the copy. status_page_read() does this.
+ * @magic is cleared when the page is removed.
+ */
+struct status_page_data {
+	u32 magic; /* STATUS_PAGE_MAGIC */
+	u16 version; /* STATUS_PAGE_VERSION */
+	u16 len; /* sizeof(struct status_page_data) */
+	u32 seq; /* sequence lock; odd while being updated */
+	u32 state; /* enum wpa_states or enum hostapd_iface_state */
+	u32 sec; /* time of the last update (os_get_time()) */
+	u32 usec;
+	u32 freq; /* operating frequency in MHz or 0 if not known */
+	s32 signal; /* station: RSSI in dBm or 0 if not known */
+	s32 noise; /* station: noise in dBm or 0 if not known */
+	u32 txrate; /* station: TX rate in kbps or 0 if not known */
+	u32 num_sta; /* AP: number of stations */
+	u32 num_sta_authorized; /* AP: number of authorized stations */
+	u32 pairwise_keys; /* number of pairwise keys configured */
+	u32 group_keys; /* number of group keys configured */
+	u8 bssid[6]; /* station: current BSSID; AP: own BSSID */
+	u8 ssid_len;
+	u8 mode; /* enum status_page_mode */
+	u8 ssid[32];
+} STRUCT_PACKED;
+
+struct status_page;
+
+#ifdef CONFIG_STATUS_PAGE
+
+struct status_page * status_page_init(const char *path,
+				      enum status_page_mode mode);
+void status_page_deinit(struct status_page *page);
+struct status_page_data * status_page_begin(struct status_page *page);
+void status_page_end(struct status_page *page);
+int status_page_read(const struct status_page_data *page,
+		     struct status_page_data *copy);
+
+#else /* CONFIG_STATUS_PAGE */
+
+static inline struct status_page *
+status_page_init(const char *path, enum status_page_mode mode)
+{
+	return NULL;
+}
+
+static inline void status_page_deinit(struct status_page *page)
+{
+}
+
+#endif /* CONFIG_STATUS_PAGE */
+
+#endif /* STATUS_PAGE_H */
@@ -0,0 +1,148 @@
+/*
+ * Binary trace ring for state machine and frame events
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "common/ieee802_11_defs.h"
+#include "trace_ring.h"
+
+/*
+ * The trace ring keeps a small fixed-size binary record of each state machine
+ * transition and management frame so that the sequence of events leading to a
+ * connection failure can be reconstructed afterwards without verbose debug
+ * logging. Entries are stored in their encoded (little endian) form. They are
+ * fetched with the TRACE_DUMP control interface command and decoded with
+ * wpa_supplicant/utils/trace_ring.py. The ring is shared by all interfaces of
+ * the process, so TRACE_DUMP on any interface returns the same entries.
+ */
+
+static u8 trace_ring[TRACE_RING_ENTRIES][TRACE_RING_ENTRY_LEN];
+static u32 trace_ring_seq; /* sequence number of the next entry */
+static unsigned int trace_ring_count;
+
+
+/**
+ * trace_ring_add - Add an event to the trace ring
+ * @event: Event type (TRACE_RING_*)
+ * @from: Previous state for state machine events
+ * @to: New state for state machine events
+ * @addr: Peer or BSSID address or %NULL if not known
+ * @arg1: Event specific value
+ * @arg2: Event specific value
+ */
+void trace_ring_add(enum trace_ring_event event, int from, int to,
+		    const u8 *addr, u16 arg1, u16 arg2)
+{
+	u8 *pos = trace_ring[trace_ring_seq % TRACE_RING_ENTRIES];
+	struct os_time now;
+
+	os_get_time(&now);
+	WPA_PUT_LE32(pos, trace_ring_seq);
+	WPA_PUT_LE32(pos + 4, now.sec);
+	WPA_PUT_LE32(pos + 8, now.usec);
+	pos[12] = event;
+	pos[13] = from;
+	pos[14] = to;
+	pos[15] = 0;
+	WPA_PUT_LE16(pos + 16, arg1);
+	WPA_PUT_LE16(pos + 18, arg2);
+	if (addr)
+		os_memcpy(pos + 20, addr, ETH_ALEN);
+	else
+		os_memset(pos + 20, 0, ETH_ALEN);
+
+	trace_ring_seq++;
+	if (trace_ring_count < TRACE_RING_ENTRIES)
+		trace_ring_count++;
+}
+
+
+/**
+ * trace_ring_mgmt - Add a management frame event to the trace ring
+ * @event: TRACE_RING_MGMT_RX or TRACE_RING_MGMT_TX_STATUS
+ * @buf: IEEE 802.11 management frame
+ * @len: Length of the frame
+ * @ok: Whether the frame was acknowledged (TX status)
+ */
+void trace_ring_mgmt(enum trace_ring_event event, const u8 *buf, size_t len,
+		     int ok)
+{
+	const struct ieee80211_mgmt *mgmt = (const struct ieee80211_mgmt *) buf;
+	u16 fc, code = 0;
+
+	if (len < IEEE80211_HDRLEN)
+		return;
+
+	fc = le_to_host16(mgmt->frame_control);
+	switch (WLAN_FC_GET_STYPE(fc)) {
+	case WLAN_FC_STYPE_AUTH:
+		if (len >= IEEE80211_HDRLEN + sizeof(mgmt->u.auth))
+			code = le_to_host16(mgmt->u.auth.status_code);
+		break;
+	case WLAN_FC_STYPE_ASSOC_RESP:
+	case WLAN_FC_STYPE_REASSOC_RESP:
+		if (len >= IEEE80211_HDRLEN + sizeof(mgmt->u.assoc_resp))
+			code = le_to_host16(mgmt->u.assoc_resp.status_code);
+		break;
+	case WLAN_FC_STYPE_DEAUTH:
+		if (len >= IEEE80211_HDRLEN + sizeof(mgmt->u.deauth))
+			code = le_to_host16(mgmt->u.deauth.reason_code);
+		break;
+	case WLAN_FC_STYPE_DISASSOC:
+		if (len >= IEEE80211_HDRLEN + sizeof(mgmt->u.disassoc))
+			code = le_to_host16(mgmt->u.disassoc.reason_code);
+		break;
+	}
+
+	trace_ring_add(event, 0, ok,
+		       event == TRACE_RING_MGMT_RX ? mgmt->sa : mgmt->da,
+		       fc, code);
+}
+
+
+/**
+ * trace_ring_dump - Write trace ring entries into a text buffer
+ * @cmd: Control interface command parameters: "[<first sequence number>]"
+ * @buf: Buffer for the hex encoded entries, one per line
+ * @buflen: Length of the buffer
+ * Returns: Number of characters written or -1 on failure
+ *
+ * Entries are written starting from the requested sequence number (or the
+ * oldest entry that is still available) for as long as they fit into the
+ * buffer. The caller can continue from the sequence number following the last
+ * returned entry.
+ */
+int trace_ring_dump(const char *cmd, char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	u32 seq, oldest;
+
+	oldest = trace_ring_seq - trace_ring_count;
+	seq = oldest;
+	while (*cmd == ' ')
+		cmd++;
+	if (*cmd) {
+		if (!isdigit((unsigned char) *cmd))
+			return -1;
+		seq = strtoul(cmd, NULL, 10);
+		if (trace_ring_seq - seq > trace_ring_count)
+			seq = oldest;
+	}
+
+	while (seq != trace_ring_seq &&
+	       (size_t) (end - pos) > 2 * TRACE_RING_ENTRY_LEN + 1) {
+		pos += wpa_snprintf_hex(pos, end - pos,
+					trace_ring[seq % TRACE_RING_ENTRIES],
+					TRACE_RING_ENTRY_LEN);
+		*pos++ = '\n';
+		seq++;
+	}
+
+	return pos - buf;
+}
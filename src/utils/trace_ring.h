@@ -0,0 +1,78 @@
+/*
+ * Binary trace ring for state machine and frame events
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+/* Number of entries kept in the trace ring */
+#define TRACE_RING_ENTRIES 2048
+
+/*
+ * Encoded entry (all fields little endian):
+ * seq(4) sec(4) usec(4) event(1) from(1) to(1) reserved(1) arg1(2) arg2(2)
+ * addr(6)
+ *
+ * There is a single ring for the whole process and the entries do not identify
+ * the interface (or BSS) they belong to; only the peer/BSSID address does. The
+ * reserved octet is always zero.
+ */
+#define TRACE_RING_ENTRY_LEN 26
+
+enum trace_ring_event {
+	TRACE_RING_NONE = 0,
+	/* State machine transitions: from/to = state, addr = peer */
+	TRACE_RING_WPA_PTK = 1,
+	TRACE_RING_WPA_PTK_GROUP = 2,
+	TRACE_RING_EAP_SERVER = 3,
+	TRACE_RING_EAP_PEER = 4,
+	/*
+	 * Management frames: arg1 = frame control, arg2 = status or reason
+	 * code, addr = peer; for TX status, to = 1 if the frame was acked
+	 */
+	TRACE_RING_MGMT_RX = 5,
+	TRACE_RING_MGMT_TX_STATUS = 6,
+	/*
+	 * Station events: addr = BSSID, arg2 = status or reason code; for
+	 * disassociation/deauthentication, arg1 = 1 if locally generated
+	 */
+	TRACE_RING_ASSOC = 7,
+	TRACE_RING_ASSOC_REJECT = 8,
+	TRACE_RING_DISASSOC = 9,
+	TRACE_RING_DEAUTH = 10,
+	/* arg1 = authentication algorithm, arg2 = status code */
+	TRACE_RING_AUTH = 11,
+};
+
+#ifdef CONFIG_TRACE_RING
+
+void trace_ring_add(enum trace_ring_event event, int from, int to,
+		    const u8 *addr, u16 arg1, u16 arg2);
+void trace_ring_mgmt(enum trace_ring_event event, const u8 *buf, size_t len,
+		     int ok);
+int trace_ring_dump(const char *cmd, char *buf, size_t buflen);
+
+#else /* CONFIG_TRACE_RING */
+
+static inline void trace_ring_add(enum trace_ring_event event, int from,
+				  int to, const u8 *addr, u16 arg1, u16 arg2)
+{
+}
+
+static inline void trace_ring_mgmt(enum trace_ring_event event,
+				   const u8 *buf, size_t len, int ok)
+{
+}
+
+static inline int trace_ring_dump(const char *cmd, char *buf, size_t buflen)
+{
+	return -1;
+}
+
+#endif /* CONFIG_TRACE_RING */
+
+#endif /* TRACE_RING_H */
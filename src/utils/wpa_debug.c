@@ -10,6 +10,15 @@
 
 #include "common.h"
 
+#ifndef CONFIG_NO_STDOUT_DEBUG
+/* This file implements the functions behind the level check macros */
+#undef wpa_printf
+#undef wpa_hexdump
+#undef wpa_hexdump_key
+#undef wpa_hexdump_ascii
+#undef wpa_hexdump_ascii_key
+#endif /* CONFIG_NO_STDOUT_DEBUG */
+
 #ifdef CONFIG_DEBUG_SYSLOG
 #include <syslog.h>
 
@@ -32,6 +41,41 @@ static FILE *wpa_debug_tracing_file = NULL;
 int wpa_debug_level = MSG_INFO;
 int wpa_debug_show_keys = 0;
 int wpa_debug_timestamp = 0;
+/* Lowest level enabled by module debug levels or Linux tracing */
+int wpa_debug_extra_level = MSG_ERROR + 1;
+
+/*
+ * Debug levels for individual modules. The module of a debug message is the
+ * "<module>:" prefix of the format string (or hexdump title), e.g., "EAPOL" or
+ * "nl80211", so that messages from a noisy module can be suppressed (or
+ * messages from a single module enabled) without having to format them first.
+ * For wpa_msg() and its variants, the caller's format string is used.
+ */
+#define WPA_DEBUG_MAX_MODULES 16
+
+static struct wpa_debug_module {
+	char name[24];
+	size_t len;
+	int level;
+} wpa_debug_modules[WPA_DEBUG_MAX_MODULES];
+static unsigned int wpa_debug_num_modules = 0;
+
+
+static void wpa_debug_update_extra_level(void)
+{
+	unsigned int i;
+	int level = MSG_ERROR + 1;
+
+#ifdef CONFIG_DEBUG_LINUX_TRACING
+	if (wpa_debug_tracing_file)
+		level = MSG_EXCESSIVE;
+#endif /* CONFIG_DEBUG_LINUX_TRACING */
+	for (i = 0; i < wpa_debug_num_modules; i++) {
+		if (wpa_debug_modules[i].level < level)
+			level = wpa_debug_modules[i].level;
+	}
+	wpa_debug_extra_level = level;
+}
 
 
 #ifdef CONFIG_ANDROID_LOG
@@ -62,6 +106,464 @@ static FILE *out_file = NULL;
 #endif /* CONFIG_DEBUG_FILE */
 
 
+static int wpa_debug_enabled(int level, const char *txt)
+{
+	unsigned int i;
+
+	for (i = 0; i < wpa_debug_num_modules; i++) {
+		struct wpa_debug_module *mod = &wpa_debug_modules[i];
+
+		if (os_strncmp(txt, mod->name, mod->len) == 0 &&
+		    txt[mod->len] == ':')
+			return level >= mod->level;
+	}
+
+	return level >= wpa_debug_level;
+}
+
+
+#if defined(CONFIG_DEBUG_ASYNC) && !defined(CONFIG_ANDROID_LOG)
+
+/*
+ * Asynchronous debug output
+ *
+ * Debug messages are formatted by the caller into a ring buffer and written
+ * to stdout/file and the Linux tracing file by a separate writer thread, so
+ * that slow output does not delay frame processing. The timestamp is taken
+ * when the message is generated. All debug prints come from the eloop thread,
+ * i.e., there is a single producer and a single consumer and the buffer is
+ * managed with atomic head/tail offsets without locking. Messages that do not
+ * fit into the buffer are dropped and the number of dropped messages is
+ * reported by the writer thread.
+ */
+
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+
+#define WPA_DEBUG_ASYNC_BUF_SIZE (512 * 1024)
+#define WPA_DEBUG_ASYNC_MAX_LEN (64 * 1024)
+#define WPA_DEBUG_ASYNC_SKIP ((unsigned int) -1)
+
+#define WPA_DEBUG_REC_OUT BIT(0)
+#define WPA_DEBUG_REC_TRACE BIT(1)
+#define WPA_DEBUG_REC_TIMESTAMP BIT(2)
+
+struct wpa_debug_rec {
+	unsigned int len; /* total length of the record in the buffer */
+	unsigned int txt_len; /* or WPA_DEBUG_ASYNC_SKIP */
+	long sec;
+	unsigned int usec;
+	int level;
+	unsigned int flags; /* WPA_DEBUG_REC_* */
+	/* followed by txt_len octets of text (not nul terminated) */
+};
+
+static u64 async_buf[WPA_DEBUG_ASYNC_BUF_SIZE / sizeof(u64)];
+static unsigned long async_head; /* updated by the producer */
+static unsigned long async_tail; /* updated by the writer thread */
+static unsigned long async_reserved;
+static unsigned int async_dropped;
+static int async_waiting;
+static int async_stop;
+static int async_started = 0;
+static int async_failed = 0;
+static int async_registered = 0;
+static int async_pipe[2] = { -1, -1 };
+static pthread_t async_thread;
+
+
+static FILE * wpa_debug_out(void)
+{
+#ifdef CONFIG_DEBUG_FILE
+	if (out_file)
+		return out_file;
+#endif /* CONFIG_DEBUG_FILE */
+	return stdout;
+}
+
+
+static void wpa_debug_async_write(struct wpa_debug_rec *rec)
+{
+	const char *txt = (const char *) (rec + 1);
+
+	if (rec->flags & WPA_DEBUG_REC_OUT) {
+		FILE *out = wpa_debug_out();
+
+		if (rec->flags & WPA_DEBUG_REC_TIMESTAMP)
+			fprintf(out, "%ld.%06u: ", rec->sec, rec->usec);
+		fwrite(txt, 1, rec->txt_len, out);
+		fputc('\n', out);
+	}
+
+#ifdef CONFIG_DEBUG_LINUX_TRACING
+	if ((rec->flags & WPA_DEBUG_REC_TRACE) && wpa_debug_tracing_file) {
+		fprintf(wpa_debug_tracing_file, WPAS_TRACE_PFX "%.*s\n",
+			rec->level, (int) rec->txt_len, txt);
+		fflush(wpa_debug_tracing_file);
+	}
+#endif /* CONFIG_DEBUG_LINUX_TRACING */
+}
+
+
+static void * wpa_debug_async_writer(void *arg)
+{
+	u8 *buf = (u8 *) async_buf;
+	unsigned long head, tail = async_tail;
+	unsigned int dropped = 0, count;
+	struct wpa_debug_rec *rec;
+	size_t pos;
+	char tmp[16];
+
+	for (;;) {
+		head = __atomic_load_n(&async_head, __ATOMIC_SEQ_CST);
+		while (tail != head) {
+			pos = tail % WPA_DEBUG_ASYNC_BUF_SIZE;
+			if (WPA_DEBUG_ASYNC_BUF_SIZE - pos < sizeof(*rec)) {
+				/* No room for a record at the end */
+				tail += WPA_DEBUG_ASYNC_BUF_SIZE - pos;
+			} else {
+				rec = (struct wpa_debug_rec *) (buf + pos);
+				if (rec->txt_len != WPA_DEBUG_ASYNC_SKIP)
+					wpa_debug_async_write(rec);
+				tail += rec->len;
+			}
+			__atomic_store_n(&async_tail, tail, __ATOMIC_RELEASE);
+		}
+
+		count = __atomic_load_n(&async_dropped, __ATOMIC_RELAXED);
+		if (count != dropped) {
+			fprintf(wpa_debug_out(),
+				"wpa_debug: %u debug message(s) dropped\n",
+				count - dropped);
+			dropped = count;
+		}
+		fflush(wpa_debug_out());
+
+		if (__atomic_load_n(&async_stop, __ATOMIC_SEQ_CST)) {
+			/* No more messages after the stop request */
+			if (__atomic_load_n(&async_head, __ATOMIC_SEQ_CST) ==
+			    tail)
+				break;
+			continue;
+		}
+
+		__atomic_store_n(&async_waiting, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&async_head, __ATOMIC_SEQ_CST) != tail ||
+		    __atomic_load_n(&async_stop, __ATOMIC_SEQ_CST)) {
+			__atomic_store_n(&async_waiting, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+		if (read(async_pipe[0], tmp, sizeof(tmp)) < 0 &&
+		    errno != EINTR && errno != EAGAIN)
+			break;
+	}
+
+	return NULL;
+}
+
+
+static void wpa_debug_async_stop(void)
+{
+	char c = 0;
+
+	if (!async_started)
+		return;
+
+	__atomic_store_n(&async_stop, 1, __ATOMIC_SEQ_CST);
+	if (write(async_pipe[1], &c, 1) < 0) {
+		/* The pipe is full, so the writer thread is already awake */
+	}
+	pthread_join(async_thread, NULL);
+	close(async_pipe[0]);
+	close(async_pipe[1]);
+	async_pipe[0] = async_pipe[1] = -1;
+	async_head = async_tail = async_reserved = 0;
+	async_waiting = 0;
+	async_stop = 0;
+	async_started = 0;
+}
+
+
+static int wpa_debug_async_start(void)
+{
+	sigset_t all, old;
+	int res;
+
+	if (async_started)
+		return 0;
+	if (async_failed)
+		return -1;
+
+	/*
+	 * Do not print debug messages from here since that would recurse
+	 * back to this function. Debug output falls back to synchronous
+	 * writes on errors.
+	 */
+	if (pipe(async_pipe) < 0) {
+		async_failed = 1;
+		return -1;
+	}
+	if (fcntl(async_pipe[1], F_SETFL, O_NONBLOCK) < 0)
+		goto fail;
+
+	if (!async_registered) {
+		if (pthread_atfork(wpa_debug_async_stop, NULL, NULL) != 0 ||
+		    atexit(wpa_debug_async_stop) != 0)
+			goto fail;
+		async_registered = 1;
+	}
+
+	/* Leave signal handling to the eloop thread */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	res = pthread_create(&async_thread, NULL, wpa_debug_async_writer,
+			     NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (res != 0)
+		goto fail;
+
+	async_started = 1;
+	return 0;
+
+fail:
+	close(async_pipe[0]);
+	close(async_pipe[1]);
+	async_pipe[0] = async_pipe[1] = -1;
+	async_failed = 1;
+	return -1;
+}
+
+
+static int wpa_debug_async_flags(int level, const char *txt)
+{
+	int flags = 0;
+
+#ifdef CONFIG_DEBUG_SYSLOG
+	if (wpa_debug_syslog)
+		return -1;
+#endif /* CONFIG_DEBUG_SYSLOG */
+	if (wpa_debug_enabled(level, txt)) {
+		flags |= WPA_DEBUG_REC_OUT;
+		if (wpa_debug_timestamp)
+			flags |= WPA_DEBUG_REC_TIMESTAMP;
+	}
+#ifdef CONFIG_DEBUG_LINUX_TRACING
+	if (wpa_debug_tracing_file)
+		flags |= WPA_DEBUG_REC_TRACE;
+#endif /* CONFIG_DEBUG_LINUX_TRACING */
+	if (flags && wpa_debug_async_start() < 0)
+		return -1;
+	return flags;
+}
+
+
+static struct wpa_debug_rec * wpa_debug_async_reserve(size_t txt_len)
+{
+	u8 *buf = (u8 *) async_buf;
+	struct wpa_debug_rec *rec;
+	unsigned long head, tail;
+	size_t len, pos, end;
+
+	len = (sizeof(*rec) + txt_len + 7) & ~7;
+	head = async_head;
+	tail = __atomic_load_n(&async_tail, __ATOMIC_ACQUIRE);
+	pos = head % WPA_DEBUG_ASYNC_BUF_SIZE;
+	end = WPA_DEBUG_ASYNC_BUF_SIZE - pos;
+	if (end < len) {
+		/* Keep records contiguous by skipping the end of the buffer */
+		if (head + end + len - tail > WPA_DEBUG_ASYNC_BUF_SIZE)
+			goto full;
+		if (end >= sizeof(*rec)) {
+			rec = (struct wpa_debug_rec *) (buf + pos);
+			rec->len = end;
+			rec->txt_len = WPA_DEBUG_ASYNC_SKIP;
+		}
+		head += end;
+		pos = 0;
+	} else if (head + len - tail > WPA_DEBUG_ASYNC_BUF_SIZE) {
+		goto full;
+	}
+
+	rec = (struct wpa_debug_rec *) (buf + pos);
+	rec->len = len;
+	rec->txt_len = txt_len;
+	async_reserved = head + len;
+	return rec;
+
+full:
+	__atomic_add_fetch(&async_dropped, 1, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+
+static void wpa_debug_async_commit(struct wpa_debug_rec *rec, int level,
+				   int flags)
+{
+	char c = 0;
+
+	rec->level = level;
+	rec->flags = flags;
+	if (flags & WPA_DEBUG_REC_TIMESTAMP) {
+		struct os_time tv;
+
+		os_get_time(&tv);
+		rec->sec = tv.sec;
+		rec->usec = tv.usec;
+	}
+
+	__atomic_store_n(&async_head, async_reserved, __ATOMIC_SEQ_CST);
+	if (__atomic_exchange_n(&async_waiting, 0, __ATOMIC_SEQ_CST) &&
+	    write(async_pipe[1], &c, 1) < 0) {
+		/* The pipe is full, so the writer thread is already awake */
+	}
+}
+
+
+static int wpa_debug_async_vprintf(int level, const char *module_txt,
+				   const char *fmt, va_list ap)
+{
+	struct wpa_debug_rec *rec;
+	char line[512];
+	int flags, len;
+	va_list ap2;
+
+	flags = wpa_debug_async_flags(level, module_txt);
+	if (flags <= 0)
+		return flags;
+
+	va_copy(ap2, ap);
+	len = vsnprintf(line, sizeof(line), fmt, ap2);
+	va_end(ap2);
+	if (len < 0)
+		return 0;
+	if (len > WPA_DEBUG_ASYNC_MAX_LEN)
+		len = WPA_DEBUG_ASYNC_MAX_LEN;
+
+	/* Reserve room for the nul termination from vsnprintf() */
+	rec = wpa_debug_async_reserve(len + 1);
+	if (!rec)
+		return 0;
+	if ((size_t) len < sizeof(line))
+		os_memcpy(rec + 1, line, len);
+	else
+		vsnprintf((char *) (rec + 1), len + 1, fmt, ap);
+	rec->txt_len = len;
+	wpa_debug_async_commit(rec, level, flags);
+	return 0;
+}
+
+
+static int wpa_debug_async_hexdump(int level, const char *title,
+				   const u8 *buf, size_t len, int show,
+				   int ascii)
+{
+	static const char hex[] = "0123456789abcdef";
+	const size_t line_len = 16;
+	struct wpa_debug_rec *rec;
+	const char *extra = NULL;
+	char hdr[200];
+	size_t hdr_len, txt_len, dump_len = 0, i, llen;
+	int flags, res, truncated = 0;
+	char *pos;
+
+	flags = wpa_debug_async_flags(level, title);
+	if (flags <= 0)
+		return flags;
+
+	res = os_snprintf(hdr, sizeof(hdr), "%s - %s(len=%lu):", title,
+			  ascii ? "hexdump_ascii" : "hexdump",
+			  (unsigned long) len);
+	if (res < 0)
+		return 0;
+	hdr_len = (size_t) res < sizeof(hdr) ? (size_t) res : sizeof(hdr) - 1;
+
+	if (ascii && !show)
+		extra = " [REMOVED]";
+	else if (buf == NULL)
+		extra = " [NULL]";
+	else if (!show)
+		extra = " [REMOVED]";
+
+	if (extra) {
+		txt_len = hdr_len + os_strlen(extra);
+	} else {
+		/* Limit the length of the dump to the maximum record size */
+		dump_len = len;
+		if (ascii) {
+			if (dump_len > WPA_DEBUG_ASYNC_MAX_LEN / 5)
+				dump_len = WPA_DEBUG_ASYNC_MAX_LEN / 5;
+			txt_len = hdr_len +
+				(dump_len + line_len - 1) / line_len * 72;
+		} else {
+			if (dump_len > WPA_DEBUG_ASYNC_MAX_LEN / 3)
+				dump_len = WPA_DEBUG_ASYNC_MAX_LEN / 3;
+			txt_len = hdr_len + dump_len * 3;
+		}
+		if (dump_len < len) {
+			truncated = 1;
+			txt_len += 4;
+		}
+	}
+
+	rec = wpa_debug_async_reserve(txt_len);
+	if (!rec)
+		return 0;
+	pos = (char *) (rec + 1);
+	os_memcpy(pos, hdr, hdr_len);
+	pos += hdr_len;
+
+	if (extra) {
+		os_memcpy(pos, extra, os_strlen(extra));
+	} else if (!ascii) {
+		for (i = 0; i < dump_len; i++) {
+			*pos++ = ' ';
+			*pos++ = hex[buf[i] >> 4];
+			*pos++ = hex[buf[i] & 0x0f];
+		}
+	} else {
+		for (; dump_len; buf += llen, dump_len -= llen) {
+			llen = dump_len > line_len ? line_len : dump_len;
+			os_memcpy(pos, "\n    ", 5);
+			pos += 5;
+			for (i = 0; i < line_len; i++) {
+				if (i < llen) {
+					*pos++ = ' ';
+					*pos++ = hex[buf[i] >> 4];
+					*pos++ = hex[buf[i] & 0x0f];
+				} else {
+					os_memcpy(pos, "   ", 3);
+					pos += 3;
+				}
+			}
+			os_memcpy(pos, "   ", 3);
+			pos += 3;
+			for (i = 0; i < line_len; i++) {
+				if (i >= llen)
+					*pos++ = ' ';
+				else if (isprint(buf[i]))
+					*pos++ = buf[i];
+				else
+					*pos++ = '_';
+			}
+		}
+	}
+	if (truncated)
+		os_memcpy(pos, " ...", 4);
+
+	wpa_debug_async_commit(rec, level, flags);
+	return 0;
+}
+
+#else /* CONFIG_DEBUG_ASYNC && !CONFIG_ANDROID_LOG */
+
+static inline void wpa_debug_async_stop(void)
+{
+}
+
+#endif /* CONFIG_DEBUG_ASYNC && !CONFIG_ANDROID_LOG */
+
+
 void wpa_debug_print_timestamp(void)
 {
 #ifndef CONFIG_ANDROID_LOG
@@ -69,6 +571,11 @@ void wpa_debug_print_timestamp(void)
 
 	if (!wpa_debug_timestamp)
 		return;
+#ifdef CONFIG_DEBUG_ASYNC
+	/* The writer thread adds the timestamps taken for each message */
+	if (!async_failed)
+		return;
+#endif /* CONFIG_DEBUG_ASYNC */
 
 	os_get_time(&tv);
 #ifdef CONFIG_DEBUG_FILE
@@ -128,6 +635,7 @@ int wpa_debug_open_linux_tracing(void)
 	ssize_t buflen;
 	char *line, *tmp1, *path = NULL;
 
+	wpa_debug_async_stop();
 	mounts = open("/proc/mounts", O_RDONLY);
 	if (mounts < 0) {
 		printf("no /proc/mounts\n");
@@ -174,6 +682,7 @@ int wpa_debug_open_linux_tracing(void)
 		printf("failed to fdopen()\n");
 		return -1;
 	}
+	wpa_debug_update_extra_level();
 
 	return 0;
 }
@@ -183,47 +692,49 @@ void wpa_debug_close_linux_tracing(void)
 {
 	if (wpa_debug_tracing_file == NULL)
 		return;
+	wpa_debug_async_stop();
 	fclose(wpa_debug_tracing_file);
 	wpa_debug_tracing_file = NULL;
+	wpa_debug_update_extra_level();
 }
 
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
 
-/**
- * wpa_printf - conditional printf
- * @level: priority level (MSG_*) of the message
- * @fmt: printf format string, followed by optional arguments
- *
- * This function is used to print conditional debugging and error messages. The
- * output may be directed to stdout, stderr, and/or syslog based on
- * configuration.
- *
- * Note: New line '\n' is added to the end of the text when printing to stdout.
+/*
+ * Print a debug message. The module debug level is selected based on
+ * module_txt, i.e., the format string used by the caller, since fmt may have
+ * been wrapped by wpa_msg() and its variants.
  */
-void wpa_printf(int level, const char *fmt, ...)
+static void wpa_debug_vprintf(int level, const char *module_txt,
+			      const char *fmt, va_list ap)
 {
-	va_list ap;
+	va_list ap2;
 
-	va_start(ap, fmt);
-	if (level >= wpa_debug_level) {
+#if defined(CONFIG_DEBUG_ASYNC) && !defined(CONFIG_ANDROID_LOG)
+	if (wpa_debug_async_vprintf(level, module_txt, fmt, ap) == 0)
+		return;
+#endif /* CONFIG_DEBUG_ASYNC && !CONFIG_ANDROID_LOG */
+
+	va_copy(ap2, ap);
+	if (wpa_debug_enabled(level, module_txt)) {
 #ifdef CONFIG_ANDROID_LOG
 		__android_log_vprint(wpa_to_android_level(level),
-				     ANDROID_LOG_NAME, fmt, ap);
+				     ANDROID_LOG_NAME, fmt, ap2);
 #else /* CONFIG_ANDROID_LOG */
 #ifdef CONFIG_DEBUG_SYSLOG
 		if (wpa_debug_syslog) {
-			vsyslog(syslog_priority(level), fmt, ap);
+			vsyslog(syslog_priority(level), fmt, ap2);
 		} else {
 #endif /* CONFIG_DEBUG_SYSLOG */
 		wpa_debug_print_timestamp();
 #ifdef CONFIG_DEBUG_FILE
 		if (out_file) {
-			vfprintf(out_file, fmt, ap);
+			vfprintf(out_file, fmt, ap2);
 			fprintf(out_file, "\n");
 		} else {
 #endif /* CONFIG_DEBUG_FILE */
-		vprintf(fmt, ap);
+		vprintf(fmt, ap2);
 		printf("\n");
 #ifdef CONFIG_DEBUG_FILE
 		}
@@ -233,26 +744,52 @@ void wpa_printf(int level, const char *fmt, ...)
 #endif /* CONFIG_DEBUG_SYSLOG */
 #endif /* CONFIG_ANDROID_LOG */
 	}
-	va_end(ap);
+	va_end(ap2);
 
 #ifdef CONFIG_DEBUG_LINUX_TRACING
 	if (wpa_debug_tracing_file != NULL) {
-		va_start(ap, fmt);
+		va_copy(ap2, ap);
 		fprintf(wpa_debug_tracing_file, WPAS_TRACE_PFX, level);
-		vfprintf(wpa_debug_tracing_file, fmt, ap);
+		vfprintf(wpa_debug_tracing_file, fmt, ap2);
 		fprintf(wpa_debug_tracing_file, "\n");
 		fflush(wpa_debug_tracing_file);
-		va_end(ap);
+		va_end(ap2);
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 }
 
 
+/**
+ * wpa_printf - conditional printf
+ * @level: priority level (MSG_*) of the message
+ * @fmt: printf format string, followed by optional arguments
+ *
+ * This function is used to print conditional debugging and error messages. The
+ * output may be directed to stdout, stderr, and/or syslog based on
+ * configuration.
+ *
+ * Note: New line '\n' is added to the end of the text when printing to stdout.
+ */
+void wpa_printf(int level, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	wpa_debug_vprintf(level, fmt, fmt, ap);
+	va_end(ap);
+}
+
+
 static void _wpa_hexdump(int level, const char *title, const u8 *buf,
 			 size_t len, int show)
 {
 	size_t i;
 
+#if defined(CONFIG_DEBUG_ASYNC) && !defined(CONFIG_ANDROID_LOG)
+	if (wpa_debug_async_hexdump(level, title, buf, len, show, 0) == 0)
+		return;
+#endif /* CONFIG_DEBUG_ASYNC && !CONFIG_ANDROID_LOG */
+
 #ifdef CONFIG_DEBUG_LINUX_TRACING
 	if (wpa_debug_tracing_file != NULL) {
 		fprintf(wpa_debug_tracing_file,
@@ -271,7 +808,7 @@ static void _wpa_hexdump(int level, const char *title, const u8 *buf,
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
-	if (level < wpa_debug_level)
+	if (!wpa_debug_enabled(level, title))
 		return;
 #ifdef CONFIG_ANDROID_LOG
 	{
@@ -394,6 +931,11 @@ static void _wpa_hexdump_ascii(int level, const char *title, const void *buf,
 	const u8 *pos = buf;
 	const size_t line_len = 16;
 
+#if defined(CONFIG_DEBUG_ASYNC) && !defined(CONFIG_ANDROID_LOG)
+	if (wpa_debug_async_hexdump(level, title, buf, len, show, 1) == 0)
+		return;
+#endif /* CONFIG_DEBUG_ASYNC && !CONFIG_ANDROID_LOG */
+
 #ifdef CONFIG_DEBUG_LINUX_TRACING
 	if (wpa_debug_tracing_file != NULL) {
 		fprintf(wpa_debug_tracing_file,
@@ -413,7 +955,7 @@ static void _wpa_hexdump_ascii(int level, const char *title, const void *buf,
 	}
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
-	if (level < wpa_debug_level)
+	if (!wpa_debug_enabled(level, title))
 		return;
 #ifdef CONFIG_ANDROID_LOG
 	_wpa_hexdump(level, title, buf, len, show);
@@ -542,6 +1084,7 @@ int wpa_debug_open_file(const char *path)
 	if (!path)
 		return 0;
 
+	wpa_debug_async_stop();
 	if (last_path == NULL || os_strcmp(last_path, path) != 0) {
 		/* Save our path to enable re-open */
 		os_free(last_path);
@@ -569,6 +1112,7 @@ void wpa_debug_close_file(void)
 #ifdef CONFIG_DEBUG_FILE
 	if (!out_file)
 		return;
+	wpa_debug_async_stop();
 	fclose(out_file);
 	out_file = NULL;
 	os_free(last_path);
@@ -604,6 +1148,32 @@ void wpa_msg_register_ifname_cb(wpa_msg_get_ifname_func func)
 }
 
 
+#ifdef CONFIG_NO_STDOUT_DEBUG
+#define wpa_msg_printf(level, module_txt, args...) do { } while (0)
+#else /* CONFIG_NO_STDOUT_DEBUG */
+/*
+ * Debug print of a formatted event message. The module debug level is matched
+ * against the format string of the wpa_msg() caller (module_txt) instead of
+ * the "%s" wrapper.
+ */
+static void wpa_msg_printf(int level, const char *module_txt,
+			   const char *fmt, ...)
+PRINTF_FORMAT(3, 4);
+
+static void wpa_msg_printf(int level, const char *module_txt,
+			   const char *fmt, ...)
+{
+	va_list ap;
+
+	if (!wpa_debug_level_enabled(level))
+		return;
+	va_start(ap, fmt);
+	wpa_debug_vprintf(level, module_txt, fmt, ap);
+	va_end(ap);
+}
+#endif /* CONFIG_NO_STDOUT_DEBUG */
+
+
 void wpa_msg(void *ctx, int level, const char *fmt, ...)
 {
 	va_list ap;
@@ -635,7 +1205,7 @@ void wpa_msg(void *ctx, int level, const char *fmt, ...)
 	}
 	len = vsnprintf(buf, buflen, fmt, ap);
 	va_end(ap);
-	wpa_printf(level, "%s%s", prefix, buf);
+	wpa_msg_printf(level, fmt, "%s%s", prefix, buf);
 	if (wpa_msg_cb)
 		wpa_msg_cb(ctx, level, WPA_MSG_PER_INTERFACE, buf, len);
 	bin_clear_free(buf, buflen);
@@ -690,7 +1260,7 @@ void wpa_msg_global(void *ctx, int level, const char *fmt, ...)
 	va_start(ap, fmt);
 	len = vsnprintf(buf, buflen, fmt, ap);
 	va_end(ap);
-	wpa_printf(level, "%s", buf);
+	wpa_msg_printf(level, fmt, "%s", buf);
 	if (wpa_msg_cb)
 		wpa_msg_cb(ctx, level, WPA_MSG_GLOBAL, buf, len);
 	bin_clear_free(buf, buflen);
@@ -745,7 +1315,7 @@ void wpa_msg_no_global(void *ctx, int level, const char *fmt, ...)
 	va_start(ap, fmt);
 	len = vsnprintf(buf, buflen, fmt, ap);
 	va_end(ap);
-	wpa_printf(level, "%s", buf);
+	wpa_msg_printf(level, fmt, "%s", buf);
 	if (wpa_msg_cb)
 		wpa_msg_cb(ctx, level, WPA_MSG_NO_GLOBAL, buf, len);
 	bin_clear_free(buf, buflen);
@@ -772,7 +1342,7 @@ void wpa_msg_global_only(void *ctx, int level, const char *fmt, ...)
 	va_start(ap, fmt);
 	len = vsnprintf(buf, buflen, fmt, ap);
 	va_end(ap);
-	wpa_printf(level, "%s", buf);
+	wpa_msg_printf(level, fmt, "%s", buf);
 	if (wpa_msg_cb)
 		wpa_msg_cb(ctx, level, WPA_MSG_ONLY_GLOBAL, buf, len);
 	os_free(buf);
@@ -860,3 +1430,153 @@ int str_to_debug_level(const char *s)
 		return MSG_ERROR;
 	return -1;
 }
+
+
+/**
+ * wpa_debug_set_module_level - Set the debug level for a module
+ * @module: Module name, i.e., the "<module>:" prefix of the debug messages
+ * @level: Debug level (MSG_*) for the module or -1 to use wpa_debug_level
+ * Returns: 0 on success, -1 on failure
+ */
+int wpa_debug_set_module_level(const char *module, int level)
+{
+	struct wpa_debug_module *mod;
+	size_t len = os_strlen(module);
+	unsigned int i;
+
+	if (len == 0 || len >= sizeof(mod->name))
+		return -1;
+
+	for (i = 0; i < wpa_debug_num_modules; i++) {
+		mod = &wpa_debug_modules[i];
+		if (mod->len == len && os_memcmp(mod->name, module, len) == 0)
+			break;
+	}
+
+	if (level < 0) {
+		if (i == wpa_debug_num_modules)
+			return 0;
+		wpa_debug_num_modules--;
+		os_memmove(&wpa_debug_modules[i], &wpa_debug_modules[i + 1],
+			   (wpa_debug_num_modules - i) *
+			   sizeof(wpa_debug_modules[0]));
+		wpa_debug_update_extra_level();
+		return 0;
+	}
+
+	if (i == wpa_debug_num_modules) {
+		if (wpa_debug_num_modules == WPA_DEBUG_MAX_MODULES)
+			return -1;
+		mod = &wpa_debug_modules[wpa_debug_num_modules++];
+		os_memcpy(mod->name, module, len);
+		mod->name[len] = '\0';
+		mod->len = len;
+	}
+	mod->level = level;
+	wpa_debug_update_extra_level();
+	return 0;
+}
+
+
+/*
+ * Split a <module>=<level> entry into the module name (in place) and the level.
+ * Returns the debug level, -1 for "default", or -2 if the entry is invalid.
+ */
+static int wpa_debug_module_level_entry(char *token)
+{
+	char *pos;
+	size_t len;
+	int level;
+
+	pos = os_strchr(token, '=');
+	if (!pos)
+		return -2;
+	*pos++ = '\0';
+	len = os_strlen(token);
+	if (len == 0 || len >= sizeof(wpa_debug_modules[0].name))
+		return -2;
+	if (os_strcasecmp(pos, "default") == 0)
+		return -1;
+	level = str_to_debug_level(pos);
+	return level < 0 ? -2 : level;
+}
+
+
+/**
+ * wpa_debug_set_module_levels - Set module debug levels from a string
+ * @cmd: Space separated list of <module>=<level> entries where level is a
+ *	debug level name or "default" to remove the module specific level
+ * Returns: 0 on success, -1 on failure
+ *
+ * The module levels are left unchanged if any of the entries is invalid or
+ * the module table does not have room for all the new modules.
+ */
+int wpa_debug_set_module_levels(const char *cmd)
+{
+	struct wpa_debug_module saved[WPA_DEBUG_MAX_MODULES];
+	unsigned int saved_num;
+	char *tmp, *token, *context = NULL;
+	int ret = 0;
+
+	/* Validate all the entries before applying any of them */
+	tmp = os_strdup(cmd);
+	if (!tmp)
+		return -1;
+	while ((token = str_token(tmp, " ", &context))) {
+		if (wpa_debug_module_level_entry(token) < -1) {
+			ret = -1;
+			break;
+		}
+	}
+	os_free(tmp);
+	if (ret < 0)
+		return -1;
+
+	tmp = os_strdup(cmd);
+	if (!tmp)
+		return -1;
+	os_memcpy(saved, wpa_debug_modules, sizeof(saved));
+	saved_num = wpa_debug_num_modules;
+	context = NULL;
+	while ((token = str_token(tmp, " ", &context))) {
+		if (wpa_debug_set_module_level(
+			    token, wpa_debug_module_level_entry(token)) < 0) {
+			/* Module table full; restore the previous levels */
+			os_memcpy(wpa_debug_modules, saved, sizeof(saved));
+			wpa_debug_num_modules = saved_num;
+			wpa_debug_update_extra_level();
+			ret = -1;
+			break;
+		}
+	}
+	os_free(tmp);
+	return ret;
+}
+
+
+/**
+ * wpa_debug_module_levels - Write the module debug levels into a buffer
+ * @buf: Buffer for the space separated list of <module>=<level> entries
+ * @buflen: Length of the buffer
+ * Returns: Number of characters written (excluding nul termination)
+ */
+int wpa_debug_module_levels(char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	unsigned int i;
+	int res;
+
+	if (buflen == 0)
+		return 0;
+	*pos = '\0';
+	for (i = 0; i < wpa_debug_num_modules; i++) {
+		res = os_snprintf(pos, end - pos, "%s%s=%s", i ? " " : "",
+				  wpa_debug_modules[i].name,
+				  debug_level_str(wpa_debug_modules[i].level));
+		if (os_snprintf_error(end - pos, res))
+			break;
+		pos += res;
+	}
+
+	return pos - buf;
+}
@@ -14,6 +14,7 @@
 extern int wpa_debug_level;
 extern int wpa_debug_show_keys;
 extern int wpa_debug_timestamp;
+extern int wpa_debug_extra_level;
 
 /* Debugging function - conditional printf and hex dump. Driver wrappers can
  * use these for debugging purposes. */
@@ -155,6 +156,60 @@ void wpa_hexdump_ascii_key(int level, const char *title, const void *buf,
  */
 #define wpa_dbg(args...) wpa_msg(args)
 
+/*
+ * The debug print functions are wrapped in macros that check the debug level
+ * before the arguments are evaluated so that filtered out messages do not cost
+ * more than a comparison. wpa_debug_extra_level is the lowest level enabled by
+ * a module specific debug level or Linux tracing; the functions themselves do
+ * the complete filtering.
+ *
+ * In addition, messages below a build time minimum level are removed from the
+ * build completely. WPA_DEBUG_MIN_LEVEL sets the minimum level for the whole
+ * build (CONFIG_DEBUG_MIN_LEVEL) and WPA_DEBUG_MODULE_MIN_LEVEL overrides it
+ * for a single source directory (CONFIG_DEBUG_MIN_LEVEL_<dir>).
+ */
+#ifdef WPA_DEBUG_MODULE_MIN_LEVEL
+#define WPA_DEBUG_BUILD_LEVEL WPA_DEBUG_MODULE_MIN_LEVEL
+#elif defined(WPA_DEBUG_MIN_LEVEL)
+#define WPA_DEBUG_BUILD_LEVEL WPA_DEBUG_MIN_LEVEL
+#endif
+
+#define wpa_debug_runtime_enabled(level) \
+	((level) >= wpa_debug_level || (level) >= wpa_debug_extra_level)
+
+#ifdef WPA_DEBUG_BUILD_LEVEL
+#define wpa_debug_level_enabled(level) \
+	((level) >= WPA_DEBUG_BUILD_LEVEL && wpa_debug_runtime_enabled(level))
+#else /* WPA_DEBUG_BUILD_LEVEL */
+#define wpa_debug_level_enabled(level) wpa_debug_runtime_enabled(level)
+#endif /* WPA_DEBUG_BUILD_LEVEL */
+
+#define wpa_printf(level, args...)				\
+	do {							\
+		if (wpa_debug_level_enabled(level))		\
+			wpa_printf((level), args);		\
+	} while (0)
+#define wpa_hexdump(level, args...)				\
+	do {							\
+		if (wpa_debug_level_enabled(level))		\
+			wpa_hexdump((level), args);		\
+	} while (0)
+#define wpa_hexdump_key(level, args...)				\
+	do {							\
+		if (wpa_debug_level_enabled(level))		\
+			wpa_hexdump_key((level), args);		\
+	} while (0)
+#define wpa_hexdump_ascii(level, args...)			\
+	do {							\
+		if (wpa_debug_level_enabled(level))		\
+			wpa_hexdump_ascii((level), args);	\
+	} while (0)
+#define wpa_hexdump_ascii_key(level, args...)			\
+	do {							\
+		if (wpa_debug_level_enabled(level))		\
+			wpa_hexdump_ascii_key((level), args);	\
+	} while (0)
+
 #endif /* CONFIG_NO_STDOUT_DEBUG */
 
 
@@ -366,5 +421,8 @@ static inline void wpa_debug_close_linux_tracing(void)
 
 const char * debug_level_str(int level);
 int str_to_debug_level(const char *s);
+int wpa_debug_set_module_level(const char *module, int level);
+int wpa_debug_set_module_levels(const char *cmd);
+int wpa_debug_module_levels(char *buf, size_t buflen);
 
 #endif /* WPA_DEBUG_H */
@@ -281,6 +281,30 @@ def test_ap_wpa2_psk_wildcard_ssid(dev, apdev):
                    scan_freq="2412")
     dev[1].connect("", bssid=apdev[0]['bssid'], raw_psk=psk, scan_freq="2412")
 
+def test_ap_wpa2_psk_wildcard_ssid_psk_cache(dev, apdev):
+    """WPA2-PSK AP and wildcard SSID configuration with PSK cache"""
+    ssid = "test-wpa2-psk"
+    passphrase = 'qwertyuiop'
+    params = hostapd.wpa2_params(ssid=ssid, passphrase=passphrase)
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    try:
+        dev[0].request("SET psk_cache_precompute 1")
+        id = dev[0].connect("", bssid=apdev[0]['bssid'], psk=passphrase,
+                            scan_freq="2412", only_add_network=True)
+        dev[0].scan_for_bss(apdev[0]['bssid'], freq="2412")
+        dev[0].select_network(id)
+        dev[0].wait_connected()
+        dev[0].request("REMOVE_NETWORK all")
+        dev[0].wait_disconnected()
+
+        dev[0].request("SET psk_cache_size 0")
+        dev[0].request("BSS_FLUSH 0")
+        dev[0].connect("", bssid=apdev[0]['bssid'], psk=passphrase,
+                       scan_freq="2412")
+    finally:
+        dev[0].request("SET psk_cache_precompute 0")
+        dev[0].request("SET psk_cache_size 16")
+
 def test_ap_wpa2_gtk_rekey(dev, apdev):
     """WPA2-PSK AP and GTK rekey enforced by AP"""
     ssid = "test-wpa2-psk"
@@ -2192,3 +2216,87 @@ def test_ap_wpa2_psk_assoc_rsn(dev, apdev):
             raise Exception("Unexpected status code: " + ev)
         dev[0].request("REMOVE_NETWORK all")
         dev[0].dump_monitor()
+
+def read_status_page(fname):
+    # struct status_page_data in src/utils/status_page.h
+    fmt = '=IHHIIIIIiiIIIII6sBB32s'
+    with open(fname, 'rb') as f:
+        data = f.read(struct.calcsize(fmt))
+    (magic, version, length, seq, state, sec, usec, freq, signal, noise,
+     txrate, num_sta, num_sta_auth, ptk, gtk, bssid, ssid_len, mode,
+     ssid) = struct.unpack(fmt, data)
+    if magic != 0x53415057 or version != 1 or length != len(data):
+        raise Exception("Invalid status page header")
+    if seq & 1:
+        raise Exception("Status page update not completed")
+    return { 'state': state, 'freq': freq, 'num_sta': num_sta,
+             'num_sta_authorized': num_sta_auth, 'pairwise_keys': ptk,
+             'group_keys': gtk,
+             'bssid': ':'.join('%02x' % ord(c) for c in bssid),
+             'ssid': ssid[0:ssid_len], 'mode': mode }
+
+def test_ap_wpa2_psk_status_page(dev, apdev):
+    """WPA2-PSK AP and station with memory-mapped status page"""
+    hfile = "/tmp/hostapd-status-page-test"
+    wfile = "/tmp/wpas-status-page-test"
+    ssid = "test-wpa2-psk"
+    params = hostapd.wpa2_params(ssid=ssid, passphrase="12345678")
+    params['status_page'] = hfile
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    try:
+        if "OK" not in dev[0].request("SET status_page " + wfile):
+            raise Exception("Failed to set status_page")
+        if not os.path.exists(wfile):
+            raise Exception("Station status page file not created")
+        dev[0].connect(ssid, psk="12345678", scan_freq="2412")
+        hapd.wait_event(["AP-STA-CONNECTED"], timeout=5)
+
+        st = read_status_page(wfile)
+        logger.info("wpa_supplicant status page: " + str(st))
+        # WPA_COMPLETED and STATUS_PAGE_MODE_STATION
+        if st['state'] != 9 or st['mode'] != 1:
+            raise Exception("Unexpected station state in status page")
+        if st['bssid'] != apdev[0]['bssid'] or st['ssid'] != ssid or \
+           st['freq'] != 2412:
+            raise Exception("Unexpected station status page contents")
+        if st['pairwise_keys'] < 1 or st['group_keys'] < 1:
+            raise Exception("Station keys not counted")
+
+        st = read_status_page(hfile)
+        logger.info("hostapd status page: " + str(st))
+        # HAPD_IFACE_ENABLED and STATUS_PAGE_MODE_AP
+        if st['state'] != 6 or st['mode'] != 2:
+            raise Exception("Unexpected AP state in status page")
+        if st['num_sta'] != 1 or st['num_sta_authorized'] != 1:
+            raise Exception("Unexpected AP station count in status page")
+        if st['pairwise_keys'] < 1 or st['group_keys'] < 1:
+            raise Exception("AP keys not counted")
+
+        dev[0].request("DISCONNECT")
+        dev[0].wait_disconnected()
+        hapd.wait_event(["AP-STA-DISCONNECTED"], timeout=5)
+        if read_status_page(wfile)['bssid'] != "00:00:00:00:00:00":
+            raise Exception("Station status page not cleared")
+        if read_status_page(hfile)['num_sta_authorized'] != 0:
+            raise Exception("AP authorized station count not updated")
+    finally:
+        dev[0].request("SET status_page ")
+    if os.path.exists(wfile):
+        raise Exception("Station status page file not removed")
+
+def test_ap_wpa2_psk_status_page_existing_file(dev, apdev):
+    """Status page does not overwrite or remove an unrelated file"""
+    fname = "/tmp/wpas-status-page-existing-test"
+    with open(fname, "w") as f:
+        f.write("unrelated file\n")
+    try:
+        dev[0].request("SET status_page " + fname)
+        dev[0].request("SET status_page ")
+        if not os.path.exists(fname):
+            raise Exception("Unrelated file removed")
+        with open(fname, "r") as f:
+            if f.read() != "unrelated file\n":
+                raise Exception("Unrelated file overwritten")
+    finally:
+        dev[0].request("SET status_page ")
+        os.unlink(fname)
@@ -1067,6 +1067,158 @@ def test_dbus_scan(dev, apdev):
         raise Exception("FlushBSS() did not remove scan results from BSSs property")
     iface.FlushBSS(1)
 
+def test_dbus_scan_bulk_signals(dev, apdev):
+    """D-Bus bulk BSS signals and signal counters"""
+    (bus,wpas_obj,path,if_obj) = prepare_dbus(dev[0])
+    iface = dbus.Interface(if_obj, WPAS_DBUS_IFACE)
+
+    hapd = hostapd.add_ap(apdev[0]['ifname'], { "ssid": "open" })
+    hapd2 = hostapd.add_ap(apdev[1]['ifname'], { "ssid": "open2" })
+
+    class TestDbusScanBulk(TestDbus):
+        def __init__(self, bus):
+            TestDbus.__init__(self, bus)
+            self.bsss_added = []
+            self.bsss_removed = []
+            self.bss_signal = False
+            self.scan_done = False
+
+        def __enter__(self):
+            gobject.timeout_add(1, self.run_scan)
+            gobject.timeout_add(15000, self.timeout)
+            self.add_signal(self.scanDone, WPAS_DBUS_IFACE, "ScanDone")
+            self.add_signal(self.bssAdded, WPAS_DBUS_IFACE, "BSSAdded")
+            self.add_signal(self.bssRemoved, WPAS_DBUS_IFACE, "BSSRemoved")
+            self.add_signal(self.bsssAdded, WPAS_DBUS_IFACE, "BSSsAdded")
+            self.add_signal(self.bsssRemoved, WPAS_DBUS_IFACE, "BSSsRemoved")
+            self.loop.run()
+            return self
+
+        def scanDone(self, success):
+            logger.debug("scanDone: success=%s" % success)
+            if not self.scan_done:
+                # BSSsAdded is sent before ScanDone
+                self.scan_done = len(self.bsss_added) == 2
+                iface.FlushBSS(0)
+
+        def bssAdded(self, bss, properties):
+            logger.debug("bssAdded: %s" % bss)
+            self.bss_signal = True
+
+        def bssRemoved(self, bss):
+            logger.debug("bssRemoved: %s" % bss)
+            self.bss_signal = True
+
+        def bsssAdded(self, bsss):
+            logger.debug("bsssAdded: %s" % str(bsss))
+            self.bsss_added += [ (str(p), v) for p,v in bsss.items() ]
+
+        def bsssRemoved(self, paths):
+            logger.debug("bsssRemoved: %s" % str(paths))
+            self.bsss_removed += [ str(p) for p in paths ]
+            self.loop.quit()
+
+        def run_scan(self, *args):
+            logger.debug("run_scan")
+            iface.Scan({'Type': 'active',
+                        'AllowRoam': False,
+                        'Channels': [(dbus.UInt32(2412), dbus.UInt32(20))]})
+            return False
+
+        def success(self):
+            return self.scan_done and len(self.bsss_removed) > 0
+
+    if "OK" not in dev[0].request("SET dbus_bss_bulk_signals 1"):
+        raise Exception("Failed to enable bulk BSS signals")
+    try:
+        cnt = wpas_obj.Get(WPAS_DBUS_SERVICE, "SignalCounters",
+                           dbus_interface=dbus.PROPERTIES_IFACE)
+        with TestDbusScanBulk(bus) as t:
+            if not t.success():
+                raise Exception("Expected signals not seen")
+            if t.bss_signal:
+                raise Exception("Unexpected BSSAdded/BSSRemoved signal")
+            ssids = [ str(bytearray(v['SSID'])) for p,v in t.bsss_added ]
+            if "open" not in ssids or "open2" not in ssids:
+                raise Exception("Unexpected BSSsAdded contents: " + str(ssids))
+
+        res = if_obj.Get(WPAS_DBUS_IFACE, "BSSs",
+                         dbus_interface=dbus.PROPERTIES_IFACE)
+        if len(res) != 0:
+            raise Exception("FlushBSS() did not remove scan results")
+        if sorted(t.bsss_removed) != sorted([ p for p,v in t.bsss_added ]):
+            raise Exception("Unexpected BSSsRemoved contents: " +
+                            str(t.bsss_removed))
+
+        cnt2 = wpas_obj.Get(WPAS_DBUS_SERVICE, "SignalCounters",
+                            dbus_interface=dbus.PROPERTIES_IFACE)
+        logger.info("SignalCounters: %s -> %s" % (str(cnt), str(cnt2)))
+        if cnt2['Sent'] <= cnt['Sent']:
+            raise Exception("Sent signal counter did not increase")
+        # Four BSSAdded/BSSRemoved signals were replaced by bulk signals
+        if cnt2['Suppressed'] < cnt['Suppressed'] + 4:
+            raise Exception("Suppressed signal counter did not increase")
+    finally:
+        dev[0].request("SET dbus_bss_bulk_signals 0")
+        iface.FlushBSS(0)
+
+def test_dbus_bss_on_demand(dev, apdev):
+    """D-Bus BSS objects registered on demand"""
+    (bus,wpas_obj,path,if_obj) = prepare_dbus(dev[0])
+    iface = dbus.Interface(if_obj, WPAS_DBUS_IFACE)
+
+    hapd = hostapd.add_ap(apdev[0]['ifname'], { "ssid": "open" })
+    bssid = apdev[0]['bssid']
+
+    if "OK" not in dev[0].request("SET dbus_bss_on_demand 1"):
+        raise Exception("Failed to enable on-demand BSS objects")
+    try:
+        dev[0].scan_for_bss(bssid, freq=2412)
+        res = if_obj.Get(WPAS_DBUS_IFACE, "BSSs",
+                         dbus_interface=dbus.PROPERTIES_IFACE)
+        if len(res) != 1:
+            raise Exception("Unexpected BSSs property value: " + str(res))
+        bss_path = res[0]
+
+        bsss_obj = bus.get_object(WPAS_DBUS_SERVICE, path + "/BSSs")
+        xml = bsss_obj.Introspect(dbus_interface=dbus.INTROSPECTABLE_IFACE)
+        node = '<node name="%s"/>' % bss_path.split('/')[-1]
+        if node not in xml:
+            raise Exception("BSS missing from introspection: " + xml)
+
+        bss_obj = bus.get_object(WPAS_DBUS_SERVICE, bss_path)
+        props = bss_obj.GetAll(WPAS_DBUS_BSS,
+                               dbus_interface=dbus.PROPERTIES_IFACE)
+        if 'Age' not in props or 'IEs' not in props:
+            raise Exception("Full BSS properties not available: " +
+                            str(props))
+        if str(bytearray(props['SSID'])) != "open":
+            raise Exception("Unexpected SSID: " + str(props['SSID']))
+
+        # Not a valid BSS object path
+        try:
+            obj = bus.get_object(WPAS_DBUS_SERVICE, bss_path + "0000")
+            obj.GetAll(WPAS_DBUS_BSS, dbus_interface=dbus.PROPERTIES_IFACE)
+            raise Exception("Invalid BSS object path accepted")
+        except dbus.exceptions.DBusException, e:
+            if "UnknownMethod" not in str(e) and "UnknownObject" not in str(e):
+                raise Exception("Unexpected error: " + str(e))
+
+        iface.FlushBSS(0)
+        res = if_obj.Get(WPAS_DBUS_IFACE, "BSSs",
+                         dbus_interface=dbus.PROPERTIES_IFACE)
+        if len(res) != 0:
+            raise Exception("FlushBSS() did not remove scan results")
+        try:
+            bss_obj.GetAll(WPAS_DBUS_BSS,
+                           dbus_interface=dbus.PROPERTIES_IFACE)
+            raise Exception("Removed BSS object still available")
+        except dbus.exceptions.DBusException, e:
+            pass
+    finally:
+        dev[0].request("SET dbus_bss_on_demand 0")
+        iface.FlushBSS(0)
+
 def test_dbus_scan_busy(dev, apdev):
     """D-Bus scan trigger rejection when busy with previous scan"""
     (bus,wpas_obj,path,if_obj) = prepare_dbus(dev[0])
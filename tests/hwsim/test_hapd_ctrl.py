@@ -4,8 +4,11 @@
 # This software may be distributed under the terms of the BSD license.
 # See README for more details.
 
+import binascii
+import struct
+
 import hostapd
-from utils import skip_with_fips
+from utils import skip_with_fips, HwsimSkip
 
 def test_hapd_ctrl_status(dev, apdev):
     """hostapd ctrl_iface STATUS commands"""
@@ -131,6 +134,64 @@ def test_hapd_ctrl_new_sta(dev, apdev):
     if "AUTHORIZED" not in hapd.request("STA 00:11:22:33:44:55"):
         raise Exception("Unexpected NEW_STA STA status")
 
+def test_hapd_ctrl_all_sta_dump(dev, apdev):
+    """hostapd and ALL_STA_DUMP ctrl_iface command"""
+    ssid = "hapd-ctrl"
+    params = { "ssid": ssid }
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    if hapd.request("ALL_STA_DUMP") != "END\n":
+        raise Exception("Unexpected ALL_STA_DUMP result without stations")
+
+    addrs = [ "02:00:00:00:01:%02x" % i for i in range(40) ]
+    for addr in addrs:
+        if "OK" not in hapd.request("NEW_STA " + addr):
+            raise Exception("NEW_STA failed")
+
+    found = []
+    cursor = None
+    requests = 0
+    while True:
+        cmd = "ALL_STA_DUMP"
+        if cursor:
+            cmd += " cursor=" + cursor
+        lines = hapd.request(cmd).splitlines()
+        requests += 1
+        if len(lines) < 2:
+            raise Exception("Unexpected ALL_STA_DUMP result: " + str(lines))
+        for l in lines[:-1]:
+            if '=' not in l:
+                found.append(l)
+        if lines[-1] == "END":
+            break
+        if not lines[-1].startswith("MORE "):
+            raise Exception("Unexpected ALL_STA_DUMP trailer: " + lines[-1])
+        cursor = lines[-1].split(' ')[1]
+        if cursor in found:
+            raise Exception("Cursor points to already reported station")
+        if requests > 20:
+            raise Exception("Too many ALL_STA_DUMP requests")
+    if sorted(found) != sorted(addrs):
+        raise Exception("Unexpected station list: " + str(found))
+    if requests < 2:
+        raise Exception("ALL_STA_DUMP reply was not split")
+
+    lines = hapd.request("ALL_STA_DUMP fields=aid,flags").splitlines()
+    if lines[-1] != "END":
+        raise Exception("Unexpected ALL_STA_DUMP fields trailer: " + lines[-1])
+    found = []
+    for l in lines[:-1]:
+        if '=' not in l:
+            found.append(l)
+        elif not l.startswith("aid=") and not l.startswith("flags="):
+            raise Exception("Unexpected field: " + l)
+    if sorted(found) != sorted(addrs):
+        raise Exception("Unexpected station list with fields: " + str(found))
+
+    if "FAIL" not in hapd.request("ALL_STA_DUMP cursor=00:11:22:33:44:55"):
+        raise Exception("Unexpected ALL_STA_DUMP success with unknown cursor")
+    if "FAIL" not in hapd.request("ALL_STA_DUMP cursor=00:11:22:33:44"):
+        raise Exception("Unexpected ALL_STA_DUMP success with invalid cursor")
+
 def test_hapd_ctrl_get(dev, apdev):
     """hostapd and GET ctrl_iface command"""
     ssid = "hapd-ctrl"
@@ -555,3 +616,51 @@ def test_hapd_ctrl_log_level(dev, apdev):
         raise Exception("Unexpected debug level(3): " + level)
     if "Timestamp: 1" not in level:
         raise Exception("Unexpected timestamp(3): " + level)
+
+def trace_dump(ctrl):
+    entries = []
+    cmd = "TRACE_DUMP"
+    while True:
+        res = ctrl.request(cmd)
+        if "FAIL" in res:
+            raise HwsimSkip("TRACE_DUMP not supported")
+        lines = res.splitlines()
+        if not lines:
+            break
+        for line in lines:
+            (seq, sec, usec, event, st_from, st_to, reserved, arg1, arg2,
+             addr) = struct.unpack('<IIIBBBBHH6s', binascii.unhexlify(line))
+            addr = ':'.join('%02x' % c for c in bytearray(addr))
+            entries.append((seq, event, st_from, st_to, arg1, arg2, addr))
+        cmd = "TRACE_DUMP %d" % (entries[-1][0] + 1)
+    return entries
+
+def test_hapd_ctrl_trace_dump(dev, apdev):
+    """hostapd ctrl_iface TRACE_DUMP"""
+    ssid = "hapd-ctrl"
+    params = hostapd.wpa2_params(ssid=ssid, passphrase="12345678")
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    trace_dump(hapd)
+    if "FAIL" not in hapd.request("TRACE_DUMP foo"):
+        raise Exception("Invalid TRACE_DUMP accepted")
+    if "UNKNOWN COMMAND" not in hapd.request("TRACE_DUMP5"):
+        raise Exception("TRACE_DUMP without separator accepted")
+
+    dev[0].connect(ssid, psk="12345678", scan_freq="2412")
+    addr = dev[0].own_addr()
+    entries = [e for e in trace_dump(hapd) if e[6] == addr]
+
+    # WPA_PTK state machine reaching PTKINITDONE (11)
+    if not any(e[1] == 1 and e[3] == 11 for e in entries):
+        raise Exception("PTKINITDONE not recorded: " + str(entries))
+    # RX Authentication and Association Request frames
+    stypes = [ (e[4] >> 4) & 0xf for e in entries if e[1] == 5 ]
+    if 11 not in stypes or 0 not in stypes:
+        raise Exception("Auth/Assoc Req RX not recorded: " + str(entries))
+    # Acknowledged Association Response with status 0
+    if not any(e[1] == 6 and (e[4] >> 4) & 0xf == 1 and e[3] == 1 and
+               e[5] == 0 for e in entries):
+        raise Exception("Assoc Resp TX status not recorded: " + str(entries))
+    seqs = [ e[0] for e in trace_dump(hapd) ]
+    if seqs != sorted(seqs) or len(set(seqs)) != len(seqs):
+        raise Exception("Unexpected sequence numbers")
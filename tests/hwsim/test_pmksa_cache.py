@@ -6,14 +6,146 @@
 
 import logging
 logger = logging.getLogger()
+import os
 import subprocess
 import time
 
 import hostapd
 from wpasupplicant import WpaSupplicant
-from utils import alloc_fail
+from utils import alloc_fail, HwsimSkip
 from test_ap_eap import eap_connect
 
+def test_pmksa_cache_max_entries(dev, apdev):
+    """PMKSA cache size limit and LRU eviction on AP"""
+    params = hostapd.wpa2_eap_params(ssid="test-pmksa-cache")
+    params['pmksa_cache_max_entries'] = "2"
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    bssid = apdev[0]['bssid']
+
+    for i in range(3):
+        dev[i].connect("test-pmksa-cache", proto="RSN", key_mgmt="WPA-EAP",
+                       eap="GPSK", identity="gpsk user",
+                       password="abcdefghijklmnop0123456789abcdef",
+                       scan_freq="2412")
+        if dev[i].get_pmksa(bssid) is None:
+            raise Exception("No PMKSA cache entry created")
+    mib = hapd.get_mib()
+    if mib['hostapdPMKSACacheMaxEntries'] != '2':
+        raise Exception("Unexpected PMKSA cache size limit")
+    if mib['hostapdPMKSACacheEntries'] != '2':
+        raise Exception("Unexpected number of PMKSA cache entries")
+    if mib['hostapdPMKSACacheEvictions'] != '1':
+        raise Exception("Unexpected number of PMKSA cache evictions")
+
+    # dev[0] entry was evicted, so full EAP authentication is needed
+    for i in [ 0, 2 ]:
+        dev[i].request("DISCONNECT")
+        dev[i].wait_disconnected()
+        dev[i].request("RECONNECT")
+        dev[i].wait_connected(timeout=15, error="Reconnect timed out")
+    mib = hapd.get_mib()
+    if mib['hostapdPMKSACacheHits'] != '1':
+        raise Exception("Unexpected number of PMKSA cache hits")
+    if int(mib['hostapdPMKSACacheMisses']) < 1:
+        raise Exception("PMKSA cache miss not reported")
+
+def test_pmksa_cache_shared(dev, apdev):
+    """PMKSA cache shared between BSSes through a shared store"""
+    store = "/tmp/hostapd-pmksa-cache-shared"
+    if os.path.exists(store):
+        os.unlink(store)
+    params = hostapd.wpa2_eap_params(ssid="test-pmksa-cache")
+    params['pmksa_cache_shared'] = store
+    try:
+        hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    except Exception, e:
+        if os.path.exists(store):
+            raise
+        raise HwsimSkip("Shared PMKSA cache not supported in the build")
+    bssid = apdev[0]['bssid']
+    try:
+        if os.stat(store).st_mode & 0077:
+            raise Exception("Shared PMKSA cache store accessible by others")
+        dev[0].connect("test-pmksa-cache", proto="RSN", key_mgmt="WPA-EAP",
+                       eap="GPSK", identity="gpsk user",
+                       password="abcdefghijklmnop0123456789abcdef", okc=True,
+                       scan_freq="2412")
+        pmksa = dev[0].get_pmksa(bssid)
+        if pmksa is None:
+            raise Exception("No PMKSA cache entry created")
+
+        # AP2 does not use OKC, so the PMK can only be found from the shared
+        # store
+        hapd2 = hostapd.add_ap(apdev[1]['ifname'], params)
+        bssid2 = apdev[1]['bssid']
+
+        dev[0].dump_monitor()
+        logger.info("Roam to AP2")
+        dev[0].scan_for_bss(bssid2, freq="2412")
+        dev[0].request("ROAM " + bssid2)
+        ev = dev[0].wait_event(["CTRL-EVENT-EAP-STARTED",
+                                "CTRL-EVENT-CONNECTED"], timeout=10)
+        if ev is None:
+            raise Exception("Roaming with the AP timed out")
+        if "CTRL-EVENT-EAP-STARTED" in ev:
+            raise Exception("Unexpected EAP exchange")
+        mib = hapd2.get_mib()
+        if mib['hostapdPMKSACacheSharedHits'] != '1':
+            raise Exception("Shared PMKSA cache hit not reported")
+    finally:
+        dev[0].request("DISCONNECT")
+        if os.path.exists(store):
+            os.unlink(store)
+
+def test_pmksa_cache_file(dev, apdev):
+    """PMKSA cache snapshot restored after AP restart"""
+    snapshot = "/tmp/hostapd-pmksa-cache-file"
+    if os.path.exists(snapshot):
+        os.unlink(snapshot)
+    params = hostapd.wpa2_eap_params(ssid="test-pmksa-cache")
+    params['pmksa_cache_file'] = snapshot
+    params['pmksa_cache_file_key'] = "000102030405060708090a0b0c0d0e0f"
+    params['pmksa_cache_file_interval'] = "0"
+    try:
+        hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    except Exception, e:
+        raise HwsimSkip("PMKSA cache snapshot not supported in the build")
+    bssid = apdev[0]['bssid']
+    try:
+        dev[0].connect("test-pmksa-cache", proto="RSN", key_mgmt="WPA-EAP",
+                       eap="GPSK", identity="gpsk user",
+                       password="abcdefghijklmnop0123456789abcdef",
+                       scan_freq="2412")
+        pmksa = dev[0].get_pmksa(bssid)
+        if pmksa is None:
+            raise Exception("No PMKSA cache entry created")
+
+        hapd.disable()
+        dev[0].wait_disconnected()
+        if not os.path.exists(snapshot):
+            raise Exception("PMKSA cache snapshot not written")
+        if os.stat(snapshot).st_mode & 0077:
+            raise Exception("PMKSA cache snapshot accessible by others")
+        hapd.enable()
+        mib = hapd.get_mib()
+        if mib['hostapdPMKSACacheEntries'] != '1':
+            raise Exception("PMKSA cache entry not restored")
+
+        dev[0].dump_monitor()
+        ev = dev[0].wait_event(["CTRL-EVENT-EAP-STARTED",
+                                "CTRL-EVENT-CONNECTED"], timeout=20)
+        if ev is None:
+            raise Exception("Reconnection timed out")
+        if "CTRL-EVENT-EAP-STARTED" in ev:
+            raise Exception("Unexpected EAP exchange")
+        pmksa2 = dev[0].get_pmksa(bssid)
+        if pmksa2 is None or pmksa['pmkid'] != pmksa2['pmkid']:
+            raise Exception("Unexpected PMKID change")
+    finally:
+        dev[0].request("DISCONNECT")
+        if os.path.exists(snapshot):
+            os.unlink(snapshot)
+
 def test_pmksa_cache_on_roam_back(dev, apdev):
     """PMKSA cache to skip EAP on reassociation back to same AP"""
     params = hostapd.wpa2_eap_params(ssid="test-pmksa-cache")
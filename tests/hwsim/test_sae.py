@@ -123,6 +123,37 @@ def test_sae_pmksa_caching_disabled(dev, apdev):
     if dev[0].get_status_field('sae_group') != '19':
             raise Exception("Expected default SAE group not used")
 
+def test_sae_pwe_cache(dev, apdev):
+    """SAE with PWE cache"""
+    if "SAE" not in dev[0].get_capability("auth_alg"):
+        raise HwsimSkip("SAE not supported")
+    params = hostapd.wpa2_params(ssid="test-sae",
+                                 passphrase="12345678")
+    params['wpa_key_mgmt'] = 'SAE'
+    params['disable_pmksa_caching'] = '1'
+    params['sae_pwe_cache_size'] = '2'
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+
+    dev[0].request("SET sae_groups ")
+    try:
+        if "OK" not in dev[0].request("SET sae_pwe_cache_size 2"):
+            raise Exception("Failed to set sae_pwe_cache_size")
+        for password in [ "12345678", "12345678", "another password",
+                          "12345678" ]:
+            hapd.set("wpa_passphrase", password)
+            dev[0].connect("test-sae", psk=password, key_mgmt="SAE",
+                           scan_freq="2412")
+            dev[0].request("DISCONNECT")
+            dev[0].wait_disconnected()
+            dev[0].request("RECONNECT")
+            dev[0].wait_connected(timeout=15, error="Reconnect timed out")
+            if dev[0].get_status_field('sae_group') != '19':
+                raise Exception("Expected default SAE group not used")
+            dev[0].request("REMOVE_NETWORK all")
+            dev[0].wait_disconnected()
+    finally:
+        dev[0].request("SET sae_pwe_cache_size 0")
+
 def test_sae_groups(dev, apdev):
     """SAE with all supported groups"""
     if "SAE" not in dev[0].get_capability("auth_alg"):
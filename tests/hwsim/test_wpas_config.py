@@ -8,6 +8,7 @@ import logging
 logger = logging.getLogger()
 import os
 
+import hostapd
 from wpasupplicant import WpaSupplicant
 
 def check_config(config):
@@ -116,6 +117,24 @@ def test_wpas_config_file(dev):
             logger.debug(data2)
             raise Exception("Unexpected configuration change")
 
+        # unchanged configuration is not written again
+        inode = os.stat(config).st_ino
+        if "OK" not in wpas.request("SAVE_CONFIG"):
+            raise Exception("Failed to save configuration file")
+        if os.stat(config).st_ino != inode:
+            raise Exception("Unchanged configuration file was rewritten")
+        wpas.request("SET wps_priority 6")
+        if "OK" not in wpas.request("SAVE_CONFIG"):
+            raise Exception("Failed to save configuration file")
+        if os.stat(config).st_ino == inode:
+            raise Exception("Changed configuration file was not rewritten")
+        with open(config, "r") as f:
+            if "wps_priority=6\n" not in f.read():
+                raise Exception("Configuration change not written")
+        if os.path.exists(config + ".tmp"):
+            raise Exception("Temporary configuration file left behind")
+        wpas.request("SET wps_priority 5")
+
         wpas.request("SET update_config 0")
         wpas.global_request("SET update_config 0")
         if "OK" in wpas.request("SAVE_CONFIG"):
@@ -146,3 +165,56 @@ def test_wpas_config_file(dev):
             os.rmdir(config)
         except:
             pass
+
+def test_wpas_config_cache(dev, apdev):
+    """wpa_supplicant config file PSK cache"""
+    config = "/tmp/test_wpas_config_cache.conf"
+    cache = config + ".cache"
+    for f in [ config, cache ]:
+        if os.path.exists(f):
+            os.remove(f)
+
+    params = hostapd.wpa2_params(ssid="test-cache", passphrase="12345678")
+    hostapd.add_ap(apdev[0]['ifname'], params)
+
+    wpas = WpaSupplicant(global_iface='/tmp/wpas-wlan5')
+    try:
+        with open(config, "w") as f:
+            f.write("config_cache=1\n")
+            f.write("network={\n\tssid=\"test-cache\"\n\tpsk=\"12345678\"\n\tkey_mgmt=WPA-PSK\n}\n")
+            f.write("network={\n\tssid=\"other\"\n\tpsk=\"abcdefgh\"\n\tdisabled=1\n}\n")
+
+        wpas.interface_add("wlan5", config=config)
+        if not os.path.exists(cache):
+            raise Exception("Configuration cache not written")
+        st = os.stat(cache)
+        if st.st_mode & 0077:
+            raise Exception("Configuration cache readable by others")
+        if st.st_size != 8 + 2 * (20 + 32):
+            raise Exception("Unexpected configuration cache size %d" % st.st_size)
+        wpas.interface_remove("wlan5")
+
+        # PSK from the cache file is used for the connection
+        wpas.interface_add("wlan5", config=config)
+        wpas.wait_connected(timeout=10)
+        wpas.interface_remove("wlan5")
+
+        # changed passphrase invalidates only the matching entry
+        with open(config, "w") as f:
+            f.write("config_cache=1\n")
+            f.write("network={\n\tssid=\"test-cache\"\n\tpsk=\"12345678\"\n\tkey_mgmt=WPA-PSK\n}\n")
+            f.write("network={\n\tssid=\"other\"\n\tpsk=\"abcdefgi\"\n\tdisabled=1\n}\n")
+        with open(cache, "r") as f:
+            data = f.read()
+        wpas.interface_add("wlan5", config=config)
+        with open(cache, "r") as f:
+            data2 = f.read()
+        if data == data2 or len(data2) != len(data):
+            raise Exception("Configuration cache not updated")
+        wpas.wait_connected(timeout=10)
+    finally:
+        for f in [ config, cache ]:
+            try:
+                os.remove(f)
+            except:
+                pass
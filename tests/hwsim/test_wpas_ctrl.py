@@ -8,14 +8,16 @@ import logging
 logger = logging.getLogger()
 import os
 import socket
+import struct
 import subprocess
 import time
 
 import hostapd
 import hwsim_utils
+import wpaspy
 from hwsim import HWSimRadio
 from wpasupplicant import WpaSupplicant
-from utils import alloc_fail
+from utils import HwsimSkip, alloc_fail
 from test_wpas_ap import wait_ap_ready
 
 def test_wpas_ctrl_network(dev):
@@ -1107,6 +1109,32 @@ def test_wpas_ctrl_log_level(dev):
     if "Timestamp: 1" not in level:
         raise Exception("Unexpected timestamp(3): " + level)
 
+def test_wpas_ctrl_log_level_module(dev):
+    """wpa_supplicant ctrl_iface LOG_LEVEL for modules"""
+    try:
+        if "OK" not in dev[2].request("LOG_LEVEL EAPOL=ERROR WPA=DEBUG"):
+            raise Exception("LOG_LEVEL module failed")
+        level = dev[2].request("LOG_LEVEL")
+        if "Current level: MSGDUMP" not in level:
+            raise Exception("Unexpected debug level: " + level)
+        if "Module levels: EAPOL=ERROR WPA=DEBUG" not in level:
+            raise Exception("Unexpected module levels: " + level)
+
+        if "OK" not in dev[2].request("LOG_LEVEL EAPOL=default"):
+            raise Exception("LOG_LEVEL module default failed")
+        level = dev[2].request("LOG_LEVEL")
+        if "Module levels: WPA=DEBUG" not in level:
+            raise Exception("Unexpected module levels(2): " + level)
+
+        for cmd in [ "EAPOL=FOO", "=DEBUG", "EAPOL", "EAPOL=DEBUG WPA" ]:
+            if "FAIL" not in dev[2].request("LOG_LEVEL " + cmd):
+                raise Exception("Invalid LOG_LEVEL accepted: " + cmd)
+    finally:
+        dev[2].request("LOG_LEVEL EAPOL=default WPA=default")
+    level = dev[2].request("LOG_LEVEL")
+    if "Module levels" in level:
+        raise Exception("Module levels not cleared: " + level)
+
 def test_wpas_ctrl_enable_disable_network(dev, apdev):
     """wpa_supplicant ctrl_iface ENABLE/DISABLE_NETWORK"""
     params = { "ssid": "test" }
@@ -1908,6 +1936,40 @@ def test_wpas_ctrl_event_burst(dev, apdev):
     if not dev[0].ping():
         raise Exception("Could not ping wpa_supplicant at the end of the test")
 
+def test_wpas_ctrl_attach_filter(dev, apdev):
+    """wpa_supplicant ATTACH with event filter"""
+    mon = wpaspy.Ctrl(os.path.join("/var/run/wpa_supplicant", dev[0].ifname))
+    tests = [ "filter=", "filter=TEST-EVENT-MESSAGE,", "foo=bar" ]
+    for t in tests:
+        if "FAIL" not in mon.request("ATTACH " + t):
+            raise Exception("Invalid ATTACH parameters accepted: " + t)
+
+    if "OK" not in mon.request("ATTACH filter=TEST-EVENT-MESSAGE filter=CTRL-EVENT-SCAN-RESULTS"):
+        raise Exception("ATTACH with filter failed")
+    mon.attached = True
+    try:
+        dev[0].scan(freq=2412)
+        if "OK" not in dev[0].request("EVENT_TEST 10"):
+            raise Exception("Could not request event messages")
+
+        count = 0
+        scan_results = False
+        while count < 10:
+            if not mon.pending(timeout=5):
+                raise Exception("Event not received through filter")
+            ev = mon.recv()
+            msg = ev.split('>', 1)[1]
+            if msg.startswith("TEST-EVENT-MESSAGE "):
+                count += 1
+            elif msg.startswith("CTRL-EVENT-SCAN-RESULTS"):
+                scan_results = True
+            else:
+                raise Exception("Unexpected event through filter: " + ev)
+        if not scan_results:
+            raise Exception("Scan results event not received through filter")
+    finally:
+        mon.close()
+
 def test_wpas_ctrl_sched_scan_plans(dev, apdev):
     """wpa_supplicant sched_scan_plans parsing"""
     dev[0].request("SET sched_scan_plans foo")
@@ -1944,3 +2006,86 @@ def test_wpas_ctrl_signal_monitor(dev, apdev):
     dev[0].request("REMOVE_NETWORK all")
     dev[1].request("REMOVE_NETWORK all")
     dev[1].wait_disconnected()
+
+def test_wpas_ctrl_stream(dev, apdev):
+    """wpa_supplicant stream control socket"""
+    path = "/var/run/wpa_supplicant/wlan0.stream"
+    if not os.path.exists(path):
+        raise HwsimSkip("Stream control interface not supported")
+
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.settimeout(5)
+    s.connect(path)
+
+    def frame(cmd):
+        return struct.pack('>I', len(cmd)) + cmd
+
+    def recv_msg():
+        data = ''
+        while len(data) < 4:
+            res = s.recv(4 - len(data))
+            if not res:
+                raise Exception("Stream control socket closed")
+            data += res
+        msg_len = struct.unpack('>I', data)[0]
+        data = ''
+        while len(data) < msg_len:
+            res = s.recv(msg_len - len(data))
+            if not res:
+                raise Exception("Stream control socket closed")
+            data += res
+        return data
+
+    def recv_reply():
+        while True:
+            msg = recv_msg()
+            if not msg.startswith('<'):
+                return msg
+
+    def request(cmd):
+        s.sendall(frame(cmd))
+        return recv_reply()
+
+    # Pipelined commands are replied to in order
+    s.sendall(frame("PING") + frame("IFNAME") + frame("STATUS") +
+              frame("UNKNOWN-COMMAND"))
+    if recv_reply() != "PONG\n":
+        raise Exception("Unexpected PING reply")
+    if recv_reply() != "wlan0":
+        raise Exception("Unexpected IFNAME reply")
+    if "wpa_state=" not in recv_reply():
+        raise Exception("Unexpected STATUS reply")
+    if recv_reply() != "UNKNOWN COMMAND\n":
+        raise Exception("Unexpected reply to unknown command")
+
+    if "FAIL" not in request("DETACH"):
+        raise Exception("DETACH accepted without ATTACH")
+    if request("ATTACH") != "OK\n":
+        raise Exception("ATTACH failed")
+
+    params = { "ssid": "stream" }
+    hapd = hostapd.add_ap(apdev[0]['ifname'], params)
+    dev[0].connect("stream", key_mgmt="NONE", scan_freq="2412")
+    while True:
+        msg = recv_msg()
+        if "CTRL-EVENT-CONNECTED" in msg:
+            break
+
+    if request("DETACH") != "OK\n":
+        raise Exception("DETACH failed")
+
+    # Too long command closes the connection
+    s.sendall(struct.pack('>I', 1000000))
+    closed = False
+    try:
+        recv_msg()
+    except Exception, e:
+        if "closed" not in str(e):
+            raise
+        closed = True
+    if not closed:
+        raise Exception("Connection not closed on too long command")
+    s.close()
+
+    if not dev[0].ping():
+        raise Exception("Could not ping wpa_supplicant")
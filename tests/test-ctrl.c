@@ -0,0 +1,343 @@
+/*
+ * Control interface client library - latency benchmark
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This measures the PING round trip through the control interface client
+ * library. "legacy" is the send/select/recv sequence that wpa_ctrl_request()
+ * used before the asynchronous API was added, "blocking" is the current
+ * wpa_ctrl_request(), and "async" keeps requests pipelined on a pooled
+ * connection with wpa_ctrl_request_async().
+ *
+ * Usage: test-ctrl [ctrl_path]
+ *
+ * Without ctrl_path, a minimal responder process is started. With ctrl_path,
+ * the requests are sent to a running wpa_supplicant or hostapd interface.
+ * The responder does not reply to "DROP", which is used to verify that a lost
+ * reply does not get later replies matched to the wrong requests.
+ */
+
+#include "utils/includes.h"
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <signal.h>
+
+#include "utils/common.h"
+#include "common/wpa_ctrl.h"
+
+#define ITERATIONS 20000
+#define WINDOW 32
+
+static int async_sent, async_done, async_fail;
+static struct os_reltime async_start[WINDOW];
+static double async_total_us;
+static int lost_done, lost_fail;
+
+
+static pid_t start_responder(const char *path)
+{
+	struct sockaddr_un addr, from;
+	socklen_t fromlen;
+	char buf[256];
+	pid_t pid;
+	int s, res;
+
+	s = socket(PF_UNIX, SOCK_DGRAM, 0);
+	if (s < 0)
+		return -1;
+	os_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	os_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+	unlink(path);
+	if (bind(s, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		close(s);
+		return -1;
+	}
+
+	pid = fork();
+	if (pid != 0) {
+		close(s);
+		return pid;
+	}
+
+	for (;;) {
+		fromlen = sizeof(from);
+		res = recvfrom(s, buf, sizeof(buf), 0,
+			       (struct sockaddr *) &from, &fromlen);
+		if (res < 0)
+			_exit(1);
+		if (res == 4 && os_memcmp(buf, "PING", 4) == 0)
+			sendto(s, "PONG\n", 5, 0, (struct sockaddr *) &from,
+			       fromlen);
+		else if (res == 4 && os_memcmp(buf, "DROP", 4) == 0)
+			continue;
+		else if (res > 5 && os_memcmp(buf, "ECHO ", 5) == 0)
+			sendto(s, buf + 5, res - 5, 0,
+			       (struct sockaddr *) &from, fromlen);
+		else
+			sendto(s, "UNKNOWN COMMAND\n", 16, 0,
+			       (struct sockaddr *) &from, fromlen);
+	}
+}
+
+
+static int legacy_request(struct wpa_ctrl *ctrl, char *reply,
+			  size_t *reply_len)
+{
+	int s = wpa_ctrl_get_fd(ctrl);
+	struct timeval tv;
+	fd_set rfds;
+	int res;
+
+	if (send(s, "PING", 4, 0) < 0)
+		return -1;
+	for (;;) {
+		tv.tv_sec = 10;
+		tv.tv_usec = 0;
+		FD_ZERO(&rfds);
+		FD_SET(s, &rfds);
+		res = select(s + 1, &rfds, NULL, NULL, &tv);
+		if (res < 0)
+			return res;
+		if (!FD_ISSET(s, &rfds))
+			return -2;
+		res = recv(s, reply, *reply_len, 0);
+		if (res < 0)
+			return res;
+		if (res > 0 && reply[0] == '<')
+			continue;
+		*reply_len = res;
+		return 0;
+	}
+}
+
+
+static int check_reply(const char *reply, size_t len)
+{
+	return len == 5 && os_memcmp(reply, "PONG\n", 5) == 0 ? 0 : -1;
+}
+
+
+static double run_legacy(struct wpa_ctrl *ctrl)
+{
+	struct os_reltime start, end, diff;
+	char reply[100];
+	size_t len;
+	int i;
+
+	os_get_reltime(&start);
+	for (i = 0; i < ITERATIONS; i++) {
+		len = sizeof(reply);
+		if (legacy_request(ctrl, reply, &len) < 0 ||
+		    check_reply(reply, len) < 0)
+			return -1;
+	}
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+
+	return (diff.sec * 1000000.0 + diff.usec) / ITERATIONS;
+}
+
+
+static double run_blocking(struct wpa_ctrl *ctrl)
+{
+	struct os_reltime start, end, diff;
+	char reply[100];
+	size_t len;
+	int i;
+
+	os_get_reltime(&start);
+	for (i = 0; i < ITERATIONS; i++) {
+		len = sizeof(reply);
+		if (wpa_ctrl_request(ctrl, "PING", 4, reply, &len, NULL) < 0 ||
+		    check_reply(reply, len) < 0)
+			return -1;
+	}
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+
+	return (diff.sec * 1000000.0 + diff.usec) / ITERATIONS;
+}
+
+
+static void async_cb(void *ctx, int id, int status, char *reply,
+		     size_t reply_len)
+{
+	struct os_reltime now, diff;
+
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &async_start[id % WINDOW], &diff);
+	async_total_us += diff.sec * 1000000.0 + diff.usec;
+	async_done++;
+	if (status < 0 || check_reply(reply, reply_len) < 0)
+		async_fail++;
+}
+
+
+static int async_send(struct wpa_ctrl *ctrl)
+{
+	struct os_reltime now;
+	int id;
+
+	os_get_reltime(&now);
+	id = wpa_ctrl_request_async(ctrl, "PING", 4, 100, async_cb, NULL);
+	if (id < 0)
+		return -1;
+	async_start[id % WINDOW] = now;
+	async_sent++;
+	return 0;
+}
+
+
+static double run_async(struct wpa_ctrl_pool *pool, const char *path,
+			double *latency)
+{
+	struct os_reltime start, end, diff;
+	struct wpa_ctrl *ctrl;
+	struct timeval tv;
+	fd_set rfds;
+	int s, timeout;
+
+	ctrl = wpa_ctrl_pool_get(pool, path);
+	if (ctrl == NULL)
+		return -1;
+	s = wpa_ctrl_get_fd(ctrl);
+
+	os_get_reltime(&start);
+	while (async_done < ITERATIONS) {
+		while (async_sent < ITERATIONS &&
+		       async_sent - async_done < WINDOW) {
+			if (async_send(ctrl) < 0)
+				return -1;
+		}
+
+		timeout = wpa_ctrl_pool_next_timeout(pool);
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		FD_ZERO(&rfds);
+		FD_SET(s, &rfds);
+		if (select(s + 1, &rfds, NULL, NULL, &tv) < 0)
+			return -1;
+		wpa_ctrl_pool_process(pool);
+		if (async_fail)
+			return -1;
+	}
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+
+	*latency = async_total_us / ITERATIONS;
+	return (diff.sec * 1000000.0 + diff.usec) / ITERATIONS;
+}
+
+
+static void lost_cb(void *ctx, int id, int status, char *reply,
+		    size_t reply_len)
+{
+	char expected[20];
+	int len;
+
+	len = os_snprintf(expected, sizeof(expected), "%d", lost_done++);
+	if (status < 0 || reply_len != (size_t) len ||
+	    os_memcmp(reply, expected, len) != 0)
+		lost_fail++;
+}
+
+
+static int run_lost_reply(const char *path)
+{
+	struct wpa_ctrl *ctrl;
+	char cmd[20], reply[100];
+	size_t len;
+	int i, res, ret = -1;
+
+	ctrl = wpa_ctrl_open(path);
+	if (ctrl == NULL)
+		return -1;
+
+	/* The responder does not reply to DROP, so the request times out */
+	wpa_ctrl_set_timeout(ctrl, 100);
+	len = sizeof(reply);
+	if (wpa_ctrl_request(ctrl, "DROP", 4, reply, &len, NULL) != -2)
+		goto done;
+
+	wpa_ctrl_set_timeout(ctrl, 5000);
+	for (i = 0; i < 3; i++) {
+		res = os_snprintf(cmd, sizeof(cmd), "ECHO %d", i);
+		if (wpa_ctrl_request_async(ctrl, cmd, res, sizeof(reply),
+					   lost_cb, NULL) < 0)
+			goto done;
+	}
+	len = sizeof(reply);
+	if (wpa_ctrl_request(ctrl, "PING", 4, reply, &len, NULL) < 0 ||
+	    check_reply(reply, len) < 0 || lost_done != 3 || lost_fail)
+		goto done;
+	ret = 0;
+
+done:
+	wpa_ctrl_close(ctrl);
+	return ret;
+}
+
+
+int main(int argc, char *argv[])
+{
+	char path[64];
+	const char *ctrl_path;
+	struct wpa_ctrl *ctrl;
+	struct wpa_ctrl_pool *pool;
+	pid_t pid = 0;
+	double legacy, blocking, async, latency = 0;
+	int ret = -1;
+
+	if (argc > 1) {
+		ctrl_path = argv[1];
+	} else {
+		os_snprintf(path, sizeof(path), "/tmp/test-ctrl-%d",
+			    (int) getpid());
+		ctrl_path = path;
+		pid = start_responder(path);
+		if (pid < 0) {
+			printf("Failed to start responder\n");
+			return -1;
+		}
+	}
+
+	ctrl = wpa_ctrl_open(ctrl_path);
+	pool = wpa_ctrl_pool_init(NULL, NULL);
+	if (ctrl == NULL || pool == NULL) {
+		printf("Failed to open %s\n", ctrl_path);
+		goto done;
+	}
+
+	if (pid > 0 && run_lost_reply(ctrl_path) < 0) {
+		printf("Replies matched to wrong requests after a lost reply\n");
+		goto done;
+	}
+
+	legacy = run_legacy(ctrl);
+	blocking = run_blocking(ctrl);
+	async = run_async(pool, ctrl_path, &latency);
+	if (legacy < 0 || blocking < 0 || async < 0) {
+		printf("PING request failed\n");
+		goto done;
+	}
+
+	printf("PING round trip (%d requests):\n", ITERATIONS);
+	printf("legacy send/select/recv: %.2f us/request\n", legacy);
+	printf("wpa_ctrl_request(): %.2f us/request\n", blocking);
+	printf("wpa_ctrl_request_async() (%d outstanding): %.2f us/request, "
+	       "%.2f us latency\n", WINDOW, async, latency);
+	ret = 0;
+
+done:
+	wpa_ctrl_pool_deinit(pool);
+	wpa_ctrl_close(ctrl);
+	if (pid > 0) {
+		kill(pid, SIGTERM);
+		waitpid(pid, NULL, 0);
+		unlink(path);
+	}
+	return ret;
+}
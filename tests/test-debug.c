@@ -0,0 +1,156 @@
+/*
+ * Debug print filtering - benchmark program
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ *
+ * This measures the cost of debug prints that are filtered out by the debug
+ * level, e.g., the MSG_DEBUG prints done for each received frame when running
+ * with the default debug level. The wpa_printf() and wpa_hexdump() macros check
+ * the level before evaluating the arguments while calling the functions
+ * directly (the names in parentheses) evaluates the arguments and enters the
+ * varargs function before the message gets filtered out.
+ *
+ * Before the benchmark, the per-module debug levels are verified for event
+ * messages that are printed through wpa_msg() and for failed updates.
+ */
+
+#include "utils/includes.h"
+#include "utils/common.h"
+
+#define ITERATIONS 10000000
+
+static u8 frame[64];
+
+
+static void frame_macro(const u8 *addr, unsigned int i)
+{
+	wpa_printf(MSG_DEBUG, "Received frame from " MACSTR " seq=%u len=%u",
+		   MAC2STR(addr), i, (unsigned int) sizeof(frame));
+	wpa_hexdump(MSG_MSGDUMP, "frame", frame, sizeof(frame));
+	wpa_printf(MSG_DEBUG, "STA " MACSTR " state=%d", MAC2STR(addr), i & 7);
+}
+
+
+static void frame_function(const u8 *addr, unsigned int i)
+{
+	(wpa_printf)(MSG_DEBUG, "Received frame from " MACSTR " seq=%u len=%u",
+		     MAC2STR(addr), i, (unsigned int) sizeof(frame));
+	(wpa_hexdump)(MSG_MSGDUMP, "frame", frame, sizeof(frame));
+	(wpa_printf)(MSG_DEBUG, "STA " MACSTR " state=%d", MAC2STR(addr),
+		     i & 7);
+}
+
+
+static int check_msg_module_level(void)
+{
+	char path[64], buf[1000];
+	FILE *f;
+	size_t len;
+	int ret = -1;
+
+	os_snprintf(path, sizeof(path), "/tmp/test-debug-%d", (int) getpid());
+	unlink(path);
+	wpa_debug_level = MSG_INFO;
+	if (wpa_debug_set_module_level("TEST", MSG_DEBUG) < 0 ||
+	    wpa_debug_open_file(path) < 0)
+		goto fail;
+	wpa_msg(NULL, MSG_DEBUG, "TEST: enabled %d", 1);
+	wpa_msg(NULL, MSG_DEBUG, "OTHER: filtered %d", 2);
+	wpa_debug_set_module_level("TEST", MSG_ERROR);
+	wpa_msg(NULL, MSG_INFO, "TEST: filtered %d", 3);
+	wpa_msg_global(NULL, MSG_WARNING, "TEST: filtered %d", 4);
+	wpa_msg(NULL, MSG_INFO, "OTHER: enabled %d", 5);
+	wpa_debug_close_file();
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		goto fail;
+	len = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[len] = '\0';
+	if (os_strcmp(buf, "TEST: enabled 1\nOTHER: enabled 5\n") == 0)
+		ret = 0;
+	else
+		printf("Unexpected wpa_msg() debug output:\n%s", buf);
+
+fail:
+	wpa_debug_set_module_level("TEST", -1);
+	unlink(path);
+	return ret;
+}
+
+
+static int check_module_levels_unchanged(void)
+{
+	char buf[100] = "", expected[100];
+	char cmd[500], *pos = cmd;
+	unsigned int i;
+	int ret = -1;
+
+	if (wpa_debug_set_module_levels("A=debug") < 0)
+		return -1;
+	wpa_debug_module_levels(expected, sizeof(expected));
+
+	/* Invalid entry after a valid one */
+	if (wpa_debug_set_module_levels("B=info A=error C=foo") == 0)
+		goto fail;
+	wpa_debug_module_levels(buf, sizeof(buf));
+	if (os_strcmp(buf, expected) != 0)
+		goto fail;
+
+	/* More new modules than fit into the module table */
+	for (i = 0; i < 20; i++)
+		pos += os_snprintf(pos, cmd + sizeof(cmd) - pos, "M%u=info ", i);
+	if (wpa_debug_set_module_levels(cmd) == 0)
+		goto fail;
+	wpa_debug_module_levels(buf, sizeof(buf));
+	if (os_strcmp(buf, expected) != 0)
+		goto fail;
+	ret = 0;
+
+fail:
+	if (ret < 0)
+		printf("Unexpected module levels after failed update: %s\n",
+		       buf);
+	wpa_debug_set_module_levels("A=default");
+	return ret;
+}
+
+
+static double run(void (*func)(const u8 *addr, unsigned int i))
+{
+	struct os_reltime start, end, diff;
+	unsigned int i;
+
+	os_get_reltime(&start);
+	for (i = 0; i < ITERATIONS; i++) {
+		frame[10] = i;
+		func(&frame[10], i);
+	}
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+
+	return (diff.sec * 1000000.0 + diff.usec) * 1000.0 / ITERATIONS;
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (check_msg_module_level() < 0) {
+		printf("Module debug level not applied to wpa_msg()\n");
+		return -1;
+	}
+	if (check_module_levels_unchanged() < 0)
+		return -1;
+
+	wpa_debug_level = MSG_INFO;
+
+	printf("Filtered debug prints per frame (3 prints, %u frames):\n",
+	       ITERATIONS);
+	printf("function call: %.1f ns/frame\n", run(frame_function));
+	printf("level check macro: %.1f ns/frame\n", run(frame_macro));
+
+	return 0;
+}
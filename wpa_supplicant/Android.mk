@@ -83,6 +83,7 @@ endif
 OBJS = config.c
 OBJS += notify.c
 OBJS += bss.c
+OBJS += psk_cache.c
 OBJS += eap_register.c
 OBJS += src/utils/common.c
 OBJS += src/utils/wpa_debug.c
@@ -1089,6 +1090,10 @@ CONFIG_INTERNAL_RC4=y
 endif
 endif
 
+ifdef CONFIG_INTERNAL_CRYPTO_ACCEL
+L_CFLAGS += -DCONFIG_INTERNAL_CRYPTO_ACCEL
+endif
+
 AESOBJS = # none so far (see below)
 ifdef CONFIG_INTERNAL_AES
 AESOBJS += src/crypto/aes-internal.c src/crypto/aes-internal-dec.c
@@ -1284,6 +1289,9 @@ endif
 L_CFLAGS += -DCONFIG_CTRL_IFACE
 ifeq ($(CONFIG_CTRL_IFACE), unix)
 L_CFLAGS += -DCONFIG_CTRL_IFACE_UNIX
+ifdef CONFIG_CTRL_IFACE_STREAM
+L_CFLAGS += -DCONFIG_CTRL_IFACE_STREAM
+endif
 endif
 ifeq ($(CONFIG_CTRL_IFACE), udp)
 L_CFLAGS += -DCONFIG_CTRL_IFACE_UDP
@@ -1409,6 +1417,24 @@ ifdef CONFIG_DEBUG_FILE
 L_CFLAGS += -DCONFIG_DEBUG_FILE
 endif
 
+ifdef CONFIG_TRACE_RING
+L_CFLAGS += -DCONFIG_TRACE_RING
+OBJS += src/utils/trace_ring.c
+endif
+
+ifdef CONFIG_STATUS_PAGE
+L_CFLAGS += -DCONFIG_STATUS_PAGE
+OBJS += src/utils/status_page.c
+endif
+
+ifdef CONFIG_DEBUG_ASYNC
+L_CFLAGS += -DCONFIG_DEBUG_ASYNC
+endif
+
+ifdef CONFIG_DEBUG_MIN_LEVEL
+L_CFLAGS += -DWPA_DEBUG_MIN_LEVEL=$(CONFIG_DEBUG_MIN_LEVEL)
+endif
+
 ifdef CONFIG_DELAYED_MIC_ERROR_REPORT
 L_CFLAGS += -DCONFIG_DELAYED_MIC_ERROR_REPORT
 endif
@@ -213,6 +213,73 @@ static void wpa_bss_update_pending_connect(struct wpa_supplicant *wpa_s,
 }
 
 
+static unsigned int wpa_bss_hash(const u8 *bssid, const u8 *ssid,
+				 size_t ssid_len)
+{
+	unsigned int hash = 0;
+	size_t i;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		hash = hash * 31 + bssid[i];
+	for (i = 0; i < ssid_len; i++)
+		hash = hash * 31 + ssid[i];
+	return (hash ^ (hash >> 8) ^ (hash >> 16)) & (WPA_BSS_HASH_SIZE - 1);
+}
+
+
+#define BSS_HASH(bssid, ssid, len) wpa_bss_hash((bssid), (ssid), (len))
+#define BSSID_HASH(bssid) wpa_bss_hash((bssid), NULL, 0)
+#define BSS_ID_HASH(id) ((id) & (WPA_BSS_HASH_SIZE - 1))
+
+
+static void wpa_bss_hash_add(struct wpa_supplicant *wpa_s,
+			     struct wpa_bss *bss)
+{
+	unsigned int hash;
+
+	hash = BSS_HASH(bss->bssid, bss->ssid, bss->ssid_len);
+	bss->hnext = wpa_s->bss_hash[hash];
+	wpa_s->bss_hash[hash] = bss;
+
+	/* Keep the most recently updated entry first for wpa_bss_get_bssid() */
+	hash = BSSID_HASH(bss->bssid);
+	bss->bnext = wpa_s->bss_bssid_hash[hash];
+	wpa_s->bss_bssid_hash[hash] = bss;
+
+	hash = BSS_ID_HASH(bss->id);
+	bss->inext = wpa_s->bss_id_hash[hash];
+	wpa_s->bss_id_hash[hash] = bss;
+}
+
+
+static void wpa_bss_hash_del(struct wpa_supplicant *wpa_s,
+			     struct wpa_bss *bss)
+{
+	struct wpa_bss **pos;
+
+	pos = &wpa_s->bss_hash[BSS_HASH(bss->bssid, bss->ssid,
+					bss->ssid_len)];
+	while (*pos && *pos != bss)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = bss->hnext;
+
+	pos = &wpa_s->bss_bssid_hash[BSSID_HASH(bss->bssid)];
+	while (*pos && *pos != bss)
+		pos = &(*pos)->bnext;
+	if (*pos)
+		*pos = bss->bnext;
+
+	pos = &wpa_s->bss_id_hash[BSS_ID_HASH(bss->id)];
+	while (*pos && *pos != bss)
+		pos = &(*pos)->inext;
+	if (*pos)
+		*pos = bss->inext;
+
+	bss->hnext = bss->bnext = bss->inext = NULL;
+}
+
+
 static void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 			   const char *reason)
 {
@@ -230,6 +297,7 @@ static void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		}
 	}
 	wpa_bss_update_pending_connect(wpa_s, bss, NULL);
+	wpa_bss_hash_del(wpa_s, bss);
 	dl_list_del(&bss->list);
 	dl_list_del(&bss->list_id);
 	wpa_s->num_bss--;
@@ -238,6 +306,7 @@ static void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 		wpa_ssid_txt(bss->ssid, bss->ssid_len), reason);
 	wpas_notify_bss_removed(wpa_s, bss->bssid, bss->id);
 	wpa_bss_anqp_free(bss->anqp);
+	os_free(bss->sel_info);
 	os_free(bss);
 }
 
@@ -256,7 +325,8 @@ struct wpa_bss * wpa_bss_get(struct wpa_supplicant *wpa_s, const u8 *bssid,
 	struct wpa_bss *bss;
 	if (!wpa_supplicant_filter_bssid_match(wpa_s, bssid))
 		return NULL;
-	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+	for (bss = wpa_s->bss_hash[BSS_HASH(bssid, ssid, ssid_len)]; bss;
+	     bss = bss->hnext) {
 		if (os_memcmp(bss->bssid, bssid, ETH_ALEN) == 0 &&
 		    bss->ssid_len == ssid_len &&
 		    os_memcmp(bss->ssid, ssid, ssid_len) == 0)
@@ -412,75 +482,136 @@ static struct wpa_bss * wpa_bss_add(struct wpa_supplicant *wpa_s,
 
 	dl_list_add_tail(&wpa_s->bss, &bss->list);
 	dl_list_add_tail(&wpa_s->bss_id, &bss->list_id);
+	wpa_bss_hash_add(wpa_s, bss);
 	wpa_s->num_bss++;
 	wpa_dbg(wpa_s, MSG_DEBUG, "BSS: Add new id %u BSSID " MACSTR
 		" SSID '%s' freq %d",
 		bss->id, MAC2STR(bss->bssid), wpa_ssid_txt(ssid, ssid_len),
 		bss->freq);
 	wpas_notify_bss_added(wpa_s, bss->bssid, bss->id);
+	wpas_psk_precompute(wpa_s);
 	return bss;
 }
 
 
-static int are_ies_equal(const struct wpa_bss *old,
-			 const struct wpa_scan_res *new_res, u32 ie)
+/* Elements that have their own change notifications */
+struct wpa_bss_ie_elems {
+	const u8 *wpa;
+	const u8 *rsn;
+	const u8 *rates;
+	const u8 *ext_rates;
+	const u8 *wps; /* first WPS IE */
+};
+
+
+static int wpa_bss_is_wps_ie(const u8 *pos)
 {
-	const u8 *old_ie, *new_ie;
-	struct wpabuf *old_ie_buff = NULL;
-	struct wpabuf *new_ie_buff = NULL;
-	int new_ie_len, old_ie_len, ret, is_multi;
-
-	switch (ie) {
-	case WPA_IE_VENDOR_TYPE:
-		old_ie = wpa_bss_get_vendor_ie(old, ie);
-		new_ie = wpa_scan_get_vendor_ie(new_res, ie);
-		is_multi = 0;
-		break;
-	case WPS_IE_VENDOR_TYPE:
-		old_ie_buff = wpa_bss_get_vendor_ie_multi(old, ie);
-		new_ie_buff = wpa_scan_get_vendor_ie_multi(new_res, ie);
-		is_multi = 1;
-		break;
-	case WLAN_EID_RSN:
-	case WLAN_EID_SUPP_RATES:
-	case WLAN_EID_EXT_SUPP_RATES:
-		old_ie = wpa_bss_get_ie(old, ie);
-		new_ie = wpa_scan_get_ie(new_res, ie);
-		is_multi = 0;
-		break;
-	default:
-		wpa_printf(MSG_DEBUG, "bss: %s: cannot compare IEs", __func__);
-		return 0;
+	return pos[0] == WLAN_EID_VENDOR_SPECIFIC && pos[1] >= 4 &&
+		WPA_GET_BE32(&pos[2]) == WPS_IE_VENDOR_TYPE;
+}
+
+
+/*
+ * Find the elements in a single pass over the IEs. This uses the same rules
+ * as wpa_bss_get_ie() and wpa_bss_get_vendor_ie(), i.e., the first matching
+ * element is used.
+ */
+static void wpa_bss_find_elems(const u8 *pos, size_t len,
+			       struct wpa_bss_ie_elems *elems)
+{
+	const u8 *end = pos + len;
+
+	os_memset(elems, 0, sizeof(*elems));
+	while (end - pos > 1) {
+		if (2 + pos[1] > end - pos)
+			break;
+		switch (pos[0]) {
+		case WLAN_EID_RSN:
+			if (!elems->rsn)
+				elems->rsn = pos;
+			break;
+		case WLAN_EID_SUPP_RATES:
+			if (!elems->rates)
+				elems->rates = pos;
+			break;
+		case WLAN_EID_EXT_SUPP_RATES:
+			if (!elems->ext_rates)
+				elems->ext_rates = pos;
+			break;
+		case WLAN_EID_VENDOR_SPECIFIC:
+			if (pos[1] >= 4 && !elems->wpa &&
+			    WPA_GET_BE32(&pos[2]) == WPA_IE_VENDOR_TYPE)
+				elems->wpa = pos;
+			if (!elems->wps && wpa_bss_is_wps_ie(pos))
+				elems->wps = pos;
+			break;
+		}
+		pos += 2 + pos[1];
 	}
+}
 
-	if (is_multi) {
-		/* in case of multiple IEs stored in buffer */
-		old_ie = old_ie_buff ? wpabuf_head_u8(old_ie_buff) : NULL;
-		new_ie = new_ie_buff ? wpabuf_head_u8(new_ie_buff) : NULL;
-		old_ie_len = old_ie_buff ? wpabuf_len(old_ie_buff) : 0;
-		new_ie_len = new_ie_buff ? wpabuf_len(new_ie_buff) : 0;
-	} else {
-		/* in case of single IE */
-		old_ie_len = old_ie ? old_ie[1] + 2 : 0;
-		new_ie_len = new_ie ? new_ie[1] + 2 : 0;
+
+static int wpa_bss_elem_equal(const u8 *a, const u8 *b)
+{
+	if (!a || !b)
+		return !a && !b;
+	return a[1] == b[1] && os_memcmp(a, b, 2 + a[1]) == 0;
+}
+
+
+static const u8 * wpa_bss_next_wps_ie(const u8 *pos, const u8 *end)
+{
+	while (pos && end - pos > 1) {
+		if (2 + pos[1] > end - pos)
+			break;
+		if (wpa_bss_is_wps_ie(pos))
+			return pos;
+		pos += 2 + pos[1];
 	}
 
-	if (!old_ie || !new_ie)
-		ret = !old_ie && !new_ie;
-	else
-		ret = (old_ie_len == new_ie_len &&
-		       os_memcmp(old_ie, new_ie, old_ie_len) == 0);
+	return NULL;
+}
 
-	wpabuf_free(old_ie_buff);
-	wpabuf_free(new_ie_buff);
 
-	return ret;
+/*
+ * Compare the concatenated payloads of the WPS IEs (as returned by
+ * wpa_bss_get_vendor_ie_multi()) without copying them into buffers.
+ */
+static int wpa_bss_wps_equal(const u8 *a, const u8 *a_end,
+			     const u8 *b, const u8 *b_end)
+{
+	const u8 *a_pos = NULL, *b_pos = NULL;
+	size_t a_len = 0, b_len = 0, len;
+
+	for (;;) {
+		while (a_len == 0 && a) {
+			a_pos = a + 2 + 4;
+			a_len = a[1] - 4;
+			a = wpa_bss_next_wps_ie(a + 2 + a[1], a_end);
+		}
+		while (b_len == 0 && b) {
+			b_pos = b + 2 + 4;
+			b_len = b[1] - 4;
+			b = wpa_bss_next_wps_ie(b + 2 + b[1], b_end);
+		}
+		if (a_len == 0 || b_len == 0)
+			return a_len == 0 && b_len == 0;
+		len = a_len < b_len ? a_len : b_len;
+		if (os_memcmp(a_pos, b_pos, len) != 0)
+			return 0;
+		a_pos += len;
+		a_len -= len;
+		b_pos += len;
+		b_len -= len;
+	}
 }
 
 
 static u32 wpa_bss_compare_res(const struct wpa_bss *old,
 			       const struct wpa_scan_res *new_res)
 {
+	struct wpa_bss_ie_elems old_elems, new_elems;
+	const u8 *old_ies, *new_ies;
 	u32 changes = 0;
 	int caps_diff = old->caps ^ new_res->caps;
 
@@ -496,22 +627,32 @@ static u32 wpa_bss_compare_res(const struct wpa_bss *old,
 	if (caps_diff & IEEE80211_CAP_IBSS)
 		changes |= WPA_BSS_MODE_CHANGED_FLAG;
 
+	old_ies = (const u8 *) (old + 1);
+	new_ies = (const u8 *) (new_res + 1);
 	if (old->ie_len == new_res->ie_len &&
-	    os_memcmp(old + 1, new_res + 1, old->ie_len) == 0)
+	    os_memcmp(old_ies, new_ies, old->ie_len) == 0)
 		return changes;
 	changes |= WPA_BSS_IES_CHANGED_FLAG;
 
-	if (!are_ies_equal(old, new_res, WPA_IE_VENDOR_TYPE))
+	/*
+	 * Locate all the compared elements with one pass over each of the IE
+	 * buffers instead of searching them separately for each element.
+	 */
+	wpa_bss_find_elems(old_ies, old->ie_len, &old_elems);
+	wpa_bss_find_elems(new_ies, new_res->ie_len, &new_elems);
+
+	if (!wpa_bss_elem_equal(old_elems.wpa, new_elems.wpa))
 		changes |= WPA_BSS_WPAIE_CHANGED_FLAG;
 
-	if (!are_ies_equal(old, new_res, WLAN_EID_RSN))
+	if (!wpa_bss_elem_equal(old_elems.rsn, new_elems.rsn))
 		changes |= WPA_BSS_RSNIE_CHANGED_FLAG;
 
-	if (!are_ies_equal(old, new_res, WPS_IE_VENDOR_TYPE))
+	if (!wpa_bss_wps_equal(old_elems.wps, old_ies + old->ie_len,
+			       new_elems.wps, new_ies + new_res->ie_len))
 		changes |= WPA_BSS_WPS_CHANGED_FLAG;
 
-	if (!are_ies_equal(old, new_res, WLAN_EID_SUPP_RATES) ||
-	    !are_ies_equal(old, new_res, WLAN_EID_EXT_SUPP_RATES))
+	if (!wpa_bss_elem_equal(old_elems.rates, new_elems.rates) ||
+	    !wpa_bss_elem_equal(old_elems.ext_rates, new_elems.ext_rates))
 		changes |= WPA_BSS_RATES_CHANGED_FLAG;
 
 	return changes;
@@ -559,6 +700,15 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 	u32 changes;
 
 	changes = wpa_bss_compare_res(bss, res);
+	if (changes & WPA_BSS_IES_CHANGED_FLAG) {
+		/*
+		 * Parse the new IEs again in the next network selection. The
+		 * flag is based on comparing the IE data, so the parsed data
+		 * and offsets stay valid for IEs that are not changed.
+		 */
+		os_free(bss->sel_info);
+		bss->sel_info = NULL;
+	}
 	if (changes & WPA_BSS_FREQ_CHANGED_FLAG)
 		wpa_printf(MSG_DEBUG, "BSS: " MACSTR " changed freq %d --> %d",
 			   MAC2STR(bss->bssid), bss->freq, res->freq);
@@ -567,6 +717,7 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 	wpa_bss_copy_res(bss, res, fetch_time);
 	/* Move the entry to the end of the list */
 	dl_list_del(&bss->list);
+	wpa_bss_hash_del(wpa_s, bss);
 #ifdef CONFIG_P2P
 	if (wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE) &&
 	    !wpa_scan_get_vendor_ie(res, P2P_IE_VENDOR_TYPE)) {
@@ -616,6 +767,7 @@ wpa_bss_update(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 	if (changes & WPA_BSS_IES_CHANGED_FLAG)
 		wpa_bss_set_hessid(bss);
 	dl_list_add_tail(&wpa_s->bss, &bss->list);
+	wpa_bss_hash_add(wpa_s, bss);
 
 	notify_bss_changes(wpa_s, changes, bss);
 
@@ -714,16 +866,15 @@ void wpa_bss_update_scan_res(struct wpa_supplicant *wpa_s,
 	if (bss == NULL)
 		bss = wpa_bss_add(wpa_s, ssid + 2, ssid[1], res, fetch_time);
 	else {
+		/*
+		 * An entry that has already been updated in this round is
+		 * already included in last_scan_res.
+		 */
+		int seen = bss->last_update_idx == wpa_s->bss_update_idx;
+
 		bss = wpa_bss_update(wpa_s, bss, res, fetch_time);
-		if (wpa_s->last_scan_res) {
-			unsigned int i;
-			for (i = 0; i < wpa_s->last_scan_res_used; i++) {
-				if (bss == wpa_s->last_scan_res[i]) {
-					/* Already in the list */
-					return;
-				}
-			}
-		}
+		if (seen)
+			return;
 	}
 
 	if (bss == NULL)
@@ -922,7 +1073,8 @@ struct wpa_bss * wpa_bss_get_bssid(struct wpa_supplicant *wpa_s,
 	struct wpa_bss *bss;
 	if (!wpa_supplicant_filter_bssid_match(wpa_s, bssid))
 		return NULL;
-	dl_list_for_each_reverse(bss, &wpa_s->bss, struct wpa_bss, list) {
+	for (bss = wpa_s->bss_bssid_hash[BSSID_HASH(bssid)]; bss;
+	     bss = bss->bnext) {
 		if (os_memcmp(bss->bssid, bssid, ETH_ALEN) == 0)
 			return bss;
 	}
@@ -947,7 +1099,8 @@ struct wpa_bss * wpa_bss_get_bssid_latest(struct wpa_supplicant *wpa_s,
 	struct wpa_bss *bss, *found = NULL;
 	if (!wpa_supplicant_filter_bssid_match(wpa_s, bssid))
 		return NULL;
-	dl_list_for_each_reverse(bss, &wpa_s->bss, struct wpa_bss, list) {
+	for (bss = wpa_s->bss_bssid_hash[BSSID_HASH(bssid)]; bss;
+	     bss = bss->bnext) {
 		if (os_memcmp(bss->bssid, bssid, ETH_ALEN) != 0)
 			continue;
 		if (found == NULL ||
@@ -990,7 +1143,8 @@ struct wpa_bss * wpa_bss_get_p2p_dev_addr(struct wpa_supplicant *wpa_s,
 struct wpa_bss * wpa_bss_get_id(struct wpa_supplicant *wpa_s, unsigned int id)
 {
 	struct wpa_bss *bss;
-	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
+	for (bss = wpa_s->bss_id_hash[BSS_ID_HASH(id)]; bss;
+	     bss = bss->inext) {
 		if (bss->id == id)
 			return bss;
 	}
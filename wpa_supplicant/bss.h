@@ -10,6 +10,7 @@
 #define BSS_H
 
 struct wpa_scan_res;
+struct wpa_bss_sel_info;
 
 #define WPA_BSS_QUAL_INVALID		BIT(0)
 #define WPA_BSS_NOISE_INVALID		BIT(1)
@@ -63,6 +64,12 @@ struct wpa_bss {
 	struct dl_list list;
 	/** List entry for struct wpa_supplicant::bss_id */
 	struct dl_list list_id;
+	/** Next entry in struct wpa_supplicant::bss_hash chain */
+	struct wpa_bss *hnext;
+	/** Next entry in struct wpa_supplicant::bss_bssid_hash chain */
+	struct wpa_bss *bnext;
+	/** Next entry in struct wpa_supplicant::bss_id_hash chain */
+	struct wpa_bss *inext;
 	/** Unique identifier for this BSS entry */
 	unsigned int id;
 	/** Number of counts without seeing this BSS */
@@ -101,6 +108,11 @@ struct wpa_bss {
 	int snr;
 	/** ANQP data */
 	struct wpa_bss_anqp *anqp;
+	/**
+	 * Parsed IEs for network selection (events.c); cleared whenever the
+	 * IEs change
+	 */
+	struct wpa_bss_sel_info *sel_info;
 	/** Length of the following IE field in octets (from Probe Response) */
 	size_t ie_len;
 	/** Length of the following Beacon IE field in octets */
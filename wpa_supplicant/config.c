@@ -17,6 +17,7 @@
 #include "p2p/p2p.h"
 #include "fst/fst.h"
 #include "config.h"
+#include "psk_cache.h"
 
 
 #if !defined(CONFIG_CTRL_IFACE) && defined(CONFIG_NO_CONFIG_WRITE)
@@ -2285,6 +2286,7 @@ void wpa_config_free(struct wpa_config *config)
 	os_free(config->wowlan_triggers);
 	os_free(config->fst_group_id);
 	os_free(config->sched_scan_plans);
+	os_free(config->status_page);
 
 	os_free(config);
 }
@@ -2685,8 +2687,8 @@ char * wpa_config_get_no_key(struct wpa_ssid *ssid, const char *var)
 void wpa_config_update_psk(struct wpa_ssid *ssid)
 {
 #ifndef CONFIG_NO_PBKDF2
-	pbkdf2_sha1(ssid->passphrase, ssid->ssid, ssid->ssid_len, 4096,
-		    ssid->psk, PMK_LEN);
+	wpa_psk_cache_derive(ssid->passphrase, ssid->ssid, ssid->ssid_len,
+			     ssid->psk);
 	wpa_hexdump_key(MSG_MSGDUMP, "PSK (from passphrase)",
 			ssid->psk, PMK_LEN);
 	ssid->psk_set = 1;
@@ -3544,6 +3546,7 @@ struct wpa_config * wpa_config_alloc_empty(const char *ctrl_interface,
 	config->bss_max_count = DEFAULT_BSS_MAX_COUNT;
 	config->bss_expiration_age = DEFAULT_BSS_EXPIRATION_AGE;
 	config->bss_expiration_scan_count = DEFAULT_BSS_EXPIRATION_SCAN_COUNT;
+	config->psk_cache_size = PSK_CACHE_DEFAULT_SIZE;
 	config->max_num_sta = DEFAULT_MAX_NUM_STA;
 	config->access_network_type = DEFAULT_ACCESS_NETWORK_TYPE;
 	config->scan_cur_freq = DEFAULT_SCAN_CUR_FREQ;
@@ -4216,7 +4219,13 @@ static const struct global_parse_data global_fields[] = {
 	{ INT(bss_max_count), 0 },
 	{ INT(bss_expiration_age), 0 },
 	{ INT(bss_expiration_scan_count), 0 },
+	{ INT_RANGE(psk_cache_size, 0, PSK_CACHE_MAX_SIZE),
+	  CFG_CHANGED_PSK_CACHE },
+	{ INT_RANGE(psk_cache_precompute, 0, 1), 0 },
+	{ INT_RANGE(config_cache, 0, 1), 0 },
 	{ INT_RANGE(filter_ssids, 0, 1), 0 },
+	{ INT_RANGE(dbus_bss_bulk_signals, 0, 1), 0 },
+	{ INT_RANGE(dbus_bss_on_demand, 0, 1), 0 },
 	{ INT_RANGE(filter_rssi, -100, 0), 0 },
 	{ INT(max_num_sta), 0 },
 	{ INT_RANGE(disassoc_low_ack, 0, 1), 0 },
@@ -4239,6 +4248,7 @@ static const struct global_parse_data global_fields[] = {
 	{ INT(okc), 0 },
 	{ INT(pmf), 0 },
 	{ FUNC(sae_groups), 0 },
+	{ INT_RANGE(sae_pwe_cache_size, 0, 1024), CFG_CHANGED_SAE_PWE_CACHE },
 	{ INT(dtim_period), 0 },
 	{ INT(beacon_int), 0 },
 	{ FUNC(ap_vendor_elements), 0 },
@@ -4264,6 +4274,7 @@ static const struct global_parse_data global_fields[] = {
 #endif /* CONFIG_FST */
 	{ INT_RANGE(wpa_rsc_relaxation, 0, 1), 0 },
 	{ STR(sched_scan_plans), CFG_CHANGED_SCHED_SCAN_PLANS },
+	{ STR(status_page), CFG_CHANGED_STATUS_PAGE },
 };
 
 #undef FUNC
@@ -333,6 +333,9 @@ struct wpa_cred {
 #define CFG_CHANGED_NFC_PASSWORD_TOKEN BIT(15)
 #define CFG_CHANGED_P2P_PASSPHRASE_LEN BIT(16)
 #define CFG_CHANGED_SCHED_SCAN_PLANS BIT(17)
+#define CFG_CHANGED_SAE_PWE_CACHE BIT(18)
+#define CFG_CHANGED_PSK_CACHE BIT(19)
+#define CFG_CHANGED_STATUS_PAGE BIT(20)
 
 /**
  * struct wpa_config - wpa_supplicant configuration data
@@ -810,6 +813,37 @@ struct wpa_config {
 	 */
 	unsigned int bss_expiration_scan_count;
 
+	/**
+	 * psk_cache_size - Number of PSKs derived from passphrases to cache
+	 *
+	 * Caching the PSKs allows connection attempts and configuration
+	 * reloads to skip the PBKDF2 derivation for passphrase and SSID pairs
+	 * that have been used before. The cache is shared by all interfaces
+	 * and the largest configured value is used. 0 disables the cache.
+	 */
+	int psk_cache_size;
+
+	/**
+	 * psk_cache_precompute - Derive PSKs for BSSID-only networks early
+	 *
+	 * When enabled, the PSK for a network that is configured with a BSSID
+	 * and a passphrase, but without an SSID, is derived in the background
+	 * as soon as a BSS with that BSSID shows up in scan results so that
+	 * the connection attempt finds it in the PSK cache.
+	 */
+	int psk_cache_precompute;
+
+	/**
+	 * config_cache - Store derived PSKs in a configuration cache file
+	 *
+	 * When enabled, the PSKs derived from network passphrases while
+	 * reading a configuration file are stored in <file>.cache and reused
+	 * on the following reads for networks with an unchanged passphrase and
+	 * SSID. This avoids running PBKDF2 for every passphrase network on
+	 * startup and on configuration reload.
+	 */
+	int config_cache;
+
 	/**
 	 * filter_ssids - SSID-based scan result filtering
 	 *
@@ -818,6 +852,25 @@ struct wpa_config {
 	 */
 	int filter_ssids;
 
+	/**
+	 * dbus_bss_bulk_signals - Report BSS table changes in bulk on D-Bus
+	 *
+	 *   0 = send BSSAdded/BSSRemoved signal for each BSS
+	 *   1 = send BSSsAdded/BSSsRemoved signals listing all the BSSes that
+	 *	were added or removed during the D-Bus signal coalescing window
+	 */
+	int dbus_bss_bulk_signals;
+
+	/**
+	 * dbus_bss_on_demand - Register D-Bus BSS objects on demand
+	 *
+	 *   0 = register a D-Bus object for each BSS when it is added
+	 *   1 = register the D-Bus object of a BSS only when a client accesses
+	 *	it; BSSAdded/BSSsAdded signals include only a compact set of
+	 *	properties (BSSID, SSID, Frequency, Signal)
+	 */
+	int dbus_bss_on_demand;
+
 	/**
 	 * filter_rssi - RSSI-based scan result filtering
 	 *
@@ -1052,6 +1105,16 @@ struct wpa_config {
 	 */
 	int *sae_groups;
 
+	/**
+	 * sae_pwe_cache_size - Number of derived SAE PWE values to cache
+	 *
+	 * Caching the password element allows repeated SAE attempts with the
+	 * same peer, password, and group to skip the PWE derivation. The
+	 * cache is shared by all interfaces and the largest configured value
+	 * is used. 0 (default) disables the cache.
+	 */
+	int sae_pwe_cache_size;
+
 	/**
 	 * dtim_period - Default DTIM period in Beacon intervals
 	 *
@@ -1275,6 +1338,17 @@ struct wpa_config {
 	 * format: <interval:iterations> <interval2:iterations2> ... <interval>
 	 */
 	 char *sched_scan_plans;
+
+	/**
+	 * status_page - Path of the memory-mapped status page file
+	 *
+	 * If set, the connection status (state, BSSID, SSID, frequency,
+	 * signal, and key counters) is published in this file in the format
+	 * defined by struct status_page_data in src/utils/status_page.h.
+	 * Monitoring tools can map the file read-only and poll it without
+	 * control interface requests. This requires CONFIG_STATUS_PAGE=y.
+	 */
+	char *status_page;
 };
 
 
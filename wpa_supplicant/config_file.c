@@ -14,14 +14,21 @@
 #ifdef ANDROID
 #include <sys/stat.h>
 #endif /* ANDROID */
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif /* _WIN32 */
 
 #include "common.h"
 #include "config.h"
 #include "base64.h"
 #include "uuid.h"
+#include "crypto/sha1.h"
+#include "common/wpa_common.h"
 #include "p2p/p2p.h"
 #include "eap_peer/eap_methods.h"
 #include "eap_peer/eap.h"
+#include "psk_cache.h"
 
 
 static int newline_terminated(const char *buf, size_t buflen)
@@ -132,8 +139,10 @@ static int wpa_config_validate_network(struct wpa_ssid *ssid, int line)
 			wpa_printf(MSG_ERROR, "Line %d: both PSK and "
 				   "passphrase configured.", line);
 			errors++;
+			/* The passphrase takes precedence */
+			ssid->psk_set = 0;
 		}
-		wpa_config_update_psk(ssid);
+		/* PSK is derived in wpa_config_derive_psks() */
 	}
 
 	if ((ssid->group_cipher & WPA_CIPHER_CCMP) &&
@@ -359,12 +368,253 @@ static int wpa_config_process_blob(struct wpa_config *config, FILE *f,
 #endif /* CONFIG_NO_CONFIG_BLOBS */
 
 
+#ifndef CONFIG_NO_PBKDF2
+
+/*
+ * Configuration cache
+ *
+ * Deriving the PSK for a network that is configured with a passphrase takes
+ * 4096 iterations of PBKDF2-SHA1 and dominates the time needed to read a
+ * configuration file with a large number of networks. With config_cache=1,
+ * the derived PSKs are stored in a binary file next to the configuration file
+ * (<name>.cache) and are used on the following reads. Each entry is keyed by
+ * an HMAC of the SSID using the passphrase as the key, so entries are used
+ * only for an unchanged passphrase and SSID and the cache does not need to be
+ * invalidated when other parts of the configuration file change.
+ */
+
+#define WPA_CONFIG_CACHE_MAGIC "WPACACHE"
+#define WPA_CONFIG_CACHE_MAGIC_LEN 8
+
+struct wpa_config_cache_entry {
+	u8 key[SHA1_MAC_LEN];
+	u8 psk[PMK_LEN];
+};
+
+
+static int wpa_config_cache_cmp(const void *a, const void *b)
+{
+	const struct wpa_config_cache_entry *x = a, *y = b;
+
+	return os_memcmp(x->key, y->key, SHA1_MAC_LEN);
+}
+
+
+static char * wpa_config_cache_name(const char *name)
+{
+	size_t len = os_strlen(name) + 7;
+	char *fname;
+
+	fname = os_malloc(len);
+	if (fname)
+		os_snprintf(fname, len, "%s.cache", name);
+	return fname;
+}
+
+
+static struct wpa_config_cache_entry *
+wpa_config_cache_load(const char *fname, size_t *num)
+{
+	struct wpa_config_cache_entry *entries;
+	char *data;
+	size_t len;
+
+	*num = 0;
+	data = os_readfile(fname, &len);
+	if (data == NULL)
+		return NULL;
+	if (len < WPA_CONFIG_CACHE_MAGIC_LEN ||
+	    os_memcmp(data, WPA_CONFIG_CACHE_MAGIC,
+		      WPA_CONFIG_CACHE_MAGIC_LEN) != 0 ||
+	    (len - WPA_CONFIG_CACHE_MAGIC_LEN) % sizeof(*entries)) {
+		wpa_printf(MSG_INFO, "Ignore invalid configuration cache '%s'",
+			   fname);
+		bin_clear_free(data, len);
+		return NULL;
+	}
+
+	len -= WPA_CONFIG_CACHE_MAGIC_LEN;
+	entries = os_malloc(len + 1);
+	if (entries) {
+		os_memcpy(entries, data + WPA_CONFIG_CACHE_MAGIC_LEN, len);
+		*num = len / sizeof(*entries);
+		qsort(entries, *num, sizeof(*entries), wpa_config_cache_cmp);
+	}
+	bin_clear_free(data, len + WPA_CONFIG_CACHE_MAGIC_LEN);
+
+	return entries;
+}
+
+
+static int wpa_config_cache_save(const char *fname,
+				 const struct wpa_config_cache_entry *entries,
+				 size_t num)
+{
+	size_t len = os_strlen(fname) + 5;
+	char *tmp_name;
+	FILE *f;
+	int ret = 0;
+
+	tmp_name = os_malloc(len);
+	if (tmp_name == NULL)
+		return -1;
+	os_snprintf(tmp_name, len, "%s.tmp", fname);
+
+	f = fopen(tmp_name, "wb");
+	if (f == NULL) {
+		wpa_printf(MSG_DEBUG, "Failed to open '%s' for writing",
+			   tmp_name);
+		os_free(tmp_name);
+		return -1;
+	}
+#ifndef _WIN32
+	/* The cache contains keys; restrict access to the owner */
+	if (fchmod(fileno(f), S_IRUSR | S_IWUSR) != 0)
+		ret = -1;
+#endif /* _WIN32 */
+	if (fwrite(WPA_CONFIG_CACHE_MAGIC, WPA_CONFIG_CACHE_MAGIC_LEN, 1,
+		   f) != 1 ||
+	    (num && fwrite(entries, sizeof(*entries), num, f) != num) ||
+	    os_fdatasync(f) != 0)
+		ret = -1;
+	if (fclose(f) != 0)
+		ret = -1;
+
+	if (ret || rename(tmp_name, fname) != 0) {
+		remove(tmp_name);
+		ret = -1;
+	}
+	os_free(tmp_name);
+
+	wpa_printf(MSG_DEBUG, "Configuration cache '%s' with %u entries written %ssuccessfully",
+		   fname, (unsigned int) num, ret ? "un" : "");
+	return ret;
+}
+
+
+static int wpa_config_psk_needed(struct wpa_ssid *ssid)
+{
+	return ssid->passphrase && !ssid->psk_set;
+}
+
+
+/*
+ * Derive the PSKs for the networks starting from first from the configuration
+ * cache, the process-wide PSK cache, or with PBKDF2. PSKs that need PBKDF2 are
+ * derived with a single pbkdf2_sha1_multi() call.
+ */
+static int wpa_config_derive_psks(struct wpa_config *config,
+				  struct wpa_ssid *first, const char *name)
+{
+	struct wpa_config_cache_entry *cache = NULL, *entries = NULL, *found;
+	struct wpa_ssid *ssid, **nets = NULL;
+	const char **passphrase = NULL;
+	const u8 **ssids = NULL;
+	size_t *ssid_lens = NULL;
+	u8 **bufs = NULL;
+	size_t i, num = 0, num_cache = 0, num_pending = 0, hits = 0;
+	char *cache_name = NULL;
+	int ret = -1;
+
+	for (ssid = first; ssid; ssid = ssid->next) {
+		if (wpa_config_psk_needed(ssid))
+			num++;
+	}
+	if (num == 0)
+		return 0;
+
+	if (config->config_cache) {
+		cache_name = wpa_config_cache_name(name);
+		if (cache_name)
+			cache = wpa_config_cache_load(cache_name, &num_cache);
+	}
+
+	entries = os_calloc(num, sizeof(*entries));
+	nets = os_calloc(num, sizeof(*nets));
+	passphrase = os_calloc(num, sizeof(*passphrase));
+	ssids = os_calloc(num, sizeof(*ssids));
+	ssid_lens = os_calloc(num, sizeof(*ssid_lens));
+	bufs = os_calloc(num, sizeof(*bufs));
+	if (!entries || !nets || !passphrase || !ssids || !ssid_lens || !bufs)
+		goto out;
+
+	for (ssid = first, i = 0; ssid; ssid = ssid->next) {
+		if (!wpa_config_psk_needed(ssid))
+			continue;
+		nets[i] = ssid;
+		if (wpa_psk_cache_key(ssid->passphrase, ssid->ssid,
+				      ssid->ssid_len, entries[i].key) < 0)
+			goto out;
+
+		found = cache ? bsearch(&entries[i], cache, num_cache,
+					sizeof(*cache), wpa_config_cache_cmp) :
+			NULL;
+		if (found) {
+			os_memcpy(ssid->psk, found->psk, PMK_LEN);
+			ssid->psk_set = 1;
+			hits++;
+		} else if (wpa_psk_cache_has(ssid->passphrase, ssid->ssid,
+					     ssid->ssid_len)) {
+			wpa_config_update_psk(ssid);
+		} else {
+			passphrase[num_pending] = ssid->passphrase;
+			ssids[num_pending] = ssid->ssid;
+			ssid_lens[num_pending] = ssid->ssid_len;
+			bufs[num_pending] = ssid->psk;
+			num_pending++;
+		}
+		i++;
+	}
+
+	wpa_printf(MSG_DEBUG,
+		   "Deriving PSKs for %u networks (%u from configuration cache, %u with PBKDF2)",
+		   (unsigned int) num, (unsigned int) hits,
+		   (unsigned int) num_pending);
+	if (num_pending &&
+	    pbkdf2_sha1_multi(num_pending, passphrase, ssids, ssid_lens, 4096,
+			      bufs, PMK_LEN) < 0)
+		goto out;
+
+	for (i = 0; i < num; i++) {
+		ssid = nets[i];
+		if (!ssid->psk_set) {
+			wpa_hexdump_key(MSG_MSGDUMP, "PSK (from passphrase)",
+					ssid->psk, PMK_LEN);
+			ssid->psk_set = 1;
+			wpa_psk_cache_store(ssid->passphrase, ssid->ssid,
+					    ssid->ssid_len, ssid->psk);
+		}
+		os_memcpy(entries[i].psk, ssid->psk, PMK_LEN);
+	}
+
+	/* Rewrite the cache if it had missing or unused entries */
+	if (cache_name && (hits != num || num_cache != num))
+		wpa_config_cache_save(cache_name, entries, num);
+
+	ret = 0;
+out:
+	if (cache)
+		bin_clear_free(cache, num_cache * sizeof(*cache));
+	if (entries)
+		bin_clear_free(entries, num * sizeof(*entries));
+	os_free(cache_name);
+	os_free(nets);
+	os_free(passphrase);
+	os_free(ssids);
+	os_free(ssid_lens);
+	os_free(bufs);
+	return ret;
+}
+
+#endif /* CONFIG_NO_PBKDF2 */
+
+
 struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp)
 {
 	FILE *f;
 	char buf[512], *pos;
 	int errors = 0, line = 0;
-	struct wpa_ssid *ssid, *tail, *head;
+	struct wpa_ssid *ssid, *tail, *head, *prev_tail;
 	struct wpa_cred *cred, *cred_tail, *cred_head;
 	struct wpa_config *config;
 	int id = 0;
@@ -384,6 +634,7 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp)
 	tail = head = config->ssid;
 	while (tail && tail->next)
 		tail = tail->next;
+	prev_tail = tail;
 	cred_tail = cred_head = config->cred;
 	while (cred_tail && cred_tail->next)
 		cred_tail = cred_tail->next;
@@ -454,6 +705,14 @@ struct wpa_config * wpa_config_read(const char *name, struct wpa_config *cfgp)
 	fclose(f);
 
 	config->ssid = head;
+#ifndef CONFIG_NO_PBKDF2
+	if (wpa_config_derive_psks(config,
+				   prev_tail ? prev_tail->next : head,
+				   name) < 0) {
+		wpa_printf(MSG_ERROR, "Failed to derive PSKs for networks");
+		errors++;
+	}
+#endif /* CONFIG_NO_PBKDF2 */
 	wpa_config_debug_dump_networks(config);
 	config->cred = cred_head;
 
@@ -1154,8 +1413,21 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 	    DEFAULT_BSS_EXPIRATION_SCAN_COUNT)
 		fprintf(f, "bss_expiration_scan_count=%u\n",
 			config->bss_expiration_scan_count);
+	if (config->psk_cache_size != PSK_CACHE_DEFAULT_SIZE)
+		fprintf(f, "psk_cache_size=%d\n", config->psk_cache_size);
+	if (config->psk_cache_precompute)
+		fprintf(f, "psk_cache_precompute=%d\n",
+			config->psk_cache_precompute);
+	if (config->config_cache)
+		fprintf(f, "config_cache=%d\n", config->config_cache);
 	if (config->filter_ssids)
 		fprintf(f, "filter_ssids=%d\n", config->filter_ssids);
+	if (config->dbus_bss_bulk_signals)
+		fprintf(f, "dbus_bss_bulk_signals=%d\n",
+			config->dbus_bss_bulk_signals);
+	if (config->dbus_bss_on_demand)
+		fprintf(f, "dbus_bss_on_demand=%d\n",
+			config->dbus_bss_on_demand);
 	if (config->max_num_sta != DEFAULT_MAX_NUM_STA)
 		fprintf(f, "max_num_sta=%u\n", config->max_num_sta);
 	if (config->disassoc_low_ack)
@@ -1213,6 +1485,9 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		}
 		fprintf(f, "\n");
 	}
+	if (config->sae_pwe_cache_size)
+		fprintf(f, "sae_pwe_cache_size=%d\n",
+			config->sae_pwe_cache_size);
 
 	if (config->ap_vendor_elements) {
 		int i, len = wpabuf_len(config->ap_vendor_elements);
@@ -1310,38 +1585,24 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 
 	if (config->sched_scan_plans)
 		fprintf(f, "sched_scan_plans=%s\n", config->sched_scan_plans);
+
+	if (config->status_page)
+		fprintf(f, "status_page=%s\n", config->status_page);
 }
 
 #endif /* CONFIG_NO_CONFIG_WRITE */
 
 
-int wpa_config_write(const char *name, struct wpa_config *config)
-{
 #ifndef CONFIG_NO_CONFIG_WRITE
-	FILE *f;
+
+static int wpa_config_write_all(FILE *f, struct wpa_config *config)
+{
 	struct wpa_ssid *ssid;
 	struct wpa_cred *cred;
 #ifndef CONFIG_NO_CONFIG_BLOBS
 	struct wpa_config_blob *blob;
 #endif /* CONFIG_NO_CONFIG_BLOBS */
 	int ret = 0;
-	const char *orig_name = name;
-	int tmp_len = os_strlen(name) + 5; /* allow space for .tmp suffix */
-	char *tmp_name = os_malloc(tmp_len);
-
-	if (tmp_name) {
-		os_snprintf(tmp_name, tmp_len, "%s.tmp", name);
-		name = tmp_name;
-	}
-
-	wpa_printf(MSG_DEBUG, "Writing configuration file '%s'", name);
-
-	f = fopen(name, "w");
-	if (f == NULL) {
-		wpa_printf(MSG_DEBUG, "Failed to open '%s' for writing", name);
-		os_free(tmp_name);
-		return -1;
-	}
 
 	wpa_config_write_global(f, config);
 
@@ -1372,13 +1633,162 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 	}
 #endif /* CONFIG_NO_CONFIG_BLOBS */
 
-	/*
-	  *  sync to disk
-	  *  fflush & fsync  ==>Yajun
-	  */
-	os_fdatasync(f);
+	return ret;
+}
+
+
+/*
+ * Serialize the configuration into an allocated buffer so that it can be
+ * compared against the current file contents before anything is written.
+ */
+static char * wpa_config_serialize(struct wpa_config *config, size_t *len)
+{
+	FILE *f;
+	char *data = NULL, *buf;
+	size_t data_len = 0;
+	int ret;
+
+#ifndef _WIN32
+	f = open_memstream(&data, &data_len);
+#else /* _WIN32 */
+	f = tmpfile();
+#endif /* _WIN32 */
+	if (f == NULL) {
+		wpa_printf(MSG_DEBUG,
+			   "Failed to open a buffer for configuration data");
+		return NULL;
+	}
+
+	ret = wpa_config_write_all(f, config);
+
+#ifdef _WIN32
+	if (!ret) {
+		long pos;
+
+		pos = ftell(f);
+		data = pos < 0 ? NULL : malloc(pos > 0 ? pos : 1);
+		data_len = pos < 0 ? 0 : pos;
+		if (data == NULL || fseek(f, 0, SEEK_SET) != 0 ||
+		    fread(data, 1, data_len, f) != data_len)
+			ret = -1;
+	}
+#endif /* _WIN32 */
+
+	if (fclose(f) != 0)
+		ret = -1;
+
+	buf = ret ? NULL : os_malloc(data_len + 1);
+	if (buf) {
+		os_memcpy(buf, data, data_len);
+		buf[data_len] = '\0';
+		*len = data_len;
+	}
+
+	if (data) {
+		/* The configuration includes keys and passwords */
+		os_memset(data, 0, data_len);
+		free(data);
+	}
+
+	return buf;
+}
+
+
+static int wpa_config_file_unchanged(const char *name, const char *buf,
+				     size_t len)
+{
+	char *data;
+	size_t data_len;
+	int res;
+
+	data = os_readfile(name, &data_len);
+	if (data == NULL)
+		return 0;
+	res = data_len == len && os_memcmp(data, buf, len) == 0;
+	bin_clear_free(data, data_len);
+	return res;
+}
 
-	fclose(f);
+
+static void wpa_config_sync_dir(const char *name)
+{
+#ifndef _WIN32
+	char *dir, *pos;
+	int fd;
+
+	/* Make the rename of the temporary file persistent */
+	dir = os_strdup(name);
+	if (dir == NULL)
+		return;
+	pos = os_strrchr(dir, '/');
+	if (pos == NULL)
+		os_strlcpy(dir, ".", os_strlen(dir) + 1);
+	else if (pos == dir)
+		pos[1] = '\0';
+	else
+		*pos = '\0';
+
+	fd = open(dir, O_RDONLY);
+	if (fd >= 0) {
+		if (fsync(fd) < 0)
+			wpa_printf(MSG_DEBUG, "fsync(%s) failed: %s",
+				   dir, strerror(errno));
+		close(fd);
+	}
+	os_free(dir);
+#endif /* _WIN32 */
+}
+
+#endif /* CONFIG_NO_CONFIG_WRITE */
+
+
+int wpa_config_write(const char *name, struct wpa_config *config)
+{
+#ifndef CONFIG_NO_CONFIG_WRITE
+	FILE *f;
+	char *buf;
+	size_t len;
+	int ret = 0;
+	const char *orig_name = name;
+	int tmp_len = os_strlen(name) + 5; /* allow space for .tmp suffix */
+	char *tmp_name;
+
+	buf = wpa_config_serialize(config, &len);
+	if (buf == NULL) {
+		wpa_printf(MSG_DEBUG, "Failed to generate configuration data");
+		return -1;
+	}
+
+	if (wpa_config_file_unchanged(name, buf, len)) {
+		wpa_printf(MSG_DEBUG,
+			   "Configuration file '%s' not changed - skip write",
+			   name);
+		bin_clear_free(buf, len);
+		return 0;
+	}
+
+	tmp_name = os_malloc(tmp_len);
+	if (tmp_name) {
+		os_snprintf(tmp_name, tmp_len, "%s.tmp", name);
+		name = tmp_name;
+	}
+
+	wpa_printf(MSG_DEBUG, "Writing configuration file '%s'", name);
+
+	f = fopen(name, "w");
+	if (f == NULL) {
+		wpa_printf(MSG_DEBUG, "Failed to open '%s' for writing", name);
+		os_free(tmp_name);
+		bin_clear_free(buf, len);
+		return -1;
+	}
+
+	if (fwrite(buf, 1, len, f) != len || os_fdatasync(f) != 0)
+		ret = -1;
+	bin_clear_free(buf, len);
+
+	if (fclose(f) != 0)
+		ret = -1;
 
 	if (tmp_name) {
 		int chmod_ret = 0;
@@ -1387,8 +1797,12 @@ int wpa_config_write(const char *name, struct wpa_config *config)
 		chmod_ret = chmod(tmp_name,
 				  S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
 #endif /* ANDROID */
-		if (chmod_ret != 0 || rename(tmp_name, orig_name) != 0)
+		if (ret || chmod_ret != 0 || rename(tmp_name, orig_name) != 0) {
+			remove(tmp_name);
 			ret = -1;
+		} else {
+			wpa_config_sync_dir(orig_name);
+		}
 
 		os_free(tmp_name);
 	}
@@ -15,6 +15,7 @@
 #include "utils/common.h"
 #include "utils/eloop.h"
 #include "utils/uuid.h"
+#include "utils/trace_ring.h"
 #include "common/version.h"
 #include "common/ieee802_11_defs.h"
 #include "common/ieee802_11_common.h"
@@ -2143,9 +2144,13 @@ static int wpa_supplicant_ctrl_iface_log_level(struct wpa_supplicant *wpa_s,
 					       size_t buflen)
 {
 	char *pos, *end, *stamp;
+	char modules[600];
 	int ret;
 
-	/* cmd: "LOG_LEVEL [<level>]" */
+	/*
+	 * cmd: "LOG_LEVEL [<level>]" or
+	 * "LOG_LEVEL <module>=<level|default> [<module>=<level|default>...]"
+	 */
 	if (*cmd == '\0') {
 		pos = buf;
 		end = buf + buflen;
@@ -2154,14 +2159,29 @@ static int wpa_supplicant_ctrl_iface_log_level(struct wpa_supplicant *wpa_s,
 				  debug_level_str(wpa_debug_level),
 				  wpa_debug_timestamp);
 		if (os_snprintf_error(end - pos, ret))
-			ret = 0;
+			return 0;
+		pos += ret;
 
-		return ret;
+		if (wpa_debug_module_levels(modules, sizeof(modules)) > 0) {
+			ret = os_snprintf(pos, end - pos,
+					  "Module levels: %s\n", modules);
+			if (!os_snprintf_error(end - pos, ret))
+				pos += ret;
+		}
+
+		return pos - buf;
 	}
 
 	while (*cmd == ' ')
 		cmd++;
 
+	if (os_strchr(cmd, '=')) {
+		if (wpa_debug_set_module_levels(cmd) < 0)
+			return -1;
+		os_memcpy(buf, "OK\n", 3);
+		return 3;
+	}
+
 	stamp = os_strchr(cmd, ' ');
 	if (stamp) {
 		*stamp++ = '\0';
@@ -6879,6 +6899,7 @@ static int wpa_supplicant_signal_poll(struct wpa_supplicant *wpa_s, char *buf,
 	ret = wpa_drv_signal_poll(wpa_s, &si);
 	if (ret)
 		return -1;
+	wpas_notify_signal_change(wpa_s, &si);
 
 	pos = buf;
 	end = buf + buflen;
@@ -8452,9 +8473,16 @@ static int wpas_ctrl_cmd_debug_level(const char *cmd)
 
 char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 					 char *buf, size_t *resp_len)
+{
+	return wpa_supplicant_ctrl_iface_process2(wpa_s, buf, resp_len, 4096);
+}
+
+
+char * wpa_supplicant_ctrl_iface_process2(struct wpa_supplicant *wpa_s,
+					  char *buf, size_t *resp_len,
+					  int reply_size)
 {
 	char *reply;
-	const int reply_size = 4096;
 	int reply_len;
 
 	if (os_strncmp(buf, WPA_CTRL_RSP, os_strlen(WPA_CTRL_RSP)) == 0 ||
@@ -8874,6 +8902,9 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strncmp(buf, "LOG_LEVEL", 9) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_log_level(
 			wpa_s, buf + 9, reply, reply_size);
+	} else if (os_strcmp(buf, "TRACE_DUMP") == 0 ||
+		   os_strncmp(buf, "TRACE_DUMP ", 11) == 0) {
+		reply_len = trace_ring_dump(buf + 10, reply, reply_size);
 	} else if (os_strncmp(buf, "LIST_NETWORKS ", 14) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_list_networks(
 			wpa_s, buf + 14, reply, reply_size);
@@ -31,6 +31,21 @@
 char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 					 char *buf, size_t *resp_len);
 
+/**
+ * wpa_supplicant_ctrl_iface_process2 - Process ctrl_iface command
+ * @wpa_s: Pointer to wpa_supplicant data
+ * @buf: Received command buffer (nul terminated string)
+ * @resp_len: Variable to be set to the response length
+ * @reply_size: Maximum length of the response
+ * Returns: Response (*resp_len bytes) or %NULL on failure
+ *
+ * This is like wpa_supplicant_ctrl_iface_process(), but allows backends that
+ * are not limited by the datagram size to use a larger response buffer.
+ */
+char * wpa_supplicant_ctrl_iface_process2(struct wpa_supplicant *wpa_s,
+					  char *buf, size_t *resp_len,
+					  int reply_size);
+
 /**
  * wpa_supplicant_global_ctrl_iface_process - Process global ctrl_iface command
  * @global: Pointer to global data from wpa_supplicant_init()
@@ -27,16 +27,34 @@
 #include "eapol_supp/eapol_supp_sm.h"
 #include "config.h"
 #include "wpa_supplicant_i.h"
+#include "common/wpa_ctrl.h"
 #include "ctrl_iface.h"
 
 /* Per-interface ctrl_iface */
 
+/* Maximum number of event messages buffered for a single monitor */
+#define CTRL_IFACE_MONITOR_MAX_PENDING 1000
+/* Maximum number of buffered messages sent to a monitor in one go */
+#define CTRL_IFACE_MONITOR_DRAIN_BURST 16
+/* Retry interval for monitors that are not receiving their messages */
+#define CTRL_IFACE_MONITOR_RETRY_USEC 20000
+/* Number of retries without progress before the socket is reopened */
+#define CTRL_IFACE_MONITOR_STALL_RETRIES 50
+/* Number of sends a monitor can block in a row before it is detached */
+#define CTRL_IFACE_MONITOR_MAX_STALLS 150
+
 /**
  * struct wpa_ctrl_dst - Internal data structure of control interface monitors
  *
  * This structure is used to store information about registered control
  * interface monitors into struct wpa_supplicant. This data is private to
  * ctrl_iface_unix.c and should not be touched directly from other files.
+ *
+ * Event messages that the monitor cannot receive immediately are buffered in
+ * pending (up to CTRL_IFACE_MONITOR_MAX_PENDING messages, dropping the oldest
+ * ones) so that a slow monitor does not delay or lose events for others. A
+ * monitor that does not receive any of its messages for
+ * CTRL_IFACE_MONITOR_MAX_STALLS consecutive attempts is detached.
  */
 struct wpa_ctrl_dst {
 	struct dl_list list;
@@ -44,6 +62,28 @@ struct wpa_ctrl_dst {
 	socklen_t addrlen;
 	int debug_level;
 	int errors;
+	unsigned int stalls; /* consecutive sends blocked by the monitor */
+	char **filter; /* event prefixes from ATTACH filter=; NULL = all */
+	size_t num_filter;
+	struct dl_list pending; /* struct wpa_ctrl_dst_msg */
+	unsigned int pending_count;
+	unsigned int dropped;
+};
+
+struct wpa_ctrl_dst_msg {
+	struct dl_list list;
+	size_t len;
+	/* followed by len octets of message data */
+};
+
+/* Transmission state of buffered event messages on a datagram socket */
+struct wpas_ctrl_drain {
+	const int *sock;
+	struct dl_list *ctrl_dst; /* struct wpa_ctrl_dst */
+	int write_sock; /* socket registered for EVENT_TYPE_WRITE or -1 */
+	unsigned int stalled; /* retries without any progress */
+	void (*reinit)(void *ctx);
+	void *ctx;
 };
 
 
@@ -52,8 +92,11 @@ struct ctrl_iface_priv {
 	int sock;
 	struct dl_list ctrl_dst;
 	int android_control_socket;
-	struct dl_list msg_queue;
-	unsigned int throttle_count;
+	struct wpas_ctrl_drain drain;
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	int stream_sock;
+	struct dl_list stream_conns; /* struct wpas_ctrl_stream_conn */
+#endif /* CONFIG_CTRL_IFACE_STREAM */
 };
 
 
@@ -62,27 +105,14 @@ struct ctrl_iface_global_priv {
 	int sock;
 	struct dl_list ctrl_dst;
 	int android_control_socket;
-	struct dl_list msg_queue;
-	unsigned int throttle_count;
-};
-
-struct ctrl_iface_msg {
-	struct dl_list list;
-	struct wpa_supplicant *wpa_s;
-	int level;
-	enum wpa_msg_type type;
-	const char *txt;
-	size_t len;
+	struct wpas_ctrl_drain drain;
 };
 
 
-static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
-					   const char *ifname, int sock,
-					   struct dl_list *ctrl_dst,
+static void wpa_supplicant_ctrl_iface_send(const char *ifname,
+					   struct wpas_ctrl_drain *drain,
 					   int level, const char *buf,
-					   size_t len,
-					   struct ctrl_iface_priv *priv,
-					   struct ctrl_iface_global_priv *gp);
+					   size_t len);
 static int wpas_ctrl_iface_reinit(struct wpa_supplicant *wpa_s,
 				  struct ctrl_iface_priv *priv);
 static int wpas_ctrl_iface_global_reinit(struct wpa_global *global,
@@ -99,6 +129,8 @@ static void wpas_ctrl_sock_debug(const char *title, int sock, const char *buf,
 
 	if (len >= 5 && os_strncmp(buf, "PONG\n", 5) == 0)
 		level = MSG_EXCESSIVE;
+	if (level < wpa_debug_level)
+		return;
 
 	optlen = sizeof(sndbuf);
 	sndbuf = 0;
@@ -115,9 +147,113 @@ static void wpas_ctrl_sock_debug(const char *title, int sock, const char *buf,
 }
 
 
+static void wpas_ctrl_filter_free(char **filter, size_t num_filter)
+{
+	size_t i;
+
+	for (i = 0; i < num_filter; i++)
+		os_free(filter[i]);
+	os_free(filter);
+}
+
+
+/*
+ * Parse the parameters of an ATTACH command. filter=<prefix>[,<prefix>...]
+ * limits the events delivered to the monitor to the ones that start with one
+ * of the prefixes (e.g., "ATTACH filter=CTRL-EVENT-BSS-"). The parameter can
+ * be repeated. No filter means that all events are delivered.
+ */
+static int wpas_ctrl_filter_parse(const char *params, char ***filter,
+				  size_t *num_filter)
+{
+	char **list = NULL, **n;
+	size_t count = 0;
+	const char *pos = params, *end;
+
+	for (;;) {
+		while (*pos == ' ')
+			pos++;
+		if (*pos == '\0')
+			break;
+		if (os_strncmp(pos, "filter=", 7) != 0)
+			goto fail;
+		pos += 7;
+		for (;;) {
+			end = pos;
+			while (*end && *end != ',' && *end != ' ')
+				end++;
+			if (end == pos)
+				goto fail;
+			n = os_realloc_array(list, count + 1, sizeof(char *));
+			if (n == NULL)
+				goto fail;
+			list = n;
+			list[count] = dup_binstr(pos, end - pos);
+			if (list[count] == NULL)
+				goto fail;
+			count++;
+			pos = end;
+			if (*pos != ',')
+				break;
+			pos++;
+		}
+	}
+
+	*filter = list;
+	*num_filter = count;
+	return 0;
+
+fail:
+	wpas_ctrl_filter_free(list, count);
+	return -1;
+}
+
+
+static int wpas_ctrl_filter_match(char **filter, size_t num_filter,
+				  const char *buf, size_t len)
+{
+	size_t i, plen;
+
+	if (filter == NULL)
+		return 1;
+
+	for (i = 0; i < num_filter; i++) {
+		plen = os_strlen(filter[i]);
+		if (plen <= len && os_memcmp(buf, filter[i], plen) == 0)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+static void wpa_ctrl_dst_addr_txt(struct wpa_ctrl_dst *dst, char *buf,
+				  size_t buflen)
+{
+	printf_encode(buf, buflen, (u8 *) dst->addr.sun_path,
+		      dst->addrlen - offsetof(struct sockaddr_un, sun_path));
+}
+
+
+static void wpa_ctrl_dst_free(struct wpa_ctrl_dst *dst)
+{
+	struct wpa_ctrl_dst_msg *msg, *prev;
+
+	dl_list_del(&dst->list);
+	dl_list_for_each_safe(msg, prev, &dst->pending, struct wpa_ctrl_dst_msg,
+			      list) {
+		dl_list_del(&msg->list);
+		os_free(msg);
+	}
+	wpas_ctrl_filter_free(dst->filter, dst->num_filter);
+	os_free(dst);
+}
+
+
 static int wpa_supplicant_ctrl_iface_attach(struct dl_list *ctrl_dst,
 					    struct sockaddr_un *from,
-					    socklen_t fromlen, int global)
+					    socklen_t fromlen, int global,
+					    const char *params)
 {
 	struct wpa_ctrl_dst *dst;
 	char addr_txt[200];
@@ -125,15 +261,22 @@ static int wpa_supplicant_ctrl_iface_attach(struct dl_list *ctrl_dst,
 	dst = os_zalloc(sizeof(*dst));
 	if (dst == NULL)
 		return -1;
+	if (wpas_ctrl_filter_parse(params, &dst->filter,
+				   &dst->num_filter) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "CTRL_IFACE: Invalid ATTACH parameters '%s'",
+			   params);
+		os_free(dst);
+		return -1;
+	}
 	os_memcpy(&dst->addr, from, sizeof(struct sockaddr_un));
 	dst->addrlen = fromlen;
 	dst->debug_level = MSG_INFO;
+	dl_list_init(&dst->pending);
 	dl_list_add(ctrl_dst, &dst->list);
-	printf_encode(addr_txt, sizeof(addr_txt),
-		      (u8 *) from->sun_path,
-		      fromlen - offsetof(struct sockaddr_un, sun_path));
-	wpa_printf(MSG_DEBUG, "CTRL_IFACE %smonitor attached %s",
-		   global ? "global " : "", addr_txt);
+	wpa_ctrl_dst_addr_txt(dst, addr_txt, sizeof(addr_txt));
+	wpa_printf(MSG_DEBUG, "CTRL_IFACE %smonitor attached %s%s",
+		   global ? "global " : "", addr_txt, params);
 	return 0;
 }
 
@@ -156,8 +299,7 @@ static int wpa_supplicant_ctrl_iface_detach(struct dl_list *ctrl_dst,
 				      offsetof(struct sockaddr_un, sun_path));
 			wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor detached %s",
 				   addr_txt);
-			dl_list_del(&dst->list);
-			os_free(dst);
+			wpa_ctrl_dst_free(dst);
 			return 0;
 		}
 	}
@@ -216,9 +358,10 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 	buf[res] = '\0';
 
-	if (os_strcmp(buf, "ATTACH") == 0) {
+	if (os_strcmp(buf, "ATTACH") == 0 ||
+	    os_strncmp(buf, "ATTACH ", 7) == 0) {
 		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
-						     fromlen, 0))
+						     fromlen, 0, buf + 6))
 			reply_len = 1;
 		else {
 			new_attached = 1;
@@ -347,6 +490,482 @@ static char * wpa_supplicant_ctrl_iface_path(struct wpa_supplicant *wpa_s)
 }
 
 
+#ifdef CONFIG_CTRL_IFACE_STREAM
+
+/*
+ * Stream control interface (<ctrl_interface>/<ifname>.stream). Commands and
+ * replies are framed with a length prefix (see wpa_ctrl.h), so a connection
+ * can carry pipelined commands and replies larger than a datagram. Replies
+ * and events that cannot be sent immediately are buffered per connection and
+ * written out when the socket becomes writable.
+ */
+
+/* Maximum length of a reply to a command on a stream connection */
+#define CTRL_IFACE_STREAM_REPLY_SIZE 262144
+/* Maximum amount of buffered output before the connection is closed */
+#define CTRL_IFACE_STREAM_MAX_PENDING (4 * CTRL_IFACE_STREAM_REPLY_SIZE)
+#define CTRL_IFACE_STREAM_MAX_CONNS 32
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif /* MSG_NOSIGNAL */
+
+struct wpas_ctrl_stream_conn {
+	struct dl_list list;
+	struct ctrl_iface_priv *priv;
+	int sock;
+	u8 *in;
+	size_t in_len;
+	u8 *out;
+	size_t out_len, out_pos, out_size;
+	int write_registered;
+	int attached;
+	int debug_level;
+	char **filter;
+	size_t num_filter;
+	int processing;
+	int closed;
+};
+
+
+static void wpas_ctrl_stream_conn_release(struct wpas_ctrl_stream_conn *conn)
+{
+	/* Commands may include passwords or keys */
+	bin_clear_free(conn->in, conn->in_len);
+	os_free(conn->out);
+	wpas_ctrl_filter_free(conn->filter, conn->num_filter);
+	os_free(conn);
+}
+
+
+static void wpas_ctrl_stream_conn_free(struct wpas_ctrl_stream_conn *conn)
+{
+	wpa_printf(MSG_DEBUG, "CTRL_IFACE stream connection %d closed",
+		   conn->sock);
+	eloop_unregister_read_sock(conn->sock);
+	if (conn->write_registered)
+		eloop_unregister_sock(conn->sock, EVENT_TYPE_WRITE);
+	close(conn->sock);
+	dl_list_del(&conn->list);
+	if (conn->processing) {
+		/*
+		 * The command being processed closed the connection (e.g., by
+		 * removing the interface); wpas_ctrl_stream_receive() frees
+		 * the connection once the command returns.
+		 */
+		conn->closed = 1;
+		return;
+	}
+	wpas_ctrl_stream_conn_release(conn);
+}
+
+
+static void wpas_ctrl_stream_writable(int sock, void *eloop_ctx,
+				      void *sock_ctx);
+
+static int wpas_ctrl_stream_send_pending(struct wpas_ctrl_stream_conn *conn)
+{
+	int res;
+
+	while (conn->out_pos < conn->out_len) {
+		res = send(conn->sock, conn->out + conn->out_pos,
+			   conn->out_len - conn->out_pos,
+			   MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			if (!conn->write_registered &&
+			    eloop_register_sock(conn->sock, EVENT_TYPE_WRITE,
+						wpas_ctrl_stream_writable,
+						NULL, conn) < 0)
+				return -1;
+			conn->write_registered = 1;
+			return 0;
+		}
+		if (res < 0) {
+			wpa_printf(MSG_DEBUG,
+				   "CTRL_IFACE stream connection %d send failed: %s",
+				   conn->sock, strerror(errno));
+			return -1;
+		}
+		conn->out_pos += res;
+	}
+
+	conn->out_len = conn->out_pos = 0;
+	if (conn->write_registered) {
+		eloop_unregister_sock(conn->sock, EVENT_TYPE_WRITE);
+		conn->write_registered = 0;
+	}
+	return 0;
+}
+
+
+static void wpas_ctrl_stream_writable(int sock, void *eloop_ctx,
+				      void *sock_ctx)
+{
+	struct wpas_ctrl_stream_conn *conn = sock_ctx;
+
+	if (wpas_ctrl_stream_send_pending(conn) < 0)
+		wpas_ctrl_stream_conn_free(conn);
+}
+
+
+static int wpas_ctrl_stream_queue(struct wpas_ctrl_stream_conn *conn,
+				  const char *prefix, size_t prefix_len,
+				  const char *buf, size_t len)
+{
+	size_t need;
+	u8 *pos;
+
+	if (conn->out_pos) {
+		os_memmove(conn->out, conn->out + conn->out_pos,
+			   conn->out_len - conn->out_pos);
+		conn->out_len -= conn->out_pos;
+		conn->out_pos = 0;
+	}
+
+	need = conn->out_len + WPA_CTRL_STREAM_HDR_LEN + prefix_len + len;
+	if (need > CTRL_IFACE_STREAM_MAX_PENDING) {
+		wpa_printf(MSG_INFO,
+			   "CTRL_IFACE stream connection %d is not receiving its messages",
+			   conn->sock);
+		return -1;
+	}
+	if (need > conn->out_size) {
+		pos = os_realloc(conn->out, need);
+		if (pos == NULL)
+			return -1;
+		conn->out = pos;
+		conn->out_size = need;
+	}
+
+	pos = conn->out + conn->out_len;
+	WPA_PUT_BE32(pos, prefix_len + len);
+	pos += WPA_CTRL_STREAM_HDR_LEN;
+	if (prefix_len)
+		os_memcpy(pos, prefix, prefix_len);
+	os_memcpy(pos + prefix_len, buf, len);
+	conn->out_len = need;
+
+	if (conn->write_registered)
+		return 0;
+	return wpas_ctrl_stream_send_pending(conn);
+}
+
+
+static int wpas_ctrl_stream_command(struct wpas_ctrl_stream_conn *conn,
+				    char *cmd)
+{
+	char *reply = NULL, *reply_buf = NULL;
+	size_t reply_len = 0;
+	int res;
+
+	if (os_strcmp(cmd, "ATTACH") == 0 ||
+	    os_strncmp(cmd, "ATTACH ", 7) == 0) {
+		char **filter;
+		size_t num_filter;
+
+		if (wpas_ctrl_filter_parse(cmd + 6, &filter,
+					   &num_filter) == 0) {
+			wpas_ctrl_filter_free(conn->filter, conn->num_filter);
+			conn->filter = filter;
+			conn->num_filter = num_filter;
+			conn->attached = 1;
+			conn->debug_level = MSG_INFO;
+			wpa_printf(MSG_DEBUG,
+				   "CTRL_IFACE stream monitor attached on connection %d%s",
+				   conn->sock, cmd + 6);
+			reply_len = 2;
+		} else {
+			reply_len = 1;
+		}
+	} else if (os_strcmp(cmd, "DETACH") == 0) {
+		reply_len = conn->attached ? 2 : 1;
+		conn->attached = 0;
+	} else if (os_strncmp(cmd, "LEVEL ", 6) == 0) {
+		conn->debug_level = atoi(cmd + 6);
+		reply_len = conn->attached ? 2 : 1;
+	} else {
+		reply_buf = wpa_supplicant_ctrl_iface_process2(
+			conn->priv->wpa_s, cmd, &reply_len,
+			CTRL_IFACE_STREAM_REPLY_SIZE);
+		reply = reply_buf;
+		if (conn->closed) {
+			os_free(reply_buf);
+			return -1;
+		}
+	}
+
+	if (!reply && reply_len == 2) {
+		reply = "OK\n";
+		reply_len = 3;
+	} else if (!reply) {
+		/* Always reply to keep pipelined replies in order */
+		reply = "FAIL\n";
+		reply_len = 5;
+	}
+
+	res = wpas_ctrl_stream_queue(conn, NULL, 0, reply, reply_len);
+	os_free(reply_buf);
+	return res;
+}
+
+
+static void wpas_ctrl_stream_receive(int sock, void *eloop_ctx,
+				     void *sock_ctx)
+{
+	struct wpas_ctrl_stream_conn *conn = sock_ctx;
+	u8 buf[4096], *pos;
+	char *cmd;
+	size_t len, used = 0;
+	int res;
+
+	res = recv(sock, buf, sizeof(buf), 0);
+	if (res < 0 && (errno == EINTR || errno == EAGAIN ||
+			errno == EWOULDBLOCK))
+		return;
+	if (res <= 0) {
+		wpas_ctrl_stream_conn_free(conn);
+		return;
+	}
+
+	pos = os_realloc(conn->in, conn->in_len + res);
+	if (pos == NULL) {
+		os_memset(buf, 0, res);
+		wpas_ctrl_stream_conn_free(conn);
+		return;
+	}
+	conn->in = pos;
+	os_memcpy(conn->in + conn->in_len, buf, res);
+	conn->in_len += res;
+	os_memset(buf, 0, res);
+
+	while (conn->in_len - used >= WPA_CTRL_STREAM_HDR_LEN) {
+		len = WPA_GET_BE32(conn->in + used);
+		if (len > WPA_CTRL_STREAM_MAX_CMD_LEN) {
+			wpa_printf(MSG_DEBUG,
+				   "CTRL_IFACE stream connection %d: Too long command (%u)",
+				   sock, (unsigned int) len);
+			wpas_ctrl_stream_conn_free(conn);
+			return;
+		}
+		if (conn->in_len - used - WPA_CTRL_STREAM_HDR_LEN < len)
+			break;
+
+		cmd = dup_binstr(conn->in + used + WPA_CTRL_STREAM_HDR_LEN,
+				 len);
+		used += WPA_CTRL_STREAM_HDR_LEN + len;
+		if (cmd == NULL) {
+			wpas_ctrl_stream_conn_free(conn);
+			return;
+		}
+		conn->processing = 1;
+		res = wpas_ctrl_stream_command(conn, cmd);
+		conn->processing = 0;
+		bin_clear_free(cmd, len);
+		if (conn->closed) {
+			wpas_ctrl_stream_conn_release(conn);
+			return;
+		}
+		if (res < 0) {
+			wpas_ctrl_stream_conn_free(conn);
+			return;
+		}
+	}
+
+	if (used) {
+		os_memmove(conn->in, conn->in + used, conn->in_len - used);
+		os_memset(conn->in + conn->in_len - used, 0, used);
+		conn->in_len -= used;
+	}
+}
+
+
+static void wpas_ctrl_stream_accept(int sock, void *eloop_ctx,
+				    void *sock_ctx)
+{
+	struct ctrl_iface_priv *priv = sock_ctx;
+	struct wpas_ctrl_stream_conn *conn;
+	int s, flags;
+
+	s = accept(sock, NULL, NULL);
+	if (s < 0) {
+		wpa_printf(MSG_DEBUG, "CTRL_IFACE stream accept failed: %s",
+			   strerror(errno));
+		return;
+	}
+
+	if (dl_list_len(&priv->stream_conns) >= CTRL_IFACE_STREAM_MAX_CONNS) {
+		wpa_printf(MSG_INFO,
+			   "CTRL_IFACE stream: Too many connections - reject new connection");
+		close(s);
+		return;
+	}
+
+	flags = fcntl(s, F_GETFL);
+	if (flags < 0 || fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0) {
+		wpa_printf(MSG_INFO, "fcntl(ctrl stream, O_NONBLOCK): %s",
+			   strerror(errno));
+		close(s);
+		return;
+	}
+
+	conn = os_zalloc(sizeof(*conn));
+	if (conn == NULL) {
+		close(s);
+		return;
+	}
+	conn->priv = priv;
+	conn->sock = s;
+	conn->debug_level = MSG_INFO;
+	if (eloop_register_read_sock(s, wpas_ctrl_stream_receive, priv->wpa_s,
+				     conn) < 0) {
+		close(s);
+		os_free(conn);
+		return;
+	}
+	dl_list_add_tail(&priv->stream_conns, &conn->list);
+	wpa_printf(MSG_DEBUG, "CTRL_IFACE stream connection %d opened", s);
+}
+
+
+static void wpas_ctrl_stream_event(struct ctrl_iface_priv *priv, int level,
+				   const char *buf, size_t len)
+{
+	struct wpas_ctrl_stream_conn *conn, *next;
+	char levelstr[10];
+	int res;
+
+	res = os_snprintf(levelstr, sizeof(levelstr), "<%d>", level);
+	if (os_snprintf_error(sizeof(levelstr), res))
+		return;
+
+	dl_list_for_each_safe(conn, next, &priv->stream_conns,
+			      struct wpas_ctrl_stream_conn, list) {
+		if (!conn->attached || level < conn->debug_level ||
+		    !wpas_ctrl_filter_match(conn->filter, conn->num_filter,
+					    buf, len))
+			continue;
+		if (wpas_ctrl_stream_queue(conn, levelstr, res, buf, len) < 0)
+			wpas_ctrl_stream_conn_free(conn);
+	}
+}
+
+
+static int wpas_ctrl_stream_open(struct ctrl_iface_priv *priv,
+				 const char *ctrl_path, int gid_set, gid_t gid)
+{
+	struct sockaddr_un addr;
+	int flags, res;
+
+	os_memset(&addr, 0, sizeof(addr));
+#if defined(__FreeBSD__) || defined(__FreeBSD_kernel__)
+	addr.sun_len = sizeof(addr);
+#endif /* __FreeBSD__ */
+	addr.sun_family = AF_UNIX;
+	res = os_snprintf(addr.sun_path, sizeof(addr.sun_path),
+			  "%s" WPA_CTRL_STREAM_SUFFIX, ctrl_path);
+	if (os_snprintf_error(sizeof(addr.sun_path), res)) {
+		wpa_printf(MSG_ERROR, "ctrl_iface stream path limit exceeded");
+		return -1;
+	}
+
+	priv->stream_sock = socket(PF_UNIX, SOCK_STREAM, 0);
+	if (priv->stream_sock < 0) {
+		wpa_printf(MSG_ERROR, "socket(PF_UNIX, SOCK_STREAM): %s",
+			   strerror(errno));
+		return -1;
+	}
+
+	if (bind(priv->stream_sock, (struct sockaddr *) &addr,
+		 sizeof(addr)) < 0) {
+		int s;
+
+		/* Replace a leftover socket unless it is still in use */
+		s = socket(PF_UNIX, SOCK_STREAM, 0);
+		if (s >= 0 &&
+		    connect(s, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+			close(s);
+			wpa_printf(MSG_INFO,
+				   "ctrl_iface stream socket '%s' exists and seems to be in use",
+				   addr.sun_path);
+			goto fail;
+		}
+		if (s >= 0)
+			close(s);
+		if (unlink(addr.sun_path) < 0 ||
+		    bind(priv->stream_sock, (struct sockaddr *) &addr,
+			 sizeof(addr)) < 0) {
+			wpa_printf(MSG_ERROR, "ctrl_iface stream bind(%s): %s",
+				   addr.sun_path, strerror(errno));
+			goto fail;
+		}
+	}
+
+	if ((gid_set && chown(addr.sun_path, -1, gid) < 0) ||
+	    chmod(addr.sun_path, S_IRWXU | S_IRWXG) < 0) {
+		wpa_printf(MSG_ERROR, "ctrl_iface stream chown/chmod(%s): %s",
+			   addr.sun_path, strerror(errno));
+		goto fail_unlink;
+	}
+
+	flags = fcntl(priv->stream_sock, F_GETFL);
+	if (flags >= 0)
+		fcntl(priv->stream_sock, F_SETFL, flags | O_NONBLOCK);
+
+	if (listen(priv->stream_sock, 5) < 0 ||
+	    eloop_register_read_sock(priv->stream_sock,
+				     wpas_ctrl_stream_accept, priv->wpa_s,
+				     priv) < 0) {
+		wpa_printf(MSG_ERROR, "ctrl_iface stream listen: %s",
+			   strerror(errno));
+		goto fail_unlink;
+	}
+
+	wpa_printf(MSG_DEBUG, "ctrl_iface stream socket '%s' opened",
+		   addr.sun_path);
+	return 0;
+
+fail_unlink:
+	unlink(addr.sun_path);
+fail:
+	close(priv->stream_sock);
+	priv->stream_sock = -1;
+	return -1;
+}
+
+
+static void wpas_ctrl_stream_close(struct ctrl_iface_priv *priv)
+{
+	struct wpas_ctrl_stream_conn *conn, *next;
+	char *fname;
+
+	dl_list_for_each_safe(conn, next, &priv->stream_conns,
+			      struct wpas_ctrl_stream_conn, list)
+		wpas_ctrl_stream_conn_free(conn);
+
+	if (priv->stream_sock < 0)
+		return;
+	eloop_unregister_read_sock(priv->stream_sock);
+	close(priv->stream_sock);
+	priv->stream_sock = -1;
+
+	fname = wpa_supplicant_ctrl_iface_path(priv->wpa_s);
+	if (fname) {
+		char path[sizeof(((struct sockaddr_un *) 0)->sun_path)];
+
+		if (!os_snprintf_error(sizeof(path),
+				       os_snprintf(path, sizeof(path), "%s"
+						   WPA_CTRL_STREAM_SUFFIX,
+						   fname)))
+			unlink(path);
+		os_free(fname);
+	}
+}
+
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+
+
 static int wpas_ctrl_iface_throttle(int sock)
 {
 #ifdef __linux__
@@ -366,117 +985,291 @@ static int wpas_ctrl_iface_throttle(int sock)
 }
 
 
-static void wpas_ctrl_msg_send_pending_global(struct wpa_global *global)
+static int wpa_ctrl_dst_queue(struct wpa_ctrl_dst *dst,
+			      const struct iovec *io, int iovlen)
 {
-	struct ctrl_iface_global_priv *gpriv;
-	struct ctrl_iface_msg *msg;
+	struct wpa_ctrl_dst_msg *msg;
+	size_t len = 0;
+	u8 *pos;
+	int i;
 
-	gpriv = global->ctrl_iface;
-	while (gpriv && !dl_list_empty(&gpriv->msg_queue) &&
-	       !wpas_ctrl_iface_throttle(gpriv->sock)) {
-		msg = dl_list_first(&gpriv->msg_queue, struct ctrl_iface_msg,
+	if (dst->pending_count >= CTRL_IFACE_MONITOR_MAX_PENDING) {
+		msg = dl_list_first(&dst->pending, struct wpa_ctrl_dst_msg,
 				    list);
-		if (!msg)
-			break;
 		dl_list_del(&msg->list);
-		wpa_supplicant_ctrl_iface_send(
-			msg->wpa_s,
-			msg->type != WPA_MSG_PER_INTERFACE ?
-			NULL : msg->wpa_s->ifname,
-			gpriv->sock, &gpriv->ctrl_dst, msg->level,
-			msg->txt, msg->len, NULL, gpriv);
 		os_free(msg);
+		dst->pending_count--;
+		if (dst->dropped++ == 0) {
+			char addr_txt[200];
+
+			wpa_ctrl_dst_addr_txt(dst, addr_txt, sizeof(addr_txt));
+			wpa_printf(MSG_DEBUG,
+				   "CTRL_IFACE monitor %s is not receiving its messages - drop oldest pending message",
+				   addr_txt);
+		}
+	}
+
+	for (i = 0; i < iovlen; i++)
+		len += io[i].iov_len;
+	msg = os_malloc(sizeof(*msg) + len);
+	if (msg == NULL) {
+		dst->dropped++;
+		return -1;
+	}
+	msg->len = len;
+	pos = (u8 *) (msg + 1);
+	for (i = 0; i < iovlen; i++) {
+		os_memcpy(pos, io[i].iov_base, io[i].iov_len);
+		pos += io[i].iov_len;
 	}
+	dl_list_add_tail(&dst->pending, &msg->list);
+	dst->pending_count++;
+	return 0;
 }
 
 
-static void wpas_ctrl_msg_send_pending_iface(struct wpa_supplicant *wpa_s)
+/* Returns 1 if the monitor was detached and freed, 0 otherwise */
+static int wpa_ctrl_dst_send_error(struct wpa_ctrl_dst *dst, int err)
 {
-	struct ctrl_iface_priv *priv;
-	struct ctrl_iface_msg *msg;
+	char addr_txt[200];
 
-	priv = wpa_s->ctrl_iface;
-	while (priv && !dl_list_empty(&priv->msg_queue) &&
-	       !wpas_ctrl_iface_throttle(priv->sock)) {
-		msg = dl_list_first(&priv->msg_queue, struct ctrl_iface_msg,
-				    list);
-		if (!msg)
-			break;
+	wpa_ctrl_dst_addr_txt(dst, addr_txt, sizeof(addr_txt));
+	wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor[%s]: %d - %s",
+		   addr_txt, err, strerror(err));
+	dst->errors++;
+
+	if (dst->errors > 10 || err == ENOENT || err == EPERM) {
+		wpa_printf(MSG_INFO, "CTRL_IFACE: Detach monitor %s that cannot receive messages",
+			   addr_txt);
+		wpa_ctrl_dst_free(dst);
+		return 1;
+	}
+
+	return 0;
+}
+
+
+/* Returns 1 if the monitor was detached and freed, 0 otherwise */
+static int wpa_ctrl_dst_send_stalled(struct wpa_ctrl_dst *dst)
+{
+	char addr_txt[200];
+
+	if (++dst->stalls < CTRL_IFACE_MONITOR_MAX_STALLS)
+		return 0;
+
+	wpa_ctrl_dst_addr_txt(dst, addr_txt, sizeof(addr_txt));
+	wpa_printf(MSG_INFO,
+		   "CTRL_IFACE: Detach monitor %s that is not receiving its messages (%u pending)",
+		   addr_txt, dst->pending_count);
+	wpa_ctrl_dst_free(dst);
+	return 1;
+}
+
+
+/*
+ * Send buffered messages to a monitor. Returns the number of messages sent or
+ * -1 if the monitor was detached.
+ */
+static int wpa_ctrl_dst_send_pending(int sock, struct wpa_ctrl_dst *dst)
+{
+	struct wpa_ctrl_dst_msg *msg;
+	int sent = 0;
+
+	while (sent < CTRL_IFACE_MONITOR_DRAIN_BURST &&
+	       (msg = dl_list_first(&dst->pending, struct wpa_ctrl_dst_msg,
+				    list))) {
+		if (sendto(sock, msg + 1, msg->len, MSG_DONTWAIT,
+			   (struct sockaddr *) &dst->addr, dst->addrlen) < 0) {
+			int _errno = errno;
+
+			if (_errno == EINTR)
+				break;
+			if (_errno == EAGAIN || _errno == EWOULDBLOCK ||
+			    _errno == ENOBUFS) {
+				if (sent == 0 && wpa_ctrl_dst_send_stalled(dst))
+					return -1;
+				break;
+			}
+			if (wpa_ctrl_dst_send_error(dst, _errno))
+				return -1;
+		} else {
+			dst->errors = 0;
+			dst->stalls = 0;
+			sent++;
+		}
 		dl_list_del(&msg->list);
-		wpa_supplicant_ctrl_iface_send(wpa_s, NULL, priv->sock,
-					       &priv->ctrl_dst, msg->level,
-					       msg->txt, msg->len, priv, NULL);
 		os_free(msg);
+		dst->pending_count--;
+
+		if (dl_list_empty(&dst->pending) && dst->dropped) {
+			char addr_txt[200], txt[100];
+			struct iovec io;
+			int res, hlen;
+
+			/* Let the monitor know that it missed some events */
+			wpa_ctrl_dst_addr_txt(dst, addr_txt, sizeof(addr_txt));
+			wpa_printf(MSG_INFO,
+				   "CTRL_IFACE: Dropped %u event message(s) for monitor %s",
+				   dst->dropped, addr_txt);
+			hlen = os_snprintf(txt, sizeof(txt), "<%d>", MSG_WARNING);
+			res = os_snprintf(txt + hlen, sizeof(txt) - hlen,
+					  WPA_EVENT_MONITOR_DROPPED "count=%u",
+					  dst->dropped);
+			dst->dropped = 0;
+			if (os_snprintf_error(sizeof(txt) - hlen, res))
+				break;
+			/* Apply the same filtering as for other events */
+			if (MSG_WARNING < dst->debug_level ||
+			    !wpas_ctrl_filter_match(dst->filter, dst->num_filter,
+						    txt + hlen, res))
+				break;
+			res += hlen;
+			io.iov_base = txt;
+			io.iov_len = res;
+			wpa_ctrl_dst_queue(dst, &io, 1);
+		}
 	}
+
+	return sent;
 }
 
 
-static void wpas_ctrl_msg_queue_timeout(void *eloop_ctx, void *timeout_ctx)
+/*
+ * Send buffered messages to all monitors on a socket. Returns the number of
+ * messages sent and sets *more if there are still messages left.
+ */
+static int wpas_ctrl_drain_pending(struct wpas_ctrl_drain *drain, int *more)
 {
-	struct wpa_supplicant *wpa_s = eloop_ctx;
-	struct ctrl_iface_priv *priv;
-	struct ctrl_iface_global_priv *gpriv;
-	int sock = -1, gsock = -1;
+	struct wpa_ctrl_dst *dst, *next;
+	int sent = 0, res;
 
-	wpas_ctrl_msg_send_pending_global(wpa_s->global);
-	wpas_ctrl_msg_send_pending_iface(wpa_s);
+	*more = 0;
+	if (*drain->sock < 0)
+		return 0;
+	dl_list_for_each_safe(dst, next, drain->ctrl_dst, struct wpa_ctrl_dst,
+			      list) {
+		if (dl_list_empty(&dst->pending))
+			continue;
+		if (wpas_ctrl_iface_throttle(*drain->sock)) {
+			*more = 1;
+			break;
+		}
+		res = wpa_ctrl_dst_send_pending(*drain->sock, dst);
+		if (res < 0)
+			continue;
+		sent += res;
+		if (!dl_list_empty(&dst->pending))
+			*more = 1;
+	}
 
-	priv = wpa_s->ctrl_iface;
-	if (priv && !dl_list_empty(&priv->msg_queue))
-		sock = priv->sock;
+	return sent;
+}
 
-	gpriv = wpa_s->global->ctrl_iface;
-	if (gpriv && !dl_list_empty(&gpriv->msg_queue))
-		gsock = gpriv->sock;
 
-	if (sock > -1 || gsock > -1) {
-		/* Continue pending message transmission from a timeout */
-		wpa_printf(MSG_MSGDUMP,
-			   "CTRL: Had to throttle pending event message transmission for (sock %d gsock %d)",
-			   sock, gsock);
-		eloop_register_timeout(0, 20000, wpas_ctrl_msg_queue_timeout,
-				       wpa_s, NULL);
+static void wpas_ctrl_drain_timeout(void *eloop_ctx, void *timeout_ctx);
+
+static void wpas_ctrl_drain_stop(struct wpas_ctrl_drain *drain)
+{
+	if (drain->write_sock >= 0) {
+		eloop_unregister_sock(drain->write_sock, EVENT_TYPE_WRITE);
+		drain->write_sock = -1;
 	}
+	eloop_cancel_timeout(wpas_ctrl_drain_timeout, drain, NULL);
+	drain->stalled = 0;
 }
 
 
-static void wpas_ctrl_msg_queue(struct dl_list *queue,
-				struct wpa_supplicant *wpa_s, int level,
-				enum wpa_msg_type type,
-				const char *txt, size_t len)
+static void wpas_ctrl_drain_writable(int sock, void *eloop_ctx,
+				     void *sock_ctx)
 {
-	struct ctrl_iface_msg *msg;
+	struct wpas_ctrl_drain *drain = sock_ctx;
+	int more, sent;
+
+	sent = wpas_ctrl_drain_pending(drain, &more);
+	if (!more) {
+		wpas_ctrl_drain_stop(drain);
+	} else if (sent == 0) {
+		/*
+		 * The local socket is writable, but the monitors are not
+		 * receiving their messages. Leave the retries to the timeout
+		 * instead of busy looping on the writability event.
+		 */
+		eloop_unregister_sock(drain->write_sock, EVENT_TYPE_WRITE);
+		drain->write_sock = -1;
+	}
+}
+
 
-	msg = os_zalloc(sizeof(*msg) + len);
-	if (!msg)
+/**
+ * wpas_ctrl_drain_schedule - Schedule transmission of buffered messages
+ * @drain: Transmission state of the socket
+ *
+ * Buffered messages are sent once the socket is writable. The socket send
+ * buffer is shared by all monitors, so it becoming writable does not tell
+ * whether a specific monitor is able to receive more messages. A retry timeout
+ * is used as well to handle that case.
+ */
+static void wpas_ctrl_drain_schedule(struct wpas_ctrl_drain *drain)
+{
+	if (*drain->sock < 0)
 		return;
 
-	msg->wpa_s = wpa_s;
-	msg->level = level;
-	msg->type = type;
-	os_memcpy(msg + 1, txt, len);
-	msg->txt = (const char *) (msg + 1);
-	msg->len = len;
-	dl_list_add_tail(queue, &msg->list);
-	eloop_cancel_timeout(wpas_ctrl_msg_queue_timeout, wpa_s, NULL);
-	eloop_register_timeout(0, 0, wpas_ctrl_msg_queue_timeout, wpa_s, NULL);
+	if (drain->write_sock < 0 &&
+	    eloop_register_sock(*drain->sock, EVENT_TYPE_WRITE,
+				wpas_ctrl_drain_writable, NULL, drain) == 0)
+		drain->write_sock = *drain->sock;
+	if (!eloop_is_timeout_registered(wpas_ctrl_drain_timeout, drain, NULL))
+		eloop_register_timeout(0, CTRL_IFACE_MONITOR_RETRY_USEC,
+				       wpas_ctrl_drain_timeout, drain, NULL);
 }
 
 
-static void wpas_ctrl_msg_queue_limit(unsigned int throttle_count,
-				      struct dl_list *queue)
+static void wpas_ctrl_drain_timeout(void *eloop_ctx, void *timeout_ctx)
 {
-	struct ctrl_iface_msg *msg;
+	struct wpas_ctrl_drain *drain = eloop_ctx;
+	int more, sent;
 
-	if (throttle_count < 2000)
+	sent = wpas_ctrl_drain_pending(drain, &more);
+	if (!more) {
+		wpas_ctrl_drain_stop(drain);
 		return;
+	}
 
-	msg = dl_list_first(queue, struct ctrl_iface_msg, list);
-	if (msg) {
-		wpa_printf(MSG_DEBUG, "CTRL: Dropped oldest pending message");
-		dl_list_del(&msg->list);
-		os_free(msg);
+	if (sent > 0) {
+		drain->stalled = 0;
+	} else if (++drain->stalled >= CTRL_IFACE_MONITOR_STALL_RETRIES &&
+		   drain->reinit) {
+		/*
+		 * Messages that monitors have not yet received are charged to
+		 * the send buffer of this socket, so a monitor that does not
+		 * receive its messages can block the others. Reopen the socket
+		 * as a workaround. This does not drop the messages that have
+		 * already been queued to the monitors.
+		 */
+		wpa_printf(MSG_DEBUG,
+			   "CTRL: Pending event message transmission stalled for sock %d - reopen socket",
+			   *drain->sock);
+		wpas_ctrl_drain_stop(drain);
+		drain->reinit(drain->ctx);
+		return;
 	}
+
+	wpa_printf(MSG_MSGDUMP,
+		   "CTRL: Had to throttle pending event message transmission for sock %d",
+		   *drain->sock);
+	wpas_ctrl_drain_schedule(drain);
+}
+
+
+static void wpas_ctrl_drain_init(struct wpas_ctrl_drain *drain,
+				 const int *sock, struct dl_list *ctrl_dst,
+				 void (*reinit)(void *ctx), void *ctx)
+{
+	drain->sock = sock;
+	drain->ctrl_dst = ctrl_dst;
+	drain->write_sock = -1;
+	drain->reinit = reinit;
+	drain->ctx = ctx;
 }
 
 
@@ -494,62 +1287,22 @@ static void wpa_supplicant_ctrl_iface_msg_cb(void *ctx, int level,
 	gpriv = wpa_s->global->ctrl_iface;
 
 	if (type != WPA_MSG_NO_GLOBAL && gpriv &&
-	    !dl_list_empty(&gpriv->ctrl_dst)) {
-		if (!dl_list_empty(&gpriv->msg_queue) ||
-		    wpas_ctrl_iface_throttle(gpriv->sock)) {
-			if (gpriv->throttle_count == 0) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle global event message for sock %d",
-					   gpriv->sock);
-			}
-			gpriv->throttle_count++;
-			wpas_ctrl_msg_queue_limit(gpriv->throttle_count,
-						  &gpriv->msg_queue);
-			wpas_ctrl_msg_queue(&gpriv->msg_queue, wpa_s, level,
-					    type, txt, len);
-		} else {
-			if (gpriv->throttle_count) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle %u global event message(s) for sock %d",
-					   gpriv->throttle_count, gpriv->sock);
-			}
-			gpriv->throttle_count = 0;
-			wpa_supplicant_ctrl_iface_send(
-				wpa_s,
-				type != WPA_MSG_PER_INTERFACE ?
-				NULL : wpa_s->ifname,
-				gpriv->sock, &gpriv->ctrl_dst, level,
-				txt, len, NULL, gpriv);
-		}
-	}
+	    !dl_list_empty(&gpriv->ctrl_dst))
+		wpa_supplicant_ctrl_iface_send(
+			type != WPA_MSG_PER_INTERFACE ? NULL : wpa_s->ifname,
+			&gpriv->drain, level, txt, len);
 
 	priv = wpa_s->ctrl_iface;
 
-	if (type != WPA_MSG_ONLY_GLOBAL && priv) {
-		if (!dl_list_empty(&priv->msg_queue) ||
-		    wpas_ctrl_iface_throttle(priv->sock)) {
-			if (priv->throttle_count == 0) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle event message for sock %d",
-					   priv->sock);
-			}
-			priv->throttle_count++;
-			wpas_ctrl_msg_queue_limit(priv->throttle_count,
-						  &priv->msg_queue);
-			wpas_ctrl_msg_queue(&priv->msg_queue, wpa_s, level,
-					    type, txt, len);
-		} else {
-			if (priv->throttle_count) {
-				wpa_printf(MSG_MSGDUMP,
-					   "CTRL: Had to throttle %u event message(s) for sock %d",
-					   priv->throttle_count, priv->sock);
-			}
-			priv->throttle_count = 0;
-			wpa_supplicant_ctrl_iface_send(wpa_s, NULL, priv->sock,
-						       &priv->ctrl_dst, level,
-						       txt, len, priv, NULL);
-		}
-	}
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	if (type != WPA_MSG_ONLY_GLOBAL && priv &&
+	    !dl_list_empty(&priv->stream_conns))
+		wpas_ctrl_stream_event(priv, level, txt, len);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+
+	if (type != WPA_MSG_ONLY_GLOBAL && priv)
+		wpa_supplicant_ctrl_iface_send(NULL, &priv->drain, level,
+					       txt, len);
 }
 
 
@@ -717,6 +1470,11 @@ static int wpas_ctrl_iface_open_sock(struct wpa_supplicant *wpa_s,
 			   fname, strerror(errno));
 		goto fail;
 	}
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	/* The stream socket is optional and kept over datagram socket reinit */
+	if (priv->stream_sock < 0)
+		wpas_ctrl_stream_open(priv, fname, gid_set, gid);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
 	os_free(fname);
 
 #ifdef ANDROID
@@ -758,6 +1516,16 @@ fail:
 }
 
 
+static void wpas_ctrl_iface_drain_reinit(void *ctx)
+{
+	struct ctrl_iface_priv *priv = ctx;
+
+	if (wpas_ctrl_iface_reinit(priv->wpa_s, priv) < 0)
+		wpa_printf(MSG_DEBUG,
+			   "Failed to reinitialize ctrl_iface socket");
+}
+
+
 struct ctrl_iface_priv *
 wpa_supplicant_ctrl_iface_init(struct wpa_supplicant *wpa_s)
 {
@@ -767,9 +1535,14 @@ wpa_supplicant_ctrl_iface_init(struct wpa_supplicant *wpa_s)
 	if (priv == NULL)
 		return NULL;
 	dl_list_init(&priv->ctrl_dst);
-	dl_list_init(&priv->msg_queue);
 	priv->wpa_s = wpa_s;
 	priv->sock = -1;
+	wpas_ctrl_drain_init(&priv->drain, &priv->sock, &priv->ctrl_dst,
+			     wpas_ctrl_iface_drain_reinit, priv);
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	priv->stream_sock = -1;
+	dl_list_init(&priv->stream_conns);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
 
 	if (wpa_s->conf->ctrl_interface == NULL)
 		return priv;
@@ -848,12 +1621,15 @@ static int wpas_ctrl_iface_reinit(struct wpa_supplicant *wpa_s,
 	if (priv->android_control_socket)
 		return priv->sock;
 
+	wpas_ctrl_drain_stop(&priv->drain);
 	eloop_unregister_read_sock(priv->sock);
 	close(priv->sock);
 	priv->sock = -1;
 	res = wpas_ctrl_iface_open_sock(wpa_s, priv);
 	if (res < 0)
 		return -1;
+	/* Continue with the messages buffered for monitors */
+	wpas_ctrl_drain_schedule(&priv->drain);
 	return priv->sock;
 }
 
@@ -861,8 +1637,11 @@ static int wpas_ctrl_iface_reinit(struct wpa_supplicant *wpa_s,
 void wpa_supplicant_ctrl_iface_deinit(struct ctrl_iface_priv *priv)
 {
 	struct wpa_ctrl_dst *dst, *prev;
-	struct ctrl_iface_msg *msg, *prev_msg;
-	struct ctrl_iface_global_priv *gpriv;
+
+#ifdef CONFIG_CTRL_IFACE_STREAM
+	wpas_ctrl_stream_close(priv);
+#endif /* CONFIG_CTRL_IFACE_STREAM */
+	wpas_ctrl_drain_stop(&priv->drain);
 
 	if (priv->sock > -1) {
 		char *fname;
@@ -916,26 +1695,8 @@ void wpa_supplicant_ctrl_iface_deinit(struct ctrl_iface_priv *priv)
 
 free_dst:
 	dl_list_for_each_safe(dst, prev, &priv->ctrl_dst, struct wpa_ctrl_dst,
-			      list) {
-		dl_list_del(&dst->list);
-		os_free(dst);
-	}
-	dl_list_for_each_safe(msg, prev_msg, &priv->msg_queue,
-			      struct ctrl_iface_msg, list) {
-		dl_list_del(&msg->list);
-		os_free(msg);
-	}
-	gpriv = priv->wpa_s->global->ctrl_iface;
-	if (gpriv) {
-		dl_list_for_each_safe(msg, prev_msg, &gpriv->msg_queue,
-				      struct ctrl_iface_msg, list) {
-			if (msg->wpa_s == priv->wpa_s) {
-				dl_list_del(&msg->list);
-				os_free(msg);
-			}
-		}
-	}
-	eloop_cancel_timeout(wpas_ctrl_msg_queue_timeout, priv->wpa_s, NULL);
+			      list)
+		wpa_ctrl_dst_free(dst);
 	os_free(priv);
 }
 
@@ -943,29 +1704,29 @@ free_dst:
 /**
  * wpa_supplicant_ctrl_iface_send - Send a control interface packet to monitors
  * @ifname: Interface name for global control socket or %NULL
- * @sock: Local socket fd
- * @ctrl_dst: List of attached listeners
+ * @drain: Local socket and attached listeners
  * @level: Priority level of the message
  * @buf: Message data
  * @len: Message length
  *
  * Send a packet to all monitor programs attached to the control interface.
+ * The packet is buffered for monitors that cannot receive it immediately or
+ * still have earlier messages pending, and for all monitors if the socket send
+ * buffer is filling up, so that there is room left for command responses.
  */
-static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
-					   const char *ifname, int sock,
-					   struct dl_list *ctrl_dst,
+static void wpa_supplicant_ctrl_iface_send(const char *ifname,
+					   struct wpas_ctrl_drain *drain,
 					   int level, const char *buf,
-					   size_t len,
-					   struct ctrl_iface_priv *priv,
-					   struct ctrl_iface_global_priv *gp)
+					   size_t len)
 {
 	struct wpa_ctrl_dst *dst, *next;
 	char levelstr[10];
-	int idx, res;
+	int idx, res, sock = *drain->sock;
+	int throttle = -1, queued = 0;
 	struct msghdr msg;
 	struct iovec io[5];
 
-	if (sock < 0 || dl_list_empty(ctrl_dst))
+	if (sock < 0 || dl_list_empty(drain->ctrl_dst))
 		return;
 
 	res = os_snprintf(levelstr, sizeof(levelstr), "<%d>", level);
@@ -984,7 +1745,7 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 		idx++;
 	}
 	io[idx].iov_base = levelstr;
-	io[idx].iov_len = os_strlen(levelstr);
+	io[idx].iov_len = res;
 	idx++;
 	io[idx].iov_base = (char *) buf;
 	io[idx].iov_len = len;
@@ -993,61 +1754,60 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 	msg.msg_iov = io;
 	msg.msg_iovlen = idx;
 
-	dl_list_for_each_safe(dst, next, ctrl_dst, struct wpa_ctrl_dst, list) {
-		int _errno;
-		char addr_txt[200];
+	dl_list_for_each_safe(dst, next, drain->ctrl_dst, struct wpa_ctrl_dst,
+			      list) {
+		int _errno, queue;
 
-		if (level < dst->debug_level)
+		if (level < dst->debug_level ||
+		    !wpas_ctrl_filter_match(dst->filter, dst->num_filter,
+					    buf, len))
 			continue;
 
-		printf_encode(addr_txt, sizeof(addr_txt),
-			      (u8 *) dst->addr.sun_path, dst->addrlen -
-			      offsetof(struct sockaddr_un, sun_path));
-		msg.msg_name = (void *) &dst->addr;
-		msg.msg_namelen = dst->addrlen;
-		wpas_ctrl_sock_debug("ctrl_sock-sendmsg", sock, buf, len);
-		if (sendmsg(sock, &msg, MSG_DONTWAIT) >= 0) {
-			wpa_printf(MSG_MSGDUMP,
-				   "CTRL_IFACE monitor sent successfully to %s",
-				   addr_txt);
-			dst->errors = 0;
-			continue;
+		if (!dl_list_empty(&dst->pending)) {
+			/* Maintain the order of the messages */
+			queue = 1;
+		} else {
+			if (throttle < 0)
+				throttle = wpas_ctrl_iface_throttle(sock);
+			queue = throttle;
 		}
 
-		_errno = errno;
-		wpa_printf(MSG_DEBUG, "CTRL_IFACE monitor[%s]: %d - %s",
-			   addr_txt, errno, strerror(errno));
-		dst->errors++;
-
-		if (dst->errors > 10 || _errno == ENOENT || _errno == EPERM) {
-			wpa_printf(MSG_INFO, "CTRL_IFACE: Detach monitor %s that cannot receive messages",
-				addr_txt);
-			wpa_supplicant_ctrl_iface_detach(ctrl_dst, &dst->addr,
-							 dst->addrlen);
-		}
+		if (!queue) {
+			msg.msg_name = (void *) &dst->addr;
+			msg.msg_namelen = dst->addrlen;
+			wpas_ctrl_sock_debug("ctrl_sock-sendmsg", sock, buf,
+					     len);
+			if (sendmsg(sock, &msg, MSG_DONTWAIT) >= 0) {
+				if (wpa_debug_level <= MSG_MSGDUMP) {
+					char addr_txt[200];
+
+					wpa_ctrl_dst_addr_txt(dst, addr_txt,
+							      sizeof(addr_txt));
+					wpa_printf(MSG_MSGDUMP,
+						   "CTRL_IFACE monitor sent successfully to %s",
+						   addr_txt);
+				}
+				dst->errors = 0;
+				dst->stalls = 0;
+				continue;
+			}
 
-		if (_errno == ENOBUFS || _errno == EAGAIN) {
-			/*
-			 * The socket send buffer could be full. This may happen
-			 * if client programs are not receiving their pending
-			 * messages. Close and reopen the socket as a workaround
-			 * to avoid getting stuck being unable to send any new
-			 * responses.
-			 */
-			if (priv)
-				sock = wpas_ctrl_iface_reinit(wpa_s, priv);
-			else if (gp)
-				sock = wpas_ctrl_iface_global_reinit(
-					wpa_s->global, gp);
-			else
-				break;
-			if (sock < 0) {
-				wpa_dbg(wpa_s, MSG_DEBUG,
-					"Failed to reinitialize ctrl_iface socket");
-				break;
+			_errno = errno;
+			if (_errno != ENOBUFS && _errno != EAGAIN &&
+			    _errno != EWOULDBLOCK) {
+				wpa_ctrl_dst_send_error(dst, _errno);
+				continue;
 			}
+			if (wpa_ctrl_dst_send_stalled(dst))
+				continue;
 		}
+
+		if (wpa_ctrl_dst_queue(dst, io, idx) == 0)
+			queued = 1;
 	}
+
+	if (queued)
+		wpas_ctrl_drain_schedule(drain);
 }
 
 
@@ -1075,11 +1835,12 @@ void wpa_supplicant_ctrl_iface_wait(struct ctrl_iface_priv *priv)
 		}
 		buf[res] = '\0';
 
-		if (os_strcmp(buf, "ATTACH") == 0) {
+		if (os_strcmp(buf, "ATTACH") == 0 ||
+		    os_strncmp(buf, "ATTACH ", 7) == 0) {
 			/* handle ATTACH signal of first monitor interface */
 			if (!wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst,
 							      &from, fromlen,
-							      0)) {
+							      0, buf + 6)) {
 				if (sendto(priv->sock, "OK\n", 3, 0,
 					   (struct sockaddr *) &from, fromlen) <
 				    0) {
@@ -1132,9 +1893,10 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 	buf[res] = '\0';
 
-	if (os_strcmp(buf, "ATTACH") == 0) {
+	if (os_strcmp(buf, "ATTACH") == 0 ||
+	    os_strncmp(buf, "ATTACH ", 7) == 0) {
 		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
-						     fromlen, 1))
+						     fromlen, 1, buf + 6))
 			reply_len = 1;
 		else
 			reply_len = 2;
@@ -1359,6 +2121,16 @@ fail:
 }
 
 
+static void wpas_ctrl_global_drain_reinit(void *ctx)
+{
+	struct ctrl_iface_global_priv *priv = ctx;
+
+	if (wpas_ctrl_iface_global_reinit(priv->global, priv) < 0)
+		wpa_printf(MSG_DEBUG,
+			   "Failed to reinitialize global ctrl_iface socket");
+}
+
+
 struct ctrl_iface_global_priv *
 wpa_supplicant_global_ctrl_iface_init(struct wpa_global *global)
 {
@@ -1368,9 +2140,10 @@ wpa_supplicant_global_ctrl_iface_init(struct wpa_global *global)
 	if (priv == NULL)
 		return NULL;
 	dl_list_init(&priv->ctrl_dst);
-	dl_list_init(&priv->msg_queue);
 	priv->global = global;
 	priv->sock = -1;
+	wpas_ctrl_drain_init(&priv->drain, &priv->sock, &priv->ctrl_dst,
+			     wpas_ctrl_global_drain_reinit, priv);
 
 	if (global->params.ctrl_interface == NULL)
 		return priv;
@@ -1404,12 +2177,15 @@ static int wpas_ctrl_iface_global_reinit(struct wpa_global *global,
 	if (priv->android_control_socket)
 		return priv->sock;
 
+	wpas_ctrl_drain_stop(&priv->drain);
 	eloop_unregister_read_sock(priv->sock);
 	close(priv->sock);
 	priv->sock = -1;
 	res = wpas_global_ctrl_iface_open_sock(global, priv);
 	if (res < 0)
 		return -1;
+	/* Continue with the messages buffered for monitors */
+	wpas_ctrl_drain_schedule(&priv->drain);
 	return priv->sock;
 }
 
@@ -1418,8 +2194,8 @@ void
 wpa_supplicant_global_ctrl_iface_deinit(struct ctrl_iface_global_priv *priv)
 {
 	struct wpa_ctrl_dst *dst, *prev;
-	struct ctrl_iface_msg *msg, *prev_msg;
 
+	wpas_ctrl_drain_stop(&priv->drain);
 	if (priv->sock >= 0) {
 		eloop_unregister_read_sock(priv->sock);
 		close(priv->sock);
@@ -1427,14 +2203,7 @@ wpa_supplicant_global_ctrl_iface_deinit(struct ctrl_iface_global_priv *priv)
 	if (priv->global->params.ctrl_interface)
 		unlink(priv->global->params.ctrl_interface);
 	dl_list_for_each_safe(dst, prev, &priv->ctrl_dst, struct wpa_ctrl_dst,
-			      list) {
-		dl_list_del(&dst->list);
-		os_free(dst);
-	}
-	dl_list_for_each_safe(msg, prev_msg, &priv->msg_queue,
-			      struct ctrl_iface_msg, list) {
-		dl_list_del(&msg->list);
-		os_free(msg);
-	}
+			      list)
+		wpa_ctrl_dst_free(dst);
 	os_free(priv);
 }
@@ -12,6 +12,7 @@
 #define DBUS_COMMON_I_H
 
 #include <dbus/dbus.h>
+#include "utils/list.h"
 
 struct wpa_dbus_property_desc;
 
@@ -25,6 +26,12 @@ struct wpas_dbus_priv {
 #if defined(CONFIG_CTRL_IFACE_DBUS_NEW)
 	struct wpa_dbus_property_desc *all_interface_properties;
 	int globals_start;
+	/* objects with pending PropertiesChanged signals */
+	struct dl_list prop_changed_objs;
+	/* pending bulk BSS signals (struct wpas_dbus_bss_signal) */
+	struct dl_list bss_signals;
+	unsigned int signals_sent;
+	unsigned int signals_suppressed;
 #if defined(CONFIG_AP)
 	int dbus_noc_refcnt;
 #endif /* CONFIG_AP */
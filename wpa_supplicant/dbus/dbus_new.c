@@ -203,6 +203,9 @@ void wpas_dbus_signal_scan_done(struct wpa_supplicant *wpa_s, int success)
 	if (iface == NULL || !wpa_s->dbus_new_path)
 		return;
 
+	/* Report the BSS table changes from the scan before ScanDone */
+	wpas_dbus_flush_bss_signals(iface);
+
 	msg = dbus_message_new_signal(wpa_s->dbus_new_path,
 				      WPAS_DBUS_NEW_IFACE_INTERFACE,
 				      "ScanDone");
@@ -219,16 +222,89 @@ void wpas_dbus_signal_scan_done(struct wpa_supplicant *wpa_s, int success)
 }
 
 
+/*
+ * BSS properties included in BSSAdded/BSSsAdded signals for BSSes that do not
+ * have a registered D-Bus object (dbus_bss_on_demand=1)
+ */
+static const struct wpa_dbus_property_desc wpas_dbus_bss_compact_properties[] =
+{
+	{ "BSSID", WPAS_DBUS_NEW_IFACE_BSS, "ay",
+	  wpas_dbus_getter_bss_bssid,
+	  NULL,
+	  NULL
+	},
+	{ "SSID", WPAS_DBUS_NEW_IFACE_BSS, "ay",
+	  wpas_dbus_getter_bss_ssid,
+	  NULL,
+	  NULL
+	},
+	{ "Frequency", WPAS_DBUS_NEW_IFACE_BSS, "q",
+	  wpas_dbus_getter_bss_frequency,
+	  NULL,
+	  NULL
+	},
+	{ "Signal", WPAS_DBUS_NEW_IFACE_BSS, "n",
+	  wpas_dbus_getter_bss_signal,
+	  NULL,
+	  NULL
+	},
+	{ NULL, NULL, NULL, NULL, NULL, NULL }
+};
+
+
+static int wpas_dbus_bss_registered(struct wpas_dbus_priv *iface,
+				    const char *bss_obj_path)
+{
+	void *obj_desc = NULL;
+
+	return dbus_connection_get_object_path_data(iface->con, bss_obj_path,
+						    &obj_desc) &&
+		obj_desc != NULL;
+}
+
+
+/**
+ * wpas_dbus_get_bss_properties - Put BSS properties into dictionary
+ * @wpa_s: %wpa_supplicant network interface data
+ * @id: unique BSS identifier
+ * @bss_obj_path: BSS object path
+ * @iter: DBus message iter at which to append property dictionary
+ * Returns: TRUE on success, FALSE on failure
+ *
+ * Adds all the properties of the BSS object if it has been registered and
+ * otherwise, only the compact set of properties.
+ */
+static dbus_bool_t wpas_dbus_get_bss_properties(struct wpa_supplicant *wpa_s,
+						unsigned int id,
+						const char *bss_obj_path,
+						DBusMessageIter *iter)
+{
+	struct wpas_dbus_priv *iface = wpa_s->global->dbus;
+	struct bss_handler_args args;
+
+	if (wpas_dbus_bss_registered(iface, bss_obj_path))
+		return wpa_dbus_get_object_properties(iface, bss_obj_path,
+						      WPAS_DBUS_NEW_IFACE_BSS,
+						      iter);
+
+	args.wpa_s = wpa_s;
+	args.id = id;
+	return wpa_dbus_get_properties(wpas_dbus_bss_compact_properties,
+				       WPAS_DBUS_NEW_IFACE_BSS, &args, iter);
+}
+
+
 /**
  * wpas_dbus_signal_bss - Send a BSS related event signal
  * @wpa_s: %wpa_supplicant network interface data
+ * @id: unique BSS identifier
  * @bss_obj_path: BSS object path
  * @sig_name: signal name - BSSAdded or BSSRemoved
  * @properties: Whether to add second argument with object properties
  *
  * Notify listeners about event related with BSS
  */
-static void wpas_dbus_signal_bss(struct wpa_supplicant *wpa_s,
+static void wpas_dbus_signal_bss(struct wpa_supplicant *wpa_s, unsigned int id,
 				 const char *bss_obj_path,
 				 const char *sig_name, int properties)
 {
@@ -252,12 +328,12 @@ static void wpas_dbus_signal_bss(struct wpa_supplicant *wpa_s,
 	if (!dbus_message_iter_append_basic(&iter, DBUS_TYPE_OBJECT_PATH,
 					    &bss_obj_path) ||
 	    (properties &&
-	     !wpa_dbus_get_object_properties(iface, bss_obj_path,
-					     WPAS_DBUS_NEW_IFACE_BSS,
-					     &iter)))
+	     !wpas_dbus_get_bss_properties(wpa_s, id, bss_obj_path, &iter))) {
 		wpa_printf(MSG_ERROR, "dbus: Failed to construct signal");
-	else
+	} else {
 		dbus_connection_send(iface->con, msg, NULL);
+		iface->signals_sent++;
+	}
 	dbus_message_unref(msg);
 }
 
@@ -265,14 +341,16 @@ static void wpas_dbus_signal_bss(struct wpa_supplicant *wpa_s,
 /**
  * wpas_dbus_signal_bss_added - Send a BSS added signal
  * @wpa_s: %wpa_supplicant network interface data
+ * @id: unique BSS identifier
  * @bss_obj_path: new BSS object path
  *
  * Notify listeners about adding new BSS
  */
 static void wpas_dbus_signal_bss_added(struct wpa_supplicant *wpa_s,
+				       unsigned int id,
 				       const char *bss_obj_path)
 {
-	wpas_dbus_signal_bss(wpa_s, bss_obj_path, "BSSAdded", TRUE);
+	wpas_dbus_signal_bss(wpa_s, id, bss_obj_path, "BSSAdded", TRUE);
 }
 
 
@@ -286,7 +364,152 @@ static void wpas_dbus_signal_bss_added(struct wpa_supplicant *wpa_s,
 static void wpas_dbus_signal_bss_removed(struct wpa_supplicant *wpa_s,
 					 const char *bss_obj_path)
 {
-	wpas_dbus_signal_bss(wpa_s, bss_obj_path, "BSSRemoved", FALSE);
+	wpas_dbus_signal_bss(wpa_s, 0, bss_obj_path, "BSSRemoved", FALSE);
+}
+
+
+/*
+ * Bulk BSS signals
+ *
+ * With dbus_bss_bulk_signals=1, the BSSAdded and BSSRemoved signals of an
+ * interface are replaced by BSSsAdded and BSSsRemoved signals that are sent at
+ * the end of the D-Bus signal coalescing window and list all the BSS objects
+ * that were added or removed during it (similarly to the InterfacesAdded and
+ * InterfacesRemoved signals of org.freedesktop.DBus.ObjectManager). A BSS that
+ * is both added and removed within the window is not reported at all.
+ */
+struct wpas_dbus_bss_signal {
+	struct dl_list list;
+	struct wpa_supplicant *wpa_s;
+	unsigned int id;
+	int added;
+};
+
+
+static int wpas_dbus_queue_bss_signal(struct wpa_supplicant *wpa_s,
+				      unsigned int id, int added)
+{
+	struct wpas_dbus_priv *iface = wpa_s->global->dbus;
+	struct wpas_dbus_bss_signal *sig;
+
+	if (!added) {
+		dl_list_for_each(sig, &iface->bss_signals,
+				 struct wpas_dbus_bss_signal, list) {
+			if (sig->wpa_s != wpa_s || sig->id != id)
+				continue;
+			/* Added and removed within the window */
+			dl_list_del(&sig->list);
+			os_free(sig);
+			iface->signals_suppressed += 2;
+			return 0;
+		}
+	}
+
+	if (!wpa_s->conf->dbus_bss_bulk_signals)
+		return -1;
+
+	sig = os_zalloc(sizeof(*sig));
+	if (!sig)
+		return -1;
+	sig->wpa_s = wpa_s;
+	sig->id = id;
+	sig->added = added;
+	dl_list_add_tail(&iface->bss_signals, &sig->list);
+	wpa_dbus_schedule_flush(iface);
+
+	return 0;
+}
+
+
+static void wpas_dbus_send_bss_signals(struct wpas_dbus_priv *iface,
+				       struct wpa_supplicant *wpa_s, int added)
+{
+	struct wpas_dbus_bss_signal *sig, *tmp;
+	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX], *path = bss_obj_path;
+	DBusMessage *msg;
+	DBusMessageIter iter, array_iter, entry_iter;
+	unsigned int id, count = 0;
+	dbus_bool_t ok;
+
+	msg = dbus_message_new_signal(wpa_s->dbus_new_path,
+				      WPAS_DBUS_NEW_IFACE_INTERFACE,
+				      added ? "BSSsAdded" : "BSSsRemoved");
+	ok = msg != NULL;
+	if (ok) {
+		dbus_message_iter_init_append(msg, &iter);
+		ok = dbus_message_iter_open_container(
+			&iter, DBUS_TYPE_ARRAY,
+			added ? "{oa{sv}}" : DBUS_TYPE_OBJECT_PATH_AS_STRING,
+			&array_iter);
+	}
+
+	dl_list_for_each_safe(sig, tmp, &iface->bss_signals,
+			      struct wpas_dbus_bss_signal, list) {
+		if (sig->wpa_s != wpa_s || sig->added != added)
+			continue;
+		id = sig->id;
+		os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
+			    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
+			    wpa_s->dbus_new_path, id);
+		dl_list_del(&sig->list);
+		os_free(sig);
+		count++;
+		if (!ok)
+			continue;
+
+		if (added)
+			ok = dbus_message_iter_open_container(
+				&array_iter, DBUS_TYPE_DICT_ENTRY, NULL,
+				&entry_iter) &&
+				dbus_message_iter_append_basic(
+					&entry_iter, DBUS_TYPE_OBJECT_PATH,
+					&path) &&
+				wpas_dbus_get_bss_properties(
+					wpa_s, id, bss_obj_path,
+					&entry_iter) &&
+				dbus_message_iter_close_container(&array_iter,
+								  &entry_iter);
+		else
+			ok = dbus_message_iter_append_basic(
+				&array_iter, DBUS_TYPE_OBJECT_PATH, &path);
+	}
+
+	if (count == 0) {
+		/* Nothing to report */
+	} else if (!ok || !dbus_message_iter_close_container(&iter,
+							     &array_iter)) {
+		wpa_printf(MSG_ERROR, "dbus: Failed to construct signal");
+	} else {
+		wpa_printf(MSG_DEBUG, "dbus: %s: %s %u BSS object(s)",
+			   wpa_s->ifname, added ? "Added" : "Removed", count);
+		dbus_connection_send(iface->con, msg, NULL);
+		iface->signals_sent++;
+		iface->signals_suppressed += count;
+	}
+
+	if (msg)
+		dbus_message_unref(msg);
+}
+
+
+/**
+ * wpas_dbus_flush_bss_signals - Send pending bulk BSS signals
+ * @iface: dbus priv struct
+ *
+ * Sends BSSsAdded and BSSsRemoved signals for all the BSS additions and
+ * removals that have been queued with dbus_bss_bulk_signals=1.
+ */
+void wpas_dbus_flush_bss_signals(struct wpas_dbus_priv *iface)
+{
+	struct wpas_dbus_bss_signal *sig;
+
+	while ((sig = dl_list_first(&iface->bss_signals,
+				    struct wpas_dbus_bss_signal, list))) {
+		struct wpa_supplicant *wpa_s = sig->wpa_s;
+
+		wpas_dbus_send_bss_signals(iface, wpa_s, 1);
+		wpas_dbus_send_bss_signals(iface, wpa_s, 0);
+	}
 }
 
 
@@ -2077,6 +2300,10 @@ void wpas_dbus_bss_signal_prop_changed(struct wpa_supplicant *wpa_s,
 		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
 		    wpa_s->dbus_new_path, id);
 
+	/* With dbus_bss_on_demand=1, the object may not have been accessed */
+	if (!wpas_dbus_bss_registered(wpa_s->global->dbus, path))
+		return;
+
 	wpa_dbus_mark_property_changed(wpa_s->global->dbus, path,
 				       WPAS_DBUS_NEW_IFACE_BSS, prop);
 }
@@ -2213,6 +2440,11 @@ static const struct wpa_dbus_property_desc wpas_dbus_global_properties[] = {
 	  NULL,
 	  NULL
 	},
+	{ "SignalCounters", WPAS_DBUS_NEW_INTERFACE, "a{sv}",
+	  wpas_dbus_getter_signal_counters,
+	  NULL,
+	  NULL
+	},
 #ifdef CONFIG_WIFI_DISPLAY
 	{ "WFDIEs", WPAS_DBUS_NEW_INTERFACE, "ay",
 	  wpas_dbus_getter_global_wfd_ies,
@@ -2299,6 +2531,9 @@ int wpas_dbus_ctrl_iface_init(struct wpas_dbus_priv *priv)
 	struct wpa_dbus_object_desc *obj_desc;
 	int ret;
 
+	dl_list_init(&priv->prop_changed_objs);
+	dl_list_init(&priv->bss_signals);
+
 	ret = wpa_dbus_ctrl_iface_props_init(priv);
 	if (ret < 0) {
 		wpa_printf(MSG_ERROR,
@@ -2349,6 +2584,7 @@ void wpas_dbus_ctrl_iface_deinit(struct wpas_dbus_priv *priv)
 {
 	if (!priv->dbus_new_initialized)
 		return;
+	wpa_dbus_flush_all_changed_properties(priv);
 	wpa_printf(MSG_DEBUG, "dbus: Unregister D-Bus object '%s'",
 		   WPAS_DBUS_NEW_PATH);
 	dbus_connection_unregister_object_path(priv->con, WPAS_DBUS_NEW_PATH);
@@ -2612,49 +2848,34 @@ int wpas_dbus_unregister_bss(struct wpa_supplicant *wpa_s,
 		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
 		    wpa_s->dbus_new_path, id);
 
-	wpa_printf(MSG_DEBUG, "dbus: Unregister BSS object '%s'",
-		   bss_obj_path);
-	if (wpa_dbus_unregister_object_per_iface(ctrl_iface, bss_obj_path)) {
-		wpa_printf(MSG_ERROR, "dbus: Cannot unregister BSS object %s",
+	/* With dbus_bss_on_demand=1, the object may not have been accessed */
+	if (wpas_dbus_bss_registered(ctrl_iface, bss_obj_path)) {
+		wpa_printf(MSG_DEBUG, "dbus: Unregister BSS object '%s'",
 			   bss_obj_path);
-		return -1;
+		if (wpa_dbus_unregister_object_per_iface(ctrl_iface,
+							 bss_obj_path)) {
+			wpa_printf(MSG_ERROR,
+				   "dbus: Cannot unregister BSS object %s",
+				   bss_obj_path);
+			return -1;
+		}
 	}
 
-	wpas_dbus_signal_bss_removed(wpa_s, bss_obj_path);
+	if (wpas_dbus_queue_bss_signal(wpa_s, id, 0) < 0)
+		wpas_dbus_signal_bss_removed(wpa_s, bss_obj_path);
 	wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
 
 	return 0;
 }
 
 
-/**
- * wpas_dbus_register_bss - Register a scanned BSS with dbus
- * @wpa_s: wpa_supplicant interface structure
- * @bssid: scanned network bssid
- * @id: unique BSS identifier
- * Returns: 0 on success, -1 on failure
- *
- * Registers BSS representing object with dbus
- */
-int wpas_dbus_register_bss(struct wpa_supplicant *wpa_s,
-			   u8 bssid[ETH_ALEN], unsigned int id)
+static int wpas_dbus_register_bss_object(struct wpa_supplicant *wpa_s,
+					 unsigned int id,
+					 const char *bss_obj_path)
 {
-	struct wpas_dbus_priv *ctrl_iface;
 	struct wpa_dbus_object_desc *obj_desc;
-	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX];
 	struct bss_handler_args *arg;
 
-	/* Do nothing if the control interface is not turned on */
-	if (wpa_s == NULL || wpa_s->global == NULL || !wpa_s->dbus_new_path)
-		return 0;
-	ctrl_iface = wpa_s->global->dbus;
-	if (ctrl_iface == NULL)
-		return 0;
-
-	os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
-		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
-		    wpa_s->dbus_new_path, id);
-
 	obj_desc = os_zalloc(sizeof(struct wpa_dbus_object_desc));
 	if (!obj_desc) {
 		wpa_printf(MSG_ERROR,
@@ -2677,17 +2898,15 @@ int wpas_dbus_register_bss(struct wpa_supplicant *wpa_s,
 
 	wpa_printf(MSG_DEBUG, "dbus: Register BSS object '%s'",
 		   bss_obj_path);
-	if (wpa_dbus_register_object_per_iface(ctrl_iface, bss_obj_path,
-					       wpa_s->ifname, obj_desc)) {
+	if (wpa_dbus_register_object_per_iface(wpa_s->global->dbus,
+					       bss_obj_path, wpa_s->ifname,
+					       obj_desc)) {
 		wpa_printf(MSG_ERROR,
 			   "Cannot register BSSID dbus object %s.",
 			   bss_obj_path);
 		goto err;
 	}
 
-	wpas_dbus_signal_bss_added(wpa_s, bss_obj_path);
-	wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
-
 	return 0;
 
 err:
@@ -2696,6 +2915,144 @@ err:
 }
 
 
+/**
+ * wpas_dbus_register_bss - Register a scanned BSS with dbus
+ * @wpa_s: wpa_supplicant interface structure
+ * @bssid: scanned network bssid
+ * @id: unique BSS identifier
+ * Returns: 0 on success, -1 on failure
+ *
+ * Registers BSS representing object with dbus. With dbus_bss_on_demand=1, only
+ * the signals are sent here and the object is registered by
+ * wpas_dbus_bsss_fallback() when a client first accesses it.
+ */
+int wpas_dbus_register_bss(struct wpa_supplicant *wpa_s,
+			   u8 bssid[ETH_ALEN], unsigned int id)
+{
+	struct wpas_dbus_priv *ctrl_iface;
+	char bss_obj_path[WPAS_DBUS_OBJECT_PATH_MAX];
+
+	/* Do nothing if the control interface is not turned on */
+	if (wpa_s == NULL || wpa_s->global == NULL || !wpa_s->dbus_new_path)
+		return 0;
+	ctrl_iface = wpa_s->global->dbus;
+	if (ctrl_iface == NULL)
+		return 0;
+
+	os_snprintf(bss_obj_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART "/%u",
+		    wpa_s->dbus_new_path, id);
+
+	if (!wpa_s->conf->dbus_bss_on_demand &&
+	    wpas_dbus_register_bss_object(wpa_s, id, bss_obj_path) < 0)
+		return -1;
+
+	if (wpas_dbus_queue_bss_signal(wpa_s, id, 1) < 0)
+		wpas_dbus_signal_bss_added(wpa_s, id, bss_obj_path);
+	wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_BSSS);
+
+	return 0;
+}
+
+
+#ifdef CONFIG_CTRL_IFACE_DBUS_INTRO
+static DBusMessage * wpas_dbus_bsss_introspect(DBusMessage *message,
+					       struct wpa_supplicant *wpa_s)
+{
+	DBusMessage *reply;
+	struct wpabuf *xml;
+	struct wpa_bss *bss;
+	const char *intro_str;
+
+	xml = wpabuf_alloc(200 + 30 * dl_list_len(&wpa_s->bss_id));
+	if (!xml)
+		return wpas_dbus_error_no_memory(message);
+
+	wpabuf_put_str(xml, DBUS_INTROSPECT_1_0_XML_DOCTYPE_DECL_NODE);
+	wpabuf_put_str(xml, "<node>");
+	dl_list_for_each(bss, &wpa_s->bss_id, struct wpa_bss, list_id)
+		wpabuf_printf(xml, "<node name=\"%u\"/>", bss->id);
+	wpabuf_put_str(xml, "</node>\n");
+	wpabuf_put_u8(xml, 0);
+
+	reply = dbus_message_new_method_return(message);
+	intro_str = wpabuf_head(xml);
+	if (reply)
+		dbus_message_append_args(reply, DBUS_TYPE_STRING, &intro_str,
+					 DBUS_TYPE_INVALID);
+	wpabuf_free(xml);
+
+	return reply;
+}
+#endif /* CONFIG_CTRL_IFACE_DBUS_INTRO */
+
+
+/**
+ * wpas_dbus_bsss_fallback - Handle messages to unregistered BSS objects
+ * @con: DBus connection
+ * @message: Received message
+ * @user_data: %wpa_supplicant network interface data
+ * Returns: Returns information whether message was handled or not
+ *
+ * Messages to the object paths under <interface>/BSSs that have no registered
+ * object end up here. A BSS object that has not yet been registered (with
+ * dbus_bss_on_demand=1) is registered and the message is then passed to it.
+ * Introspection of <interface>/BSSs itself lists all the BSSes regardless of
+ * whether their objects have been registered.
+ */
+static DBusHandlerResult wpas_dbus_bsss_fallback(DBusConnection *con,
+						 DBusMessage *message,
+						 void *user_data)
+{
+	struct wpa_supplicant *wpa_s = user_data;
+	const char *path, *pos;
+	char *end;
+	size_t len;
+	unsigned long id;
+
+	path = dbus_message_get_path(message);
+	if (!path || !wpa_s->dbus_new_path)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	len = os_strlen(wpa_s->dbus_new_path);
+	if (os_strncmp(path, wpa_s->dbus_new_path, len) != 0 ||
+	    os_strncmp(path + len, "/" WPAS_DBUS_NEW_BSSIDS_PART,
+		       os_strlen("/" WPAS_DBUS_NEW_BSSIDS_PART)) != 0)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	pos = path + len + os_strlen("/" WPAS_DBUS_NEW_BSSIDS_PART);
+
+	if (*pos == '\0') {
+#ifdef CONFIG_CTRL_IFACE_DBUS_INTRO
+		DBusMessage *reply;
+
+		if (!dbus_message_is_method_call(
+			    message, WPA_DBUS_INTROSPECTION_INTERFACE,
+			    WPA_DBUS_INTROSPECTION_METHOD))
+			return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+		reply = wpas_dbus_bsss_introspect(message, wpa_s);
+		if (reply) {
+			dbus_connection_send(con, reply, NULL);
+			dbus_message_unref(reply);
+		}
+		return DBUS_HANDLER_RESULT_HANDLED;
+#else /* CONFIG_CTRL_IFACE_DBUS_INTRO */
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+#endif /* CONFIG_CTRL_IFACE_DBUS_INTRO */
+	}
+
+	if (*pos != '/' || pos[1] < '0' || pos[1] > '9' ||
+	    (pos[1] == '0' && pos[2] != '\0'))
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+	errno = 0;
+	id = strtoul(pos + 1, &end, 10);
+	if (errno || *end != '\0' || id > (unsigned int) -1 ||
+	    !wpa_bss_get_id(wpa_s, id) ||
+	    wpas_dbus_register_bss_object(wpa_s, id, path) < 0)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	return wpa_dbus_dispatch_object_message(con, message, path);
+}
+
+
 static const struct wpa_dbus_method_desc wpas_dbus_interface_methods[] = {
 	{ "Scan", WPAS_DBUS_NEW_IFACE_INTERFACE,
 	  (WPADBusMethodHandler) wpas_dbus_handler_scan,
@@ -3278,6 +3635,18 @@ static const struct wpa_dbus_signal_desc wpas_dbus_interface_signals[] = {
 		  END_ARGS
 	  }
 	},
+	{ "BSSsAdded", WPAS_DBUS_NEW_IFACE_INTERFACE,
+	  {
+		  { "bsss", "a{oa{sv}}", ARG_OUT },
+		  END_ARGS
+	  }
+	},
+	{ "BSSsRemoved", WPAS_DBUS_NEW_IFACE_INTERFACE,
+	  {
+		  { "paths", "ao", ARG_OUT },
+		  END_ARGS
+	  }
+	},
 	{ "BlobAdded", WPAS_DBUS_NEW_IFACE_INTERFACE,
 	  {
 		  { "name", "s", ARG_OUT },
@@ -3609,6 +3978,11 @@ int wpas_dbus_register_interface(struct wpa_supplicant *wpa_s)
 {
 	struct wpa_dbus_object_desc *obj_desc = NULL;
 	struct wpas_dbus_priv *ctrl_iface = wpa_s->global->dbus;
+	DBusObjectPathVTable bsss_vtable = {
+		NULL, &wpas_dbus_bsss_fallback,
+		NULL, NULL, NULL, NULL
+	};
+	char bsss_path[WPAS_DBUS_OBJECT_PATH_MAX];
 	int next;
 
 	/* Do nothing if the control interface is not turned on */
@@ -3642,6 +4016,13 @@ int wpas_dbus_register_interface(struct wpa_supplicant *wpa_s)
 					       wpa_s->ifname, obj_desc))
 		goto err;
 
+	os_snprintf(bsss_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART, wpa_s->dbus_new_path);
+	if (!dbus_connection_register_fallback(ctrl_iface->con, bsss_path,
+					       &bsss_vtable, wpa_s))
+		wpa_printf(MSG_ERROR, "dbus: Could not register fallback %s",
+			   bsss_path);
+
 	wpas_dbus_signal_interface_added(wpa_s);
 
 	return 0;
@@ -3662,6 +4043,7 @@ err:
 int wpas_dbus_unregister_interface(struct wpa_supplicant *wpa_s)
 {
 	struct wpas_dbus_priv *ctrl_iface;
+	char bsss_path[WPAS_DBUS_OBJECT_PATH_MAX];
 
 	/* Do nothing if the control interface is not turned on */
 	if (wpa_s == NULL || wpa_s->global == NULL)
@@ -3681,6 +4063,13 @@ int wpas_dbus_unregister_interface(struct wpa_supplicant *wpa_s)
 	}
 #endif /* CONFIG_AP */
 
+	/* Pending bulk BSS signals refer to wpa_s */
+	wpas_dbus_flush_bss_signals(ctrl_iface);
+
+	os_snprintf(bsss_path, WPAS_DBUS_OBJECT_PATH_MAX,
+		    "%s/" WPAS_DBUS_NEW_BSSIDS_PART, wpa_s->dbus_new_path);
+	dbus_connection_unregister_object_path(ctrl_iface->con, bsss_path);
+
 	if (wpa_dbus_unregister_object_per_iface(ctrl_iface,
 						 wpa_s->dbus_new_path))
 		return -1;
@@ -129,6 +129,7 @@ void wpas_dbus_unsubscribe_noc(struct wpas_dbus_priv *priv);
 
 int wpas_dbus_ctrl_iface_init(struct wpas_dbus_priv *priv);
 void wpas_dbus_ctrl_iface_deinit(struct wpas_dbus_priv *iface);
+void wpas_dbus_flush_bss_signals(struct wpas_dbus_priv *iface);
 
 int wpas_dbus_register_interface(struct wpa_supplicant *wpa_s);
 int wpas_dbus_unregister_interface(struct wpa_supplicant *wpa_s);
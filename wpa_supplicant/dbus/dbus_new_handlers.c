@@ -978,6 +978,42 @@ dbus_bool_t wpas_dbus_getter_global_capabilities(
 }
 
 
+/**
+ * wpas_dbus_getter_signal_counters - Get D-Bus signal counters
+ * @iter: Pointer to incoming dbus message iter
+ * @error: Location to store error on failure
+ * @user_data: Function specific data
+ * Returns: TRUE on success, FALSE on failure
+ *
+ * Getter for "SignalCounters" property. Returns the number of coalesced
+ * PropertiesChanged and BSS signals that have been sent ("Sent") and the
+ * number of signals that were not sent because they were merged into another
+ * signal ("Suppressed").
+ */
+dbus_bool_t wpas_dbus_getter_signal_counters(
+	const struct wpa_dbus_property_desc *property_desc,
+	DBusMessageIter *iter, DBusError *error, void *user_data)
+{
+	struct wpa_global *global = user_data;
+	DBusMessageIter iter_dict, variant_iter;
+
+	if (!dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT,
+					      "a{sv}", &variant_iter) ||
+	    !wpa_dbus_dict_open_write(&variant_iter, &iter_dict) ||
+	    !wpa_dbus_dict_append_uint32(&iter_dict, "Sent",
+					 global->dbus->signals_sent) ||
+	    !wpa_dbus_dict_append_uint32(&iter_dict, "Suppressed",
+					 global->dbus->signals_suppressed) ||
+	    !wpa_dbus_dict_close_write(&variant_iter, &iter_dict) ||
+	    !dbus_message_iter_close_container(iter, &variant_iter)) {
+		dbus_set_error_const(error, DBUS_ERROR_NO_MEMORY, "no memory");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
 static int wpas_dbus_get_scan_type(DBusMessage *message, DBusMessageIter *var,
 				   char **type, DBusMessage **reply)
 {
@@ -374,6 +374,8 @@ static DBusHandlerResult message_handler(DBusConnection *connection,
 					 DBusMessage *message, void *user_data)
 {
 	struct wpa_dbus_object_desc *obj_dsc = user_data;
+	/* obj_dsc may be freed by the handler */
+	struct wpas_dbus_priv *priv = obj_dsc->priv;
 	const char *method;
 	const char *path;
 	const char *msg_interface;
@@ -419,12 +421,37 @@ static DBusHandlerResult message_handler(DBusConnection *connection,
 		dbus_message_unref(reply);
 	}
 
-	wpa_dbus_flush_all_changed_properties(connection);
+	wpa_dbus_flush_all_changed_properties(priv);
 
 	return DBUS_HANDLER_RESULT_HANDLED;
 }
 
 
+/**
+ * wpa_dbus_dispatch_object_message - Handle a message for a registered object
+ * @con: DBus connection
+ * @message: Received message
+ * @path: Path of the registered object to which the message is addressed
+ * Returns: Returns information whether message was handled or not
+ *
+ * This can be used by fallback handlers that register the target object of
+ * a message only when the message is received.
+ */
+DBusHandlerResult wpa_dbus_dispatch_object_message(DBusConnection *con,
+						   DBusMessage *message,
+						   const char *path)
+{
+	struct wpa_dbus_object_desc *obj_desc = NULL;
+
+	if (!dbus_connection_get_object_path_data(con, path,
+						  (void **) &obj_desc) ||
+	    !obj_desc)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	return message_handler(con, message, obj_desc);
+}
+
+
 /**
  * free_dbus_object_desc - Frees object description data structure
  * @connection: DBus connection
@@ -442,6 +469,9 @@ void free_dbus_object_desc(struct wpa_dbus_object_desc *obj_dsc)
 	if (obj_dsc->user_data_free_func)
 		obj_dsc->user_data_free_func(obj_dsc->user_data);
 
+	if (obj_dsc->prop_changed_list.next)
+		dl_list_del(&obj_dsc->prop_changed_list);
+
 	os_free(obj_dsc->path);
 	os_free(obj_dsc->prop_changed_flags);
 	os_free(obj_dsc);
@@ -478,6 +508,7 @@ int wpa_dbus_ctrl_iface_init(struct wpas_dbus_priv *iface,
 	};
 
 	obj_desc->connection = iface->con;
+	obj_desc->priv = iface;
 	obj_desc->path = os_strdup(dbus_path);
 
 	/* Register the message handler for the global dbus interface */
@@ -543,6 +574,7 @@ int wpa_dbus_register_object_per_iface(struct wpas_dbus_priv *ctrl_iface,
 
 	con = ctrl_iface->con;
 	obj_desc->connection = con;
+	obj_desc->priv = ctrl_iface;
 	obj_desc->path = os_strdup(path);
 
 	dbus_error_init(&error);
@@ -565,9 +597,6 @@ int wpa_dbus_register_object_per_iface(struct wpas_dbus_priv *ctrl_iface,
 }
 
 
-static void flush_object_timeout_handler(void *eloop_ctx, void *timeout_ctx);
-
-
 /**
  * wpa_dbus_unregister_object_per_iface - Unregisters DBus object
  * @ctrl_iface: Pointer to dbus private data
@@ -590,8 +619,7 @@ int wpa_dbus_unregister_object_per_iface(
 		return 0;
 	}
 
-	eloop_cancel_timeout(flush_object_timeout_handler, con, obj_desc);
-
+	/* Pending property changes are dropped when obj_desc is freed */
 	if (!dbus_connection_unregister_object_path(con, path))
 		return -1;
 
@@ -680,6 +708,7 @@ static void do_send_prop_changed_signal(
 			   __func__);
 	} else {
 		dbus_connection_send(con, msg, NULL);
+		obj_dsc->priv->signals_sent++;
 	}
 
 	dbus_message_unref(msg);
@@ -707,6 +736,7 @@ static void do_send_deprecated_prop_changed_signal(
 			   __func__);
 	} else {
 		dbus_connection_send(con, msg, NULL);
+		obj_dsc->priv->signals_sent++;
 	}
 
 	dbus_message_unref(msg);
@@ -736,51 +766,55 @@ static void send_prop_changed_signal(
 }
 
 
-static void flush_object_timeout_handler(void *eloop_ctx, void *timeout_ctx)
+static void flush_object(DBusConnection *con,
+			 struct wpa_dbus_object_desc *obj_desc)
 {
-	DBusConnection *con = eloop_ctx;
-	struct wpa_dbus_object_desc *obj_desc = timeout_ctx;
+	const struct wpa_dbus_property_desc *dsc;
+	int i;
 
-	wpa_printf(MSG_DEBUG,
-		   "dbus: %s: Timeout - sending changed properties of object %s",
-		   __func__, obj_desc->path);
-	wpa_dbus_flush_object_changed_properties(con, obj_desc->path);
+	if (obj_desc->prop_changed_list.next)
+		dl_list_del(&obj_desc->prop_changed_list);
+
+	for (dsc = obj_desc->properties, i = 0; dsc && dsc->dbus_property;
+	     dsc++, i++) {
+		if (obj_desc->prop_changed_flags == NULL ||
+		    !obj_desc->prop_changed_flags[i])
+			continue;
+		send_prop_changed_signal(con, obj_desc->path,
+					 dsc->dbus_interface, obj_desc);
+	}
 }
 
 
-static void recursive_flush_changed_properties(DBusConnection *con,
-					       const char *path)
+static void flush_timeout_handler(void *eloop_ctx, void *timeout_ctx)
 {
-	char **objects = NULL;
-	char subobj_path[WPAS_DBUS_OBJECT_PATH_MAX];
-	int i;
-
-	wpa_dbus_flush_object_changed_properties(con, path);
-
-	if (!dbus_connection_list_registered(con, path, &objects))
-		goto out;
-
-	for (i = 0; objects[i]; i++) {
-		os_snprintf(subobj_path, WPAS_DBUS_OBJECT_PATH_MAX,
-			    "%s/%s", path, objects[i]);
-		recursive_flush_changed_properties(con, subobj_path);
-	}
+	struct wpas_dbus_priv *iface = eloop_ctx;
 
-out:
-	dbus_free_string_array(objects);
+	wpa_printf(MSG_DEBUG,
+		   "dbus: %s: Timeout - sending changed properties of %u object(s)",
+		   __func__, dl_list_len(&iface->prop_changed_objs));
+	wpa_dbus_flush_all_changed_properties(iface);
 }
 
 
 /**
  * wpa_dbus_flush_all_changed_properties - Send all PropertiesChanged signals
- * @con: DBus connection
+ * @iface: dbus priv struct
  *
- * Traverses through all registered objects and sends PropertiesChanged for
- * each properties.
+ * Sends the pending bulk BSS signals and PropertiesChanged signals for all
+ * objects that have properties marked as changed.
  */
-void wpa_dbus_flush_all_changed_properties(DBusConnection *con)
+void wpa_dbus_flush_all_changed_properties(struct wpas_dbus_priv *iface)
 {
-	recursive_flush_changed_properties(con, WPAS_DBUS_NEW_PATH);
+	struct wpa_dbus_object_desc *obj_desc;
+
+	eloop_cancel_timeout(flush_timeout_handler, iface, NULL);
+	wpas_dbus_flush_bss_signals(iface);
+
+	while ((obj_desc = dl_list_first(&iface->prop_changed_objs,
+					 struct wpa_dbus_object_desc,
+					 prop_changed_list)))
+		flush_object(iface->con, obj_desc);
 }
 
 
@@ -795,38 +829,51 @@ void wpa_dbus_flush_all_changed_properties(DBusConnection *con)
  *
  * You need to call this function after wpa_dbus_mark_property_changed()
  * if you want to send PropertiesChanged signal immediately (i.e., without
- * waiting timeout to expire). PropertiesChanged signal for an object is sent
- * automatically short time after first marking property as changed. All
- * PropertiesChanged signals are sent automatically after responding on DBus
- * message, so if you marked a property changed as a result of DBus call
+ * waiting timeout to expire). PropertiesChanged signals for all objects are
+ * sent automatically short time after first marking a property as changed.
+ * All PropertiesChanged signals are sent automatically after responding on
+ * DBus message, so if you marked a property changed as a result of DBus call
  * (e.g., param setter), you usually do not need to call this function.
  */
 void wpa_dbus_flush_object_changed_properties(DBusConnection *con,
 					      const char *path)
 {
 	struct wpa_dbus_object_desc *obj_desc = NULL;
-	const struct wpa_dbus_property_desc *dsc;
-	int i;
 
 	dbus_connection_get_object_path_data(con, path, (void **) &obj_desc);
 	if (!obj_desc)
 		return;
-	eloop_cancel_timeout(flush_object_timeout_handler, con, obj_desc);
 
-	for (dsc = obj_desc->properties, i = 0; dsc && dsc->dbus_property;
-	     dsc++, i++) {
-		if (obj_desc->prop_changed_flags == NULL ||
-		    !obj_desc->prop_changed_flags[i])
-			continue;
-		send_prop_changed_signal(con, path, dsc->dbus_interface,
-					 obj_desc);
-	}
+	/* Announce new BSS objects before any changes that refer to them */
+	if (obj_desc->priv)
+		wpas_dbus_flush_bss_signals(obj_desc->priv);
+	flush_object(con, obj_desc);
 }
 
 
+/*
+ * Property changes and BSS additions/removals are collected for all objects
+ * during this window (in microseconds) after the first change and then sent
+ * together, so that, e.g., the BSS table updates after a scan result in a
+ * single pass over the changed objects.
+ */
 #define WPA_DBUS_SEND_PROP_CHANGED_TIMEOUT 5000
 
 
+/**
+ * wpa_dbus_schedule_flush - Schedule sending of pending signals
+ * @iface: dbus priv struct
+ *
+ * Starts the coalescing window unless it is already running.
+ */
+void wpa_dbus_schedule_flush(struct wpas_dbus_priv *iface)
+{
+	if (!eloop_is_timeout_registered(flush_timeout_handler, iface, NULL))
+		eloop_register_timeout(0, WPA_DBUS_SEND_PROP_CHANGED_TIMEOUT,
+				       flush_timeout_handler, iface, NULL);
+}
+
+
 /**
  * wpa_dbus_mark_property_changed - Mark a property as changed and
  * @iface: dbus priv struct
@@ -863,8 +910,12 @@ void wpa_dbus_mark_property_changed(struct wpas_dbus_priv *iface,
 	for (dsc = obj_desc->properties; dsc && dsc->dbus_property; dsc++, i++)
 		if (os_strcmp(property, dsc->dbus_property) == 0 &&
 		    os_strcmp(interface, dsc->dbus_interface) == 0) {
-			if (obj_desc->prop_changed_flags)
+			if (obj_desc->prop_changed_flags) {
+				/* Merged into an already pending signal */
+				if (obj_desc->prop_changed_flags[i])
+					iface->signals_suppressed++;
 				obj_desc->prop_changed_flags[i] = 1;
+			}
 			break;
 		}
 
@@ -875,12 +926,10 @@ void wpa_dbus_mark_property_changed(struct wpas_dbus_priv *iface,
 		return;
 	}
 
-	if (!eloop_is_timeout_registered(flush_object_timeout_handler,
-					 iface->con, obj_desc)) {
-		eloop_register_timeout(0, WPA_DBUS_SEND_PROP_CHANGED_TIMEOUT,
-				       flush_object_timeout_handler,
-				       iface->con, obj_desc);
-	}
+	if (!obj_desc->prop_changed_list.next)
+		dl_list_add_tail(&iface->prop_changed_objs,
+				 &obj_desc->prop_changed_list);
+	wpa_dbus_schedule_flush(iface);
 }
 
 
@@ -902,8 +951,6 @@ dbus_bool_t wpa_dbus_get_object_properties(struct wpas_dbus_priv *iface,
 					   DBusMessageIter *iter)
 {
 	struct wpa_dbus_object_desc *obj_desc = NULL;
-	DBusMessageIter dict_iter;
-	DBusError error;
 
 	dbus_connection_get_object_path_data(iface->con, path,
 					     (void **) &obj_desc);
@@ -914,6 +961,28 @@ dbus_bool_t wpa_dbus_get_object_properties(struct wpas_dbus_priv *iface,
 		return FALSE;
 	}
 
+	return wpa_dbus_get_properties(obj_desc->properties, interface,
+				       obj_desc->user_data, iter);
+}
+
+
+/**
+ * wpa_dbus_get_properties - Put properties into dictionary
+ * @props: Property descriptions
+ * @interface: interface name which properties will be obtained
+ * @user_data: Argument passed to the property getters
+ * @iter: DBus message iter at which to append property dictionary.
+ *
+ * Same as wpa_dbus_get_object_properties(), but does not require the
+ * properties to belong to a registered object.
+ */
+dbus_bool_t wpa_dbus_get_properties(const struct wpa_dbus_property_desc *props,
+				    const char *interface, void *user_data,
+				    DBusMessageIter *iter)
+{
+	DBusMessageIter dict_iter;
+	DBusError error;
+
 	if (!wpa_dbus_dict_open_write(iter, &dict_iter)) {
 		wpa_printf(MSG_ERROR, "dbus: %s: failed to open message dict",
 			   __func__);
@@ -921,8 +990,7 @@ dbus_bool_t wpa_dbus_get_object_properties(struct wpas_dbus_priv *iface,
 	}
 
 	dbus_error_init(&error);
-	if (!fill_dict_with_properties(&dict_iter, obj_desc->properties,
-				       interface, obj_desc->user_data,
+	if (!fill_dict_with_properties(&dict_iter, props, interface, user_data,
 				       &error)) {
 		wpa_printf(MSG_ERROR,
 			   "dbus: %s: failed to get object properties: (%s) %s",
@@ -11,6 +11,7 @@
 #define WPA_DBUS_CTRL_H
 
 #include <dbus/dbus.h>
+#include "utils/list.h"
 
 typedef DBusMessage * (*WPADBusMethodHandler)(DBusMessage *message,
 					      void *user_data);
@@ -26,6 +27,7 @@ dbus_bool_t f(const struct wpa_dbus_property_desc *property_desc, \
 
 struct wpa_dbus_object_desc {
 	DBusConnection *connection;
+	struct wpas_dbus_priv *priv;
 	char *path;
 
 	/* list of methods, properties and signals registered with object */
@@ -35,6 +37,8 @@ struct wpa_dbus_object_desc {
 
 	/* property changed flags */
 	u8 *prop_changed_flags;
+	/* entry in wpas_dbus_priv::prop_changed_objs while changes are pending */
+	struct dl_list prop_changed_list;
 
 	/* argument for method handlers and properties
 	 * getter and setter functions */
@@ -130,8 +134,18 @@ dbus_bool_t wpa_dbus_get_object_properties(struct wpas_dbus_priv *iface,
 					   const char *interface,
 					   DBusMessageIter *iter);
 
+dbus_bool_t wpa_dbus_get_properties(const struct wpa_dbus_property_desc *props,
+				    const char *interface, void *user_data,
+				    DBusMessageIter *iter);
 
-void wpa_dbus_flush_all_changed_properties(DBusConnection *con);
+DBusHandlerResult wpa_dbus_dispatch_object_message(DBusConnection *con,
+						   DBusMessage *message,
+						   const char *path);
+
+
+void wpa_dbus_flush_all_changed_properties(struct wpas_dbus_priv *iface);
+
+void wpa_dbus_schedule_flush(struct wpas_dbus_priv *iface);
 
 void wpa_dbus_flush_object_changed_properties(DBusConnection *con,
 					      const char *path);
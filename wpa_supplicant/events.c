@@ -12,6 +12,7 @@
 #include "eapol_supp/eapol_supp_sm.h"
 #include "rsn_supp/wpa.h"
 #include "eloop.h"
+#include "trace_ring.h"
 #include "config.h"
 #include "l2_packet/l2_packet.h"
 #include "wpa_supplicant_i.h"
@@ -501,11 +502,45 @@ static int wpa_supplicant_match_privacy(struct wpa_bss *bss,
 }
 
 
+/*
+ * Parsed IEs of a BSS for network selection. This is stored in
+ * struct wpa_bss::sel_info and the BSS table drops it when the IEs of the BSS
+ * change, so only new and changed BSSes need to be parsed again after a scan.
+ */
+struct wpa_bss_sel_info {
+	int rsn_ie; /* offset of RSN IE from the start of the IEs or -1 */
+	int wpa_ie; /* offset of WPA IE from the start of the IEs or -1 */
+	struct wpa_ie_data rsn_data;
+	struct wpa_ie_data wpa_data;
+	int rsn_parse_failed;
+	int wpa_parse_failed;
+	int osen;
+	int wps;
+};
+
+
+/*
+ * Network independent information about a BSS that is needed for matching it
+ * against the configured networks. This is collected once per BSS in network
+ * selection instead of repeating it for each network.
+ */
+struct wpa_bss_match_info {
+	struct wpa_blacklist *e;
+	const struct wpa_bss_sel_info *sel;
+	struct wpa_bss_sel_info sel_buf; /* used if sel cannot be allocated */
+	const u8 *rsn_ie;
+	const u8 *wpa_ie;
+	int osen;
+	int wpa; /* WPA or RSN IE included */
+};
+
+
 static int wpa_supplicant_ssid_bss_match(struct wpa_supplicant *wpa_s,
 					 struct wpa_ssid *ssid,
-					 struct wpa_bss *bss)
+					 struct wpa_bss *bss,
+					 const struct wpa_bss_match_info *info)
 {
-	struct wpa_ie_data ie;
+	const struct wpa_ie_data *ie;
 	int proto_match = 0;
 	const u8 *rsn_ie, *wpa_ie;
 	int ret;
@@ -521,50 +556,51 @@ static int wpa_supplicant_ssid_bss_match(struct wpa_supplicant *wpa_s,
 		  ssid->wep_key_len[ssid->wep_tx_keyidx] > 0) ||
 		 (ssid->key_mgmt & WPA_KEY_MGMT_IEEE8021X_NO_WPA));
 
-	rsn_ie = wpa_bss_get_ie(bss, WLAN_EID_RSN);
+	rsn_ie = info->rsn_ie;
 	while ((ssid->proto & WPA_PROTO_RSN) && rsn_ie) {
 		proto_match++;
 
-		if (wpa_parse_wpa_ie(rsn_ie, 2 + rsn_ie[1], &ie)) {
+		if (info->sel->rsn_parse_failed) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip RSN IE - parse "
 				"failed");
 			break;
 		}
+		ie = &info->sel->rsn_data;
 
 		if (wep_ok &&
-		    (ie.group_cipher & (WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104)))
+		    (ie->group_cipher & (WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104)))
 		{
 			wpa_dbg(wpa_s, MSG_DEBUG, "   selected based on TSN "
 				"in RSN IE");
 			return 1;
 		}
 
-		if (!(ie.proto & ssid->proto)) {
+		if (!(ie->proto & ssid->proto)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip RSN IE - proto "
 				"mismatch");
 			break;
 		}
 
-		if (!(ie.pairwise_cipher & ssid->pairwise_cipher)) {
+		if (!(ie->pairwise_cipher & ssid->pairwise_cipher)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip RSN IE - PTK "
 				"cipher mismatch");
 			break;
 		}
 
-		if (!(ie.group_cipher & ssid->group_cipher)) {
+		if (!(ie->group_cipher & ssid->group_cipher)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip RSN IE - GTK "
 				"cipher mismatch");
 			break;
 		}
 
-		if (!(ie.key_mgmt & ssid->key_mgmt)) {
+		if (!(ie->key_mgmt & ssid->key_mgmt)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip RSN IE - key mgmt "
 				"mismatch");
 			break;
 		}
 
 #ifdef CONFIG_IEEE80211W
-		if (!(ie.capabilities & WPA_CAPABILITY_MFPC) &&
+		if (!(ie->capabilities & WPA_CAPABILITY_MFPC) &&
 		    wpas_get_ssid_pmf(wpa_s, ssid) ==
 		    MGMT_FRAME_PROTECTION_REQUIRED) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip RSN IE - no mgmt "
@@ -572,7 +608,7 @@ static int wpa_supplicant_ssid_bss_match(struct wpa_supplicant *wpa_s,
 			break;
 		}
 #endif /* CONFIG_IEEE80211W */
-		if ((ie.capabilities & WPA_CAPABILITY_MFPR) &&
+		if ((ie->capabilities & WPA_CAPABILITY_MFPR) &&
 		    wpas_get_ssid_pmf(wpa_s, ssid) ==
 		    NO_MGMT_FRAME_PROTECTION) {
 			wpa_dbg(wpa_s, MSG_DEBUG,
@@ -584,43 +620,44 @@ static int wpa_supplicant_ssid_bss_match(struct wpa_supplicant *wpa_s,
 		return 1;
 	}
 
-	wpa_ie = wpa_bss_get_vendor_ie(bss, WPA_IE_VENDOR_TYPE);
+	wpa_ie = info->wpa_ie;
 	while ((ssid->proto & WPA_PROTO_WPA) && wpa_ie) {
 		proto_match++;
 
-		if (wpa_parse_wpa_ie(wpa_ie, 2 + wpa_ie[1], &ie)) {
+		if (info->sel->wpa_parse_failed) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip WPA IE - parse "
 				"failed");
 			break;
 		}
+		ie = &info->sel->wpa_data;
 
 		if (wep_ok &&
-		    (ie.group_cipher & (WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104)))
+		    (ie->group_cipher & (WPA_CIPHER_WEP40 | WPA_CIPHER_WEP104)))
 		{
 			wpa_dbg(wpa_s, MSG_DEBUG, "   selected based on TSN "
 				"in WPA IE");
 			return 1;
 		}
 
-		if (!(ie.proto & ssid->proto)) {
+		if (!(ie->proto & ssid->proto)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip WPA IE - proto "
 				"mismatch");
 			break;
 		}
 
-		if (!(ie.pairwise_cipher & ssid->pairwise_cipher)) {
+		if (!(ie->pairwise_cipher & ssid->pairwise_cipher)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip WPA IE - PTK "
 				"cipher mismatch");
 			break;
 		}
 
-		if (!(ie.group_cipher & ssid->group_cipher)) {
+		if (!(ie->group_cipher & ssid->group_cipher)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip WPA IE - GTK "
 				"cipher mismatch");
 			break;
 		}
 
-		if (!(ie.key_mgmt & ssid->key_mgmt)) {
+		if (!(ie->key_mgmt & ssid->key_mgmt)) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip WPA IE - key mgmt "
 				"mismatch");
 			break;
@@ -642,8 +679,7 @@ static int wpa_supplicant_ssid_bss_match(struct wpa_supplicant *wpa_s,
 		return 0;
 	}
 
-	if ((ssid->key_mgmt & WPA_KEY_MGMT_OSEN) &&
-	    wpa_bss_get_vendor_ie(bss, OSEN_IE_VENDOR_TYPE)) {
+	if ((ssid->key_mgmt & WPA_KEY_MGMT_OSEN) && info->osen) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "   allow in OSEN");
 		return 1;
 	}
@@ -821,38 +857,76 @@ static int addr_in_list(const u8 *addr, const u8 *list, size_t num)
 }
 
 
-static struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
-					    int i, struct wpa_bss *bss,
-					    struct wpa_ssid *group,
-					    int only_first_ssid)
+/* Parse the network independent security related IEs of a BSS */
+static void wpa_bss_sel_info_parse(struct wpa_bss *bss,
+				   struct wpa_bss_sel_info *sel)
 {
-	u8 wpa_ie_len, rsn_ie_len;
-	int wpa;
-	struct wpa_blacklist *e;
+	const u8 *ies = (const u8 *) (bss + 1);
 	const u8 *ie;
-	struct wpa_ssid *ssid;
-	int osen;
 
-	ie = wpa_bss_get_vendor_ie(bss, WPA_IE_VENDOR_TYPE);
-	wpa_ie_len = ie ? ie[1] : 0;
+	os_memset(sel, 0, sizeof(*sel));
 
 	ie = wpa_bss_get_ie(bss, WLAN_EID_RSN);
-	rsn_ie_len = ie ? ie[1] : 0;
+	sel->rsn_ie = ie ? ie - ies : -1;
+	if (ie && wpa_parse_wpa_ie(ie, 2 + ie[1], &sel->rsn_data))
+		sel->rsn_parse_failed = 1;
+
+	ie = wpa_bss_get_vendor_ie(bss, WPA_IE_VENDOR_TYPE);
+	sel->wpa_ie = ie ? ie - ies : -1;
+	if (ie && wpa_parse_wpa_ie(ie, 2 + ie[1], &sel->wpa_data))
+		sel->wpa_parse_failed = 1;
+
+	/* PMKID pointers would point to the IEs that may get reallocated */
+	sel->rsn_data.pmkid = sel->wpa_data.pmkid = NULL;
+	sel->rsn_data.num_pmkid = sel->wpa_data.num_pmkid = 0;
+
+	sel->osen = wpa_bss_get_vendor_ie(bss, OSEN_IE_VENDOR_TYPE) != NULL;
+	sel->wps = wpa_bss_get_vendor_ie(bss, WPS_IE_VENDOR_TYPE) != NULL;
+}
+
+
+/*
+ * Collect the network independent information about a BSS for network
+ * selection. Returns 0 if the BSS can be considered for selection or -1 if it
+ * should be skipped regardless of the network.
+ */
+static int wpa_bss_match_info_get(struct wpa_supplicant *wpa_s, int i,
+				  struct wpa_bss *bss,
+				  struct wpa_bss_match_info *info)
+{
+	const u8 *ies = (const u8 *) (bss + 1);
+	struct wpa_blacklist *e;
 
-	ie = wpa_bss_get_vendor_ie(bss, OSEN_IE_VENDOR_TYPE);
-	osen = ie != NULL;
+	os_memset(info, 0, sizeof(*info));
+	if (!bss->sel_info) {
+		bss->sel_info = os_malloc(sizeof(struct wpa_bss_sel_info));
+		if (bss->sel_info)
+			wpa_bss_sel_info_parse(bss, bss->sel_info);
+	}
+	if (bss->sel_info) {
+		info->sel = bss->sel_info;
+	} else {
+		wpa_bss_sel_info_parse(bss, &info->sel_buf);
+		info->sel = &info->sel_buf;
+	}
+	info->rsn_ie = info->sel->rsn_ie >= 0 ? ies + info->sel->rsn_ie : NULL;
+	info->wpa_ie = info->sel->wpa_ie >= 0 ? ies + info->sel->wpa_ie : NULL;
+	info->osen = info->sel->osen;
 
 	wpa_dbg(wpa_s, MSG_DEBUG, "%d: " MACSTR " ssid='%s' "
 		"wpa_ie_len=%u rsn_ie_len=%u caps=0x%x level=%d freq=%d %s%s%s",
 		i, MAC2STR(bss->bssid), wpa_ssid_txt(bss->ssid, bss->ssid_len),
-		wpa_ie_len, rsn_ie_len, bss->caps, bss->level, bss->freq,
-		wpa_bss_get_vendor_ie(bss, WPS_IE_VENDOR_TYPE) ? " wps" : "",
+		info->wpa_ie ? info->wpa_ie[1] : 0,
+		info->rsn_ie ? info->rsn_ie[1] : 0,
+		bss->caps, bss->level, bss->freq,
+		info->sel->wps ? " wps" : "",
 		(wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE) ||
 		 wpa_bss_get_vendor_ie_beacon(bss, P2P_IE_VENDOR_TYPE)) ?
 		" p2p" : "",
-		osen ? " osen=1" : "");
+		info->osen ? " osen=1" : "");
 
 	e = wpa_blacklist_get(wpa_s, bss->bssid);
+	info->e = e;
 	if (e) {
 		int limit = 1;
 		if (wpa_supplicant_enabled_networks(wpa_s) == 1) {
@@ -869,203 +943,233 @@ static struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
 		if (e->count > limit) {
 			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - blacklisted "
 				"(count=%d limit=%d)", e->count, limit);
-			return NULL;
+			return -1;
 		}
 	}
 
 	if (bss->ssid_len == 0) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - SSID not known");
-		return NULL;
+		return -1;
 	}
 
 	if (disallowed_bssid(wpa_s, bss->bssid)) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - BSSID disallowed");
-		return NULL;
+		return -1;
 	}
 
 	if (disallowed_ssid(wpa_s, bss->ssid, bss->ssid_len)) {
 		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - SSID disallowed");
-		return NULL;
+		return -1;
 	}
 
-	wpa = wpa_ie_len > 0 || rsn_ie_len > 0;
+	info->wpa = (info->wpa_ie && info->wpa_ie[1]) ||
+		(info->rsn_ie && info->rsn_ie[1]);
 
-	for (ssid = group; ssid; ssid = only_first_ssid ? NULL : ssid->pnext) {
-		int check_ssid = wpa ? 1 : (ssid->ssid_len != 0);
-		int res;
+	return 0;
+}
 
-		if (wpas_network_disabled(wpa_s, ssid)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - disabled");
-			continue;
-		}
 
-		res = wpas_temp_disabled(wpa_s, ssid);
-		if (res > 0) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - disabled "
-				"temporarily for %d second(s)", res);
-			continue;
-		}
+static int wpa_scan_res_match_ssid(struct wpa_supplicant *wpa_s,
+				   struct wpa_ssid *ssid, struct wpa_bss *bss,
+				   const struct wpa_bss_match_info *info)
+{
+	int wpa = info->wpa;
+	int osen = info->osen;
+	int check_ssid = wpa ? 1 : (ssid->ssid_len != 0);
+	int res;
+#ifdef CONFIG_P2P
+	const u8 *ie;
+#endif /* CONFIG_P2P */
+
+	if (wpas_network_disabled(wpa_s, ssid)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - disabled");
+		return 0;
+	}
+
+	res = wpas_temp_disabled(wpa_s, ssid);
+	if (res > 0) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - disabled "
+			"temporarily for %d second(s)", res);
+		return 0;
+	}
 
 #ifdef CONFIG_WPS
-		if ((ssid->key_mgmt & WPA_KEY_MGMT_WPS) && e && e->count > 0) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - blacklisted "
-				"(WPS)");
-			continue;
-		}
+	if ((ssid->key_mgmt & WPA_KEY_MGMT_WPS) && info->e &&
+	    info->e->count > 0) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - blacklisted "
+			"(WPS)");
+		return 0;
+	}
 
-		if (wpa && ssid->ssid_len == 0 &&
+	if (wpa && ssid->ssid_len == 0 &&
+	    wpas_wps_ssid_wildcard_ok(wpa_s, ssid, bss))
+		check_ssid = 0;
+
+	if (!wpa && (ssid->key_mgmt & WPA_KEY_MGMT_WPS)) {
+		/* Only allow wildcard SSID match if an AP
+		 * advertises active WPS operation that matches
+		 * with our mode. */
+		check_ssid = 1;
+		if (ssid->ssid_len == 0 &&
 		    wpas_wps_ssid_wildcard_ok(wpa_s, ssid, bss))
 			check_ssid = 0;
-
-		if (!wpa && (ssid->key_mgmt & WPA_KEY_MGMT_WPS)) {
-			/* Only allow wildcard SSID match if an AP
-			 * advertises active WPS operation that matches
-			 * with our mode. */
-			check_ssid = 1;
-			if (ssid->ssid_len == 0 &&
-			    wpas_wps_ssid_wildcard_ok(wpa_s, ssid, bss))
-				check_ssid = 0;
-		}
+	}
 #endif /* CONFIG_WPS */
 
-		if (ssid->bssid_set && ssid->ssid_len == 0 &&
-		    os_memcmp(bss->bssid, ssid->bssid, ETH_ALEN) == 0)
-			check_ssid = 0;
+	if (ssid->bssid_set && ssid->ssid_len == 0 &&
+	    os_memcmp(bss->bssid, ssid->bssid, ETH_ALEN) == 0)
+		check_ssid = 0;
 
-		if (check_ssid &&
-		    (bss->ssid_len != ssid->ssid_len ||
-		     os_memcmp(bss->ssid, ssid->ssid, bss->ssid_len) != 0)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - SSID mismatch");
-			continue;
-		}
+	if (check_ssid &&
+	    (bss->ssid_len != ssid->ssid_len ||
+	     os_memcmp(bss->ssid, ssid->ssid, bss->ssid_len) != 0)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - SSID mismatch");
+		return 0;
+	}
 
-		if (ssid->bssid_set &&
-		    os_memcmp(bss->bssid, ssid->bssid, ETH_ALEN) != 0) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - BSSID mismatch");
-			continue;
-		}
+	if (ssid->bssid_set &&
+	    os_memcmp(bss->bssid, ssid->bssid, ETH_ALEN) != 0) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - BSSID mismatch");
+		return 0;
+	}
 
-		/* check blacklist */
-		if (ssid->num_bssid_blacklist &&
-		    addr_in_list(bss->bssid, ssid->bssid_blacklist,
-				 ssid->num_bssid_blacklist)) {
-			wpa_dbg(wpa_s, MSG_DEBUG,
-				"   skip - BSSID blacklisted");
-			continue;
-		}
+	/* check blacklist */
+	if (ssid->num_bssid_blacklist &&
+	    addr_in_list(bss->bssid, ssid->bssid_blacklist,
+			 ssid->num_bssid_blacklist)) {
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"   skip - BSSID blacklisted");
+		return 0;
+	}
 
-		/* if there is a whitelist, only accept those APs */
-		if (ssid->num_bssid_whitelist &&
-		    !addr_in_list(bss->bssid, ssid->bssid_whitelist,
-				  ssid->num_bssid_whitelist)) {
-			wpa_dbg(wpa_s, MSG_DEBUG,
-				"   skip - BSSID not in whitelist");
-			continue;
-		}
+	/* if there is a whitelist, only accept those APs */
+	if (ssid->num_bssid_whitelist &&
+	    !addr_in_list(bss->bssid, ssid->bssid_whitelist,
+			  ssid->num_bssid_whitelist)) {
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"   skip - BSSID not in whitelist");
+		return 0;
+	}
 
-		if (!wpa_supplicant_ssid_bss_match(wpa_s, ssid, bss))
-			continue;
+	if (!wpa_supplicant_ssid_bss_match(wpa_s, ssid, bss, info))
+		return 0;
 
-		if (!osen && !wpa &&
-		    !(ssid->key_mgmt & WPA_KEY_MGMT_NONE) &&
-		    !(ssid->key_mgmt & WPA_KEY_MGMT_WPS) &&
-		    !(ssid->key_mgmt & WPA_KEY_MGMT_IEEE8021X_NO_WPA)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - non-WPA network "
-				"not allowed");
-			continue;
-		}
+	if (!osen && !wpa &&
+	    !(ssid->key_mgmt & WPA_KEY_MGMT_NONE) &&
+	    !(ssid->key_mgmt & WPA_KEY_MGMT_WPS) &&
+	    !(ssid->key_mgmt & WPA_KEY_MGMT_IEEE8021X_NO_WPA)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - non-WPA network "
+			"not allowed");
+		return 0;
+	}
 
-		if (wpa && !wpa_key_mgmt_wpa(ssid->key_mgmt) &&
-		    has_wep_key(ssid)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - ignore WPA/WPA2 AP for WEP network block");
-			continue;
-		}
+	if (wpa && !wpa_key_mgmt_wpa(ssid->key_mgmt) &&
+	    has_wep_key(ssid)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - ignore WPA/WPA2 AP for WEP network block");
+		return 0;
+	}
 
-		if ((ssid->key_mgmt & WPA_KEY_MGMT_OSEN) && !osen) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - non-OSEN network "
-				"not allowed");
-			continue;
-		}
+	if ((ssid->key_mgmt & WPA_KEY_MGMT_OSEN) && !osen) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - non-OSEN network "
+			"not allowed");
+		return 0;
+	}
 
-		if (!wpa_supplicant_match_privacy(bss, ssid)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - privacy "
-				"mismatch");
-			continue;
-		}
+	if (!wpa_supplicant_match_privacy(bss, ssid)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - privacy "
+			"mismatch");
+		return 0;
+	}
 
-		if (!bss_is_ess(bss)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - not ESS network");
-			continue;
-		}
+	if (!bss_is_ess(bss)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - not ESS network");
+		return 0;
+	}
 
-		if (!freq_allowed(ssid->freq_list, bss->freq)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - frequency not "
-				"allowed");
-			continue;
-		}
+	if (!freq_allowed(ssid->freq_list, bss->freq)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - frequency not "
+			"allowed");
+		return 0;
+	}
 
-		if (!rate_match(wpa_s, bss)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - rate sets do "
-				"not match");
-			continue;
-		}
+	if (!rate_match(wpa_s, bss)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - rate sets do "
+			"not match");
+		return 0;
+	}
 
 #ifdef CONFIG_P2P
-		if (ssid->p2p_group &&
-		    !wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE) &&
-		    !wpa_bss_get_vendor_ie_beacon(bss, P2P_IE_VENDOR_TYPE)) {
-			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - no P2P IE seen");
-			continue;
-		}
+	if (ssid->p2p_group &&
+	    !wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE) &&
+	    !wpa_bss_get_vendor_ie_beacon(bss, P2P_IE_VENDOR_TYPE)) {
+		wpa_dbg(wpa_s, MSG_DEBUG, "   skip - no P2P IE seen");
+		return 0;
+	}
 
-		if (!is_zero_ether_addr(ssid->go_p2p_dev_addr)) {
-			struct wpabuf *p2p_ie;
-			u8 dev_addr[ETH_ALEN];
+	if (!is_zero_ether_addr(ssid->go_p2p_dev_addr)) {
+		struct wpabuf *p2p_ie;
+		u8 dev_addr[ETH_ALEN];
 
-			ie = wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE);
-			if (ie == NULL) {
-				wpa_dbg(wpa_s, MSG_DEBUG, "   skip - no P2P element");
-				continue;
-			}
-			p2p_ie = wpa_bss_get_vendor_ie_multi(
-				bss, P2P_IE_VENDOR_TYPE);
-			if (p2p_ie == NULL) {
-				wpa_dbg(wpa_s, MSG_DEBUG, "   skip - could not fetch P2P element");
-				continue;
-			}
+		ie = wpa_bss_get_vendor_ie(bss, P2P_IE_VENDOR_TYPE);
+		if (ie == NULL) {
+			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - no P2P element");
+			return 0;
+		}
+		p2p_ie = wpa_bss_get_vendor_ie_multi(
+			bss, P2P_IE_VENDOR_TYPE);
+		if (p2p_ie == NULL) {
+			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - could not fetch P2P element");
+			return 0;
+		}
 
-			if (p2p_parse_dev_addr_in_p2p_ie(p2p_ie, dev_addr) < 0
-			    || os_memcmp(dev_addr, ssid->go_p2p_dev_addr,
-					 ETH_ALEN) != 0) {
-				wpa_dbg(wpa_s, MSG_DEBUG, "   skip - no matching GO P2P Device Address in P2P element");
-				wpabuf_free(p2p_ie);
-				continue;
-			}
+		if (p2p_parse_dev_addr_in_p2p_ie(p2p_ie, dev_addr) < 0
+		    || os_memcmp(dev_addr, ssid->go_p2p_dev_addr,
+				 ETH_ALEN) != 0) {
+			wpa_dbg(wpa_s, MSG_DEBUG, "   skip - no matching GO P2P Device Address in P2P element");
 			wpabuf_free(p2p_ie);
+			return 0;
 		}
+		wpabuf_free(p2p_ie);
+	}
 
-		/*
-		 * TODO: skip the AP if its P2P IE has Group Formation
-		 * bit set in the P2P Group Capability Bitmap and we
-		 * are not in Group Formation with that device.
-		 */
+	/*
+	 * TODO: skip the AP if its P2P IE has Group Formation
+	 * bit set in the P2P Group Capability Bitmap and we
+	 * are not in Group Formation with that device.
+	 */
 #endif /* CONFIG_P2P */
 
-		if (os_reltime_before(&bss->last_update, &wpa_s->scan_min_time))
-		{
-			struct os_reltime diff;
+	if (os_reltime_before(&bss->last_update, &wpa_s->scan_min_time)) {
+		struct os_reltime diff;
 
-			os_reltime_sub(&wpa_s->scan_min_time,
-				       &bss->last_update, &diff);
-			wpa_dbg(wpa_s, MSG_DEBUG,
-				"   skip - scan result not recent enough (%u.%06u seconds too old)",
-				(unsigned int) diff.sec,
-				(unsigned int) diff.usec);
-			continue;
-		}
+		os_reltime_sub(&wpa_s->scan_min_time,
+			       &bss->last_update, &diff);
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"   skip - scan result not recent enough (%u.%06u seconds too old)",
+			(unsigned int) diff.sec,
+			(unsigned int) diff.usec);
+		return 0;
+	}
+
+	/* Matching configuration found */
+	return 1;
+}
 
-		/* Matching configuration found */
-		return ssid;
+
+static struct wpa_ssid * wpa_scan_res_match(struct wpa_supplicant *wpa_s,
+					    int i, struct wpa_bss *bss,
+					    struct wpa_ssid *group,
+					    int only_first_ssid)
+{
+	struct wpa_bss_match_info info;
+	struct wpa_ssid *ssid;
+
+	if (wpa_bss_match_info_get(wpa_s, i, bss, &info) < 0)
+		return NULL;
+
+	for (ssid = group; ssid; ssid = only_first_ssid ? NULL : ssid->pnext) {
+		if (wpa_scan_res_match_ssid(wpa_s, ssid, bss, &info))
+			return ssid;
 	}
 
 	/* No matching configuration found */
@@ -1104,6 +1208,181 @@ wpa_supplicant_select_bss(struct wpa_supplicant *wpa_s,
 	return NULL;
 }
 
+
+/*
+ * Index of the configured networks for BSS selection. A network with an SSID
+ * can only match a BSS with the same SSID, so such networks are hashed on the
+ * SSID and only the networks without an SSID (wildcard match) need to be
+ * checked against every BSS. The lists are in the order of the priority group
+ * and the position within the group to select the same BSS and network as a
+ * full walk through the groups with wpa_supplicant_select_bss() would.
+ */
+struct wpa_ssid_index_entry {
+	struct wpa_ssid *ssid;
+	int prio;
+	unsigned int pos;
+	struct wpa_ssid_index_entry *next;
+};
+
+struct wpa_ssid_index {
+	struct wpa_ssid_index_entry *entries;
+	struct wpa_ssid_index_entry **hash;
+	size_t hash_size;
+	struct wpa_ssid_index_entry **wildcard; /* per priority group */
+	struct wpa_bss_match_info *info; /* per wpa_s->last_scan_res entry */
+	u8 *info_state; /* 0 = not yet collected, 1 = valid, 2 = skip BSS */
+};
+
+
+static unsigned int wpa_ssid_index_hash(const u8 *ssid, size_t ssid_len,
+					size_t hash_size)
+{
+	unsigned int hash = 0;
+	size_t i;
+
+	for (i = 0; i < ssid_len; i++)
+		hash = hash * 31 + ssid[i];
+	return (hash ^ (hash >> 10) ^ (hash >> 20)) & (hash_size - 1);
+}
+
+
+static void wpa_ssid_index_free(struct wpa_ssid_index *idx)
+{
+	if (!idx)
+		return;
+	os_free(idx->entries);
+	os_free(idx->hash);
+	os_free(idx->wildcard);
+	os_free(idx->info);
+	os_free(idx->info_state);
+	os_free(idx);
+}
+
+
+static struct wpa_ssid_index *
+wpa_ssid_index_build(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_config *conf = wpa_s->conf;
+	struct wpa_ssid_index *idx;
+	struct wpa_ssid_index_entry *entry, **list;
+	struct wpa_ssid *ssid;
+	size_t num = 0, i;
+	unsigned int pos;
+	int prio;
+
+	for (prio = 0; prio < conf->num_prio; prio++) {
+		for (ssid = conf->pssid[prio]; ssid; ssid = ssid->pnext)
+			num++;
+	}
+
+	idx = os_zalloc(sizeof(*idx));
+	if (!idx)
+		return NULL;
+	idx->hash_size = 16;
+	while (idx->hash_size < 2 * num)
+		idx->hash_size *= 2;
+	idx->entries = os_calloc(num + 1, sizeof(*idx->entries));
+	idx->hash = os_calloc(idx->hash_size, sizeof(*idx->hash));
+	idx->wildcard = os_calloc(conf->num_prio + 1, sizeof(*idx->wildcard));
+	idx->info = os_calloc(wpa_s->last_scan_res_used + 1,
+			      sizeof(*idx->info));
+	idx->info_state = os_zalloc(wpa_s->last_scan_res_used + 1);
+	if (!idx->entries || !idx->hash || !idx->wildcard || !idx->info ||
+	    !idx->info_state) {
+		wpa_ssid_index_free(idx);
+		return NULL;
+	}
+
+	entry = idx->entries;
+	for (prio = 0; prio < conf->num_prio; prio++) {
+		pos = 0;
+		for (ssid = conf->pssid[prio]; ssid; ssid = ssid->pnext) {
+			entry->ssid = ssid;
+			entry->prio = prio;
+			entry->pos = pos++;
+			entry++;
+		}
+	}
+
+	/* Add in the reverse order to get the lists in selection order */
+	for (i = num; i > 0; i--) {
+		entry = &idx->entries[i - 1];
+		ssid = entry->ssid;
+		if (ssid->ssid_len)
+			list = &idx->hash[wpa_ssid_index_hash(ssid->ssid,
+							      ssid->ssid_len,
+							      idx->hash_size)];
+		else
+			list = &idx->wildcard[entry->prio];
+		entry->next = *list;
+		*list = entry;
+	}
+
+	return idx;
+}
+
+
+static struct wpa_bss *
+wpa_supplicant_select_bss_indexed(struct wpa_supplicant *wpa_s,
+				  struct wpa_ssid_index *idx, int prio,
+				  struct wpa_ssid **selected_ssid)
+{
+	struct wpa_ssid_index_entry *a, *b, *entry;
+	unsigned int i;
+
+	wpa_dbg(wpa_s, MSG_DEBUG, "Selecting BSS from priority group %d",
+		wpa_s->conf->pssid[prio]->priority);
+
+	for (i = 0; i < wpa_s->last_scan_res_used; i++) {
+		struct wpa_bss *bss = wpa_s->last_scan_res[i];
+
+		if (!idx->info_state[i])
+			idx->info_state[i] =
+				wpa_bss_match_info_get(wpa_s, i, bss,
+						       &idx->info[i]) < 0 ?
+				2 : 1;
+		if (idx->info_state[i] != 1)
+			continue;
+
+		/* Merge the SSID matches and the wildcard networks */
+		a = idx->hash[wpa_ssid_index_hash(bss->ssid, bss->ssid_len,
+						  idx->hash_size)];
+		b = idx->wildcard[prio];
+		for (;;) {
+			while (a &&
+			       (a->prio < prio ||
+				(a->prio == prio &&
+				 (a->ssid->ssid_len != bss->ssid_len ||
+				  os_memcmp(a->ssid->ssid, bss->ssid,
+					    bss->ssid_len) != 0))))
+				a = a->next;
+			if (a && a->prio > prio)
+				a = NULL;
+			if (!a && !b)
+				break;
+			if (!b || (a && a->pos < b->pos)) {
+				entry = a;
+				a = a->next;
+			} else {
+				entry = b;
+				b = b->next;
+			}
+
+			if (!wpa_scan_res_match_ssid(wpa_s, entry->ssid, bss,
+						     &idx->info[i]))
+				continue;
+			*selected_ssid = entry->ssid;
+			wpa_dbg(wpa_s, MSG_DEBUG, "   selected BSS " MACSTR
+				" ssid='%s'",
+				MAC2STR(bss->bssid),
+				wpa_ssid_txt(bss->ssid, bss->ssid_len));
+			return bss;
+		}
+	}
+
+	return NULL;
+}
+
 #ifdef CONFIG_FYJ_ORANGE
 /*
   * select bss according to different priority rule
@@ -1264,11 +1543,17 @@ struct wpa_bss * wpa_supplicant_pick_network(struct wpa_supplicant *wpa_s,
 	int prio;
 	struct wpa_ssid *next_ssid = NULL;
 	struct wpa_ssid *ssid;
+	struct wpa_ssid_index *idx = NULL;
 
 	if (wpa_s->last_scan_res == NULL ||
 	    wpa_s->last_scan_res_used == 0)
 		return NULL; /* no scan results from last update */
 
+#ifndef CONFIG_FYJ_ORANGE
+	/* Fall back to going through all the networks if this fails */
+	idx = wpa_ssid_index_build(wpa_s);
+#endif /* CONFIG_FYJ_ORANGE */
+
 	if (wpa_s->next_ssid) {
 		/* check that next_ssid is still valid */
 		for (ssid = wpa_s->conf->ssid; ssid; ssid = ssid->next) {
@@ -1315,9 +1600,13 @@ struct wpa_bss * wpa_supplicant_pick_network(struct wpa_supplicant *wpa_s,
 				if (selected)
 					break;
 			}
-			selected = wpa_supplicant_select_bss(
-				wpa_s, wpa_s->conf->pssid[prio],
-				selected_ssid, 0);
+			if (idx)
+				selected = wpa_supplicant_select_bss_indexed(
+					wpa_s, idx, prio, selected_ssid);
+			else
+				selected = wpa_supplicant_select_bss(
+					wpa_s, wpa_s->conf->pssid[prio],
+					selected_ssid, 0);
 			if (selected)
 				break;
 		}
@@ -1328,9 +1617,13 @@ struct wpa_bss * wpa_supplicant_pick_network(struct wpa_supplicant *wpa_s,
 				"blacklist and try again");
 			wpa_blacklist_clear(wpa_s);
 			wpa_s->blacklist_cleared++;
+			if (idx)
+				os_memset(idx->info_state, 0,
+					  wpa_s->last_scan_res_used);
 		} else if (selected == NULL)
 			break;
 	}
+	wpa_ssid_index_free(idx);
 
 	ssid = *selected_ssid;
 	if (selected && ssid && ssid->mem_only_psk && !ssid->psk_set &&
@@ -3120,6 +3413,19 @@ static void wpa_supplicant_event_unprot_disassoc(struct wpa_supplicant *wpa_s,
 }
 
 
+static void wpas_trace_mgmt(struct wpa_supplicant *wpa_s,
+			    enum trace_ring_event event, const u8 *buf,
+			    size_t len, int ok)
+{
+#ifdef CONFIG_AP
+	/* Frames in AP mode are traced by the AP MLME */
+	if (wpa_s->ap_iface)
+		return;
+#endif /* CONFIG_AP */
+	trace_ring_mgmt(event, buf, len, ok);
+}
+
+
 static void wpas_event_disconnect(struct wpa_supplicant *wpa_s, const u8 *addr,
 				  u16 reason_code, int locally_generated,
 				  const u8 *ie, size_t ie_len, int deauth)
@@ -3191,6 +3497,8 @@ static void wpas_event_disassoc(struct wpa_supplicant *wpa_s,
 		wpa_hexdump(MSG_DEBUG, "Disassociation frame IE(s)",
 			    ie, ie_len);
 	}
+	trace_ring_add(TRACE_RING_DISASSOC, 0, 0, addr, locally_generated,
+		       reason_code);
 
 #ifdef CONFIG_AP
 	if (wpa_s->ap_iface && info && info->addr) {
@@ -3247,6 +3555,8 @@ static void wpas_event_deauth(struct wpa_supplicant *wpa_s,
 		wpa_hexdump(MSG_DEBUG, "Deauthentication frame IE(s)",
 			    ie, ie_len);
 	}
+	trace_ring_add(TRACE_RING_DEAUTH, 0, 0, addr, locally_generated,
+		       reason_code);
 
 	wpa_reset_ft_completed(wpa_s->wpa);
 
@@ -3532,9 +3842,20 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			wpa_printf(MSG_DEBUG,
 				   "FST: MB IEs updated from auth IE");
 #endif /* CONFIG_FST */
+		trace_ring_add(TRACE_RING_AUTH, 0, 0, data->auth.peer,
+			       data->auth.auth_type, data->auth.status_code);
 		sme_event_auth(wpa_s, data);
 		break;
 	case EVENT_ASSOC:
+		/*
+		 * Record the event before processing it so that it precedes
+		 * the state machine transitions it triggers in the trace ring.
+		 * wpa_s->bssid is not yet updated at this point.
+		 */
+		trace_ring_add(TRACE_RING_ASSOC, 0, 0,
+			       data && data->assoc_info.addr ?
+			       data->assoc_info.addr : wpa_s->pending_bssid,
+			       0, 0);
 		wpa_supplicant_event_assoc(wpa_s, data);
 		if (data && data->assoc_info.authorized)
 			wpa_supplicant_event_assoc_auth(wpa_s, data);
@@ -3647,6 +3968,9 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			wpa_msg(wpa_s, MSG_INFO, WPA_EVENT_ASSOC_REJECT
 				"status_code=%u",
 				data->assoc_reject.status_code);
+		trace_ring_add(TRACE_RING_ASSOC_REJECT, 0, 0,
+			       data->assoc_reject.bssid, 0,
+			       data->assoc_reject.status_code);
 		if (wpa_s->drv_flags & WPA_DRIVER_FLAGS_SME)
 			sme_event_assoc_reject(wpa_s, data);
 		else {
@@ -3725,6 +4049,11 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			" type=%d stype=%d",
 			MAC2STR(data->tx_status.dst),
 			data->tx_status.type, data->tx_status.stype);
+		if (data->tx_status.type == WLAN_FC_TYPE_MGMT)
+			wpas_trace_mgmt(wpa_s, TRACE_RING_MGMT_TX_STATUS,
+					data->tx_status.data,
+					data->tx_status.data_len,
+					data->tx_status.ack);
 #ifdef CONFIG_AP
 		if (wpa_s->ap_iface == NULL) {
 #ifdef CONFIG_OFFCHANNEL
@@ -3865,6 +4194,11 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			data->rx_mgmt.frame;
 		fc = le_to_host16(mgmt->frame_control);
 		stype = WLAN_FC_GET_STYPE(fc);
+		if (stype != WLAN_FC_STYPE_PROBE_REQ &&
+		    stype != WLAN_FC_STYPE_BEACON)
+			wpas_trace_mgmt(wpa_s, TRACE_RING_MGMT_RX,
+					data->rx_mgmt.frame,
+					data->rx_mgmt.frame_len, 0);
 
 #ifdef CONFIG_AP
 		if (wpa_s->ap_iface == NULL) {
@@ -3987,6 +4321,7 @@ void wpa_supplicant_event(void *ctx, enum wpa_event_type event,
 			data->signal_change.current_txrate);
 		wpa_bss_update_level(wpa_s->current_bss,
 				     data->signal_change.current_signal);
+		wpas_notify_signal_change(wpa_s, &data->signal_change);
 		bgscan_notify_signal_change(
 			wpa_s, data->signal_change.above_threshold,
 			data->signal_change.current_signal,
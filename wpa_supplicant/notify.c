@@ -9,9 +9,11 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "utils/status_page.h"
 #include "common/wpa_ctrl.h"
 #include "config.h"
 #include "wpa_supplicant_i.h"
+#include "bss.h"
 #include "wps_supplicant.h"
 #include "dbus/dbus_common.h"
 #include "dbus/dbus_old.h"
@@ -106,6 +108,8 @@ void wpas_notify_state_changed(struct wpa_supplicant *wpa_s,
 
 	sme_state_changed(wpa_s);
 
+	wpas_notify_status_page(wpa_s);
+
 #ifdef ANDROID
 	wpa_msg_ctrl(wpa_s, MSG_INFO, WPA_EVENT_STATE_CHANGE
 		     "id=%d state=%d BSSID=" MACSTR " SSID=%s",
@@ -152,6 +156,8 @@ void wpas_notify_bssid_changed(struct wpa_supplicant *wpa_s)
 		return;
 
 	wpas_dbus_signal_prop_changed(wpa_s, WPAS_DBUS_PROP_CURRENT_BSS);
+
+	wpas_notify_status_page(wpa_s);
 }
 
 
@@ -384,6 +390,9 @@ void wpas_notify_bss_signal_changed(struct wpa_supplicant *wpa_s,
 
 	wpas_dbus_bss_signal_prop_changed(wpa_s, WPAS_DBUS_BSS_PROP_SIGNAL,
 					  id);
+
+	if (wpa_s->current_bss && wpa_s->current_bss->id == id)
+		wpas_notify_status_page(wpa_s);
 }
 
 
@@ -829,3 +838,81 @@ void wpas_notify_network_type_changed(struct wpa_supplicant *wpa_s,
 	}
 #endif /* CONFIG_P2P */
 }
+
+
+/**
+ * wpas_notify_status_page - Update the memory-mapped status page
+ * @wpa_s: Pointer to wpa_supplicant data
+ *
+ * Publishes the current connection state in the status_page file if one is
+ * configured.
+ */
+void wpas_notify_status_page(struct wpa_supplicant *wpa_s)
+{
+#ifdef CONFIG_STATUS_PAGE
+	struct status_page_data *page;
+	struct wpa_bss *bss = wpa_s->current_bss;
+
+	if (!wpa_s->status_page)
+		return;
+
+	page = status_page_begin(wpa_s->status_page);
+	page->state = wpa_s->wpa_state;
+	if (wpa_s->wpa_state >= WPA_ASSOCIATED) {
+		os_memcpy(page->bssid, wpa_s->bssid, ETH_ALEN);
+		page->freq = wpa_s->assoc_freq;
+		if (bss) {
+			page->signal = bss->level;
+			page->ssid_len = bss->ssid_len;
+			os_memcpy(page->ssid, bss->ssid, bss->ssid_len);
+		} else {
+			page->signal = 0;
+			page->ssid_len = 0;
+		}
+	} else {
+		os_memset(page->bssid, 0, ETH_ALEN);
+		page->freq = 0;
+		page->signal = 0;
+		page->noise = 0;
+		page->txrate = 0;
+		page->ssid_len = 0;
+	}
+	status_page_end(wpa_s->status_page);
+#endif /* CONFIG_STATUS_PAGE */
+}
+
+
+void wpas_notify_signal_change(struct wpa_supplicant *wpa_s,
+			       const struct wpa_signal_info *si)
+{
+#ifdef CONFIG_STATUS_PAGE
+	struct status_page_data *page;
+
+	if (!wpa_s->status_page || wpa_s->wpa_state < WPA_ASSOCIATED)
+		return;
+
+	page = status_page_begin(wpa_s->status_page);
+	page->signal = si->current_signal;
+	page->noise = si->current_noise;
+	page->txrate = si->current_txrate;
+	status_page_end(wpa_s->status_page);
+#endif /* CONFIG_STATUS_PAGE */
+}
+
+
+void wpas_notify_key_configured(struct wpa_supplicant *wpa_s, int group)
+{
+#ifdef CONFIG_STATUS_PAGE
+	struct status_page_data *page;
+
+	if (!wpa_s->status_page)
+		return;
+
+	page = status_page_begin(wpa_s->status_page);
+	if (group)
+		page->group_keys++;
+	else
+		page->pairwise_keys++;
+	status_page_end(wpa_s->status_page);
+#endif /* CONFIG_STATUS_PAGE */
+}
@@ -14,6 +14,7 @@
 struct wps_credential;
 struct wps_event_m2d;
 struct wps_event_fail;
+struct wpa_signal_info;
 
 int wpas_notify_supplicant_initialized(struct wpa_global *global);
 void wpas_notify_supplicant_deinitialized(struct wpa_global *global);
@@ -140,5 +141,9 @@ void wpas_notify_network_type_changed(struct wpa_supplicant *wpa_s,
 void wpas_notify_p2p_invitation_received(struct wpa_supplicant *wpa_s,
 					 const u8 *sa, const u8 *go_dev_addr,
 					 const u8 *bssid, int id, int op_freq);
+void wpas_notify_status_page(struct wpa_supplicant *wpa_s);
+void wpas_notify_signal_change(struct wpa_supplicant *wpa_s,
+			       const struct wpa_signal_info *si);
+void wpas_notify_key_configured(struct wpa_supplicant *wpa_s, int group);
 
 #endif /* NOTIFY_H */
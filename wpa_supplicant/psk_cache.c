@@ -0,0 +1,240 @@
+/*
+ * wpa_supplicant - Cache of PSKs derived from passphrases
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#include "includes.h"
+
+#include "common.h"
+#include "utils/list.h"
+#include "crypto/sha1.h"
+#include "common/wpa_common.h"
+#include "psk_cache.h"
+
+#ifndef CONFIG_NO_PBKDF2
+
+/*
+ * Deriving a PSK from a passphrase takes 4096 iterations of PBKDF2-SHA1, which
+ * is noticeable on every connection attempt on low-power hosts. Networks
+ * configured with only a BSSID get the SSID from the BSS, so their PSK cannot
+ * be derived when the configuration is read. Keep the most recently derived
+ * PSKs in a small process-wide LRU cache. The passphrase is stored only as an
+ * HMAC keyed with the passphrase over the SSID and all entries are cleared
+ * from memory when evicted.
+ */
+struct wpa_psk_cache_entry {
+	struct dl_list list;
+	u8 key[SHA1_MAC_LEN];
+	u8 psk[PMK_LEN];
+};
+
+static struct dl_list psk_cache = DL_LIST_HEAD_INIT(psk_cache);
+static unsigned int psk_cache_len;
+static unsigned int psk_cache_max = PSK_CACHE_DEFAULT_SIZE;
+
+
+static void wpa_psk_cache_free_entry(struct wpa_psk_cache_entry *entry)
+{
+	dl_list_del(&entry->list);
+	psk_cache_len--;
+	bin_clear_free(entry, sizeof(*entry));
+}
+
+
+/**
+ * wpa_psk_cache_key - Calculate the cache key for a passphrase and SSID
+ * @passphrase: ASCII passphrase
+ * @ssid: SSID
+ * @ssid_len: Length of the SSID in octets
+ * @key: Buffer for the key (SHA1_MAC_LEN octets)
+ * Returns: 0 on success, -1 on failure
+ */
+int wpa_psk_cache_key(const char *passphrase, const u8 *ssid, size_t ssid_len,
+		      u8 *key)
+{
+	return hmac_sha1((const u8 *) passphrase, os_strlen(passphrase),
+			 ssid, ssid_len, key);
+}
+
+
+static struct wpa_psk_cache_entry * wpa_psk_cache_find(const u8 *key)
+{
+	struct wpa_psk_cache_entry *entry;
+
+	dl_list_for_each(entry, &psk_cache, struct wpa_psk_cache_entry, list) {
+		if (os_memcmp_const(entry->key, key, SHA1_MAC_LEN) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+
+
+static void wpa_psk_cache_add(const u8 *key, const u8 *psk)
+{
+	struct wpa_psk_cache_entry *entry;
+
+	if (psk_cache_max == 0)
+		return;
+
+	while (psk_cache_len >= psk_cache_max) {
+		entry = dl_list_last(&psk_cache, struct wpa_psk_cache_entry,
+				     list);
+		if (entry == NULL)
+			break;
+		wpa_psk_cache_free_entry(entry);
+	}
+
+	entry = os_zalloc(sizeof(*entry));
+	if (entry == NULL)
+		return;
+	os_memcpy(entry->key, key, SHA1_MAC_LEN);
+	os_memcpy(entry->psk, psk, PMK_LEN);
+	dl_list_add(&psk_cache, &entry->list);
+	psk_cache_len++;
+}
+
+
+/**
+ * wpa_psk_cache_derive - Derive a PSK from a passphrase using the cache
+ * @passphrase: ASCII passphrase
+ * @ssid: SSID
+ * @ssid_len: Length of the SSID in octets
+ * @psk: Buffer for the derived PSK (PMK_LEN octets)
+ * Returns: 1 if the PSK was found in the cache, 0 if it was derived, or -1 on
+ * failure
+ */
+int wpa_psk_cache_derive(const char *passphrase, const u8 *ssid,
+			 size_t ssid_len, u8 *psk)
+{
+	struct wpa_psk_cache_entry *entry;
+	u8 key[SHA1_MAC_LEN];
+	int use_cache;
+
+	use_cache = psk_cache_max > 0 &&
+		wpa_psk_cache_key(passphrase, ssid, ssid_len, key) == 0;
+	if (use_cache) {
+		entry = wpa_psk_cache_find(key);
+		if (entry) {
+			os_memcpy(psk, entry->psk, PMK_LEN);
+			/* Move to the front to maintain LRU order */
+			dl_list_del(&entry->list);
+			dl_list_add(&psk_cache, &entry->list);
+			os_memset(key, 0, sizeof(key));
+			wpa_printf(MSG_DEBUG,
+				   "PSK cache: Use cached PSK for SSID '%s'",
+				   wpa_ssid_txt(ssid, ssid_len));
+			return 1;
+		}
+	}
+
+	if (pbkdf2_sha1(passphrase, ssid, ssid_len, 4096, psk, PMK_LEN) < 0) {
+		os_memset(key, 0, sizeof(key));
+		return -1;
+	}
+
+	if (use_cache)
+		wpa_psk_cache_add(key, psk);
+	os_memset(key, 0, sizeof(key));
+	return 0;
+}
+
+
+/**
+ * wpa_psk_cache_store - Add a PSK that was derived without the cache
+ * @passphrase: ASCII passphrase
+ * @ssid: SSID
+ * @ssid_len: Length of the SSID in octets
+ * @psk: PSK derived from the passphrase and SSID (PMK_LEN octets)
+ */
+void wpa_psk_cache_store(const char *passphrase, const u8 *ssid,
+			 size_t ssid_len, const u8 *psk)
+{
+	struct wpa_psk_cache_entry *entry;
+	u8 key[SHA1_MAC_LEN];
+
+	if (psk_cache_max == 0 ||
+	    wpa_psk_cache_key(passphrase, ssid, ssid_len, key) < 0)
+		return;
+	entry = wpa_psk_cache_find(key);
+	if (entry)
+		wpa_psk_cache_free_entry(entry);
+	wpa_psk_cache_add(key, psk);
+	os_memset(key, 0, sizeof(key));
+}
+
+
+/**
+ * wpa_psk_cache_has - Check whether a PSK is available in the cache
+ * @passphrase: ASCII passphrase
+ * @ssid: SSID
+ * @ssid_len: Length of the SSID in octets
+ * Returns: 1 if the PSK for the passphrase and SSID is cached, 0 if not
+ */
+int wpa_psk_cache_has(const char *passphrase, const u8 *ssid,
+		      size_t ssid_len)
+{
+	u8 key[SHA1_MAC_LEN];
+	int res;
+
+	if (psk_cache_max == 0 ||
+	    wpa_psk_cache_key(passphrase, ssid, ssid_len, key) < 0)
+		return 0;
+	res = wpa_psk_cache_find(key) != NULL;
+	os_memset(key, 0, sizeof(key));
+	return res;
+}
+
+
+/**
+ * wpa_psk_cache_set_size - Set the maximum number of cached PSKs
+ * @size: Maximum number of entries; 0 disables the cache
+ *
+ * The cache is shared by all interfaces in the process. Reducing the size
+ * evicts the least recently used entries.
+ */
+void wpa_psk_cache_set_size(unsigned int size)
+{
+	struct wpa_psk_cache_entry *entry;
+
+	if (size > PSK_CACHE_MAX_SIZE)
+		size = PSK_CACHE_MAX_SIZE;
+	if (size != psk_cache_max)
+		wpa_printf(MSG_DEBUG, "PSK cache: Size %u -> %u",
+			   psk_cache_max, size);
+	psk_cache_max = size;
+
+	while (psk_cache_len > psk_cache_max) {
+		entry = dl_list_last(&psk_cache, struct wpa_psk_cache_entry,
+				     list);
+		wpa_psk_cache_free_entry(entry);
+	}
+}
+
+
+/**
+ * wpa_psk_cache_get_size - Get the maximum number of cached PSKs
+ * Returns: Maximum number of entries; 0 if the cache is disabled
+ */
+unsigned int wpa_psk_cache_get_size(void)
+{
+	return psk_cache_max;
+}
+
+
+/**
+ * wpa_psk_cache_flush - Remove all entries from the PSK cache
+ */
+void wpa_psk_cache_flush(void)
+{
+	struct wpa_psk_cache_entry *entry, *n;
+
+	dl_list_for_each_safe(entry, n, &psk_cache, struct wpa_psk_cache_entry,
+			      list)
+		wpa_psk_cache_free_entry(entry);
+}
+
+#endif /* CONFIG_NO_PBKDF2 */
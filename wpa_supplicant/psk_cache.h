@@ -0,0 +1,42 @@
+/*
+ * wpa_supplicant - Cache of PSKs derived from passphrases
+ * Copyright (c) 2026, agent <agent@local>
+ *
+ * This software may be distributed under the terms of the BSD license.
+ * See README for more details.
+ */
+
+#ifndef PSK_CACHE_H
+#define PSK_CACHE_H
+
+/* Default and upper bound for wpa_psk_cache_set_size() */
+#define PSK_CACHE_DEFAULT_SIZE 16
+#define PSK_CACHE_MAX_SIZE 256
+
+#ifndef CONFIG_NO_PBKDF2
+
+int wpa_psk_cache_derive(const char *passphrase, const u8 *ssid,
+			 size_t ssid_len, u8 *psk);
+int wpa_psk_cache_has(const char *passphrase, const u8 *ssid,
+		      size_t ssid_len);
+void wpa_psk_cache_store(const char *passphrase, const u8 *ssid,
+			 size_t ssid_len, const u8 *psk);
+int wpa_psk_cache_key(const char *passphrase, const u8 *ssid, size_t ssid_len,
+		      u8 *key);
+void wpa_psk_cache_set_size(unsigned int size);
+unsigned int wpa_psk_cache_get_size(void);
+void wpa_psk_cache_flush(void);
+
+#else /* CONFIG_NO_PBKDF2 */
+
+static inline void wpa_psk_cache_set_size(unsigned int size)
+{
+}
+
+static inline void wpa_psk_cache_flush(void)
+{
+}
+
+#endif /* CONFIG_NO_PBKDF2 */
+
+#endif /* PSK_CACHE_H */
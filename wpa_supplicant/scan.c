@@ -1700,38 +1700,78 @@ struct wpabuf * wpa_scan_get_vendor_ie_multi(const struct wpa_scan_res *res,
 
 #define IS_5GHZ(n) (n > 4000)
 
+/*
+ * Sort keys for scan results. These are computed once per scan result before
+ * sorting so that the comparison functions do not need to walk through the IEs
+ * of both entries for each of the O(n log n) comparisons. The keys are stored
+ * in a contiguous array that is sorted instead of the array of pointers to the
+ * scan results.
+ */
+struct wpa_scan_res_key {
+	struct wpa_scan_res *res;
+#ifdef CONFIG_WPS
+	struct wpabuf *wps;
+#endif /* CONFIG_WPS */
+	unsigned int est_throughput;
+	int snr;
+	int level;
+	int qual;
+	unsigned int wpa:1;
+	unsigned int privacy:1;
+	unsigned int level_dbm:1;
+	unsigned int band_5ghz:1;
+	unsigned int uses_wps:1;
+};
+
+
+static void wpa_scan_res_key_init(struct wpa_scan_res_key *key,
+				  struct wpa_scan_res *res, int wps)
+{
+	os_memset(key, 0, sizeof(*key));
+	key->res = res;
+	key->est_throughput = res->est_throughput;
+	key->snr = res->snr;
+	key->level = res->level;
+	key->qual = res->qual;
+	key->wpa = wpa_scan_get_vendor_ie(res, WPA_IE_VENDOR_TYPE) != NULL ||
+		wpa_scan_get_ie(res, WLAN_EID_RSN) != NULL;
+	key->privacy = !!(res->caps & IEEE80211_CAP_PRIVACY);
+	key->level_dbm = !!(res->flags & WPA_SCAN_LEVEL_DBM);
+	key->band_5ghz = IS_5GHZ(res->freq);
+#ifdef CONFIG_WPS
+	if (wps) {
+		key->uses_wps = wpa_scan_get_vendor_ie(res, WPS_IE_VENDOR_TYPE) !=
+			NULL;
+		if (key->uses_wps)
+			key->wps = wpa_scan_get_vendor_ie_multi(
+				res, WPS_IE_VENDOR_TYPE);
+	}
+#endif /* CONFIG_WPS */
+}
+
+
 /* Compare function for sorting scan results. Return >0 if @b is considered
  * better. */
 static int wpa_scan_result_compar(const void *a, const void *b)
 {
 #define MIN(a,b) a < b ? a : b
-	struct wpa_scan_res **_wa = (void *) a;
-	struct wpa_scan_res **_wb = (void *) b;
-	struct wpa_scan_res *wa = *_wa;
-	struct wpa_scan_res *wb = *_wb;
-	int wpa_a, wpa_b;
+	const struct wpa_scan_res_key *wa = a;
+	const struct wpa_scan_res_key *wb = b;
 	int snr_a, snr_b, snr_a_full, snr_b_full;
 
 	/* WPA/WPA2 support preferred */
-	wpa_a = wpa_scan_get_vendor_ie(wa, WPA_IE_VENDOR_TYPE) != NULL ||
-		wpa_scan_get_ie(wa, WLAN_EID_RSN) != NULL;
-	wpa_b = wpa_scan_get_vendor_ie(wb, WPA_IE_VENDOR_TYPE) != NULL ||
-		wpa_scan_get_ie(wb, WLAN_EID_RSN) != NULL;
-
-	if (wpa_b && !wpa_a)
+	if (wb->wpa && !wa->wpa)
 		return 1;
-	if (!wpa_b && wpa_a)
+	if (!wb->wpa && wa->wpa)
 		return -1;
 
 	/* privacy support preferred */
-	if ((wa->caps & IEEE80211_CAP_PRIVACY) == 0 &&
-	    (wb->caps & IEEE80211_CAP_PRIVACY))
+	if (!wa->privacy && wb->privacy)
 		return 1;
-	if ((wa->caps & IEEE80211_CAP_PRIVACY) &&
-	    (wb->caps & IEEE80211_CAP_PRIVACY) == 0)
+	if (wa->privacy && !wb->privacy)
 		return -1;
 
-	if (wa->flags & wb->flags & WPA_SCAN_LEVEL_DBM) {
+	if (wa->level_dbm && wb->level_dbm) {
 		snr_a_full = wa->snr;
 		snr_a = MIN(wa->snr, GREAT_SNR);
 		snr_b_full = wb->snr;
@@ -1748,8 +1788,8 @@ static int wpa_scan_result_compar(const void *a, const void *b)
 	    (wa->qual && wb->qual && abs(wb->qual - wa->qual) < 10)) {
 		if (wa->est_throughput != wb->est_throughput)
 			return wb->est_throughput - wa->est_throughput;
-		if (IS_5GHZ(wa->freq) ^ IS_5GHZ(wb->freq))
-			return IS_5GHZ(wa->freq) ? -1 : 1;
+		if (wa->band_5ghz ^ wb->band_5ghz)
+			return wa->band_5ghz ? -1 : 1;
 	}
 
 	/* all things being equal, use SNR; if SNRs are
@@ -1767,29 +1807,17 @@ static int wpa_scan_result_compar(const void *a, const void *b)
  * provisioning. Return >0 if @b is considered better. */
 static int wpa_scan_result_wps_compar(const void *a, const void *b)
 {
-	struct wpa_scan_res **_wa = (void *) a;
-	struct wpa_scan_res **_wb = (void *) b;
-	struct wpa_scan_res *wa = *_wa;
-	struct wpa_scan_res *wb = *_wb;
-	int uses_wps_a, uses_wps_b;
-	struct wpabuf *wps_a, *wps_b;
+	const struct wpa_scan_res_key *wa = a;
+	const struct wpa_scan_res_key *wb = b;
 	int res;
 
-	/* Optimization - check WPS IE existence before allocated memory and
-	 * doing full reassembly. */
-	uses_wps_a = wpa_scan_get_vendor_ie(wa, WPS_IE_VENDOR_TYPE) != NULL;
-	uses_wps_b = wpa_scan_get_vendor_ie(wb, WPS_IE_VENDOR_TYPE) != NULL;
-	if (uses_wps_a && !uses_wps_b)
+	if (wa->uses_wps && !wb->uses_wps)
 		return -1;
-	if (!uses_wps_a && uses_wps_b)
+	if (!wa->uses_wps && wb->uses_wps)
 		return 1;
 
-	if (uses_wps_a && uses_wps_b) {
-		wps_a = wpa_scan_get_vendor_ie_multi(wa, WPS_IE_VENDOR_TYPE);
-		wps_b = wpa_scan_get_vendor_ie_multi(wb, WPS_IE_VENDOR_TYPE);
-		res = wps_ap_priority_compar(wps_a, wps_b);
-		wpabuf_free(wps_a);
-		wpabuf_free(wps_b);
+	if (wa->uses_wps && wb->uses_wps) {
+		res = wps_ap_priority_compar(wa->wps, wb->wps);
 		if (res)
 			return res;
 	}
@@ -1810,6 +1838,42 @@ static int wpa_scan_result_wps_compar(const void *a, const void *b)
 #endif /* CONFIG_WPS */
 
 
+static void wpa_scan_results_sort(struct wpa_scan_results *scan_res, int wps)
+{
+	int (*compar)(const void *, const void *) = wpa_scan_result_compar;
+	struct wpa_scan_res_key *keys;
+	size_t i;
+
+	if (scan_res->num < 2)
+		return;
+
+#ifdef CONFIG_WPS
+	if (wps)
+		compar = wpa_scan_result_wps_compar;
+#endif /* CONFIG_WPS */
+
+	keys = os_calloc(scan_res->num, sizeof(*keys));
+	if (keys == NULL) {
+		wpa_printf(MSG_DEBUG,
+			   "Failed to allocate scan result sort keys - leave results unsorted");
+		return;
+	}
+
+	for (i = 0; i < scan_res->num; i++)
+		wpa_scan_res_key_init(&keys[i], scan_res->res[i], wps);
+
+	qsort(keys, scan_res->num, sizeof(*keys), compar);
+
+	for (i = 0; i < scan_res->num; i++) {
+		scan_res->res[i] = keys[i].res;
+#ifdef CONFIG_WPS
+		wpabuf_free(keys[i].wps);
+#endif /* CONFIG_WPS */
+	}
+	os_free(keys);
+}
+
+
 static void dump_scan_res(struct wpa_scan_results *scan_res)
 {
 #ifndef CONFIG_NO_STDOUT_DEBUG
@@ -2104,7 +2168,7 @@ wpa_supplicant_get_scan_results(struct wpa_supplicant *wpa_s,
 {
 	struct wpa_scan_results *scan_res;
 	size_t i;
-	int (*compar)(const void *, const void *) = wpa_scan_result_compar;
+	int wps = 0;
 
 	scan_res = wpa_drv_get_scan_results2(wpa_s);
 	if (scan_res == NULL) {
@@ -2131,12 +2195,11 @@ wpa_supplicant_get_scan_results(struct wpa_supplicant *wpa_s,
 	if (wpas_wps_searching(wpa_s)) {//Scan due to WPS setup?  ==>Yajun
 		wpa_dbg(wpa_s, MSG_DEBUG, "WPS: Order scan results with WPS "
 			"provisioning rules");
-		compar = wpa_scan_result_wps_compar;
+		wps = 1;
 	}
 #endif /* CONFIG_WPS */
 
-	qsort(scan_res->res, scan_res->num, sizeof(struct wpa_scan_res *),
-	      compar);
+	wpa_scan_results_sort(scan_res, wps);
 	dump_scan_res(scan_res);
 
 	wpa_bss_update_start(wpa_s);
@@ -0,0 +1,151 @@
+#!/usr/bin/env python
+#
+# Decode the binary trace ring (TRACE_DUMP) of wpa_supplicant/hostapd
+# Copyright (c) 2026, agent <agent@local>
+#
+# This software may be distributed under the terms of the BSD license.
+# See README for more details.
+#
+# Usage:
+#   trace_ring.py <control interface socket>
+#	Fetch all entries from a running wpa_supplicant/hostapd (requires wpaspy)
+#   trace_ring.py -f <file|->
+#	Decode saved TRACE_DUMP output (one hex encoded entry per line)
+#
+# The trace ring is shared by all interfaces of the process and the entries do
+# not identify the interface, so events of different interfaces can only be
+# told apart by the peer/BSSID address.
+
+import binascii
+import struct
+import sys
+
+ENTRY_FMT = '<IIIBBBBHH6s'
+ENTRY_LEN = struct.calcsize(ENTRY_FMT)
+
+# These need to match the state enums in src/ap/wpa_auth_i.h,
+# src/eap_server/eap_i.h, and src/eap_peer/eap_i.h.
+WPA_PTK_STATES = [ "INITIALIZE", "DISCONNECT", "DISCONNECTED",
+                   "AUTHENTICATION", "AUTHENTICATION2", "INITPMK", "INITPSK",
+                   "PTKSTART", "PTKCALCNEGOTIATING", "PTKCALCNEGOTIATING2",
+                   "PTKINITNEGOTIATING", "PTKINITDONE" ]
+WPA_PTK_GROUP_STATES = [ "IDLE", "REKEYNEGOTIATING", "REKEYESTABLISHED",
+                         "KEYERROR" ]
+EAP_SERVER_STATES = [ "DISABLED", "INITIALIZE", "IDLE", "RECEIVED",
+                      "INTEGRITY_CHECK", "METHOD_RESPONSE", "METHOD_REQUEST",
+                      "PROPOSE_METHOD", "SELECT_ACTION", "SEND_REQUEST",
+                      "DISCARD", "NAK", "RETRANSMIT", "SUCCESS", "FAILURE",
+                      "TIMEOUT_FAILURE", "PICK_UP_METHOD",
+                      "INITIALIZE_PASSTHROUGH", "IDLE2", "RETRANSMIT2",
+                      "RECEIVED2", "DISCARD2", "SEND_REQUEST2", "AAA_REQUEST",
+                      "AAA_RESPONSE", "AAA_IDLE", "TIMEOUT_FAILURE2",
+                      "FAILURE2", "SUCCESS2", "INITIATE_REAUTH_START",
+                      "INITIATE_RECEIVED" ]
+EAP_PEER_STATES = [ "INITIALIZE", "DISABLED", "IDLE", "RECEIVED",
+                    "GET_METHOD", "METHOD", "SEND_RESPONSE", "DISCARD",
+                    "IDENTITY", "NOTIFICATION", "RETRANSMIT", "SUCCESS",
+                    "FAILURE" ]
+
+STATE_MACHINES = { 1: ("WPA_PTK", WPA_PTK_STATES),
+                   2: ("WPA_PTK_GROUP", WPA_PTK_GROUP_STATES),
+                   3: ("EAP_SERVER", EAP_SERVER_STATES),
+                   4: ("EAP_PEER", EAP_PEER_STATES) }
+
+MGMT_STYPES = { 0: "assoc-req", 1: "assoc-resp", 2: "reassoc-req",
+                3: "reassoc-resp", 4: "probe-req", 5: "probe-resp",
+                8: "beacon", 9: "atim", 10: "disassoc", 11: "auth",
+                12: "deauth", 13: "action" }
+
+STA_EVENTS = { 7: "ASSOC", 8: "ASSOC_REJECT", 9: "DISASSOC", 10: "DEAUTH",
+               11: "AUTH" }
+
+def state_name(states, state):
+    if state < len(states):
+        return states[state]
+    return "?%d" % state
+
+def decode_entry(data):
+    (seq, sec, usec, event, st_from, st_to, reserved, arg1, arg2,
+     addr) = struct.unpack(ENTRY_FMT, data)
+    addr = ':'.join('%02x' % c for c in bytearray(addr))
+    ts = "%d.%06d" % (sec, usec)
+    if event in STATE_MACHINES:
+        name, states = STATE_MACHINES[event]
+        txt = "%s %s -> %s" % (name, state_name(states, st_from),
+                               state_name(states, st_to))
+    elif event in (5, 6):
+        stype = (arg1 >> 4) & 0xf
+        txt = "%s %s" % ("MGMT-RX" if event == 5 else "MGMT-TX-STATUS",
+                         MGMT_STYPES.get(stype, "stype=%d" % stype))
+        if stype in (1, 3, 11):
+            txt += " status=%d" % arg2
+        elif stype in (10, 12):
+            txt += " reason=%d" % arg2
+        if event == 6:
+            txt += " ack=%d" % st_to
+    elif event in STA_EVENTS:
+        txt = STA_EVENTS[event]
+        if event == 11:
+            txt += " alg=%d status=%d" % (arg1, arg2)
+        elif event == 8:
+            txt += " status=%d" % arg2
+        elif event in (9, 10):
+            txt += " reason=%d%s" % (arg2, " (local)" if arg1 else "")
+    else:
+        txt = "event=%d from=%d to=%d arg1=%d arg2=%d" % (event, st_from,
+                                                          st_to, arg1, arg2)
+    return seq, "%s [%u] %s %s" % (ts, seq, addr, txt)
+
+def decode_lines(lines):
+    entries = []
+    for line in lines:
+        line = line.strip()
+        if not line:
+            continue
+        data = binascii.unhexlify(line)
+        if len(data) != ENTRY_LEN:
+            raise Exception("Invalid entry length: " + line)
+        entries.append(decode_entry(data))
+    return entries
+
+def fetch(path):
+    import wpaspy
+    ctrl = wpaspy.Ctrl(path)
+    lines = []
+    seq = None
+    while True:
+        cmd = "TRACE_DUMP" if seq is None else "TRACE_DUMP %d" % seq
+        res = ctrl.request(cmd)
+        if res.startswith("FAIL"):
+            raise Exception("TRACE_DUMP failed (CONFIG_TRACE_RING not enabled?)")
+        new = [l for l in res.splitlines() if l.strip()]
+        if not new:
+            break
+        lines += new
+        last, txt = decode_lines(new[-1:])[0]
+        seq = (last + 1) & 0xffffffff
+    return lines
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == '-f':
+        if sys.argv[2] == '-':
+            lines = sys.stdin.readlines()
+        else:
+            with open(sys.argv[2], 'r') as f:
+                lines = f.readlines()
+    elif len(sys.argv) == 2:
+        lines = fetch(sys.argv[1])
+    else:
+        print("usage: trace_ring.py <ctrl socket> | -f <file|->")
+        sys.exit(1)
+
+    print("# all interfaces (entries do not identify the interface)")
+    prev = None
+    for seq, txt in decode_lines(lines):
+        if prev is not None and seq != ((prev + 1) & 0xffffffff):
+            print("--- %d entries lost ---" % ((seq - prev - 1) & 0xffffffff))
+        prev = seq
+        print(txt)
+
+if __name__ == "__main__":
+    main()
@@ -669,7 +669,8 @@ static char ** wpa_cli_complete_set(const char *str, int pos)
 #endif /* CONFIG_P2P */
 		"country", "bss_max_count", "bss_expiration_age",
 		"bss_expiration_scan_count", "filter_ssids", "filter_rssi",
-		"max_num_sta", "disassoc_low_ack",
+		"dbus_bss_bulk_signals", "dbus_bss_on_demand", "max_num_sta",
+		"disassoc_low_ack",
 #ifdef CONFIG_HS20
 		"hs20",
 #endif /* CONFIG_HS20 */
@@ -683,7 +684,7 @@ static char ** wpa_cli_complete_set(const char *str, int pos)
 		"tdls_external_control", "osu_dir", "wowlan_triggers",
 		"p2p_search_delay", "mac_addr", "rand_addr_lifetime",
 		"preassoc_mac_addr", "key_mgmt_offload", "passive_scan",
-		"reassoc_same_bss_optim", "wps_priority"
+		"reassoc_same_bss_optim", "wps_priority", "status_page"
 	};
 	int i, num_fields = ARRAY_SIZE(fields);
 
@@ -753,7 +754,8 @@ static char ** wpa_cli_complete_get(const char *str, int pos)
 #endif /* CONFIG_P2P */
 		"bss_max_count", "bss_expiration_age",
 		"bss_expiration_scan_count", "filter_ssids", "filter_rssi",
-		"max_num_sta", "disassoc_low_ack",
+		"dbus_bss_bulk_signals", "dbus_bss_on_demand", "max_num_sta",
+		"disassoc_low_ack",
 #ifdef CONFIG_HS20
 		"hs20",
 #endif /* CONFIG_HS20 */
@@ -765,7 +767,7 @@ static char ** wpa_cli_complete_get(const char *str, int pos)
 		"tdls_external_control", "osu_dir", "wowlan_triggers",
 		"p2p_search_delay", "mac_addr", "rand_addr_lifetime",
 		"preassoc_mac_addr", "key_mgmt_offload", "passive_scan",
-		"reassoc_same_bss_optim"
+		"reassoc_same_bss_optim", "status_page"
 	};
 	int i, num_fields = ARRAY_SIZE(fields);
 
@@ -1445,6 +1447,13 @@ static int wpa_cli_cmd_log_level(struct wpa_ctrl *ctrl, int argc, char *argv[])
 }
 
 
+static int wpa_cli_cmd_trace_dump(struct wpa_ctrl *ctrl, int argc,
+				  char *argv[])
+{
+	return wpa_cli_cmd(ctrl, "TRACE_DUMP", 0, argc, argv);
+}
+
+
 static int wpa_cli_cmd_list_networks(struct wpa_ctrl *ctrl, int argc,
 				     char *argv[])
 {
@@ -2984,6 +2993,10 @@ static const struct wpa_cli_cmd wpa_cli_commands[] = {
 	  cli_cmd_flag_none,
 	  "<level> [<timestamp>] = update the log level/timestamp\n"
 	  "log_level = display the current log level and log options" },
+	{ "trace_dump", wpa_cli_cmd_trace_dump, NULL,
+	  cli_cmd_flag_none,
+	  "[<seq>] = dump binary trace ring entries (of all interfaces) starting\n"
+	  "  from <seq>" },
 	{ "list_networks", wpa_cli_cmd_list_networks, NULL,
 	  cli_cmd_flag_none,
 	  "= list configured networks" },
@@ -4288,6 +4301,13 @@ static char * wpa_cli_get_default_ifname(void)
 		if (os_strcmp(dent->d_name, ".") == 0 ||
 		    os_strcmp(dent->d_name, "..") == 0)
 			continue;
+#ifdef CONFIG_CTRL_IFACE_STREAM
+		if (os_strlen(dent->d_name) > os_strlen(WPA_CTRL_STREAM_SUFFIX) &&
+		    os_strcmp(dent->d_name + os_strlen(dent->d_name) -
+			      os_strlen(WPA_CTRL_STREAM_SUFFIX),
+			      WPA_CTRL_STREAM_SUFFIX) == 0)
+			continue;
+#endif /* CONFIG_CTRL_IFACE_STREAM */
 		printf("Selected interface '%s'\n", dent->d_name);
 		ifname = os_strdup(dent->d_name);
 		break;
@@ -23,6 +23,7 @@
 #include "eloop.h"
 #include "config.h"
 #include "utils/ext_password.h"
+#include "utils/status_page.h"
 #include "l2_packet/l2_packet.h"
 #include "wpa_supplicant_i.h"
 #include "driver_i.h"
@@ -34,9 +35,11 @@
 #include "common/wpa_ctrl.h"
 #include "common/ieee802_11_defs.h"
 #include "common/hw_features_common.h"
+#include "common/sae.h"
 #include "p2p/p2p.h"
 #include "fst/fst.h"
 #include "blacklist.h"
+#include "psk_cache.h"
 #include "wpas_glue.h"
 #include "wps_supplicant.h"
 #include "ibss_rsn.h"
@@ -397,6 +400,104 @@ void free_hw_features(struct wpa_supplicant *wpa_s)
 }
 
 
+#ifndef CONFIG_NO_PBKDF2
+
+static int wpas_psk_precompute_needed(struct wpa_supplicant *wpa_s,
+				      struct wpa_ssid *ssid,
+				      struct wpa_bss **bss)
+{
+	if (!wpa_key_mgmt_wpa_psk(ssid->key_mgmt) || !ssid->bssid_set ||
+	    ssid->ssid_len || !ssid->passphrase ||
+	    wpas_network_disabled(wpa_s, ssid))
+		return 0;
+
+	*bss = wpa_bss_get_bssid_latest(wpa_s, ssid->bssid);
+	return *bss && !wpa_psk_cache_has(ssid->passphrase, (*bss)->ssid,
+					  (*bss)->ssid_len);
+}
+
+
+/**
+ * wpas_psk_precompute_next - Derive the next PSK in a precompute pass
+ * @wpa_s: Pointer to wpa_supplicant data
+ * Returns: 1 if a PSK was derived, 0 if the pass is completed
+ *
+ * Each network is handled at most once per pass even if its PSK does not
+ * stay in the cache (e.g., the cache is smaller than the number of networks)
+ * to avoid deriving PSKs in a loop.
+ */
+int wpas_psk_precompute_next(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_ssid *ssid;
+	struct wpa_bss *bss;
+	u8 psk[PMK_LEN];
+
+	if (wpa_psk_cache_get_size() == 0)
+		return 0;
+
+	/* Networks are kept in the order of their ids */
+	for (ssid = wpa_s->conf->ssid; ssid; ssid = ssid->next) {
+		if (ssid->id < wpa_s->psk_precompute_next_id ||
+		    !wpas_psk_precompute_needed(wpa_s, ssid, &bss))
+			continue;
+
+		wpa_s->psk_precompute_next_id = ssid->id + 1;
+		wpa_dbg(wpa_s, MSG_DEBUG,
+			"PSK cache: Precompute PSK for network id=%d SSID '%s'",
+			ssid->id, wpa_ssid_txt(bss->ssid, bss->ssid_len));
+		wpa_psk_cache_derive(ssid->passphrase, bss->ssid,
+				     bss->ssid_len, psk);
+		os_memset(psk, 0, sizeof(psk));
+		return 1;
+	}
+
+	return 0;
+}
+
+
+static void wpas_psk_precompute_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct wpa_supplicant *wpa_s = eloop_ctx;
+
+	/*
+	 * Derive one PSK per event loop iteration to avoid delaying other
+	 * events when several networks need a new PSK.
+	 */
+	if (wpas_psk_precompute_next(wpa_s))
+		eloop_register_timeout(0, 0, wpas_psk_precompute_timeout,
+				       wpa_s, NULL);
+}
+
+#endif /* CONFIG_NO_PBKDF2 */
+
+
+/**
+ * wpas_psk_precompute - Schedule background PSK derivation
+ * @wpa_s: Pointer to wpa_supplicant data
+ *
+ * This function is called when a new BSS is added to the BSS table. If
+ * psk_cache_precompute is enabled, the PSKs for enabled networks that are
+ * configured with a BSSID and a passphrase, but no SSID, are derived from
+ * the event loop for the SSIDs found in the BSS table so that a following
+ * connection attempt does not need to wait for PBKDF2.
+ */
+void wpas_psk_precompute(struct wpa_supplicant *wpa_s)
+{
+#ifndef CONFIG_NO_PBKDF2
+	if (!wpa_s->conf->psk_cache_precompute ||
+	    wpa_psk_cache_get_size() == 0)
+		return;
+
+	/* Start a new pass to cover the networks of the new BSS */
+	wpa_s->psk_precompute_next_id = 0;
+	if (eloop_is_timeout_registered(wpas_psk_precompute_timeout, wpa_s,
+					NULL))
+		return;
+	eloop_register_timeout(0, 0, wpas_psk_precompute_timeout, wpa_s, NULL);
+#endif /* CONFIG_NO_PBKDF2 */
+}
+
+
 static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 {
 	int i;
@@ -458,6 +559,9 @@ static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 #endif /* CONFIG_DELAYED_MIC_ERROR_REPORT */
 
 	eloop_cancel_timeout(wpas_network_reenabled, wpa_s, NULL);
+#ifndef CONFIG_NO_PBKDF2
+	eloop_cancel_timeout(wpas_psk_precompute_timeout, wpa_s, NULL);
+#endif /* CONFIG_NO_PBKDF2 */
 
 	wpas_wps_deinit(wpa_s);
 
@@ -527,6 +631,9 @@ static void wpa_supplicant_cleanup(struct wpa_supplicant *wpa_s)
 	ext_password_deinit(wpa_s->ext_pw);
 	wpa_s->ext_pw = NULL;
 
+	status_page_deinit(wpa_s->status_page);
+	wpa_s->status_page = NULL;
+
 	wpabuf_free(wpa_s->last_gas_resp);
 	wpa_s->last_gas_resp = NULL;
 	wpabuf_free(wpa_s->prev_gas_resp);
@@ -1300,8 +1407,8 @@ int wpa_supplicant_set_suites(struct wpa_supplicant *wpa_s,
 		if (bss && ssid->bssid_set && ssid->ssid_len == 0 &&
 		    ssid->passphrase) {
 			u8 psk[PMK_LEN];
-		        pbkdf2_sha1(ssid->passphrase, bss->ssid, bss->ssid_len,
-				    4096, psk, PMK_LEN);
+			wpa_psk_cache_derive(ssid->passphrase, bss->ssid,
+					     bss->ssid_len, psk);
 		        wpa_hexdump_key(MSG_MSGDUMP, "PSK (from passphrase)",
 					psk, PMK_LEN);
 			wpa_sm_set_pmk(wpa_s->wpa, psk, PMK_LEN, NULL);
@@ -1336,8 +1443,8 @@ int wpa_supplicant_set_suites(struct wpa_supplicant *wpa_s,
 #ifndef CONFIG_NO_PBKDF2
 			if (wpabuf_len(pw) >= 8 && wpabuf_len(pw) < 64 && bss)
 			{
-				pbkdf2_sha1(pw_str, bss->ssid, bss->ssid_len,
-					    4096, psk, PMK_LEN);
+				wpa_psk_cache_derive(pw_str, bss->ssid,
+						     bss->ssid_len, psk);
 				os_memset(pw_str, 0, sizeof(pw_str));
 				wpa_hexdump_key(MSG_MSGDUMP, "PSK (from "
 						"external passphrase)",
@@ -3825,6 +3932,31 @@ int wpas_init_ext_pw(struct wpa_supplicant *wpa_s)
 }
 
 
+int wpas_init_status_page(struct wpa_supplicant *wpa_s)
+{
+	status_page_deinit(wpa_s->status_page);
+	wpa_s->status_page = NULL;
+
+	if (!wpa_s->conf->status_page || !wpa_s->conf->status_page[0])
+		return 0;
+
+	wpa_s->status_page = status_page_init(wpa_s->conf->status_page,
+					      STATUS_PAGE_MODE_STATION);
+	if (!wpa_s->status_page) {
+#ifdef CONFIG_STATUS_PAGE
+		wpa_printf(MSG_ERROR, "Failed to initialize status page");
+#else /* CONFIG_STATUS_PAGE */
+		wpa_printf(MSG_ERROR,
+			   "status_page requires CONFIG_STATUS_PAGE=y build option");
+#endif /* CONFIG_STATUS_PAGE */
+		return -1;
+	}
+	wpas_notify_status_page(wpa_s);
+
+	return 0;
+}
+
+
 #ifdef CONFIG_FST
 
 static const u8 * wpas_fst_get_bssid_cb(void *ctx)
@@ -4753,6 +4885,9 @@ static int wpa_supplicant_init_iface(struct wpa_supplicant *wpa_s,
 	if (wpas_init_ext_pw(wpa_s) < 0)
 		return -1;
 
+	if (wpas_init_status_page(wpa_s) < 0)
+		return -1;
+
 	wpas_rrm_reset(wpa_s);
 
 	wpas_sched_scan_plans_set(wpa_s, wpa_s->conf->sched_scan_plans);
@@ -4846,6 +4981,47 @@ static void wpa_supplicant_deinit_iface(struct wpa_supplicant *wpa_s,
 }
 
 
+static void wpas_sae_pwe_cache_update(struct wpa_global *global)
+{
+#ifdef CONFIG_SAE
+	struct wpa_supplicant *wpa_s;
+	unsigned int size = 0;
+
+	/* The PWE cache is process-wide; use the largest configured size */
+	for (wpa_s = global->ifaces; wpa_s; wpa_s = wpa_s->next) {
+		if (wpa_s->conf &&
+		    (unsigned int) wpa_s->conf->sae_pwe_cache_size > size)
+			size = wpa_s->conf->sae_pwe_cache_size;
+	}
+
+	sae_pwe_cache_set_size(size);
+#endif /* CONFIG_SAE */
+}
+
+
+static void wpas_psk_cache_update(struct wpa_global *global)
+{
+	struct wpa_supplicant *wpa_s;
+	unsigned int size = 0;
+
+	if (global->ifaces == NULL) {
+		/* Do not keep PSKs around without interfaces that use them */
+		wpa_psk_cache_flush();
+		wpa_psk_cache_set_size(PSK_CACHE_DEFAULT_SIZE);
+		return;
+	}
+
+	/* The PSK cache is process-wide; use the largest configured size */
+	for (wpa_s = global->ifaces; wpa_s; wpa_s = wpa_s->next) {
+		if (wpa_s->conf &&
+		    (unsigned int) wpa_s->conf->psk_cache_size > size)
+			size = wpa_s->conf->psk_cache_size;
+	}
+
+	wpa_psk_cache_set_size(size);
+}
+
+
 /**
  * wpa_supplicant_add_iface - Add a new network interface
  * @global: Pointer to global data from wpa_supplicant_init()
@@ -4911,6 +5087,8 @@ struct wpa_supplicant * wpa_supplicant_add_iface(struct wpa_global *global,
 
 	wpa_s->next = global->ifaces;
 	global->ifaces = wpa_s;
+	wpas_sae_pwe_cache_update(global);
+	wpas_psk_cache_update(global);
 
 	wpa_dbg(wpa_s, MSG_DEBUG, "Added interface %s", wpa_s->ifname);
 	wpa_supplicant_set_state(wpa_s, WPA_DISCONNECTED);
@@ -4982,6 +5160,8 @@ int wpa_supplicant_remove_iface(struct wpa_global *global,
 	if (global->p2p_invite_group == wpa_s)
 		global->p2p_invite_group = NULL;
 	wpa_supplicant_deinit_iface(wpa_s, 1, terminate);
+	wpas_sae_pwe_cache_update(global);
+	wpas_psk_cache_update(global);
 
 #ifdef CONFIG_MESH
 	if (mesh_if_created) {
@@ -5325,9 +5505,18 @@ void wpa_supplicant_update_config(struct wpa_supplicant *wpa_s)
 	if (wpa_s->conf->changed_parameters & CFG_CHANGED_EXT_PW_BACKEND)
 		wpas_init_ext_pw(wpa_s);
 
+	if (wpa_s->conf->changed_parameters & CFG_CHANGED_STATUS_PAGE)
+		wpas_init_status_page(wpa_s);
+
 	if (wpa_s->conf->changed_parameters & CFG_CHANGED_SCHED_SCAN_PLANS)
 		wpas_sched_scan_plans_set(wpa_s, wpa_s->conf->sched_scan_plans);
 
+	if (wpa_s->conf->changed_parameters & CFG_CHANGED_SAE_PWE_CACHE)
+		wpas_sae_pwe_cache_update(wpa_s->global);
+
+	if (wpa_s->conf->changed_parameters & CFG_CHANGED_PSK_CACHE)
+		wpas_psk_cache_update(wpa_s->global);
+
 #ifdef CONFIG_WPS
 	wpas_wps_update_config(wpa_s);
 #endif /* CONFIG_WPS */
@@ -529,6 +529,16 @@ struct wpa_supplicant {
 				 struct wpa_scan_results *scan_res);
 	struct dl_list bss; /* struct wpa_bss::list */
 	struct dl_list bss_id; /* struct wpa_bss::list_id */
+#define WPA_BSS_HASH_SIZE 256
+	/* BSS entries hashed on (BSSID, SSID); chained with wpa_bss::hnext */
+	struct wpa_bss *bss_hash[WPA_BSS_HASH_SIZE];
+	/*
+	 * BSS entries hashed on BSSID; chained with wpa_bss::bnext in the
+	 * order of the most recent update first
+	 */
+	struct wpa_bss *bss_bssid_hash[WPA_BSS_HASH_SIZE];
+	/* BSS entries hashed on id; chained with wpa_bss::inext */
+	struct wpa_bss *bss_id_hash[WPA_BSS_HASH_SIZE];
 	size_t num_bss;
 	unsigned int bss_update_idx;
 	unsigned int bss_next_id;
@@ -946,6 +956,11 @@ struct wpa_supplicant {
 
 	struct ext_password_data *ext_pw;
 
+	/* First network id to consider in the PSK precompute pass */
+	int psk_precompute_next_id;
+
+	struct status_page *status_page;
+
 	struct wpabuf *last_gas_resp, *prev_gas_resp;
 	u8 last_gas_addr[ETH_ALEN], prev_gas_addr[ETH_ALEN];
 	u8 last_gas_dialog_token, prev_gas_dialog_token;
@@ -1115,6 +1130,8 @@ int disallowed_bssid(struct wpa_supplicant *wpa_s, const u8 *bssid);
 int disallowed_ssid(struct wpa_supplicant *wpa_s, const u8 *ssid,
 		    size_t ssid_len);
 void wpas_request_connection(struct wpa_supplicant *wpa_s);
+void wpas_psk_precompute(struct wpa_supplicant *wpa_s);
+int wpas_psk_precompute_next(struct wpa_supplicant *wpa_s);
 int wpas_build_ext_capab(struct wpa_supplicant *wpa_s, u8 *buf, size_t buflen);
 int wpas_update_random_addr(struct wpa_supplicant *wpa_s, int style);
 int wpas_update_random_addr_disassoc(struct wpa_supplicant *wpa_s);
@@ -1181,6 +1198,7 @@ int wpas_network_disabled(struct wpa_supplicant *wpa_s, struct wpa_ssid *ssid);
 int wpas_get_ssid_pmf(struct wpa_supplicant *wpa_s, struct wpa_ssid *ssid);
 
 int wpas_init_ext_pw(struct wpa_supplicant *wpa_s);
+int wpas_init_status_page(struct wpa_supplicant *wpa_s);
 
 void dump_freq_data(struct wpa_supplicant *wpa_s, const char *title,
 		    struct wpa_used_freq_data *freqs_data,
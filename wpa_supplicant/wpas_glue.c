@@ -488,6 +488,8 @@ static int wpa_supplicant_set_key(void *_wpa_s, enum wpa_alg alg,
 				  const u8 *key, size_t key_len)
 {
 	struct wpa_supplicant *wpa_s = _wpa_s;
+	int ret;
+
 	if (alg == WPA_ALG_TKIP && key_idx == 0 && key_len == 32) {
 		/* Clear the MIC error counter when setting a new PTK. */
 		wpa_s->mic_errors_seen = 0;
@@ -499,8 +501,12 @@ static int wpa_supplicant_set_key(void *_wpa_s, enum wpa_alg alg,
 		wpa_s->last_gtk_len = key_len;
 	}
 #endif /* CONFIG_TESTING_GET_GTK */
-	return wpa_drv_set_key(wpa_s, alg, addr, key_idx, set_tx, seq, seq_len,
-			       key, key_len);
+	ret = wpa_drv_set_key(wpa_s, alg, addr, key_idx, set_tx, seq, seq_len,
+			      key, key_len);
+	if (ret == 0 && alg != WPA_ALG_NONE)
+		wpas_notify_key_configured(wpa_s, !addr ||
+					   is_broadcast_ether_addr(addr));
+	return ret;
 }
 
 
@@ -9,8 +9,14 @@
 #include "utils/includes.h"
 
 #include "utils/common.h"
+#include "common/ieee802_11_defs.h"
+#include "common/wpa_common.h"
+#include "drivers/driver.h"
 #include "wpa_supplicant_i.h"
+#include "config.h"
+#include "bss.h"
 #include "blacklist.h"
+#include "psk_cache.h"
 
 
 static int wpas_blacklist_module_tests(void)
@@ -69,6 +75,439 @@ fail:
 }
 
 
+static struct wpa_scan_res * wpas_bss_test_res(u16 last, const char *ssid)
+{
+	struct wpa_scan_res *res;
+	size_t ssid_len = os_strlen(ssid);
+	u8 *pos;
+	/* WPA2-Personal with CCMP */
+	static const u8 rsn_ie[] = {
+		WLAN_EID_RSN, 20, 0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,
+		0x01, 0x00, 0x00, 0x0f, 0xac, 0x04,
+		0x01, 0x00, 0x00, 0x0f, 0xac, 0x02, 0x00, 0x00
+	};
+
+	res = os_zalloc(sizeof(*res) + 2 + ssid_len + sizeof(rsn_ie));
+	if (!res)
+		return NULL;
+	res->bssid[0] = 0x02;
+	res->bssid[4] = last >> 8;
+	res->bssid[5] = last;
+	res->freq = 2412;
+	res->caps = IEEE80211_CAP_ESS | IEEE80211_CAP_PRIVACY;
+	res->ie_len = 2 + ssid_len + sizeof(rsn_ie);
+	pos = (u8 *) (res + 1);
+	*pos++ = WLAN_EID_SSID;
+	*pos++ = ssid_len;
+	os_memcpy(pos, ssid, ssid_len);
+	pos += ssid_len;
+	os_memcpy(pos, rsn_ie, sizeof(rsn_ie));
+	return res;
+}
+
+
+static int wpas_bss_test_update(struct wpa_supplicant *wpa_s, u16 last,
+				const char *ssid)
+{
+	struct wpa_scan_res *res;
+	struct os_reltime now;
+
+	res = wpas_bss_test_res(last, ssid);
+	if (!res)
+		return -1;
+	os_get_reltime(&now);
+	wpa_bss_update_scan_res(wpa_s, res, &now);
+	os_free(res);
+	return 0;
+}
+
+
+static int wpas_bss_module_tests(void)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_global global;
+	struct wpa_config conf;
+	struct wpa_radio radio;
+	struct wpa_bss *bss, *bss2;
+	u8 bssid[ETH_ALEN] = { 0x02, 0, 0, 0, 0, 0 };
+	unsigned int i;
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "bss module tests");
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&global, 0, sizeof(global));
+	os_memset(&conf, 0, sizeof(conf));
+	os_memset(&radio, 0, sizeof(radio));
+	dl_list_init(&radio.work);
+	conf.bss_max_count = 1000;
+	conf.bss_expiration_scan_count = 1;
+	wpa_s.global = &global;
+	wpa_s.conf = &conf;
+	wpa_s.radio = &radio;
+	wpa_s.p2p_mgmt = 1; /* no control interface or D-Bus notifications */
+	wpa_bss_init(&wpa_s);
+
+	/* Enough entries to get multiple entries in each hash bucket */
+	wpa_bss_update_start(&wpa_s);
+	for (i = 0; i < 600; i++) {
+		if (wpas_bss_test_update(&wpa_s, i & 0xff,
+					 i < 256 ? "a" : (i < 512 ? "b" : "c")))
+			goto fail;
+	}
+	if (wpas_bss_test_update(&wpa_s, 1, "a") < 0)
+		goto fail;
+	wpa_bss_update_end(&wpa_s, NULL, 1);
+	if (wpa_s.num_bss != 600 || wpa_s.last_scan_res_used != 600)
+		goto fail;
+
+	bssid[5] = 1;
+	bss = wpa_bss_get(&wpa_s, bssid, (const u8 *) "b", 1);
+	if (!bss || bss->ssid_len != 1 || bss->ssid[0] != 'b' ||
+	    os_memcmp(bss->bssid, bssid, ETH_ALEN) != 0 ||
+	    wpa_bss_get_id(&wpa_s, bss->id) != bss ||
+	    wpa_bss_get(&wpa_s, bssid, (const u8 *) "d", 1))
+		goto fail;
+
+	/* Most recently updated entry is returned for a BSSID */
+	bss = wpa_bss_get_bssid(&wpa_s, bssid);
+	if (!bss || bss->ssid[0] != 'a')
+		goto fail;
+	bssid[5] = 2;
+	bss = wpa_bss_get_bssid(&wpa_s, bssid);
+	if (!bss || bss->ssid[0] != 'c')
+		goto fail;
+
+	/* Entries that are not seen in a new scan are expired */
+	wpa_bss_update_start(&wpa_s);
+	if (wpas_bss_test_update(&wpa_s, 2, "a") < 0)
+		goto fail;
+	wpa_bss_update_end(&wpa_s, NULL, 1);
+	if (wpa_s.num_bss != 1)
+		goto fail;
+	bss = wpa_bss_get_bssid(&wpa_s, bssid);
+	bss2 = wpa_bss_get(&wpa_s, bssid, (const u8 *) "a", 1);
+	if (!bss || bss != bss2 || wpa_bss_get_id(&wpa_s, bss->id) != bss ||
+	    wpa_bss_get_id(&wpa_s, bss->id + 1))
+		goto fail;
+	bssid[5] = 1;
+	if (wpa_bss_get_bssid(&wpa_s, bssid) ||
+	    wpa_bss_get(&wpa_s, bssid, (const u8 *) "a", 1))
+		goto fail;
+
+	ret = 0;
+fail:
+	wpa_bss_deinit(&wpa_s);
+	os_free(wpa_s.last_scan_res);
+	if (wpa_s.num_bss || wpa_s.bss_hash[0] || wpa_s.bss_bssid_hash[0])
+		ret = -1;
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "bss module test failure");
+
+	return ret;
+}
+
+
+#define WPAS_PICK_TEST_NETWORKS 1000
+#define WPAS_PICK_TEST_BSSES 1000
+#define WPAS_PICK_TEST_ROUNDS 10
+
+static int wpas_pick_network_module_tests(void)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_global global;
+	struct wpa_radio radio;
+	struct wpa_ssid *ssid, *selected_ssid = NULL, *expected = NULL;
+	struct wpa_bss *bss = NULL;
+	struct wpa_bss_sel_info *sel_info;
+	struct wpa_scan_res *res, *tmp;
+	static const u8 collision[2][4] = {
+		{ 0x00, 0xe6, 0x72, 0x29 }, { 0x02, 0x70, 0x11, 0x00 }
+	};
+	u8 *pos;
+	struct os_reltime start, end, diff;
+	char buf[32];
+	unsigned int i;
+	int debug_level, ret = -1;
+
+	wpa_printf(MSG_INFO, "network selection module tests");
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&global, 0, sizeof(global));
+	os_memset(&radio, 0, sizeof(radio));
+	dl_list_init(&radio.work);
+	wpa_s.global = &global;
+	wpa_s.radio = &radio;
+	wpa_s.conf = wpa_config_alloc_empty(NULL, NULL);
+	if (!wpa_s.conf)
+		return -1;
+	wpa_s.conf->bss_max_count = WPAS_PICK_TEST_BSSES;
+	wpa_bss_init(&wpa_s);
+
+	/* WPA2-Personal networks in ten priority groups */
+	for (i = 0; i < WPAS_PICK_TEST_NETWORKS; i++) {
+		ssid = wpa_config_add_network(wpa_s.conf);
+		if (!ssid)
+			goto fail;
+		wpa_config_set_network_defaults(ssid);
+		os_snprintf(buf, sizeof(buf), "net-%u", i);
+		ssid->ssid = (u8 *) os_strdup(buf);
+		if (!ssid->ssid)
+			goto fail;
+		ssid->ssid_len = os_strlen(buf);
+		ssid->priority = i % 10;
+		ssid->psk_set = 1;
+		if (i == 19)
+			expected = ssid;
+	}
+	wpa_config_update_prio_list(wpa_s.conf);
+
+	/*
+	 * Only two of the BSSes match a network; the one in the highest
+	 * priority group is expected to be selected.
+	 */
+	wpa_bss_update_start(&wpa_s);
+	for (i = 0; i < WPAS_PICK_TEST_BSSES; i++) {
+		if (i == 100)
+			os_snprintf(buf, sizeof(buf), "net-5");
+		else if (i == WPAS_PICK_TEST_BSSES - 100)
+			os_snprintf(buf, sizeof(buf), "net-19");
+		else
+			os_snprintf(buf, sizeof(buf), "ap-%u", i);
+		if (wpas_bss_test_update(&wpa_s, i, buf) < 0)
+			goto fail;
+	}
+	wpa_bss_update_end(&wpa_s, NULL, 1);
+
+	debug_level = wpa_debug_level;
+	wpa_debug_level = MSG_INFO;
+	os_get_reltime(&start);
+	for (i = 0; i < WPAS_PICK_TEST_ROUNDS; i++)
+		bss = wpa_supplicant_pick_network(&wpa_s, &selected_ssid);
+	os_get_reltime(&end);
+	wpa_debug_level = debug_level;
+	os_reltime_sub(&end, &start, &diff);
+	wpa_printf(MSG_INFO,
+		   "network selection: %u networks, %u BSSes: %lu usec per selection",
+		   WPAS_PICK_TEST_NETWORKS, WPAS_PICK_TEST_BSSES,
+		   (unsigned long) (diff.sec * 1000000 + diff.usec) /
+		   WPAS_PICK_TEST_ROUNDS);
+
+	if (!bss || selected_ssid != expected ||
+	    bss != wpa_s.last_scan_res[WPAS_PICK_TEST_BSSES - 100])
+		goto fail;
+
+	/* Parsed IEs are kept over BSS table updates until the IEs change */
+	sel_info = bss->sel_info;
+	if (!sel_info)
+		goto fail;
+	res = wpas_bss_test_res(WPAS_PICK_TEST_BSSES - 100, "net-19");
+	if (!res)
+		goto fail;
+	os_get_reltime(&start);
+	wpa_bss_update_start(&wpa_s);
+	wpa_bss_update_scan_res(&wpa_s, res, &start);
+	if (bss->sel_info != sel_info) {
+		os_free(res);
+		goto fail;
+	}
+	/* Change the RSN IE group cipher to TKIP */
+	((u8 *) (res + 1))[res->ie_len - 15] = 0x02;
+	wpa_bss_update_scan_res(&wpa_s, res, &start);
+	wpa_bss_update_end(&wpa_s, NULL, 0);
+	os_free(res);
+	if (bss->sel_info)
+		goto fail;
+
+	/*
+	 * IE changes are noticed even if the IE length does not change and a
+	 * simple hash of the IEs would not change either. These vendor element
+	 * payloads give the same FNV-1a hash for the IEs.
+	 */
+	res = wpas_bss_test_res(WPAS_PICK_TEST_BSSES - 100, "net-19");
+	if (!res)
+		goto fail;
+	tmp = os_realloc(res, sizeof(*res) + res->ie_len + 6);
+	if (!tmp) {
+		os_free(res);
+		goto fail;
+	}
+	res = tmp;
+	pos = (u8 *) (res + 1) + res->ie_len;
+	res->ie_len += 6;
+	*pos++ = WLAN_EID_VENDOR_SPECIFIC;
+	*pos++ = 4;
+	for (i = 0; i < 2; i++) {
+		os_memcpy(pos, collision[i], 4);
+		wpa_bss_update_start(&wpa_s);
+		wpa_bss_update_scan_res(&wpa_s, res, &start);
+		wpa_bss_update_end(&wpa_s, NULL, 0);
+		if (i == 0)
+			wpa_supplicant_pick_network(&wpa_s, &selected_ssid);
+		bss = wpa_bss_get_bssid(&wpa_s, res->bssid);
+		if (!bss || (i == 0 && !bss->sel_info) ||
+		    (i == 1 && bss->sel_info)) {
+			os_free(res);
+			goto fail;
+		}
+	}
+	os_free(res);
+
+	ret = 0;
+fail:
+	wpa_bss_deinit(&wpa_s);
+	os_free(wpa_s.last_scan_res);
+	wpa_config_free(wpa_s.conf);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "network selection module test failure");
+
+	return ret;
+}
+
+
+#ifndef CONFIG_NO_PBKDF2
+static int wpas_psk_cache_module_tests(void)
+{
+	/* IEEE Std 802.11-2012, M.4.2 test vector */
+	const u8 expected[PMK_LEN] = {
+		0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef,
+		0x9e, 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90,
+		0x2e, 0x83, 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2,
+		0x3a, 0xed, 0x76, 0x2e, 0x97, 0x10, 0xa1, 0x2e
+	};
+	u8 psk[PMK_LEN];
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "psk_cache module tests");
+
+	wpa_psk_cache_flush();
+	wpa_psk_cache_set_size(2);
+
+	if (wpa_psk_cache_has("password", (u8 *) "IEEE", 4) ||
+	    wpa_psk_cache_derive("password", (u8 *) "IEEE", 4, psk) != 0 ||
+	    os_memcmp(psk, expected, PMK_LEN) != 0 ||
+	    !wpa_psk_cache_has("password", (u8 *) "IEEE", 4) ||
+	    wpa_psk_cache_has("password", (u8 *) "IEEE2", 5) ||
+	    wpa_psk_cache_has("password2", (u8 *) "IEEE", 4))
+		goto fail;
+
+	os_memset(psk, 0, sizeof(psk));
+	if (wpa_psk_cache_derive("password", (u8 *) "IEEE", 4, psk) != 1 ||
+	    os_memcmp(psk, expected, PMK_LEN) != 0)
+		goto fail;
+
+	/* The least recently used entry is evicted when the cache is full */
+	if (wpa_psk_cache_derive("password", (u8 *) "IEEE2", 5, psk) != 0 ||
+	    wpa_psk_cache_derive("password", (u8 *) "IEEE", 4, psk) != 1 ||
+	    wpa_psk_cache_derive("password", (u8 *) "IEEE3", 5, psk) != 0 ||
+	    !wpa_psk_cache_has("password", (u8 *) "IEEE", 4) ||
+	    wpa_psk_cache_has("password", (u8 *) "IEEE2", 5) ||
+	    !wpa_psk_cache_has("password", (u8 *) "IEEE3", 5))
+		goto fail;
+
+	wpa_psk_cache_set_size(1);
+	if (wpa_psk_cache_has("password", (u8 *) "IEEE", 4) ||
+	    !wpa_psk_cache_has("password", (u8 *) "IEEE3", 5))
+		goto fail;
+
+	wpa_psk_cache_set_size(0);
+	if (wpa_psk_cache_has("password", (u8 *) "IEEE3", 5) ||
+	    wpa_psk_cache_derive("password", (u8 *) "IEEE", 4, psk) != 0 ||
+	    os_memcmp(psk, expected, PMK_LEN) != 0 ||
+	    wpa_psk_cache_has("password", (u8 *) "IEEE", 4))
+		goto fail;
+
+	ret = 0;
+fail:
+	wpa_psk_cache_flush();
+	wpa_psk_cache_set_size(PSK_CACHE_DEFAULT_SIZE);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "psk_cache module test failure");
+
+	return ret;
+}
+
+
+static int wpas_psk_precompute_module_tests(void)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_global global;
+	struct wpa_radio radio;
+	struct wpa_ssid *ssid;
+	unsigned int i;
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "PSK precompute module tests");
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&global, 0, sizeof(global));
+	os_memset(&radio, 0, sizeof(radio));
+	dl_list_init(&radio.work);
+	wpa_s.global = &global;
+	wpa_s.radio = &radio;
+	wpa_s.conf = wpa_config_alloc_empty(NULL, NULL);
+	if (!wpa_s.conf)
+		return -1;
+	wpa_bss_init(&wpa_s);
+
+	/* Two BSSID-only networks with a BSS in the BSS table */
+	wpa_bss_update_start(&wpa_s);
+	for (i = 0; i < 2; i++) {
+		ssid = wpa_config_add_network(wpa_s.conf);
+		if (!ssid)
+			goto fail;
+		wpa_config_set_network_defaults(ssid);
+		ssid->passphrase = os_strdup("password");
+		if (!ssid->passphrase)
+			goto fail;
+		ssid->bssid_set = 1;
+		ssid->bssid[0] = 0x02;
+		ssid->bssid[5] = i;
+		if (wpas_bss_test_update(&wpa_s, i, i ? "IEEE2" : "IEEE") < 0)
+			goto fail;
+	}
+	wpa_bss_update_end(&wpa_s, NULL, 1);
+	wpa_s.conf->psk_cache_precompute = 1;
+	wpa_psk_cache_flush();
+
+	/* Nothing is derived when the cache is disabled */
+	wpa_psk_cache_set_size(0);
+	wpas_psk_precompute(&wpa_s);
+	if (wpas_psk_precompute_next(&wpa_s) != 0)
+		goto fail;
+
+	/*
+	 * The pass ends after each network has been handled once even if the
+	 * PSKs do not fit into the cache.
+	 */
+	wpa_psk_cache_set_size(1);
+	wpa_s.psk_precompute_next_id = 0;
+	if (wpas_psk_precompute_next(&wpa_s) != 1 ||
+	    wpas_psk_precompute_next(&wpa_s) != 1 ||
+	    wpas_psk_precompute_next(&wpa_s) != 0 ||
+	    wpa_psk_cache_has("password", (u8 *) "IEEE", 4) ||
+	    !wpa_psk_cache_has("password", (u8 *) "IEEE2", 5))
+		goto fail;
+
+	ret = 0;
+fail:
+	wpa_psk_cache_flush();
+	wpa_psk_cache_set_size(PSK_CACHE_DEFAULT_SIZE);
+	wpa_bss_deinit(&wpa_s);
+	os_free(wpa_s.last_scan_res);
+	wpa_config_free(wpa_s.conf);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "PSK precompute module test failure");
+
+	return ret;
+}
+#endif /* CONFIG_NO_PBKDF2 */
+
+
 int wpas_module_tests(void)
 {
 	int ret = 0;
@@ -78,6 +517,20 @@ int wpas_module_tests(void)
 	if (wpas_blacklist_module_tests() < 0)
 		ret = -1;
 
+	if (wpas_bss_module_tests() < 0)
+		ret = -1;
+
+	if (wpas_pick_network_module_tests() < 0)
+		ret = -1;
+
+#ifndef CONFIG_NO_PBKDF2
+	if (wpas_psk_cache_module_tests() < 0)
+		ret = -1;
+
+	if (wpas_psk_precompute_module_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_NO_PBKDF2 */
+
 #ifdef CONFIG_WPS
 	{
 		int wps_module_tests(void);